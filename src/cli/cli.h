@@ -50,6 +50,6 @@ public:
     std::function<Error(Ref<Scene>, const std::string& arg)> cmd;
     std::array<char, 128> msg { 0 };
 };
-extern std::array<Command, 35> root;
+extern std::array<Command, 55> root;
 
 } // namespace ic::cli
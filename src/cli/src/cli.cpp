@@ -20,6 +20,11 @@ template <> const char* to_str<cli::Type>(cli::Type v)
 namespace cli {
     using namespace replxx;
     static void _print_help(void);
+    LCS_ERROR static _simulate(const std::filesystem::path& scene_path,
+        const std::filesystem::path& stimulus_path,
+        const std::filesystem::path& out_path,
+        const std::filesystem::path& vcd_path, uint64_t ticks,
+        Backend::Type engine, Backend::Type cross_check);
 
     int parse_args(int argc, char** argv)
     {
@@ -30,8 +35,41 @@ namespace cli {
             args.push_back(argv[i]);
         }
 
-        for (auto& arg : args) {
-            if (arg == "-i" || arg == "--interactive") {
+        std::filesystem::path simulate, stimulus, out, vcd;
+        uint64_t ticks            = 1;
+        Backend::Type engine      = Backend::TYPE_S;
+        Backend::Type cross_check = Backend::TYPE_S;
+        for (size_t i = 0; i < args.size(); i++) {
+            const std::string& arg = args[i];
+            bool has_value         = i + 1 < args.size();
+            if (arg == "--simulate" || arg == "--stimulus" || arg == "--out"
+                || arg == "--vcd" || arg == "--ticks" || arg == "--engine"
+                || arg == "--cross-check") {
+                if (!has_value) {
+                    return ERROR(Error::NO_ARGUMENT);
+                }
+                const std::string& value = args[++i];
+                if (arg == "--simulate") {
+                    simulate = value;
+                } else if (arg == "--stimulus") {
+                    stimulus = value;
+                } else if (arg == "--out") {
+                    out = value;
+                } else if (arg == "--vcd") {
+                    vcd = value;
+                } else if (arg == "--engine" || arg == "--cross-check") {
+                    if (!Backend::parse(
+                            value, arg == "--engine" ? engine : cross_check)) {
+                        return ERROR(Error::INVALID_ARGUMENT);
+                    }
+                } else {
+                    char* end = nullptr;
+                    ticks     = std::strtoull(value.c_str(), &end, 10);
+                    if (*end != '\0' || ticks == 0) {
+                        return ERROR(Error::INVALID_ARGUMENT);
+                    }
+                }
+            } else if (arg == "-i" || arg == "--interactive") {
                 gui = false;
             } else if (arg == "-h" || arg == "--help") {
                 _print_help();
@@ -52,16 +90,87 @@ namespace cli {
                 }
             }
         }
+        if (!simulate.empty()) {
+            // Batch simulation never starts the shell or the user interface.
+            if (stimulus.empty() || out.empty()) {
+                return ERROR(Error::NO_ARGUMENT);
+            }
+            fs::init();
+            Error err = _simulate(
+                simulate, stimulus, out, vcd, ticks, engine, cross_check);
+            fs::close();
+            exit(err);
+        }
         if (gui) {
             return -1;
         }
         return 0;
     }
 
+    static StreamFormat _stream_format(const std::filesystem::path& path)
+    {
+        return path.extension() == ".csv" ? StreamFormat::CSV
+                                          : StreamFormat::BINARY;
+    }
+
+    LCS_ERROR static _simulate(const std::filesystem::path& scene_path,
+        const std::filesystem::path& stimulus_path,
+        const std::filesystem::path& out_path,
+        const std::filesystem::path& vcd_path, uint64_t ticks,
+        Backend::Type engine, Backend::Type cross_check)
+    {
+        Scene scene;
+        if (Error err = scene.read_file(scene_path); err != Error::OK) {
+            return err;
+        }
+        std::ifstream stimulus { stimulus_path, std::ios::binary };
+        if (!stimulus) {
+            return ERROR(Error::NOT_FOUND);
+        }
+        std::ofstream samples { out_path, std::ios::binary | std::ios::trunc };
+        if (!samples) {
+            return ERROR(Error::INVALID_FILE);
+        }
+        if (engine != Backend::TYPE_S) {
+            scene.engine = engine;
+        }
+        WaveRecorder recorder;
+        if (!vcd_path.empty()) {
+            // Only the event backend drives the relations of the scene, the
+            // others would leave the waveform flat.
+            if (scene.engine != Backend::EVENT) {
+                L_WARN("--vcd requires the event backend.");
+                return ERROR(Error::INVALID_ARGUMENT);
+            }
+            recorder.add_outputs(scene);
+            if (Error err = recorder.open(scene, vcd_path); err != Error::OK) {
+                return err;
+            }
+        }
+        std::unique_ptr<Backend> backend = Backend::create(scene.engine);
+        if (cross_check != Backend::TYPE_S) {
+            backend = std::make_unique<CrossCheck>(
+                std::move(backend), Backend::create(cross_check));
+        }
+        if (Error err = backend->load(scene); err != Error::OK) {
+            return err;
+        }
+        Error err = run_stimulus(*backend, stimulus,
+            _stream_format(stimulus_path), samples, _stream_format(out_path),
+            ticks);
+        recorder.close();
+        if (err == Error::OK && cross_check != Backend::TYPE_S
+            && static_cast<CrossCheck&>(*backend).divergence().has_value()) {
+            return ERROR(Error::DIVERGENCE);
+        }
+        return err;
+    }
+
     static void _print_help(void)
     {
         puts("Usage:\r\n"
              "  " APPNAME_BIN " [OPTIONS] [FILE ...]\r\n"
+             "  " APPNAME_BIN " --simulate FILE --stimulus FILE --out FILE\r\n"
              "\r\n"
              "  A free and open-source cross-platform logic circuit "
              "simulator.\r\n"
@@ -72,6 +181,24 @@ namespace cli {
              "  -V, --verbose         Enable verbose logging.\r\n"
              "  -h, --help            Prints this section.\r\n"
              "\r\n"
+             "Simulation:\r\n"
+             "  --simulate FILE       Simulates the scene without the user "
+             "interface.\r\n"
+             "  --stimulus FILE       Input values of every step, .csv or "
+             "binary.\r\n"
+             "  --out FILE            Writes the outputs of every step, .csv "
+             "or binary.\r\n"
+             "  --vcd FILE            Records the outputs as a waveform, "
+             "event backend\r\n"
+             "                        only.\r\n"
+             "  --ticks N             Ticks between steps, 1 by default.\r\n"
+             "  --engine NAME         Simulation backend: event, recursive, "
+             "levelized\r\n"
+             "                        or bit-parallel.\r\n"
+             "  --cross-check NAME    Runs a second backend in lockstep and "
+             "reports\r\n"
+             "                        the first divergence.\r\n"
+             "\r\n"
              "Report bugs in the bug tracker at\r\n"
              "<https://github.com/umutsevdi/imcircuit/"
              "issues>\r\n"
@@ -1,3 +1,4 @@
+#include <cctype>
 #include <string>
 #include "cli.h"
 #include "common.h"
@@ -105,6 +106,12 @@ static Error as(const std::string& data, Node& value, bool required = true)
         value.type = Node::COMPONENT_OUTPUT;
     } else if (type == "Component Input") {
         value.type = Node::COMPONENT_INPUT;
+    } else if (type == "Sequential") {
+        value.type = Node::SEQUENTIAL;
+    } else if (type == "LUT") {
+        value.type = Node::LUT;
+    } else if (type == "Memory") {
+        value.type = Node::MEMORY;
     } else {
         return ERROR(Error::INVALID_NODE);
     }
@@ -112,6 +119,40 @@ static Error as(const std::string& data, Node& value, bool required = true)
     return Error::OK;
 }
 
+static Error as(const std::string& data, Gate::Type& value)
+{
+    for (uint8_t type = 0; type < Gate::TYPE_S; type++) {
+        if (data == to_str<Gate::Type>(static_cast<Gate::Type>(type))) {
+            value = static_cast<Gate::Type>(type);
+            return Error::OK;
+        }
+    }
+    return ERROR(Error::INVALID_ARGUMENT);
+}
+
+static Error as(const std::string& data, Sequential::Type& value)
+{
+    for (uint8_t type = 0; type < Sequential::TYPE_S; type++) {
+        if (data
+            == to_str<Sequential::Type>(static_cast<Sequential::Type>(type))) {
+            value = static_cast<Sequential::Type>(type);
+            return Error::OK;
+        }
+    }
+    return ERROR(Error::INVALID_ARGUMENT);
+}
+
+static Error as(const std::string& data, Memory::Type& value)
+{
+    for (uint8_t type = 0; type < Memory::TYPE_S; type++) {
+        if (data == to_str<Memory::Type>(static_cast<Memory::Type>(type))) {
+            value = static_cast<Memory::Type>(type);
+            return Error::OK;
+        }
+    }
+    return ERROR(Error::INVALID_ARGUMENT);
+}
+
 Error print_node(Node node, Ref<Gate> n)
 {
     if (n == nullptr) {
@@ -128,11 +169,11 @@ Error print_node(Node node, Ref<Gate> n)
     for (auto& out : n->output) {
         output_info << out << ' ';
     }
-    L_INFO("Gate@%zu: type:%s connected:%s position:(%d,%d) inputs: {%s}, "
-           "outputs: {%s}",
+    L_INFO("Gate@%zu: type:%s connected:%s position:(%d,%d) delay:%u "
+           "inputs: {%s}, outputs: {%s}",
         node.index, to_str<Gate::Type>(n->type()),
         n->is_connected() ? "true" : "false", n->point().x, n->point().y,
-        input_info.str().c_str(), output_info.str().c_str());
+        n->delay(), input_info.str().c_str(), output_info.str().c_str());
     return Error::OK;
 }
 
@@ -171,6 +212,91 @@ Error print_node(Node node, Ref<Output> n)
     return Error::OK;
 }
 
+Error print_node(Node node, Ref<Sequential> n)
+{
+    if (n == nullptr) {
+        return ERROR(Error::NODE_NOT_FOUND);
+    }
+    std::stringstream input_info {};
+    for (size_t i = 0; i < n->inputs.size(); i++) {
+        input_info << "[" << i << ":"
+                   << (n->inputs[i] != 0 ? std::to_string(n->inputs[i])
+                                         : "empty")
+                   << ']';
+    }
+    std::stringstream output_info {};
+    for (const auto& [sock, rels] : n->outputs) {
+        output_info << "[" << static_cast<int>(sock) << ":";
+        for (auto& out : rels) {
+            output_info << ' ' << out;
+        }
+        output_info << ']';
+    }
+    L_INFO("Sequential@%zu: type:%s width:%u value:0x%llx connected:%s "
+           "position:(%d,%d) inputs: {%s}, outputs: {%s}",
+        node.index, to_str<Sequential::Type>(n->type()), n->width(),
+        static_cast<unsigned long long>(n->value()),
+        n->is_connected() ? "true" : "false", n->point().x, n->point().y,
+        input_info.str().c_str(), output_info.str().c_str());
+    return Error::OK;
+}
+
+Error print_node(Node node, Ref<Lut> n)
+{
+    if (n == nullptr) {
+        return ERROR(Error::NODE_NOT_FOUND);
+    }
+    std::stringstream input_info {};
+    for (size_t i = 0; i < n->inputs.size(); i++) {
+        input_info << "[" << i << ":"
+                   << (n->inputs[i] != 0 ? std::to_string(n->inputs[i])
+                                         : "empty")
+                   << ']';
+    }
+    std::stringstream output_info {};
+    for (auto& out : n->output) {
+        output_info << out << ' ';
+    }
+    std::stringstream table_info {};
+    for (size_t i = (1u << n->inputs.size()); i > 0; i--) {
+        table_info << n->table()[i - 1];
+    }
+    L_INFO("LUT@%zu: table:%s connected:%s position:(%d,%d) inputs: {%s}, "
+           "outputs: {%s}",
+        node.index, table_info.str().c_str(),
+        n->is_connected() ? "true" : "false", n->point().x, n->point().y,
+        input_info.str().c_str(), output_info.str().c_str());
+    return Error::OK;
+}
+
+Error print_node(Node node, Ref<Memory> n)
+{
+    if (n == nullptr) {
+        return ERROR(Error::NODE_NOT_FOUND);
+    }
+    std::stringstream input_info {};
+    for (size_t i = 0; i < n->inputs.size(); i++) {
+        input_info << "[" << i << ":"
+                   << (n->inputs[i] != 0 ? std::to_string(n->inputs[i])
+                                         : "empty")
+                   << ']';
+    }
+    std::stringstream output_info {};
+    for (const auto& [sock, rels] : n->outputs) {
+        output_info << "[" << static_cast<int>(sock) << ":";
+        for (auto& out : rels) {
+            output_info << ' ' << out;
+        }
+        output_info << ']';
+    }
+    L_INFO("Memory@%zu: type:%s address:%u data:%u connected:%s "
+           "position:(%d,%d) inputs: {%s}, outputs: {%s}",
+        node.index, to_str<Memory::Type>(n->type()), n->address_s(),
+        n->data_s(), n->is_connected() ? "true" : "false", n->point().x,
+        n->point().y, input_info.str().c_str(), output_info.str().c_str());
+    return Error::OK;
+}
+
 Error print_node(Node node, Ref<Component> n)
 {
     return Error::OK; /** TODO implement*/
@@ -281,6 +407,33 @@ Error _add_input(Ref<Scene> scene, const std::string& arg)
     return Error::OK;
 }
 
+Error _add_memory(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    std::stringstream ss { arg };
+    std::string type_str;
+    int address_s = 8;
+    int data_s    = 8;
+    ss >> type_str;
+    Memory::Type type;
+    if (Error err = as(type_str, type); err != Error::OK) {
+        return err;
+    }
+    if (!ss.eof() && !(ss >> address_s)) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    if (!ss.eof() && !(ss >> data_s)) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    if (address_s <= 0 || address_s > Memory::MAX_ADDRESS || data_s <= 0
+        || data_s > Memory::MAX_DATA) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    scene->add_node<Memory>(
+        type, static_cast<sockid>(address_s), static_cast<sockid>(data_s));
+    return Error::OK;
+}
+
 Error _add_output(Ref<Scene> scene, const std::string&)
 {
     expect_scene(scene);
@@ -288,6 +441,52 @@ Error _add_output(Ref<Scene> scene, const std::string&)
     return Error::OK;
 }
 
+Error _add_sequential(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    size_t type_end = arg.find(' ');
+    Sequential::Type type;
+    if (Error err = as(arg.substr(0, type_end), type); err != Error::OK) {
+        return err;
+    }
+    int width = 8;
+    if (type_end != std::string::npos) {
+        if (Error err = as(arg.substr(type_end + 1), width); err != Error::OK) {
+            return err;
+        }
+    }
+    if (width <= 0 || width > Sequential::MAX_WIDTH) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    scene->add_node<Sequential>(type, static_cast<sockid>(width));
+    return Error::OK;
+}
+
+Error _add_lut(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    size_t size_end = arg.find(' ');
+    if (size_end == std::string::npos) {
+        return ERROR(Error::NO_ARGUMENT);
+    }
+    int input_s = 0;
+    if (Error err = as(arg.substr(0, size_end), input_s); err != Error::OK) {
+        return err;
+    }
+    std::string bits = arg.substr(size_end + 1);
+    if (input_s <= 0 || input_s > Lut::MAX_INPUT
+        || bits.size() > (1u << input_s)) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    try {
+        // The rightmost character is the output for the index zero.
+        scene->add_node<Lut>(static_cast<sockid>(input_s), Lut::Table { bits });
+    } catch (const std::exception& e) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    return Error::OK;
+}
+
 Error _add_timer(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -301,6 +500,26 @@ Error _add_timer(Ref<Scene> scene, const std::string& arg)
 
 Error _close(Ref<Scene>, const std::string&) { return tabs::close(); }
 
+Error _collapse(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    std::vector<Node> nodes;
+    std::stringstream ss { arg };
+    std::string token;
+    while (ss >> token) {
+        Node node;
+        if (Error err = as(token, node); err != Error::OK) {
+            return err;
+        }
+        nodes.push_back(node);
+    }
+    Node lut;
+    if (Error err = scene->collapse(nodes, lut); err != Error::OK) {
+        return err;
+    }
+    return print_node(lut, scene->get_node<Lut>(lut));
+}
+
 Error _connect(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -351,6 +570,121 @@ Error _disconnect(Ref<Scene> scene, const std::string& arg)
     return scene->disconnect(id);
 }
 
+Error _equiv(Ref<Scene> scene, const std::string& arg)
+{
+    std::stringstream ss { arg };
+    std::string first, second;
+    ss >> first >> second;
+    if (first.empty()) {
+        return ERROR(Error::NO_ARGUMENT);
+    }
+    // A single path is compared against the active scene.
+    Scene lhs, rhs;
+    if (second.empty()) {
+        expect_scene(scene);
+    } else if (Error err = lhs.read_file(first); err != Error::OK) {
+        return err;
+    }
+    if (Error err = rhs.read_file(second.empty() ? first : second);
+        err != Error::OK) {
+        return err;
+    }
+    Equivalence result;
+    if (Error err = check_equivalence(
+            second.empty() ? *scene : lhs, rhs, result);
+        err != Error::OK) {
+        return err;
+    }
+    if (result.is_equivalent) {
+        L_INFO("Equivalent, %llu patterns%s%s.",
+            static_cast<unsigned long long>(result.patterns),
+            result.is_proven ? ", proven" : "",
+            result.is_cached ? ", cached" : "");
+    } else {
+        std::string inputs;
+        for (bool v : result.counterexample) {
+            inputs += v ? '1' : '0';
+        }
+        L_INFO("Not equivalent. Output %zu differs for inputs %s.",
+            result.output, inputs.c_str());
+    }
+    return Error::OK;
+}
+
+Error _export_netlist(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    if (arg.empty()) {
+        return ERROR(Error::NO_ARGUMENT);
+    }
+    return hdl::write_scene(*scene, arg);
+}
+
+/**
+ * Reads test vectors, one per line with the value of input 0 first. Empty
+ * lines and lines that start with "#" are skipped.
+ */
+Error _faults(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    std::string data;
+    if (!fs::read(arg, data)) {
+        return ERROR(Error::NOT_FOUND);
+    }
+    std::vector<std::vector<bool>> vectors;
+    std::stringstream ss { data };
+    std::string line;
+    while (std::getline(ss, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<bool> vector;
+        for (char c : line) {
+            if (c == '0' || c == '1') {
+                vector.push_back(c == '1');
+            } else if (!std::isspace(static_cast<unsigned char>(c))) {
+                return ERROR(Error::INVALID_ARGUMENT);
+            }
+        }
+        vectors.push_back(vector);
+    }
+    FaultCoverage result;
+    if (Error err = simulate_faults(*scene, vectors, result);
+        err != Error::OK) {
+        return err;
+    }
+    L_INFO("Fault coverage %.2f%%, %zu of %zu faults detected.",
+        result.ratio() * 100, result.detected, result.total);
+    for (const Fault& f : result.undetected) {
+        L_INFO("Undetected: relation %u stuck-at-%d.", f.rel, f.value ? 1 : 0);
+    }
+    return Error::OK;
+}
+
+/**
+ * Writes the optimized netlist of the scene as C++ source that
+ * NativeNetlist can compile.
+ */
+Error _export_cpp(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    if (arg.empty()) {
+        return ERROR(Error::NO_ARGUMENT);
+    }
+    Netlist netlist;
+    if (Error err = netlist.compile(*scene); err != Error::OK) {
+        return err;
+    }
+    netlist.optimize();
+    if (!fs::write(arg, NativeNetlist::generate(netlist))) {
+        return ERROR(Error::INVALID_FILE);
+    }
+    L_INFO("Wrote %s with %zu inputs and %zu outputs to %s.",
+        NativeNetlist::SYMBOL, netlist.inputs.size(), netlist.outputs.size(),
+        arg.c_str());
+    return Error::OK;
+}
+
 Error _help(Ref<Scene>, const std::string&)
 {
     L_INFO(APPNAME " shell provides the following commands:");
@@ -362,6 +696,22 @@ Error _help(Ref<Scene>, const std::string&)
     return Error::OK;
 };
 
+Error _import(Ref<Scene> scene, const std::string& arg)
+{
+    if (scene != nullptr) {
+        return ERROR(Error::ALREADY_ACTIVE_SCENE);
+    }
+    if (arg.empty()) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    size_t idx = tabs::create("", "local", "", 1);
+    if (Error err = hdl::read_scene(arg, *tabs::active(idx)); err) {
+        Error _ = tabs::close(idx);
+        return err;
+    }
+    return Error::OK;
+}
+
 Error _include(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -371,6 +721,12 @@ Error _include(Ref<Scene> scene, const std::string& arg)
     return scene->add_dependency(arg);
 }
 
+Error _install(Ref<Scene> scene, const std::string&)
+{
+    expect_scene(scene);
+    return library::install(*scene);
+}
+
 Error _list_component(Ref<Scene> scene, const std::string&)
 {
     expect_scene(scene);
@@ -442,6 +798,62 @@ Error _list_output(Ref<Scene> scene, const std::string&)
     return Error::OK;
 }
 
+Error _list_package(Ref<Scene>, const std::string&)
+{
+    for (const library::Package& package : library::list()) {
+        L_INFO(" > %s | inputs: %d, outputs: %d, size: %u, blob: %016llx",
+            package.name.c_str(), package.input_s, package.output_s,
+            package.size, static_cast<unsigned long long>(package.hash));
+    }
+    return Error::OK;
+}
+
+Error _list_sequential(Ref<Scene> scene, const std::string&)
+{
+    expect_scene(scene);
+    for (size_t i = 0; i < scene->_sequentials.size(); i++) {
+        if (!scene->_sequentials[i].is_null()) {
+            const auto& g = scene->_sequentials[i];
+            L_INFO(" > Sequential@%zu | type: %s, value: 0x%llx, "
+                   "is_connected: %s, position: (%d, %d)",
+                i, to_str<Sequential::Type>(g.type()),
+                static_cast<unsigned long long>(g.value()),
+                g.is_connected() ? "true" : "false", g.point().x, g.point().y);
+        }
+    }
+    return Error::OK;
+}
+
+Error _list_lut(Ref<Scene> scene, const std::string&)
+{
+    expect_scene(scene);
+    for (size_t i = 0; i < scene->_luts.size(); i++) {
+        if (!scene->_luts[i].is_null()) {
+            const auto& g = scene->_luts[i];
+            L_INFO(" > LUT@%zu   | inputs: %zu, value: %s, is_connected: %s, "
+                   "position: (%d, %d)",
+                i, g.inputs.size(), to_str(g.get()),
+                g.is_connected() ? "true" : "false", g.point().x, g.point().y);
+        }
+    }
+    return Error::OK;
+}
+
+Error _list_memory(Ref<Scene> scene, const std::string&)
+{
+    expect_scene(scene);
+    for (size_t i = 0; i < scene->_memories.size(); i++) {
+        if (!scene->_memories[i].is_null()) {
+            const auto& g = scene->_memories[i];
+            L_INFO(" > Memory@%zu | type: %s, size: %zux%u, is_connected: %s, "
+                   "position: (%d, %d)",
+                i, to_str<Memory::Type>(g.type()), g.size(), g.data_s(),
+                g.is_connected() ? "true" : "false", g.point().x, g.point().y);
+        }
+    }
+    return Error::OK;
+}
+
 Error _list_rel(Ref<Scene> scene, const std::string&)
 {
     for (const auto& [k, v] : scene->_relations) {
@@ -460,9 +872,32 @@ Error _list_all(Ref<Scene> scene, const std::string& arg)
     _list_input(scene, arg);
     _list_output(scene, arg);
     _list_component(scene, arg);
+    _list_sequential(scene, arg);
+    _list_lut(scene, arg);
+    _list_memory(scene, arg);
     return Error::OK;
 }
 
+Error _load_memory(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    size_t node_end = arg.find(' ');
+    if (node_end == std::string::npos) {
+        return ERROR(Error::NO_ARGUMENT);
+    }
+    Node node;
+    if (Error err = as(arg.substr(0, node_end), node); err != Error::OK) {
+        return err;
+    } else if (node.type != Node::MEMORY) {
+        return ERROR(Error::INVALID_NODE);
+    }
+    auto memory = scene->get_node<Memory>(node);
+    if (memory == nullptr) {
+        return ERROR(Error::NODE_NOT_FOUND);
+    }
+    return memory->load_file(arg.substr(node_end + 1));
+}
+
 Error _move(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -521,6 +956,22 @@ Error _open(Ref<Scene> scene, const std::string& arg)
     return tabs::open(arg);
 }
 
+Error _optimize(Ref<Scene> scene, const std::string&)
+{
+    expect_scene(scene);
+    Netlist netlist;
+    if (Error err = netlist.compile(*scene); err != Error::OK) {
+        return err;
+    }
+    Netlist::Stats stats = netlist.optimize();
+    Aig aig;
+    aig.build(netlist);
+    L_INFO("Gates: %zu -> %zu, AND nodes: %zu, inputs: %zu, outputs: %zu",
+        stats.gates_before, stats.gates_after, aig.and_count(),
+        netlist.inputs.size(), netlist.outputs.size());
+    return Error::OK;
+}
+
 Error _remove(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -555,6 +1006,44 @@ Error _set_author(Ref<Scene> scene, const std::string& arg)
     return scene->set_author(arg);
 }
 
+Error _set_delay(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    size_t delay_start = arg.find(' ');
+    if (delay_start == std::string::npos) {
+        return ERROR(Error::NO_ARGUMENT);
+    }
+    int delay = 0;
+    if (Error err = as(arg.substr(delay_start + 1), delay); err) {
+        return err;
+    }
+    if (delay < 0 || delay >= Gate::INHERIT_DELAY) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    std::string target = arg.substr(0, delay_start);
+    if (target.find('@') != std::string::npos) {
+        Node node;
+        if (Error err = as(target, node); err) {
+            return err;
+        }
+        if (node.type != Node::GATE) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        auto gate = scene->get_node<Gate>(node);
+        if (gate == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        gate->set_delay(delay);
+        return Error::OK;
+    }
+    Gate::Type type;
+    if (Error err = as(target, type); err) {
+        return err;
+    }
+    scene->gate_delay[type] = delay;
+    return Error::OK;
+}
+
 Error _set_desc(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -564,6 +1053,28 @@ Error _set_desc(Ref<Scene> scene, const std::string& arg)
     return scene->set_description(arg);
 }
 
+Error _set_engine(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    if (!Backend::parse(arg, scene->engine)) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    L_INFO("Simulations run on the %s backend.",
+        to_str<Backend::Type>(scene->engine));
+    return Error::OK;
+}
+
+Error _set_native(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    if (Error err = as(arg, scene->is_native); err != Error::OK) {
+        return err;
+    }
+    L_INFO("Compiled netlists run on the %s.",
+        scene->is_native ? "native code" : "interpreter");
+    return Error::OK;
+}
+
 Error _set_name(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -602,12 +1113,33 @@ Error _show_node(Ref<Scene> scene, const std::string& arg)
     case Node::GATE: print_node(node, scene->get_node<Gate>(node)); break;
     case Node::INPUT: print_node(node, scene->get_node<Input>(node)); break;
     case Node::OUTPUT: print_node(node, scene->get_node<Output>(node)); break;
+    case Node::SEQUENTIAL:
+        print_node(node, scene->get_node<Sequential>(node));
+        break;
+    case Node::LUT: print_node(node, scene->get_node<Lut>(node)); break;
+    case Node::MEMORY: print_node(node, scene->get_node<Memory>(node)); break;
     default: break;
     }
 
     return Error::OK;
 }
 
+Error _step(Ref<Scene> scene, const std::string& arg)
+{
+    expect_scene(scene);
+    int ticks = 1;
+    if (Error err = as(arg, ticks, false); err != Error ::OK) {
+        return err;
+    }
+    if (ticks <= 0) {
+        return ERROR(Error::INVALID_ARGUMENT);
+    }
+    size_t events = scene->step(ticks, scene->event_budget);
+    L_INFO("Delivered %zu events. Time: %llu ticks.", events,
+        static_cast<unsigned long long>(scene->tick()));
+    return Error::OK;
+}
+
 Error _toggle(Ref<Scene> scene, const std::string& arg)
 {
     expect_scene(scene);
@@ -631,7 +1163,7 @@ Error _exit(Ref<Scene>, const std::string&)
     return Error::OK;
 }
 
-std::array<Command, 35> root {
+std::array<Command, 55> root {
     Command {
         "add component", "Add a component to the scene.", _add_component, STR },
     { "add gate AND", "Add an AND gate.", _add_gate_and, INT, true },
@@ -642,33 +1174,70 @@ std::array<Command, 35> root {
     { "add gate XNOR", "Add an XNOR gate.", _add_gate_xnor, INT, true },
     { "add gate XOR", "Add an XOR gate.", _add_gate_xor, INT, true },
     { "add input", "Add an input.", _add_input, BOOL, true },
+    { "add lut", "Add a lookup table with a binary truth table.", _add_lut,
+        STR },
+    { "add memory", "Add a ROM or RAM block.", _add_memory, STR },
     { "add output", "Add an output.", _add_output },
+    { "add sequential", "Add a flip-flop, latch or register.",
+        _add_sequential, STR },
     { "add timer", "Add a timer.", _add_timer, INT, true },
     { "close", "Close the existing scene.", _close },
+    { "collapse", "Replace the given gates with a lookup table.", _collapse,
+        STR },
     { "connect", "Connect two nodes.", _connect, NODE_INT_NODE_INT },
     { "disconnect", "Severe a connection.", _disconnect, INT },
+    { "equiv", "Compare a scene with the active scene or another scene.",
+        _equiv, STR },
     { "exit ", "Exit the shell.", _exit },
+    { "export cpp", "Write the active scene as a C++ function.", _export_cpp,
+        STR },
+    { "export netlist",
+        "Write the active scene as a BLIF or Verilog netlist by extension.",
+        _export_netlist, STR },
+    { "faults", "Report stuck-at fault coverage of the test vectors in a file.",
+        _faults, STR },
     { "help", "Display information about the shell.", _help },
+    { "import", "Open a Verilog or BLIF netlist as a new scene.", _import,
+        STR },
     { "include ", "Import a dependency to the active scene.", _include, STR },
+    { "install", "Store the active component in the package library.",
+        _install },
     { "list component", "List all components.", _list_component },
     { "list gate", "List all logic gates.", _list_gate },
     { "list input", "List all inputs and timers.", _list_input },
+    { "list lut", "List all lookup tables.", _list_lut },
+    { "list memory", "List all memory blocks.", _list_memory },
     { "list output", "List all outputs.", _list_output },
+    { "list package", "List all packages of the library.", _list_package },
     { "list rel", "List all conections.", _list_rel },
+    { "list sequential", "List all flip-flops, latches and registers.",
+        _list_sequential },
     { "list", "List all objects.", _list_all },
+    { "load memory", "Load a .hex or binary file into a memory block.",
+        _load_memory, STR },
     { "Move", "Move selected node in x y coordinates.", _move, NODE_INT_INT },
     { "new", "Create a new scene.", _new, STR, true },
     { "open", "Open a saved scene.", _open, STR },
+    { "optimize", "Report the size of the optimized netlist and AIG.",
+        _optimize },
     { "remove", "Delete selected node.", _remove, NODE },
     { "save as", "Save active scene to new path.", _save_as, STR },
     { "save", "Save existing scene.", _save },
     { "set author", "Set author of the scene.", _set_author, STR },
+    { "set delay", "Set delay of a gate type or a gate.", _set_delay, STR },
     { "set desc", "Set description of the scene.", _set_desc, STR },
+    { "set engine",
+        "Set the simulation backend: event, recursive, levelized or "
+        "bit-parallel.",
+        _set_engine, STR },
     { "set name", "Set name of the scene.", _set_name, STR },
+    { "set native", "Run compiled netlists as native code.", _set_native,
+        BOOL },
     { "show rel", "Display information about selected connection.", _show_rel,
         INT },
     { "show node", "Display information about selected node.", _show_node,
         NODE },
+    { "step", "Advance the simulation clock.", _step, INT, true },
     { "toggle", "Toggle selected node.", _toggle, NODE },
 };
 
@@ -13,6 +13,7 @@
 
 #include <array>
 #include <cstdint>
+#include <cstdio>
 #include <cstring>
 #include <filesystem>
 #include <functional>
@@ -268,6 +269,43 @@ namespace fs {
     bool read(
         const std::filesystem::path& path, std::vector<unsigned char>& data);
 
+    /**
+     * Read only memory mapping of a file. Parsing straight from the mapping
+     * avoids holding a second copy of large files in memory. The mapping is
+     * released when the object is destroyed or closed.
+     */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(MappedFile&&);
+        MappedFile& operator=(MappedFile&&);
+        MappedFile(const MappedFile&)            = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        /**
+         * Maps the given file and hints the kernel that it will be read
+         * sequentially. Any previous mapping is released.
+         * @param path to map
+         * @returns whether mapping is successful, empty files can not be
+         * mapped
+         */
+        bool open(const std::filesystem::path& path);
+
+        /** Releases the mapping. */
+        void close(void);
+
+        const uint8_t* data(void) const { return _data; }
+        size_t size(void) const { return _size; }
+
+    private:
+        const uint8_t* _data = nullptr;
+        size_t _size         = 0;
+#ifdef _WIN32
+        void* _mapping = nullptr;
+#endif
+    };
+
     /**
      * Write contents of data to the desired path.
      * @param path to save
@@ -285,6 +323,45 @@ namespace fs {
     bool write(
         const std::filesystem::path& path, std::vector<unsigned char>& data);
 
+    /**
+     * Creates a name next to the given path that no other process or thread
+     * uses, to build a file in before it replaces the target.
+     * @param path to replace
+     * @returns the temporary path
+     */
+    std::filesystem::path temp_path(const std::filesystem::path& path);
+
+    /**
+     * Writes a file through a temporary file from fs::temp_path, which is
+     * flushed to the disk and then moved over the target. Readers see either
+     * the old or the new file, even when several processes write it at once.
+     * @param path to save
+     * @param fn writes the contents to the given file, returns whether it
+     * succeeded
+     * @returns Whether the operation is successful or not
+     */
+    bool write_atomic(const std::filesystem::path& path,
+        const std::function<bool(std::FILE*)>& fn);
+
+    /**
+     * Writes contents of data to the desired path with fs::write_atomic.
+     * @param path to save
+     * @param data to save
+     * @returns Whether the operation is successful or not
+     */
+    bool write_atomic(
+        const std::filesystem::path& path, const std::string& data);
+
+    /**
+     * Writes contents of data to the desired path with fs::write_atomic.
+     * Used for binary files.
+     * @param path to save
+     * @param data to save
+     * @returns Whether the operation is successful or not
+     */
+    bool write_atomic(const std::filesystem::path& path,
+        const std::vector<unsigned char>& data);
+
 } // namespace fs
 
 namespace net {
@@ -357,3 +434,47 @@ std::vector<std::string> split(std::string& s, const std::string& delimiter);
 std::vector<std::string> split(std::string& s, const char delimiter);
 std::string base64_encode(const std::string& input);
 std::string base64_decode(const std::string& input);
+/**
+ * Non-cryptographic 64-bit hash, stable across platforms. Used as a cache
+ * key, not for integrity against tampering.
+ */
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * Computes hash64 of data that arrives in pieces, e.g. while it is streamed
+ * to a file. The total size seeds the hash, so it has to be known up front.
+ */
+class Hash64 {
+public:
+    explicit Hash64(size_t size, uint64_t seed = 0);
+    void update(const void* data, size_t size);
+    /** Returns the hash once all of the data is passed to update. */
+    uint64_t digest(void) const;
+
+private:
+    uint64_t _h;
+    uint64_t _word = 0;
+    size_t _word_s = 0;
+};
+
+/**
+ * Compresses data into a single block of the LZ4 block format. Fast rather
+ * than small, incompressible data grows by less than 1%.
+ * @param data to compress
+ * @param size of the data in bytes
+ * @param out to append the block to
+ * @returns size of the block in bytes
+ */
+size_t lz4_compress(
+    const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+/**
+ * Decompresses a block of the LZ4 block format.
+ * @param data block to decompress
+ * @param size of the block in bytes
+ * @param out to write the bytes into
+ * @param out_s number of bytes the block decompresses into
+ * @returns false if the block is malformed or of another size
+ */
+bool lz4_decompress(
+    const uint8_t* data, size_t size, uint8_t* out, size_t out_s);
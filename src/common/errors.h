@@ -90,6 +90,25 @@ enum Error {
     NFD,
     /** Error while updating the locale. */
     LOCALE_ERROR,
+    /** Selected nodes can not be replaced with a lookup table. */
+    NOT_COLLAPSIBLE,
+    /** Scene contains state or loops that can not be compiled to a netlist. */
+    NOT_COMBINATIONAL,
+    /** Compared scenes do not have the same number of inputs and outputs. */
+    IO_MISMATCH,
+    /** No C++ compiler is available to build native code. */
+    COMPILER_NOT_FOUND,
+    /** Generated code could not be compiled or loaded. */
+    NATIVE_BUILD_FAILED,
+    /** Cross checked simulation backends produced different outputs. */
+    DIVERGENCE,
+    /** Checksum of a scene document does not match its contents. */
+    CHECKSUM_MISMATCH,
+    /** Netlist file uses a construct that is not supported, or a scene has
+       nodes that can not be written to a netlist file. */
+    UNSUPPORTED_NETLIST,
+    /** Package index exists but can not be read. */
+    DAMAGED_INDEX,
     /** Represents the how many types of error codes exists. Not a valid error
        code.*/
     ERROR_S
@@ -146,8 +165,22 @@ constexpr const char* errmsg(Error e)
     case UNTERMINATED_FLOW: return "Already active flow.";
     case NFD: return "NFD Eror.";
     case LOCALE_ERROR: return "Error while updating the locale.";
+    case NOT_COLLAPSIBLE:
+        return "Selected nodes can not be replaced with a lookup table.";
+    case NOT_COMBINATIONAL:
+        return "Scene contains state or loops that can not be compiled.";
+    case IO_MISMATCH:
+        return "Scenes do not have the same number of inputs and outputs.";
+    case COMPILER_NOT_FOUND: return "No C++ compiler was found.";
+    case NATIVE_BUILD_FAILED:
+        return "Generated code could not be compiled or loaded.";
+    case DIVERGENCE: return "Simulation backends produced different outputs.";
+    case CHECKSUM_MISMATCH: return "Scene document is corrupted.";
+    case UNSUPPORTED_NETLIST: return "Netlist is not supported.";
+    case DAMAGED_INDEX: return "Package index is damaged.";
 
-    case ERROR_S: return "Unknown Error.";
+    case ERROR_S: break;
     }
+    return "Unknown Error.";
 };
 } // namespace ic
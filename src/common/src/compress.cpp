@@ -0,0 +1,156 @@
+#include <array>
+#include <cstring>
+#include "common.h"
+
+/**
+ * Blocks follow the LZ4 block format, a sequence is a token with the literal
+ * length in the high and the match length - 4 in the low nibble, the length
+ * bytes of the literals, the literals, a 16-bit offset (little endian) and
+ * the length bytes of the match. The last sequence only has literals.
+ */
+static constexpr size_t MIN_MATCH     = 4;
+static constexpr size_t LAST_LITERALS = 5;
+/** A match can not start within the last bytes of the block. */
+static constexpr size_t MATCH_LIMIT = 12;
+static constexpr size_t MAX_OFFSET  = 0xFFFF;
+static constexpr size_t HASH_BITS   = 12;
+
+static inline uint32_t _read32(const uint8_t* data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static inline uint32_t _hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static void _push_length(std::vector<uint8_t>& out, size_t length)
+{
+    while (length >= 0xFF) {
+        out.push_back(0xFF);
+        length -= 0xFF;
+    }
+    out.push_back(static_cast<uint8_t>(length));
+}
+
+static void _push_sequence(std::vector<uint8_t>& out, const uint8_t* literals,
+    size_t literal_s, size_t offset, size_t match_s)
+{
+    size_t match_code = match_s - MIN_MATCH;
+    out.push_back(std::min<size_t>(literal_s, 0xF) << 4
+        | std::min<size_t>(match_code, 0xF));
+    if (literal_s >= 0xF) {
+        _push_length(out, literal_s - 0xF);
+    }
+    out.insert(out.end(), literals, literals + literal_s);
+    out.push_back(static_cast<uint8_t>(offset));
+    out.push_back(static_cast<uint8_t>(offset >> 8));
+    if (match_code >= 0xF) {
+        _push_length(out, match_code - 0xF);
+    }
+}
+
+size_t lz4_compress(
+    const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    size_t begin  = out.size();
+    size_t anchor = 0;
+    if (size > MATCH_LIMIT) {
+        // Positions are stored off by one, so zero marks an empty slot.
+        std::array<uint32_t, 1 << HASH_BITS> table {};
+        size_t limit = size - MATCH_LIMIT;
+        size_t i     = 0;
+        size_t miss  = 0;
+        while (i < limit) {
+            uint32_t sequence = _read32(data + i);
+            uint32_t& slot    = table[_hash(sequence)];
+            size_t ref        = slot;
+            slot              = i + 1;
+            if (ref == 0 || i - (ref - 1) > MAX_OFFSET
+                || _read32(data + ref - 1) != sequence) {
+                // Skip faster through data that does not compress.
+                i += 1 + (miss++ >> 6);
+                continue;
+            }
+            ref--;
+            size_t match_s = MIN_MATCH;
+            size_t max     = size - LAST_LITERALS - i;
+            while (match_s < max && data[ref + match_s] == data[i + match_s]) {
+                match_s++;
+            }
+            _push_sequence(out, data + anchor, i - anchor, i - ref, match_s);
+            i += match_s;
+            anchor = i;
+            miss   = 0;
+        }
+    }
+    size_t literal_s = size - anchor;
+    out.push_back(std::min<size_t>(literal_s, 0xF) << 4);
+    if (literal_s >= 0xF) {
+        _push_length(out, literal_s - 0xF);
+    }
+    out.insert(out.end(), data + anchor, data + size);
+    return out.size() - begin;
+}
+
+static bool _pop_length(
+    const uint8_t*& data, const uint8_t* end, size_t& length)
+{
+    uint8_t byte = 0xFF;
+    while (byte == 0xFF) {
+        if (data == end) {
+            return false;
+        }
+        byte   = *data++;
+        length += byte;
+    }
+    return true;
+}
+
+bool lz4_decompress(
+    const uint8_t* data, size_t size, uint8_t* out, size_t out_s)
+{
+    const uint8_t* end = data + size;
+    size_t written     = 0;
+    while (data < end) {
+        uint8_t token    = *data++;
+        size_t literal_s = token >> 4;
+        if (literal_s == 0xF && !_pop_length(data, end, literal_s)) {
+            return false;
+        }
+        if (literal_s > static_cast<size_t>(end - data)
+            || literal_s > out_s - written) {
+            return false;
+        }
+        std::memcpy(out + written, data, literal_s);
+        data    += literal_s;
+        written += literal_s;
+        if (data == end) {
+            break;
+        } else if (end - data < 2) {
+            return false;
+        }
+        size_t offset  = data[0] | data[1] << 8;
+        size_t match_s = token & 0xF;
+        data += 2;
+        if (match_s == 0xF && !_pop_length(data, end, match_s)) {
+            return false;
+        }
+        match_s += MIN_MATCH;
+        if (offset == 0 || offset > written || match_s > out_s - written) {
+            return false;
+        }
+        // Matches may overlap the bytes they produce, so they are copied in
+        // order.
+        uint8_t* dst       = out + written;
+        const uint8_t* src = dst - offset;
+        for (size_t i = 0; i < match_s; i++) {
+            dst[i] = src[i];
+        }
+        written += match_s;
+    }
+    return written == out_s;
+}
@@ -1,10 +1,20 @@
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <mutex>
+#include <random>
 #include "common.h"
 
+#if defined(_WIN32)
+#include <io.h>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace ic {
 static std::chrono::time_point<std::chrono::steady_clock> app_start_time;
 namespace fs {
@@ -141,6 +151,90 @@ namespace fs {
         return false;
     }
 
+    std::filesystem::path temp_path(const std::filesystem::path& path)
+    {
+        // The pid separates processes, the counter separates threads, and
+        // the random part separates a process from an earlier one that
+        // had the same pid and left its file behind.
+        static const uint32_t seed = std::random_device {}();
+        static std::atomic<uint32_t> counter { 0 };
+#if defined(_WIN32)
+        unsigned long long pid = _getpid();
+#else
+        unsigned long long pid = getpid();
+#endif
+        char suffix[64];
+        snprintf(suffix, sizeof(suffix), ".%llu-%08x-%u.tmp", pid, seed,
+            counter.fetch_add(1));
+        std::filesystem::path tmp_path = path;
+        tmp_path += suffix;
+        return tmp_path;
+    }
+
+    bool write_atomic(const std::filesystem::path& path,
+        const std::function<bool(std::FILE*)>& fn)
+    {
+        std::error_code ec;
+        if (path.has_parent_path()) {
+            std::filesystem::create_directories(path.parent_path(), ec);
+        }
+        std::filesystem::path tmp_path = temp_path(path);
+#if defined(_WIN32)
+        std::FILE* file = _wfopen(tmp_path.c_str(), L"wb");
+#else
+        std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+#endif
+        if (file == nullptr) {
+            L_ERROR("Failed to open file for writing %s.",
+                tmp_path.string().c_str());
+            return false;
+        }
+        bool is_written = fn(file) && std::fflush(file) == 0;
+#if defined(_WIN32)
+        is_written = is_written && _commit(_fileno(file)) == 0;
+#else
+        is_written = is_written && fsync(fileno(file)) == 0;
+#endif
+        is_written = std::fclose(file) == 0 && is_written;
+        if (is_written) {
+            std::filesystem::rename(tmp_path, path, ec);
+        }
+        if (!is_written || ec) {
+            L_ERROR("Failed to write %s.", path.string().c_str());
+            std::filesystem::remove(tmp_path, ec);
+            return false;
+        }
+#if !defined(_WIN32)
+        // Persist the rename itself.
+        int dir = ::open(
+            path.has_parent_path() ? path.parent_path().c_str() : ".",
+            O_RDONLY | O_CLOEXEC);
+        if (dir >= 0) {
+            fsync(dir);
+            ::close(dir);
+        }
+#endif
+        return true;
+    }
+
+    bool write_atomic(
+        const std::filesystem::path& path, const std::string& data)
+    {
+        return write_atomic(path, [&](std::FILE* file) {
+            return std::fwrite(data.data(), 1, data.size(), file)
+                == data.size();
+        });
+    }
+
+    bool write_atomic(const std::filesystem::path& path,
+        const std::vector<unsigned char>& data)
+    {
+        return write_atomic(path, [&](std::FILE* file) {
+            return std::fwrite(data.data(), 1, data.size(), file)
+                == data.size();
+        });
+    }
+
     bool read(const std::filesystem::path& path, std::string& data)
     {
         std::ifstream infile { path };
@@ -153,11 +247,15 @@ namespace fs {
     bool read(
         const std::filesystem::path& path, std::vector<unsigned char>& data)
     {
-        std::ifstream infile { path, std::ios::binary };
-        std::vector<unsigned char> buffer(
-            std::istreambuf_iterator<char>(infile), {});
-        data = std::move(buffer);
-        return !data.empty();
+        std::ifstream infile { path, std::ios::binary | std::ios::ate };
+        if (!infile) {
+            data.clear();
+            return false;
+        }
+        data.resize(static_cast<size_t>(infile.tellg()));
+        infile.seekg(0);
+        infile.read(reinterpret_cast<char*>(data.data()), data.size());
+        return infile && !data.empty();
     }
 
 #include "po.h"
@@ -320,10 +418,11 @@ void Message::_set_time(void)
 void Message::_fn_parse(const char* name)
 {
     static std::map<const char*, std::string> line_cache {};
-    if (const auto& p = line_cache.find(name); p != line_cache.end()) {
-        std::strncpy(module.data(), p->second.data(),
-            std::min(module.max_size() - 1, p->second.size()));
-    } else {
+    // Messages are created on any thread.
+    static std::mutex line_cache_mtx;
+    std::lock_guard<std::mutex> lock(line_cache_mtx);
+    auto p = line_cache.find(name);
+    if (p == line_cache.end()) {
         std::string fnname { name };
         if (fnname.find("lambda") == std::string::npos) {
             size_t fn_end   = fnname.find_first_of('(');
@@ -338,12 +437,13 @@ void Message::_fn_parse(const char* name)
             if (second_last_ns != std::string::npos) {
                 fn_begin = second_last_ns;
             }
-            line_cache[name] = fnname.substr(fn_begin);
+            p = line_cache.emplace(name, fnname.substr(fn_begin)).first;
         } else {
-            line_cache[name] = "ImCircuit";
+            p = line_cache.emplace(name, "ImCircuit").first;
         }
-        _fn_parse(name);
     }
+    std::strncpy(module.data(), p->second.data(),
+        std::min(module.max_size() - 1, p->second.size()));
 }
 
 } // namespace ic
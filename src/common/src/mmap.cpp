@@ -0,0 +1,103 @@
+#include "common.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ic::fs {
+
+MappedFile::MappedFile(MappedFile&& other) { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other)
+{
+    if (this != &other) {
+        close();
+        std::swap(_data, other._data);
+        std::swap(_size, other._size);
+#ifdef _WIN32
+        std::swap(_mapping, other._mapping);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::filesystem::path& path)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        L_ERROR("Failed to open %s.", path.string().c_str());
+        return false;
+    }
+    LARGE_INTEGER size {};
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping
+        = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        L_ERROR("Failed to map %s.", path.string().c_str());
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        L_ERROR("Failed to map %s.", path.string().c_str());
+        return false;
+    }
+    _mapping = mapping;
+    _data    = static_cast<const uint8_t*>(view);
+    _size    = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        L_ERROR("Failed to open %s.", path.c_str());
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file.
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        L_ERROR("Failed to map %s.", path.c_str());
+        return false;
+    }
+    madvise(view, st.st_size, MADV_SEQUENTIAL);
+    _data = static_cast<const uint8_t*>(view);
+    _size = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
+
+void MappedFile::close(void)
+{
+    if (_data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(_data);
+    CloseHandle(_mapping);
+    _mapping = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(_data), _size);
+#endif
+    _data = nullptr;
+    _size = 0;
+}
+
+} // namespace ic::fs
@@ -95,3 +95,52 @@ std::string base64_decode(const std::string& input)
 
     return output;
 }
+
+static inline uint64_t _mix64(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    return h ^ (h >> 33);
+}
+
+Hash64::Hash64(size_t size, uint64_t seed)
+    : _h { seed ^ (size * 0x9E3779B97F4A7C15ULL) }
+{
+}
+
+void Hash64::update(const void* data, size_t size)
+{
+    // Words are read byte by byte so that the result does not depend on the
+    // endianness or alignment.
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    size_t i         = 0;
+    for (; i < size && _word_s != 0; i++) {
+        _word |= static_cast<uint64_t>(p[i]) << (8 * _word_s);
+        if (++_word_s == 8) {
+            _h      = (_h ^ _mix64(_word)) * 0x9E3779B97F4A7C15ULL;
+            _word   = 0;
+            _word_s = 0;
+        }
+    }
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word = 0;
+        for (size_t j = 0; j < 8; j++) {
+            word |= static_cast<uint64_t>(p[i + j]) << (8 * j);
+        }
+        _h = (_h ^ _mix64(word)) * 0x9E3779B97F4A7C15ULL;
+    }
+    for (; i < size; i++) {
+        _word |= static_cast<uint64_t>(p[i]) << (8 * _word_s++);
+    }
+}
+
+uint64_t Hash64::digest(void) const { return _mix64(_h ^ _mix64(_word)); }
+
+uint64_t hash64(const void* data, size_t size, uint64_t seed)
+{
+    Hash64 h { size, seed };
+    h.update(data, size);
+    return h.digest();
+}
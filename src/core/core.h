@@ -13,10 +13,16 @@
 #include <array>
 #include <bitset>
 #include <cstdint>
+#include <cstdio>
+#include <deque>
 #include <filesystem>
+#include <fstream>
 #include <map>
+#include <memory>
 #include <optional>
 #include <stack>
+#include <unordered_map>
+#include <unordered_set>
 #include "common.h"
 
 namespace ic {
@@ -49,6 +55,12 @@ struct Node {
         /** Output slot of a component. NOTE: Only available in Component
            Scenes. */
         COMPONENT_OUTPUT,
+        /** A flip-flop, latch or register. */
+        SEQUENTIAL,
+        /** A lookup table with up to Lut::MAX_INPUT inputs. */
+        LUT,
+        /** A ROM or RAM block. */
+        MEMORY,
 
         NODE_S
     };
@@ -65,6 +77,12 @@ struct Node {
     bool operator<(const Node& n) const { return this->index < n.index; }
 
     inline uint32_t numeric(void) const { return index | (type << 16); }
+    /** Inverse of Node::numeric. */
+    static inline Node from_numeric(uint32_t n)
+    {
+        return Node { static_cast<uint16_t>(n & 0xFFFF),
+            static_cast<Node::Type>((n >> 16) & 0x0F) };
+    }
 
     uint16_t index : 16;
     Type type : 4;
@@ -187,7 +205,10 @@ struct Rel {
 /** Describes a single logic gate. */
 class Gate final : public BaseNode {
 public:
-    enum Type : uint8_t { NOT, AND, OR, XOR, NAND, NOR, XNOR };
+    enum Type : uint8_t { NOT, AND, OR, XOR, NAND, NOR, XNOR, TYPE_S };
+    /** Gate::delay value that defers to the scene's per-type delay. */
+    static constexpr uint16_t INHERIT_DELAY = UINT16_MAX;
+
     Gate(Scene*, Type type = Type::AND, sockid max_in = 2);
     Gate(const Gate&)            = default;
     Gate(Gate&&)                 = default;
@@ -202,6 +223,21 @@ public:
     /** Removes an input socket. */
     bool decrement(void);
 
+    /**
+     * Propagation delay of the gate in ticks. Returns the instance override
+     * if one is set, the scene's delay for the gate type otherwise.
+     */
+    uint16_t delay(void) const;
+    /** Whether the gate overrides the scene's delay for its type. */
+    bool has_delay(void) const { return _delay != INHERIT_DELAY; }
+    /**
+     * Overrides the propagation delay of this gate.
+     * @param delay in ticks, Gate::INHERIT_DELAY to use the scene default
+     */
+    void set_delay(uint16_t delay);
+    /** Applies the gate function to the given input values. */
+    bool evaluate(const std::vector<bool>& in) const;
+
     /* BaseNode */
     virtual bool is_connected(void) const override;
     virtual State get(sockid slot = 0) const override;
@@ -217,6 +253,7 @@ private:
     /** Gate specific calculation function */
     Type _type;
     State _value;
+    uint16_t _delay = INHERIT_DELAY;
 };
 
 class Component final : public BaseNode {
@@ -323,6 +360,219 @@ private:
     State _value = State::DISABLED;
 };
 
+/**
+ * A memory element that is evaluated natively instead of being built from
+ * gates with feedback. Sockets are laid out as follows:
+ *
+ * | Type        | Inputs                  | Outputs       |
+ * |-------------|-------------------------|---------------|
+ * | D_FLIPFLOP  | D, CLK, EN, RST         | Q, !Q         |
+ * | JK_FLIPFLOP | J, K, CLK, EN, RST      | Q, !Q         |
+ * | SR_LATCH    | S, R                    | Q, !Q         |
+ * | D_LATCH     | D, EN, RST              | Q, !Q         |
+ * | REGISTER    | D0..Dn, CLK, EN, RST    | Q0..Qn        |
+ *
+ * Flip-flops and registers capture on the rising edge of CLK. EN and RST are
+ * optional, an unconnected EN is enabled and an unconnected RST is inactive.
+ * RST clears the state asynchronously.
+ */
+class Sequential final : public BaseNode {
+public:
+    enum Type : uint8_t {
+        D_FLIPFLOP,
+        JK_FLIPFLOP,
+        SR_LATCH,
+        D_LATCH,
+        REGISTER,
+        TYPE_S
+    };
+    /** Socket id of a control input the type does not have. */
+    static constexpr sockid NO_SOCK = UINT8_MAX;
+    /** Maximum number of bits of a register. */
+    static constexpr sockid MAX_WIDTH = 32;
+
+    Sequential(Scene*, Type type = Type::D_FLIPFLOP, sockid width = 1);
+    Sequential(const Sequential&)            = default;
+    Sequential(Sequential&&)                 = default;
+    Sequential& operator=(Sequential&&)      = default;
+    Sequential& operator=(const Sequential&) = default;
+    ~Sequential()                            = default;
+
+    Type type(void) const { return _type; }
+    /** Number of stored bits, only registers have more than one. */
+    sockid width(void) const { return _width; }
+    /** Whether the state only changes on a clock edge. */
+    bool is_clocked(void) const;
+    /** Socket of the clock, or the enable of a D latch. */
+    sockid clock(void) const;
+    /** Socket of the optional enable input. */
+    sockid enable(void) const;
+    /** Socket of the optional asynchronous reset input. */
+    sockid reset(void) const;
+
+    /** Stored value, bit i is the Q output of the ith bit. */
+    uint64_t value(void) const { return _value; }
+    /** Overwrites the stored value and notifies connected nodes. */
+    void set_value(uint64_t value);
+
+    /* BaseNode */
+    virtual bool is_connected(void) const override;
+    virtual State get(sockid slot = 0) const override;
+    virtual void on_signal(void) override;
+    virtual void clean(void) override;
+
+    std::vector<relid> inputs;
+    std::map<sockid, std::vector<relid>> outputs;
+
+private:
+    /** Value of an input socket, unconnected sockets are DISABLED. */
+    State _input(sockid sock) const;
+    /** Signals the outputs whose relations are out of date. */
+    void _notify(void);
+
+    Type _type;
+    sockid _width;
+    uint64_t _value = 0;
+    /** Clock level during the last evaluation. */
+    State _clock = DISABLED;
+    bool _is_disabled = true;
+};
+
+/**
+ * A k-input lookup table that evaluates an arbitrary logic function with a
+ * single indexed read. Input i is bit i of the index, so the output for the
+ * inputs (x0, x1, ..., xk) is the table bit at x0 + 2*x1 + ... + 2^k*xk.
+ * A Lut without inputs is a constant, the first bit of its table.
+ */
+class Lut final : public BaseNode {
+public:
+    /** Maximum number of inputs. */
+    static constexpr sockid MAX_INPUT = 8;
+    /** Truth table, only the first 2^k bits are used. */
+    using Table = std::bitset<1 << MAX_INPUT>;
+
+    Lut(Scene*, sockid input_s = 2, const Table& table = {});
+    Lut(const Lut&)            = default;
+    Lut(Lut&&)                 = default;
+    Lut& operator=(Lut&&)      = default;
+    Lut& operator=(const Lut&) = default;
+    ~Lut()                     = default;
+
+    inline const Table& table(void) const { return _table; }
+    /** Replaces the truth table and re-evaluates the output. */
+    void set_table(const Table& table);
+    /** Output for the given input index. */
+    inline bool lookup(uint32_t index) const { return _table[index]; }
+
+    /* BaseNode */
+    virtual bool is_connected(void) const override;
+    virtual State get(sockid slot = 0) const override;
+    virtual void on_signal(void) override;
+    virtual void clean(void) override;
+
+    std::vector<relid> inputs;
+    std::vector<relid> output;
+
+private:
+    Table _table;
+    State _value = DISABLED;
+};
+
+/**
+ * A ROM or RAM block backed by a contiguous buffer, where each word takes
+ * Memory::word_s bytes in little-endian order. Sockets are laid out as
+ * follows:
+ *
+ * | Type | Inputs                   | Outputs |
+ * |------|--------------------------|---------|
+ * | ROM  | A0..An                   | Q0..Qm  |
+ * | RAM  | A0..An, D0..Dm, WE, CLK  | Q0..Qm  |
+ *
+ * Reads are asynchronous, Q always shows the word at the address. A RAM
+ * writes D on the rising edge of CLK while WE is set.
+ */
+class Memory final : public BaseNode {
+public:
+    enum Type : uint8_t { ROM, RAM, TYPE_S };
+    /** Maximum number of address bits. */
+    static constexpr sockid MAX_ADDRESS = 16;
+    /** Maximum number of data bits. */
+    static constexpr sockid MAX_DATA = 32;
+
+    Memory(Scene*, Type type = Type::ROM, sockid address_s = 8,
+        sockid data_s = 8);
+    Memory(const Memory&)            = default;
+    Memory(Memory&&)                 = default;
+    Memory& operator=(Memory&&)      = default;
+    Memory& operator=(const Memory&) = default;
+    ~Memory()                        = default;
+
+    Type type(void) const { return _type; }
+    sockid address_s(void) const { return _address_s; }
+    sockid data_s(void) const { return _data_s; }
+    /** Number of bytes a word is stored in. */
+    size_t word_s(void) const { return (_data_s + 7) / 8; }
+    /** Number of words. */
+    size_t size(void) const { return size_t { 1 } << _address_s; }
+    /** Socket of the write enable input of a RAM. */
+    sockid write_enable(void) const { return _address_s + _data_s; }
+    /** Socket of the clock input of a RAM. */
+    sockid clock(void) const { return _address_s + _data_s + 1; }
+
+    /** Backing buffer of size() * word_s() bytes. */
+    inline const std::vector<uint8_t>& data(void) const { return _data; }
+    uint32_t read(uint32_t address) const;
+    void write(uint32_t address, uint32_t value);
+
+    /**
+     * Overwrites the contents from a raw buffer in the layout of
+     * Memory::data. Missing bytes are cleared, extra bytes are ignored.
+     */
+    void load(const std::vector<uint8_t>& raw);
+    /**
+     * Overwrites the contents from whitespace separated hexadecimal words.
+     * "@<address>" moves the cursor and "//" starts a comment, as in
+     * Verilog's $readmemh.
+     * @returns Error on failure:
+     *
+     * - Error::INVALID_ARGUMENT
+     */
+    LCS_ERROR load_hex(const std::string& text);
+    /**
+     * Loads a ".hex" text file with Memory::load_hex, any other file as a
+     * raw binary with Memory::load.
+     * @returns Error on failure:
+     *
+     * - Error::NOT_FOUND
+     * - Error::INVALID_ARGUMENT
+     */
+    LCS_ERROR load_file(const std::filesystem::path& path);
+
+    /* BaseNode */
+    virtual bool is_connected(void) const override;
+    virtual State get(sockid slot = 0) const override;
+    virtual void on_signal(void) override;
+    virtual void clean(void) override;
+
+    std::vector<relid> inputs;
+    std::map<sockid, std::vector<relid>> outputs;
+
+private:
+    /** Value of an input socket, unconnected sockets are DISABLED. */
+    State _input(sockid sock) const;
+    /** Signals the outputs whose relations are out of date. */
+    void _notify(void);
+
+    Type _type;
+    sockid _address_s;
+    sockid _data_s;
+    std::vector<uint8_t> _data;
+    /** Address during the last evaluation. */
+    uint32_t _address = 0;
+    State _clock      = DISABLED;
+    bool _is_disabled = true;
+};
+
 /**
  * A component scene contains the ComponentContext, Component Context can
  * execute a scene with given parameters.
@@ -398,9 +648,916 @@ template <typename T> constexpr Node::Type as_node_type(void)
     if constexpr (std::is_same<T, Output>::value) {
         return Node::Type::OUTPUT;
     }
+    if constexpr (std::is_same<T, Sequential>::value) {
+        return Node::Type::SEQUENTIAL;
+    }
+    if constexpr (std::is_same<T, Lut>::value) {
+        return Node::Type::LUT;
+    }
+    if constexpr (std::is_same<T, Memory>::value) {
+        return Node::Type::MEMORY;
+    }
     return Node::Type::NODE_S;
 }
 
+/**
+ * A flattened, combinational form of a Scene that is evaluated in a single
+ * pass. Components are inlined and every Gate or Lut becomes a cell. Cells
+ * are stored in topological order, so the fanin of a cell always precedes
+ * it. The first two cells are the constants false and true.
+ *
+ * Signals are two-valued. A node that is not fully connected evaluates to
+ * false, which is how its DISABLED state is seen by the nodes it drives.
+ *
+ * Each net carries 64 independent patterns, one per bit, so a single
+ * Netlist::simulate call evaluates 64 input combinations.
+ */
+class Netlist {
+public:
+    enum Op : uint8_t {
+        CONST0,
+        CONST1,
+        /** Primary input, its value is assigned by the caller. */
+        INPUT,
+        BUF,
+        NOT,
+        AND,
+        OR,
+        XOR,
+        NAND,
+        NOR,
+        XNOR,
+        /** Lookup table, see Lut for the layout of the table. */
+        LUT,
+        OP_S
+    };
+    /** Index of the cell that drives a net. */
+    using netid = uint32_t;
+
+    struct Cell {
+        Op op;
+        /** Index of the truth table in Netlist::tables, LUT only. */
+        uint32_t table;
+        /** Position of the first fanin in Netlist::fanin. */
+        uint32_t first;
+        /** Number of fanins. */
+        uint32_t size;
+    };
+
+    /** Connects a scene node to a net of the netlist. */
+    struct Port {
+        Node node;
+        netid net;
+    };
+
+    /** Gate counts before and after Netlist::optimize. */
+    struct Stats {
+        size_t gates_before;
+        size_t gates_after;
+    };
+
+    Netlist(void);
+    Netlist(const Netlist&)            = default;
+    Netlist(Netlist&&)                 = default;
+    Netlist& operator=(Netlist&&)      = default;
+    Netlist& operator=(const Netlist&) = default;
+    ~Netlist()                         = default;
+
+    /**
+     * Replaces the netlist with the compiled form of the scene. A scene with
+     * a ComponentContext is compiled as a component, its component inputs
+     * and outputs become the ports and its Input nodes are constants.
+     * Otherwise Input and Output nodes are the ports. The scene is not
+     * modified.
+     * @param scene to compile
+     * @param keep_relations whether to fill Netlist::relations
+     * @returns Error on failure:
+     *
+     * - Error::NOT_COMBINATIONAL
+     * - Error::COMPONENT_NOT_FOUND
+     */
+    LCS_ERROR compile(const Scene& scene, bool keep_relations = false);
+
+    /**
+     * Shrinks the netlist without changing the function of its outputs.
+     * Constants are propagated, buffers and double inverters are removed,
+     * identical cells are merged and cells that do not reach an output are
+     * deleted. Ports keep their positions.
+     * @returns gate counts before and after the pass
+     */
+    Stats optimize(void);
+
+    /**
+     * Appends a cell as is. The fanin must already be in the netlist.
+     * @param op of the cell
+     * @param in fanin of the cell
+     * @param table index in Netlist::tables for LUT cells
+     * @returns net of the cell
+     */
+    netid add(Op op, const std::vector<netid>& in, uint32_t table = 0);
+
+    /** Number of cells other than constants and inputs. */
+    size_t gate_count(void) const;
+
+    /**
+     * Evaluates 64 patterns at once.
+     * @param in values of each input port, bit j belongs to pattern j
+     * @param out values of each output port
+     */
+    void simulate(const std::vector<uint64_t>& in, std::vector<uint64_t>& out);
+
+    /**
+     * Evaluates a single pattern, compatible with ComponentContext::run.
+     * @param input bit i is the value of input port i
+     * @returns bit i is the value of output port i
+     */
+    uint64_t run(uint64_t input);
+
+    /** Value of a net after the last simulation. */
+    inline uint64_t value(netid net) const { return _values[net]; }
+
+    /**
+     * Evaluates a single cell.
+     * @param net of the cell
+     * @param values of every net, only the fanin of the cell is read
+     * @returns value of the cell
+     */
+    uint64_t evaluate(netid net, const uint64_t* values) const;
+
+    /**
+     * Fills Netlist::truth_table with the outputs of every input pattern,
+     * after which Netlist::run is a single lookup.
+     * @returns whether the netlist has few enough inputs to be tabulated
+     */
+    bool tabulate(void);
+
+    /**
+     * Saves the netlist and its truth table as a compiled artifact that can
+     * be loaded instead of compiling the scene again.
+     * @param path to save
+     * @param key identifies the scene the netlist was compiled from
+     * @returns Error on failure:
+     *
+     * - Error::NO_SAVE_PATH_DEFINED
+     */
+    LCS_ERROR write_file(const std::filesystem::path& path, uint64_t key) const;
+
+    /**
+     * Loads a compiled artifact saved by Netlist::write_file.
+     * @param path to read from
+     * @param key the artifact is expected to be saved with
+     * @returns Error on failure:
+     *
+     * - Error::NOT_FOUND
+     * - Error::INVALID_FILE if the artifact belongs to another key, another
+     *   version or is damaged
+     */
+    LCS_ERROR read_file(const std::filesystem::path& path, uint64_t key);
+
+    /** Version of the artifacts, changes whenever the compiler, the
+     * optimizer or the layout of the artifact does. */
+    static constexpr uint8_t ARTIFACT_VERSION = 1;
+    /** Netlists with up to this many inputs are tabulated. */
+    static constexpr size_t TABULATE_S = 12;
+
+    std::vector<Cell> cells;
+    std::vector<netid> fanin;
+    std::vector<Lut::Table> tables;
+    std::vector<Port> inputs;
+    std::vector<Port> outputs;
+    /** BUF cell of each relation of the compiled scene, filled only when
+     * compiled with keep_relations and dropped by Netlist::optimize.
+     * Relations inside components are not included. */
+    std::map<relid, netid> relations;
+    /** Outputs of each input pattern, filled by Netlist::tabulate. */
+    std::vector<uint64_t> truth_table;
+
+private:
+    std::vector<uint64_t> _values;
+};
+
+/**
+ * A Netlist that is translated to straight-line C++, built into a shared
+ * library with the system compiler and loaded at run time. Until
+ * NativeNetlist::build succeeds, or when no compiler is available, the
+ * netlist is interpreted instead, so the results never depend on whether
+ * native code is in use.
+ */
+class NativeNetlist {
+public:
+    /**
+     * Signature of the generated function, evaluates 64 patterns at once.
+     * @param in values of each input port, bit j belongs to pattern j
+     * @param out values of each output port
+     */
+    using Fn = void (*)(const uint64_t* in, uint64_t* out);
+    /** Name of the generated function. */
+    static constexpr const char* SYMBOL = "ic_simulate";
+
+    NativeNetlist(Netlist&& netlist);
+    NativeNetlist(const NativeNetlist&)            = delete;
+    NativeNetlist(NativeNetlist&&)                 = default;
+    NativeNetlist& operator=(NativeNetlist&&)      = default;
+    NativeNetlist& operator=(const NativeNetlist&) = delete;
+    ~NativeNetlist()                               = default;
+
+    /**
+     * Translates a netlist to a C++ translation unit that defines
+     * NativeNetlist::SYMBOL with the NativeNetlist::Fn signature.
+     * @param netlist to translate
+     * @returns source code
+     */
+    static std::string generate(const Netlist& netlist);
+
+    /**
+     * Compiles the generated source with the compiler in the CXX environment
+     * variable, or c++ when it is not set, and loads it. The compiler must
+     * accept GCC style options. Libraries are kept
+     * in fs::CACHE by the hash of their source, so a netlist is only compiled
+     * once.
+     * @returns Error on failure:
+     *
+     * - Error::COMPILER_NOT_FOUND
+     * - Error::NATIVE_BUILD_FAILED
+     */
+    LCS_ERROR build(void);
+
+    /** Whether the native code is loaded. */
+    inline bool is_native(void) const { return _fn != nullptr; }
+
+    /** See Netlist::simulate. */
+    void simulate(const std::vector<uint64_t>& in, std::vector<uint64_t>& out);
+
+    /** See Netlist::run. */
+    uint64_t run(uint64_t input);
+
+    Netlist netlist;
+
+private:
+    struct Library {
+        void operator()(void* handle) const;
+    };
+
+    std::unique_ptr<void, Library> _library;
+    Fn _fn = nullptr;
+    std::vector<uint64_t> _in;
+    std::vector<uint64_t> _out;
+};
+
+/**
+ * And-Inverter Graph, a netlist where every gate is lowered to two-input AND
+ * nodes and inverters are complemented edges. A literal is a variable index
+ * shifted left by one, with the lowest bit set for the complement. Variable
+ * zero is the constant false, so literal 0 is false and literal 1 is true.
+ *
+ * AND nodes are structurally hashed, building the same AND twice returns the
+ * same literal. Variables are created in topological order, so simulation is
+ * a single pass over a flat array of literal pairs.
+ */
+class Aig {
+public:
+    /** Variable index and complement bit. */
+    using lit = uint32_t;
+    static constexpr lit LIT_FALSE = 0;
+    static constexpr lit LIT_TRUE  = 1;
+    /** Fanin of input variables. */
+    static constexpr lit LIT_INPUT = UINT32_MAX;
+
+    /** Fanin of a variable, both are LIT_INPUT for inputs. */
+    struct And {
+        lit left;
+        lit right;
+    };
+
+    /** Connects a scene node to a literal of the graph. */
+    struct Port {
+        Node node;
+        lit literal;
+    };
+
+    Aig(void);
+    Aig(const Aig&)            = default;
+    Aig(Aig&&)                 = default;
+    Aig& operator=(Aig&&)      = default;
+    Aig& operator=(const Aig&) = default;
+    ~Aig()                     = default;
+
+    /**
+     * Replaces the graph with the optimized netlist of the scene.
+     * @param scene to build from
+     * @returns Error on failure, see Netlist::compile
+     */
+    LCS_ERROR build(const Scene& scene);
+
+    /** Replaces the graph with the given netlist, keeping its ports. */
+    void build(const Netlist& netlist);
+
+    /**
+     * Adds the cells of a netlist on top of the existing graph.
+     * @param netlist to lower
+     * @param in literals of each input port of the netlist
+     * @returns literals of each output port of the netlist
+     */
+    std::vector<lit> lower(const Netlist& netlist, const std::vector<lit>& in);
+
+    /** Adds an input variable and returns its literal. */
+    lit add_input(Node node = {});
+    /** Marks a literal as an output. */
+    void add_output(Node node, lit literal);
+
+    lit make_and(lit a, lit b);
+    lit make_or(lit a, lit b);
+    lit make_xor(lit a, lit b);
+    /** Returns s ? t : e. */
+    lit make_mux(lit s, lit t, lit e);
+
+    static constexpr lit negate(lit l) { return l ^ 1; }
+    static constexpr uint32_t var(lit l) { return l >> 1; }
+    static constexpr bool is_complement(lit l) { return l & 1; }
+
+    /** Number of AND nodes. */
+    size_t and_count(void) const;
+
+    /**
+     * Evaluates 64 * words patterns at once. Each port uses `words`
+     * consecutive words, so input i of pattern j is bit j % 64 of
+     * in[i * words + j / 64].
+     * @param in values of each input port
+     * @param out values of each output port
+     * @param words number of 64-bit words per port
+     */
+    void simulate(const std::vector<uint64_t>& in, std::vector<uint64_t>& out,
+        size_t words = 1);
+
+    /**
+     * Evaluates a single pattern, compatible with ComponentContext::run.
+     * @param input bit i is the value of input port i
+     * @returns bit i is the value of output port i
+     */
+    uint64_t run(uint64_t input);
+
+    /** Fanin of each variable, variable zero is the constant. */
+    std::vector<And> nodes;
+    std::vector<Port> inputs;
+    std::vector<Port> outputs;
+
+private:
+    /** Maps the fanin pair of each AND node to its variable. */
+    std::unordered_map<uint64_t, uint32_t> _hash;
+    std::vector<uint64_t> _values;
+};
+
+/**
+ * Conflict-driven clause learning SAT solver. Literals use the same encoding
+ * as Aig, variable v is 2 * v and its negation is 2 * v + 1. Conflicts are
+ * analyzed to the first unique implication point, decisions follow variable
+ * activity with saved phases and the search restarts on a Luby schedule.
+ */
+class SatSolver {
+public:
+    enum Result { SAT, UNSAT, UNKNOWN };
+    using lit = uint32_t;
+
+    SatSolver(void)                        = default;
+    SatSolver(const SatSolver&)            = default;
+    SatSolver(SatSolver&&)                 = default;
+    SatSolver& operator=(SatSolver&&)      = default;
+    SatSolver& operator=(const SatSolver&) = default;
+    ~SatSolver()                           = default;
+
+    /** Adds a variable and returns its index. */
+    uint32_t new_var(void);
+
+    /**
+     * Adds a clause, a disjunction of literals.
+     * @returns false if the formula is known to be unsatisfiable
+     */
+    bool add_clause(std::vector<lit> clause);
+
+    /**
+     * Searches for a satisfying assignment.
+     * @param conflicts maximum number of conflicts before giving up
+     * @returns SatSolver::UNKNOWN if the budget is exhausted
+     */
+    Result solve(uint64_t conflicts = UINT64_MAX);
+
+    /** Value of a variable in the satisfying assignment. */
+    inline bool value(uint32_t var) const { return _assign[var] == 1; }
+
+    /** Number of conflicts during the last search. */
+    inline uint64_t conflicts(void) const { return _conflicts; }
+
+private:
+    static constexpr uint32_t NO_REASON = UINT32_MAX;
+    static constexpr uint8_t UNASSIGNED = 2;
+
+    /** Value of a literal, 0 for false, 1 for true or UNASSIGNED. */
+    uint8_t _value(lit l) const;
+    void _enqueue(lit l, uint32_t reason);
+    /** @returns the conflicting clause or NO_REASON */
+    uint32_t _propagate(void);
+    /** Learns a clause from a conflict, returns the backjump level. */
+    uint32_t _analyze(uint32_t conflict, std::vector<lit>& learnt);
+    void _backtrack(uint32_t level);
+    void _bump(uint32_t var);
+    /** Unassigned variable with the highest activity, or UINT32_MAX. */
+    uint32_t _pick(void);
+    void _heap_insert(uint32_t var);
+    void _heap_up(size_t i);
+    void _heap_down(size_t i);
+
+    std::vector<std::vector<lit>> _clauses;
+    /** Clauses that watch a literal, by literal. */
+    std::vector<std::vector<uint32_t>> _watches;
+    std::vector<uint8_t> _assign;
+    std::vector<uint8_t> _phase;
+    std::vector<uint32_t> _level;
+    std::vector<uint32_t> _reason;
+    std::vector<double> _activity;
+    double _var_inc = 1;
+    std::vector<lit> _trail;
+    std::vector<size_t> _trail_lim;
+    size_t _qhead = 0;
+    /** Binary max-heap of variables by activity. */
+    std::vector<uint32_t> _heap;
+    /** Position of each variable in the heap, SIZE_MAX if absent. */
+    std::vector<size_t> _heap_pos;
+    std::vector<uint8_t> _seen;
+    bool _is_unsat      = false;
+    uint64_t _conflicts = 0;
+};
+
+/** Outcome of an equivalence check between two scenes. */
+struct Equivalence {
+    /** Whether no simulated pattern distinguished the scenes. */
+    bool is_equivalent = true;
+    /** Whether the result holds for every input combination. Otherwise
+     * no counterexample was found within the limits. */
+    bool is_proven = false;
+    /** Whether the result was read from the cache. */
+    bool is_cached = false;
+    /** Number of simulated patterns. */
+    uint64_t patterns = 0;
+    /** Input values of a distinguishing pattern by input port. */
+    std::vector<bool> counterexample;
+    /** Output port that differs for the counterexample. */
+    size_t output = 0;
+};
+
+/** Scenes with at most this many inputs are compared exhaustively. */
+constexpr size_t EXHAUSTIVE_INPUT_S = 24;
+
+/**
+ * Compares two combinational scenes with the same number of input and output
+ * ports, matched by their order. Both scenes are compiled into a single Aig
+ * whose outputs are the XOR of each output pair, then simulated in parallel
+ * blocks of patterns until an output is set. Scenes with at most
+ * EXHAUSTIVE_INPUT_S inputs are simulated for every input combination.
+ * Larger ones are simulated for the given number of random patterns, then
+ * the Tseitin encoding of the miter is given to SatSolver.
+ *
+ * Proven results are cached in fs::CACHE by the hash of both scenes and
+ * their dependencies.
+ * @param lhs first scene
+ * @param rhs second scene
+ * @param result of the comparison
+ * @param patterns number of random patterns for large scenes
+ * @param threads number of workers, zero to use every core
+ * @param conflicts budget of the SAT solver
+ * @returns Error on failure:
+ *
+ * - Error::IO_MISMATCH
+ * - Netlist::compile
+ */
+LCS_ERROR check_equivalence(const Scene& lhs, const Scene& rhs,
+    Equivalence& result, uint64_t patterns = 1 << 20, size_t threads = 0,
+    uint64_t conflicts = 1 << 20);
+
+/** A relation whose value is stuck regardless of its driver. */
+struct Fault {
+    relid rel;
+    /** Stuck-at-1 if set, stuck-at-0 otherwise. */
+    bool value;
+};
+
+/** Outcome of a fault simulation. */
+struct FaultCoverage {
+    size_t total    = 0;
+    size_t detected = 0;
+    /** Faults that no test vector exposes at an output, by relation. */
+    std::vector<Fault> undetected;
+
+    inline double ratio(void) const
+    {
+        return total == 0 ? 1.0 : static_cast<double>(detected) / total;
+    }
+};
+
+/**
+ * Injects a stuck-at-0 and a stuck-at-1 fault on every relation of a
+ * combinational scene and applies the test vectors. A fault is detected when
+ * an output differs from the fault free scene.
+ *
+ * Faults are simulated 64 at a time, one per bit lane, and only the cells
+ * that the faults of a batch reach are evaluated. A batch stops at the first
+ * vector once each of its faults is detected.
+ * @param scene to test
+ * @param vectors test vectors, value i of a vector belongs to input port i
+ * @param result coverage of the vectors
+ * @param threads number of workers, zero to use every core
+ * @returns Error on failure:
+ *
+ * - Netlist::compile
+ */
+LCS_ERROR simulate_faults(const Scene& scene,
+    const std::vector<std::vector<bool>>& vectors, FaultCoverage& result,
+    size_t threads = 0);
+
+/** Encoding of stimulus and sample streams, see run_stimulus. */
+enum class StreamFormat : uint8_t {
+    /** One comma separated row of 0 and 1 per step. Samples are preceded by
+     * a header and start with the tick, DISABLED is written as x. */
+    CSV,
+    /** STREAM_MAGIC, the number of values as a little endian uint16_t, then
+     * one row per step with a bit per value, lowest bit first. */
+    BINARY,
+};
+
+constexpr char STREAM_MAGIC[4] = { 'I', 'C', 'S', 1 };
+
+/**
+ * A simulation engine that applies rows of input values to a scene and
+ * samples its outputs after each row. Values are matched to the Input and
+ * Output nodes in index order.
+ *
+ * - Backend::EVENT drives the scene itself, honoring gate delays and state.
+ * - Backend::RECURSIVE evaluates the cone of each output on demand.
+ * - Backend::LEVELIZED evaluates every node once in topological order.
+ * - Backend::BIT_PARALLEL runs 64 rows at once on the compiled Netlist, or
+ *   on native code when Scene::is_native is set. Its values are two-valued,
+ *   so a DISABLED node reads as FALSE.
+ *
+ * Every backend other than Backend::EVENT settles instantly and requires a
+ * combinational scene.
+ */
+class Backend {
+public:
+    enum Type : uint8_t { EVENT, RECURSIVE, LEVELIZED, BIT_PARALLEL, TYPE_S };
+
+    virtual ~Backend() = default;
+
+    /**
+     * Creates an unloaded backend.
+     * @param type of the backend
+     * @returns backend
+     */
+    static std::unique_ptr<Backend> create(Type type);
+
+    /**
+     * Finds the backend with the name given by to_str<Backend::Type>.
+     * @param name of the backend
+     * @param type to write into
+     * @returns whether the name is valid
+     */
+    static bool parse(const std::string& name, Type& type);
+
+    inline Type type(void) const { return _type; }
+    /** Scene of the last Backend::load. */
+    inline Scene* scene(void) const { return _scene; }
+    inline size_t input_size(void) const { return _inputs.size(); }
+    inline size_t output_size(void) const { return _outputs.size(); }
+
+    /** Number of rows that Backend::run evaluates in a single pass. */
+    virtual size_t batch_size(void) const { return 1; }
+
+    /**
+     * Prepares the backend to simulate the scene. The scene must outlive
+     * the backend and keep its nodes and relations until the next load.
+     * @param scene to simulate
+     * @returns Error on failure:
+     *
+     * - Error::NOT_COMBINATIONAL
+     * - Netlist::compile
+     */
+    LCS_ERROR virtual load(Scene& scene);
+
+    /**
+     * Simulates a step for each row.
+     * @param in value of each input for every row
+     * @param ticks simulation ticks of each step, Backend::EVENT only
+     * @param out value of each output after every row
+     */
+    virtual void run(const std::vector<std::vector<bool>>& in, uint64_t ticks,
+        std::vector<std::vector<State>>& out)
+        = 0;
+
+protected:
+    Backend(Type type);
+
+    Type _type;
+    Scene* _scene = nullptr;
+    std::vector<Node> _inputs;
+    std::vector<Node> _outputs;
+};
+
+/**
+ * Runs two backends in lockstep on the same rows and records the first
+ * output on which they disagree. The outputs of the first backend are
+ * returned. Against Backend::BIT_PARALLEL, which has no DISABLED state,
+ * DISABLED matches any value.
+ */
+class CrossCheck final : public Backend {
+public:
+    struct Divergence {
+        /** Row of the divergence, counted from the first Backend::run. */
+        size_t step;
+        /** Index of the output. */
+        size_t output;
+        State expected;
+        State actual;
+    };
+
+    CrossCheck(std::unique_ptr<Backend> expected,
+        std::unique_ptr<Backend> actual);
+    CrossCheck(const CrossCheck&)            = delete;
+    CrossCheck(CrossCheck&&)                 = default;
+    CrossCheck& operator=(CrossCheck&&)      = default;
+    CrossCheck& operator=(const CrossCheck&) = delete;
+    ~CrossCheck()                            = default;
+
+    /** First disagreement, if any. */
+    inline const std::optional<Divergence>& divergence(void) const
+    {
+        return _divergence;
+    }
+
+    /* Backend */
+    virtual size_t batch_size(void) const override;
+    LCS_ERROR virtual load(Scene& scene) override;
+    virtual void run(const std::vector<std::vector<bool>>& in, uint64_t ticks,
+        std::vector<std::vector<State>>& out) override;
+
+private:
+    std::unique_ptr<Backend> _expected;
+    std::unique_ptr<Backend> _actual;
+    std::vector<std::vector<State>> _actual_out;
+    std::optional<Divergence> _divergence;
+    size_t _step = 0;
+};
+
+/**
+ * Drives the Input nodes of a scene from a stimulus and samples its Output
+ * nodes after every step, using the backend of Scene::engine. Values are
+ * matched to the nodes in index order. Both streams are processed a batch
+ * of rows at a time, so neither is held in memory. A CSV stimulus may start
+ * with a header row.
+ * @param scene to simulate
+ * @param stimulus to read from
+ * @param in_format of the stimulus
+ * @param samples to write the outputs into
+ * @param out_format of the samples
+ * @param ticks simulation ticks between rows
+ * @returns Error on failure:
+ *
+ * - Error::INVALID_FILE
+ * - Error::IO_MISMATCH
+ * - Backend::load
+ */
+LCS_ERROR run_stimulus(Scene& scene, std::istream& stimulus,
+    StreamFormat in_format, std::ostream& samples, StreamFormat out_format,
+    uint64_t ticks = 1);
+
+/**
+ * Same as run_stimulus with a loaded backend.
+ * @param backend to simulate with
+ * @param stimulus to read from
+ * @param in_format of the stimulus
+ * @param samples to write the outputs into
+ * @param out_format of the samples
+ * @param ticks simulation ticks between rows
+ * @returns Error on failure:
+ *
+ * - Error::INVALID_FILE
+ * - Error::IO_MISMATCH
+ */
+LCS_ERROR run_stimulus(Backend& backend, std::istream& stimulus,
+    StreamFormat in_format, std::ostream& samples, StreamFormat out_format,
+    uint64_t ticks = 1);
+
+/**
+ * A time-ordered queue of pending relation updates. Events are stored in a
+ * ring of buckets indexed by their tick, so that scheduling and popping are
+ * constant time. The ring starts with EventWheel::SLOT_S buckets and doubles
+ * whenever a delay does not fit in it.
+ */
+class EventWheel {
+public:
+    static constexpr size_t SLOT_S = 256;
+    struct Event {
+        uint64_t tick;
+        relid id;
+        State value;
+    };
+
+    EventWheel()                             = default;
+    EventWheel(const EventWheel&)            = default;
+    EventWheel(EventWheel&&)                 = default;
+    EventWheel& operator=(EventWheel&&)      = default;
+    EventWheel& operator=(const EventWheel&) = default;
+    ~EventWheel()                            = default;
+
+    /**
+     * Schedules an update for given relation.
+     * @param delay ticks from now, must be non-zero
+     * @param id relation to update
+     * @param value to set
+     */
+    void push(uint16_t delay, relid id, State value);
+
+    /**
+     * Delivers events up to and including the given tick in time order.
+     * Stops early when the budget is exhausted, in which case the wheel
+     * keeps its position and the remaining events are delivered on the
+     * next call.
+     * @param until last tick to process
+     * @param budget maximum number of events to deliver
+     * @param deliver callback that is executed for each event
+     * @returns number of delivered events
+     */
+    size_t advance(uint64_t until, size_t budget,
+        const std::function<void(relid, State)>& deliver);
+
+    /** Current simulation time in ticks. */
+    inline uint64_t now(void) const { return _now; }
+    /** Number of pending events. */
+    inline size_t size(void) const { return _size; }
+    inline bool empty(void) const { return _size == 0; }
+    /** Drops all pending events without moving the time. */
+    void clear(void);
+
+private:
+    std::vector<std::vector<Event>> _slots;
+    uint64_t _now = 0;
+    size_t _size  = 0;
+};
+
+/**
+ * Streams the value changes of selected relations into a Value Change Dump
+ * file. The scene reports each change through Scene::recorder, which is a
+ * single null check while nothing is recorded. Time stamps are simulation
+ * ticks, see Scene::TICK_RATE. DISABLED is written as high impedance.
+ */
+class WaveRecorder {
+public:
+    /** Size of the write buffer before it is flushed to the file. */
+    static constexpr size_t BUFFER_S = 1 << 16;
+
+    WaveRecorder(void)                           = default;
+    WaveRecorder(const WaveRecorder&)            = delete;
+    WaveRecorder(WaveRecorder&&)                 = delete;
+    WaveRecorder& operator=(WaveRecorder&&)      = delete;
+    WaveRecorder& operator=(const WaveRecorder&) = delete;
+    ~WaveRecorder();
+
+    /**
+     * Selects a relation to record. Must be called before WaveRecorder::open.
+     * @param id relation to record
+     * @param name of the signal, rel_<id> if empty
+     */
+    void add(relid id, const std::string& name = "");
+
+    /** Selects the relation of every connected Output node of the scene. */
+    void add_outputs(const Scene& scene);
+
+    /**
+     * Writes the header and the current values, then attaches to the scene.
+     * The scene must outlive the recording.
+     * @param scene to record
+     * @param path of the VCD file
+     * @returns Error on failure:
+     *
+     * - Error::REL_NOT_FOUND
+     * - Error::NOT_FOUND
+     */
+    LCS_ERROR open(Scene& scene, const std::filesystem::path& path);
+
+    /** Detaches from the scene and flushes the remaining changes. */
+    void close(void);
+
+    inline bool is_open(void) const { return _scene != nullptr; }
+
+    /**
+     * Appends a value change if the relation is recorded.
+     * @param id relation that changed
+     * @param value new value
+     * @param tick time of the change
+     */
+    void record(relid id, State value, uint64_t tick);
+
+private:
+    void _flush(void);
+
+    struct Signal {
+        relid id;
+        std::string name;
+    };
+    std::vector<Signal> _signals;
+    /** VCD identifier of each recorded relation. */
+    std::unordered_map<relid, std::string> _codes;
+    Scene* _scene = nullptr;
+    std::ofstream _file;
+    std::string _buffer;
+    uint64_t _last_tick = UINT64_MAX;
+};
+
+/**
+ * Append-only log of the edits of a scene that is saved to a file. The log
+ * is kept next to the scene file and replayed when the file is opened, so
+ * editing only appends the edit instead of rewriting the scene, and the
+ * edits since the last save survive a crash. The scene reports its edits
+ * through Scene::journal.
+ *
+ * Adding, duplicating, removing and moving nodes, connecting or
+ * disconnecting them, editing their properties and writing memory words
+ * are recorded. Other
+ * changes, such as the dependencies, are written by Journal::compact, which
+ * folds the journal into the scene file.
+ */
+class Journal {
+public:
+    /** Size of the journal in bytes after which it is compacted. */
+    static constexpr size_t COMPACT_S = 1 << 20;
+
+    Journal(void)                      = default;
+    Journal(const Journal&)            = delete;
+    Journal(Journal&&)                 = delete;
+    Journal& operator=(Journal&&)      = delete;
+    Journal& operator=(const Journal&) = delete;
+    ~Journal();
+
+    /** Path of the journal of a scene file. */
+    static std::filesystem::path path_of(const std::filesystem::path& path);
+
+    /**
+     * Replays the journal of a scene file onto the scene that was read from
+     * it, then attaches to the scene. A journal written for a different
+     * version of the file is discarded, a torn record at its end is
+     * dropped.
+     * @param path of the scene file
+     * @param scene read from the file
+     * @returns Error on failure:
+     *
+     * - Error::NOT_FOUND
+     * - Error::NO_SAVE_PATH_DEFINED
+     * - Errors of the replayed edits
+     */
+    LCS_ERROR open(const std::filesystem::path& path, Scene& scene);
+
+    /**
+     * Saves the scene to the file and starts an empty journal for it, then
+     * attaches to the scene. The journal of a previous path is removed.
+     * @param path of the scene file
+     * @param scene to save
+     * @returns Error on failure:
+     *
+     * - Error::NO_SAVE_PATH_DEFINED
+     */
+    LCS_ERROR compact(const std::filesystem::path& path, Scene& scene);
+
+    /**
+     * Closes the journal file. Scene::journal has to be cleared by the
+     * caller.
+     * @param discard whether to remove the journal file as well
+     */
+    void close(bool discard = false);
+
+    inline bool is_open(void) const { return _file != nullptr; }
+    /** Number of edits that are not in the scene file yet. */
+    inline size_t pending(void) const { return _pending; }
+    /** Size of the journal file in bytes. */
+    inline size_t size(void) const { return _size; }
+
+    void add(const Scene& scene, Node node);
+    void remove(const Scene& scene, Node node);
+    void move(const Scene& scene, const BaseNode& node, Point p);
+    /** Records the properties of a node after one of them was edited. */
+    void update(const Scene& scene, const BaseNode& node);
+    /** Records a word written to a memory, without the rest of its data. */
+    void write(const Scene& scene, const Memory& memory, uint32_t address,
+        uint32_t value);
+    void connect(const Scene& scene, const Rel& rel);
+    void disconnect(const Scene& scene, const Rel& rel);
+
+private:
+    LCS_ERROR _restart(const Scene& scene);
+    void _append(const Scene& scene, const std::vector<uint8_t>& record);
+
+    std::filesystem::path _path;
+    std::FILE* _file = nullptr;
+    size_t _size     = 0;
+    size_t _pending  = 0;
+};
+
 class Scene {
 public:
     Scene(const std::string& name = "", const std::string& author = "",
@@ -429,6 +1586,30 @@ public:
      */
     void run(float delta);
 
+    /** Number of simulation ticks in a second of Scene::frame_s. */
+    static constexpr uint32_t TICK_RATE = 1000;
+
+    /**
+     * Advances the simulation clock, delivering the delayed signals that
+     * are due.
+     * @param ticks to advance
+     * @param budget maximum number of events to deliver
+     * @returns number of delivered events
+     */
+    size_t step(uint64_t ticks = 1, size_t budget = SIZE_MAX);
+
+    /**
+     * Delivers pending delayed signals until the scene is stable or the
+     * budget is exhausted. Used to treat a delayed scene as a combinational
+     * block, i.e. when it is executed as a component.
+     * @param budget maximum number of events to deliver
+     * @returns whether the scene has settled
+     */
+    bool settle(size_t budget = 1 << 20);
+
+    /** Current simulation time in ticks. */
+    inline uint64_t tick(void) const { return _wheel.now(); }
+
     /**
      * Creates a node in a scene with given type. Passes arguments to
      * the constructor similar to emplace methods.
@@ -460,9 +1641,15 @@ public:
             L_DEBUG("Last node found at %zu/%zu for %s", i, vec.size(),
                 to_str<Node::Type>(node_type));
         }
+        if (_is_loading) {
+            return id;
+        }
         L_INFO(
             "Added %s@%d to the scene.", to_str<Node::Type>(id.type), id.index);
         undo.push([this, id]() { remove_node(id); });
+        if (journal != nullptr) {
+            journal->add(*this, id);
+        }
         return id;
     }
 
@@ -473,6 +1660,22 @@ public:
      */
     Error duplicate_node(Node& node);
 
+    /**
+     * Replaces a group of gates and lookup tables with a single Lut that
+     * computes the same function. The group must be acyclic, fully
+     * connected, have at most Lut::MAX_INPUT distinct inputs from outside
+     * and exactly one node whose output is used outside of it. On success
+     * the node reference is set to the new lookup table.
+     * @param nodes to collapse
+     * @param lut newly created lookup table
+     * @returns Error on failure:
+     *
+     * - Error::NODE_NOT_FOUND
+     * - Error::NOT_CONNECTED
+     * - Error::NOT_COLLAPSIBLE
+     */
+    LCS_ERROR collapse(const std::vector<Node>& nodes, Node& lut);
+
     /**
      * Safely removes given node from the scene.
      *
@@ -553,6 +1756,21 @@ public:
     connect_with_id(relid id, Node to_node, sockid to_sock, Node from_node,
         sockid from_sock = 0);
 
+    /**
+     * Starts a bulk load. Until Scene::end_load, nodes and relations are
+     * added without simulating them, maintaining the levels, logging them
+     * or recording them in the undo history, so building a large scene is
+     * linear in its size. Relations are not journaled either.
+     */
+    void begin_load(void);
+
+    /**
+     * Ends a bulk load. The levels and feedback relations of the whole
+     * scene are computed at once and every node is evaluated once in level
+     * order, after which the scene is simulated as usual.
+     */
+    void end_load(void);
+
     /**
      * Safely disconnects a node relationship.
      * @param id relid to disconnect
@@ -571,32 +1789,132 @@ public:
      */
     void signal(relid id, State value);
 
+    /**
+     * Trigger a signal for the given relation after a delay. Zero delay is
+     * equivalent to Scene::signal.
+     * @param id relationship id
+     * @param value to set
+     * @param delay in ticks
+     */
+    void schedule(relid id, State value, uint16_t delay);
+
+    /** A group of nodes whose outputs feed back into their own inputs. */
+    struct FeedbackLoop {
+        std::vector<Node> nodes;
+        /** Whether the loop failed to converge during its last evaluation. */
+        bool oscillating = false;
+    };
+
+    /**
+     * Returns the feedback loops of the scene, which are the strongly
+     * connected components of the node graph. The result is cached until the
+     * next connection change.
+     */
+    const std::vector<FeedbackLoop>& loops(void);
+
+    /** Whether any feedback loop in the scene is oscillating. */
+    bool is_oscillating(void) const;
+
+    /**
+     * Topological level of a node. For every relation that is not a
+     * feedback edge, the level of the target is greater than the level of
+     * the source. Clocked Sequential nodes are treated as level zero by their
+     * targets, since their outputs only change on a clock edge. Levels are
+     * maintained incrementally while editing.
+     * @param node to query
+     * @returns level, zero for nodes without inputs
+     */
+    uint32_t level(Node node) const;
+
+    /**
+     * Whether the relation closes a feedback loop. Feedback edges are
+     * excluded from the topological order.
+     * @param id relationship id
+     */
+    bool is_feedback(relid id) const;
+
+    /**
+     * Version of the scene document written by default. Version 1 is a
+     * stream of fixed width instructions, version 2 is a checksummed
+     * section table with variable length integers.
+     */
+    static constexpr uint8_t FORMAT_VERSION = 2;
+    /** Flag of the version byte of a version 2 document whose section
+     * table and sections are compressed. */
+    static constexpr uint8_t FORMAT_COMPRESSED = 0x80;
+
     /**
      * Serializes given scene.
      * @param buffer to write into
+     * @param format version of the document, 1 or 2, optionally with
+     * Scene::FORMAT_COMPRESSED
      * @returns Error on failure
      */
-    Error write_to(std::vector<uint8_t>& buffer) const;
+    Error write_to(
+        std::vector<uint8_t>& buffer, uint8_t format = FORMAT_VERSION) const;
 
     /**
-     * Deserializes given scene.
+     * Saves the scene to a file in the latest format, compressed if
+     * Scene::is_compressed is set. The document is streamed to a temporary
+     * file that replaces the target only after it is flushed to the disk,
+     * so an interrupted save keeps the old file.
+     * @param path to save
+     * @returns Error on failure:
+     *
+     * - Error::NO_SAVE_PATH_DEFINED
+     */
+    LCS_ERROR write_file(const std::filesystem::path& path) const;
+
+    /**
+     * Deserializes given scene. Both versions of the document are accepted.
      * @param buffer to read from
-     * @returns Error on failure
+     * @returns Error on failure:
+     *
+     * - Error::INVALID_SCENE_FORMAT
+     * - Error::CHECKSUM_MISMATCH
      */
     LCS_ERROR read_from(const std::vector<uint8_t>& buffer);
 
+    /**
+     * Deserializes given scene from a memory region.
+     * @param data to read from
+     * @param size of the data in bytes
+     * @returns Error on failure, see Scene::read_from
+     */
+    LCS_ERROR read_from(const uint8_t* data, size_t size);
+
+    /**
+     * Deserializes given scene from a file. The file is memory mapped and
+     * parsed in place instead of being copied into a buffer first.
+     * @param path to read from
+     * @returns Error on failure:
+     *
+     * - Error::NOT_FOUND
+     * - Errors of Scene::read_from
+     */
+    LCS_ERROR read_file(const std::filesystem::path& path);
+
     /** Returns a dependency string. */
     std::string to_dependency(void) const;
 
+    /** Hash of the serialized scene together with the scenes it depends on,
+     * changes whenever the document or any of its dependencies does. */
+    uint64_t content_hash(void) const;
+
     LCS_ERROR add_dependency(const std::string& name);
     void add_dependency(Scene&& scene);
 
     void remove_dependency(size_t idx);
 
-    inline uint64_t run_dependency(size_t idx, uint64_t input)
-    {
-        return _dependencies[idx].component_context->run(input, frame_s);
-    }
+    /**
+     * Executes a dependency. Combinational dependencies are compiled into an
+     * optimized Netlist on first use, others run through their
+     * ComponentContext.
+     * @param idx of the dependency
+     * @param input binary encoded input
+     * @returns binary encoded result
+     */
+    uint64_t run_dependency(size_t idx, uint64_t input);
 
     inline const std::vector<Scene>& dependencies(void) const
     {
@@ -614,6 +1932,12 @@ public:
             return _inputs;
         } else if constexpr (std::is_same<T, Output>()) {
             return _outputs;
+        } else if constexpr (std::is_same<T, Sequential>()) {
+            return _sequentials;
+        } else if constexpr (std::is_same<T, Lut>()) {
+            return _luts;
+        } else if constexpr (std::is_same<T, Memory>()) {
+            return _memories;
         }
     }
 
@@ -624,9 +1948,41 @@ public:
     std::vector<Component> _components;
     std::vector<Input> _inputs;
     std::vector<Output> _outputs;
+    std::vector<Sequential> _sequentials;
+    std::vector<Lut> _luts;
+    std::vector<Memory> _memories;
     std::map<relid, Rel> _relations;
     /** Delta counter in seconds. */
     float frame_s;
+    /** Propagation delay of each Gate::Type in ticks. Zero delay settles
+     * instantly. */
+    std::array<uint16_t, Gate::TYPE_S> gate_delay {};
+    /** Maximum number of delayed signals to deliver in a single frame. */
+    size_t event_budget = 1 << 16;
+    /** Maximum number of times a node in a feedback loop is evaluated
+     * before the loop is considered to be oscillating. */
+    size_t loop_limit = 64;
+    /** Whether combinational dependencies are compiled to native code. Falls
+     * back to the interpreter when they can not be built. */
+    bool is_native = false;
+    /** Backend that runs batch simulations, see run_stimulus. */
+    Backend::Type engine = Backend::EVENT;
+    /** Whether the scene file is compressed. Set when a compressed file is
+     * read, so saving keeps the format of the file. */
+    bool is_compressed = false;
+    /** Receives the value changes of relations while a recording is open.
+     * Not copied or moved with the scene. */
+    WaveRecorder* recorder = nullptr;
+    /** Receives the edits of the scene while it is journaled. Moved with the
+     * scene, since the journal belongs to the scene file. */
+    Journal* journal = nullptr;
+    /** Parsed file in the dependency cache this dependency is a copy of.
+     * Keeps the file cached while any copy of it is alive. */
+    std::shared_ptr<const Scene> source;
+    /** Hash of the file the dependency was read from and of the files of its
+     * own dependencies, 0 if it was not read from the library. Keys the
+     * compiled artifact instead of Scene::content_hash. */
+    uint64_t source_hash = 0;
 
     Node _last_node[Node::Type::NODE_S];
     relid _last_rel;
@@ -642,6 +1998,57 @@ private:
     std::array<char, 60> _author {};
 
     std::vector<Scene> _dependencies;
+    EventWheel _wheel;
+
+    /** Compiled form of the scene when it is used as a dependency. */
+    std::optional<NativeNetlist> _netlist;
+    bool _is_compiled = false;
+
+    std::vector<FeedbackLoop> _loops;
+    /** Maps Node::numeric to its index in Scene::_loops. */
+    std::unordered_map<uint32_t, uint32_t> _loop_of;
+    bool _loops_dirty = true;
+    /** Loop nodes that are waiting to be evaluated. */
+    std::deque<Node> _pending;
+    std::unordered_set<uint32_t> _queued;
+    /** Number of evaluations of each loop node in the current convergence. */
+    std::unordered_map<uint32_t, size_t> _evals;
+    bool _converging = false;
+
+    /** Level of each node by Node::numeric, missing nodes are at zero. */
+    std::unordered_map<uint32_t, uint32_t> _levels;
+    /** Relations that are ignored by the topological order. */
+    std::unordered_set<relid> _feedback;
+    /** Whether a bulk load is in progress, see Scene::begin_load. */
+    bool _is_loading = false;
+
+    /** Finds the feedback loops using Tarjan's algorithm. */
+    void _find_loops(void);
+    /** Executes fn for each relation that leaves the node. */
+    void _fanout(Node node, const std::function<void(relid)>& fn);
+    /** Executes fn for each relation that enters the node. */
+    void _fanin(Node node, const std::function<void(relid)>& fn);
+    /**
+     * Raises the levels in the cone of `to` after a `from` to `to` relation
+     * is added.
+     * @returns false if the relation closes a loop, levels are unchanged
+     */
+    bool _raise_levels(Node from, Node to);
+    /** Lowers the levels in the cone of the node after an input is removed.
+     */
+    void _lower_levels(Node node);
+    /** Whether there is a path from `from` to `to`. */
+    bool _reaches(Node from, Node to);
+    /** Computes the levels and feedback relations of the whole scene at
+     * once. */
+    void _compute_levels(void);
+    /** Whether the node is a Sequential that only changes on a clock edge. */
+    bool _is_clocked(Node node);
+    /** Level of a node as seen by the nodes it is connected to. */
+    uint32_t _source_level(Node node);
+    /** Evaluates pending loop nodes until they reach a fixed point or
+     * Scene::loop_limit is exceeded. */
+    void _converge(void);
     /** The helper method for move constructor and move assignment */
     void _move_from(Scene&&);
 };
@@ -659,6 +2066,8 @@ namespace tabs {
         bool is_saved;
         std::filesystem::path path;
         Scene scene;
+        /** Journal of the scene file, once the scene has a path. */
+        std::unique_ptr<Journal> journal;
     };
 
     /**
@@ -745,8 +2154,12 @@ namespace tabs {
 } // namespace tabs
 
 /**
- * Loads the given component. If the component does not
- * exist in file system attempts to pull it from an available mirror.
+ * Loads the given component. Components are looked up in the package index
+ * first, then among the files of the library directory. If the component
+ * does not exist in file system attempts to pull it from an available
+ * mirror. Components in the file system are parsed once and shared through
+ * a cache while any scene uses them, the scene receives a copy of the
+ * cached one. The cache notices when the file changes.
  * @param name component name
  * @param scene to update
  * @returns Error on failure:
@@ -760,4 +2173,150 @@ namespace tabs {
  */
 Error load_dependency(const std::string& name, Scene& scene);
 
+/**
+ * Drops a component from the dependency cache, so it is read again the next
+ * time it is loaded. Scenes that already use it keep their copy.
+ * @param name component name
+ */
+void forget_dependency(const std::string& name);
+
+/**
+ * Content addressed package store in fs::LIBRARY. Every document is a blob
+ * named by its hash, so identical packages are stored once. An index maps
+ * dependency strings to their blob and I/O signature. The index is a hash
+ * table that is memory mapped, looking up a package neither lists the
+ * directory nor parses a document.
+ */
+namespace library {
+
+    /** An entry of the package index. */
+    struct Package {
+        /** Dependency string, author/name/version. */
+        std::string name;
+        /** hash64 of the document, names its blob. */
+        uint64_t hash;
+        /** Size of the document in bytes. */
+        uint32_t size;
+        sockid input_s;
+        sockid output_s;
+    };
+
+    /** Path of the blob with the given hash. */
+    std::filesystem::path blob_path(uint64_t hash);
+
+    /**
+     * Stores a component under its dependency string, replacing the package
+     * that had the same name.
+     * @param component to store
+     * @returns Error on failure:
+     *
+     * - Error::NOT_A_COMPONENT
+     * - Error::NO_SAVE_PATH_DEFINED
+     * - Error::DAMAGED_INDEX, the index is left as it is
+     */
+    LCS_ERROR install(const Scene& component);
+
+    /**
+     * Removes a package from the index, and its blob if no other package
+     * shares it.
+     * @param name dependency string of the package
+     * @returns Error on failure:
+     *
+     * - Error::COMPONENT_NOT_FOUND
+     * - Error::NO_SAVE_PATH_DEFINED
+     * - Error::DAMAGED_INDEX
+     */
+    LCS_ERROR remove(const std::string& name);
+
+    /**
+     * Looks up a package in the mapped index. The index file is not checked
+     * for changes by other processes until library::refresh is called.
+     * Install and remove refresh it themselves.
+     * @param name dependency string of the package
+     * @param package to fill
+     * @returns whether the package is in the index
+     */
+    bool find(const std::string& name, Package& package);
+
+    /**
+     * Makes the next lookup map the index again if its file was replaced.
+     * Called once before a batch of dependencies is resolved.
+     */
+    void refresh(void);
+
+    /** Every package of the index, in no particular order. */
+    std::vector<Package> list(void);
+
+} // namespace library
+
+/**
+ * Gate level netlists in structural Verilog and BLIF. Files are read as a
+ * stream, only the design itself is kept in memory.
+ *
+ * The Verilog subset has modules with scalar and vector ports and wires,
+ * the gate primitives, continuous assignments of ~, &, |, ^ and ?: over
+ * nets and constants, and instances of the other modules of the file with
+ * ordered or named connections. The $_AND_ style cells of Yosys, including
+ * $_DFF_P_ and $_DLATCH_P_, are understood as well. BLIF models may use
+ * .inputs, .outputs, .names with up to Lut::MAX_INPUT inputs, .latch and
+ * .subckt.
+ *
+ * The top module is the first one that no other module instantiates.
+ */
+namespace hdl {
+
+    enum Format { VERILOG, BLIF };
+
+    /** Format of a file by its extension, BLIF for .blif and Verilog for
+     * anything else. */
+    Format format_of(const std::filesystem::path& path);
+
+    /**
+     * Imports a netlist into an empty scene. The ports of the top module
+     * become Input and Output nodes, every module it instantiates becomes a
+     * component dependency of the scene. Constants are Luts without inputs,
+     * so the scene has the ports of the top module. Scenes are built with
+     * Scene::begin_load.
+     * @param path to read
+     * @param scene to build
+     * @returns Error on failure:
+     *
+     * - Error::NOT_FOUND
+     * - Error::UNSUPPORTED_NETLIST
+     * - Error::INVALID_NODE if a module has more nodes than a scene holds
+     */
+    LCS_ERROR read_scene(const std::filesystem::path& path, Scene& scene);
+
+    /**
+     * Imports a netlist flattened into a Netlist, which is not limited in
+     * size the way a scene is. Buffers are kept as BUF cells until
+     * Netlist::optimize removes them.
+     * @param path to read
+     * @param netlist to replace
+     * @returns Error on failure:
+     *
+     * - Error::NOT_FOUND
+     * - Error::UNSUPPORTED_NETLIST
+     * - Error::NOT_COMBINATIONAL if the design has latches or loops
+     */
+    LCS_ERROR read_netlist(const std::filesystem::path& path, Netlist& netlist);
+
+    /**
+     * Exports a scene in the format of the file extension. Every dependency
+     * becomes a module that the components instantiate. Unconnected inputs
+     * are written as constant false, and gates or Luts with one drive
+     * constant false, as in Netlist::compile.
+     * @param scene to write
+     * @param path to write to
+     * @returns Error on failure:
+     *
+     * - Error::UNSUPPORTED_NETLIST for memories and for sequentials other
+     *   than D flip-flops and D latches without enable or reset
+     * - Error::NO_SAVE_PATH_DEFINED
+     */
+    LCS_ERROR write_scene(
+        const Scene& scene, const std::filesystem::path& path);
+
+} // namespace hdl
+
 } // namespace ic
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+using lit = Aig::lit;
+
+Aig::Aig(void) { nodes.push_back({ LIT_FALSE, LIT_FALSE }); }
+
+Error Aig::build(const Scene& scene)
+{
+    Netlist netlist;
+    if (Error err = netlist.compile(scene); err != Error::OK) {
+        return err;
+    }
+    netlist.optimize();
+    build(netlist);
+    return Error::OK;
+}
+
+void Aig::build(const Netlist& netlist)
+{
+    *this = Aig {};
+    std::vector<lit> in;
+    for (const Netlist::Port& p : netlist.inputs) {
+        in.push_back(add_input(p.node));
+    }
+    std::vector<lit> out = lower(netlist, in);
+    for (size_t i = 0; i < out.size(); i++) {
+        add_output(netlist.outputs[i].node, out[i]);
+    }
+    L_INFO("Built an AIG with %zu inputs and %zu AND nodes.", inputs.size(),
+        and_count());
+}
+
+lit Aig::add_input(Node node)
+{
+    lit l = nodes.size() << 1;
+    nodes.push_back({ LIT_INPUT, LIT_INPUT });
+    inputs.push_back({ node, l });
+    return l;
+}
+
+void Aig::add_output(Node node, lit literal)
+{
+    outputs.push_back({ node, literal });
+}
+
+lit Aig::make_and(lit a, lit b)
+{
+    if (a > b) {
+        std::swap(a, b);
+    }
+    if (a == LIT_FALSE || a == negate(b)) {
+        return LIT_FALSE;
+    } else if (a == LIT_TRUE || a == b) {
+        return b;
+    }
+    uint64_t key = (static_cast<uint64_t>(a) << 32) | b;
+    auto it      = _hash.find(key);
+    if (it != _hash.end()) {
+        return it->second << 1;
+    }
+    uint32_t v = nodes.size();
+    nodes.push_back({ a, b });
+    _hash.emplace(key, v);
+    return v << 1;
+}
+
+lit Aig::make_or(lit a, lit b)
+{
+    return negate(make_and(negate(a), negate(b)));
+}
+
+lit Aig::make_xor(lit a, lit b)
+{
+    return make_or(make_and(a, negate(b)), make_and(negate(a), b));
+}
+
+lit Aig::make_mux(lit s, lit t, lit e)
+{
+    if (t == e) {
+        return t;
+    }
+    return make_or(make_and(s, t), make_and(negate(s), e));
+}
+
+/** Combines the literals pairwise to keep the depth logarithmic. */
+template <typename F> static lit _reduce(std::vector<lit> in, F combine)
+{
+    if (in.empty()) {
+        return Aig::LIT_FALSE;
+    }
+    while (in.size() > 1) {
+        size_t half = in.size() / 2;
+        for (size_t i = 0; i < half; i++) {
+            in[i] = combine(in[2 * i], in[2 * i + 1]);
+        }
+        if (in.size() % 2 == 1) {
+            in[half] = in.back();
+            half++;
+        }
+        in.resize(half);
+    }
+    return in[0];
+}
+
+std::vector<lit> Aig::lower(const Netlist& netlist, const std::vector<lit>& in)
+{
+    std::vector<lit> map(netlist.cells.size(), LIT_FALSE);
+    for (size_t i = 0; i < netlist.inputs.size() && i < in.size(); i++) {
+        map[netlist.inputs[i].net] = in[i];
+    }
+    auto land = [this](lit a, lit b) { return make_and(a, b); };
+    auto lor  = [this](lit a, lit b) { return make_or(a, b); };
+    auto lxor = [this](lit a, lit b) { return make_xor(a, b); };
+
+    std::vector<lit> fanin;
+    for (Netlist::netid i = 0; i < netlist.cells.size(); i++) {
+        const Netlist::Cell& cell = netlist.cells[i];
+        fanin.clear();
+        for (uint32_t j = 0; j < cell.size; j++) {
+            fanin.push_back(map[netlist.fanin[cell.first + j]]);
+        }
+        switch (cell.op) {
+        case Netlist::CONST0: map[i] = LIT_FALSE; break;
+        case Netlist::CONST1: map[i] = LIT_TRUE; break;
+        case Netlist::INPUT: break;
+        case Netlist::BUF: map[i] = fanin[0]; break;
+        case Netlist::NOT: map[i] = negate(fanin[0]); break;
+        case Netlist::AND: map[i] = _reduce(fanin, land); break;
+        case Netlist::NAND: map[i] = negate(_reduce(fanin, land)); break;
+        case Netlist::OR: map[i] = _reduce(fanin, lor); break;
+        case Netlist::NOR: map[i] = negate(_reduce(fanin, lor)); break;
+        case Netlist::XOR: map[i] = _reduce(fanin, lxor); break;
+        case Netlist::XNOR: map[i] = negate(_reduce(fanin, lxor)); break;
+        case Netlist::LUT: {
+            // Shannon expansion, the table is reduced one input at a time
+            // by selecting between the halves where the input is clear and
+            // where it is set.
+            const Lut::Table& table = netlist.tables[cell.table];
+            std::vector<lit> entries(1u << cell.size);
+            for (size_t m = 0; m < entries.size(); m++) {
+                entries[m] = table[m] ? LIT_TRUE : LIT_FALSE;
+            }
+            for (lit x : fanin) {
+                size_t half = entries.size() / 2;
+                for (size_t m = 0; m < half; m++) {
+                    entries[m]
+                        = make_mux(x, entries[2 * m + 1], entries[2 * m]);
+                }
+                entries.resize(half);
+            }
+            map[i] = entries[0];
+            break;
+        }
+        default: break;
+        }
+    }
+
+    std::vector<lit> out;
+    for (const Netlist::Port& p : netlist.outputs) {
+        out.push_back(map[p.net]);
+    }
+    return out;
+}
+
+size_t Aig::and_count(void) const
+{
+    return nodes.size() - 1 - inputs.size();
+}
+
+void Aig::simulate(
+    const std::vector<uint64_t>& in, std::vector<uint64_t>& out, size_t words)
+{
+    _values.assign(nodes.size() * words, 0);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        uint64_t* value = &_values[var(inputs[i].literal) * words];
+        for (size_t w = 0; w < words; w++) {
+            value[w] = i * words + w < in.size() ? in[i * words + w] : 0;
+        }
+    }
+    for (uint32_t v = 1; v < nodes.size(); v++) {
+        const And& node = nodes[v];
+        if (node.left == LIT_INPUT) {
+            continue;
+        }
+        // Complemented edges are applied as an XOR with an all ones mask,
+        // which keeps the inner loop free of branches.
+        const uint64_t* left  = &_values[var(node.left) * words];
+        const uint64_t* right = &_values[var(node.right) * words];
+        uint64_t left_mask    = is_complement(node.left) ? UINT64_MAX : 0;
+        uint64_t right_mask   = is_complement(node.right) ? UINT64_MAX : 0;
+        uint64_t* value       = &_values[v * words];
+        for (size_t w = 0; w < words; w++) {
+            value[w] = (left[w] ^ left_mask) & (right[w] ^ right_mask);
+        }
+    }
+    out.resize(outputs.size() * words);
+    for (size_t i = 0; i < outputs.size(); i++) {
+        lit l          = outputs[i].literal;
+        uint64_t mask  = is_complement(l) ? UINT64_MAX : 0;
+        uint64_t* from = &_values[var(l) * words];
+        for (size_t w = 0; w < words; w++) {
+            out[i * words + w] = from[w] ^ mask;
+        }
+    }
+}
+
+uint64_t Aig::run(uint64_t input)
+{
+    std::vector<uint64_t> in(inputs.size());
+    std::vector<uint64_t> out;
+    for (size_t i = 0; i < in.size() && i < 64; i++) {
+        in[i] = (input >> i) & 1 ? UINT64_MAX : 0;
+    }
+    simulate(in, out);
+    uint64_t output = 0;
+    for (size_t i = 0; i < out.size() && i < 64; i++) {
+        output |= (out[i] & 1) << i;
+    }
+    return output;
+}
+
+} // namespace ic
@@ -0,0 +1,523 @@
+#include <algorithm>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+template <> const char* to_str<Backend::Type>(Backend::Type s)
+{
+    switch (s) {
+    case Backend::EVENT: return "event";
+    case Backend::RECURSIVE: return "recursive";
+    case Backend::LEVELIZED: return "levelized";
+    case Backend::BIT_PARALLEL: return "bit-parallel";
+    default: return "null";
+    }
+}
+
+bool Backend::parse(const std::string& name, Type& type)
+{
+    for (uint8_t t = 0; t < TYPE_S; t++) {
+        if (name == to_str<Type>(static_cast<Type>(t))) {
+            type = static_cast<Type>(t);
+            return true;
+        }
+    }
+    return false;
+}
+
+Backend::Backend(Type type)
+    : _type { type }
+{
+}
+
+Error Backend::load(Scene& scene)
+{
+    _scene = &scene;
+    _inputs.clear();
+    _outputs.clear();
+    for (size_t i = 0; i < scene._inputs.size(); i++) {
+        if (!scene._inputs[i].is_null()) {
+            _inputs.push_back(Node { static_cast<uint16_t>(i), Node::INPUT });
+        }
+    }
+    for (size_t i = 0; i < scene._outputs.size(); i++) {
+        if (!scene._outputs[i].is_null()) {
+            _outputs.push_back(
+                Node { static_cast<uint16_t>(i), Node::OUTPUT });
+        }
+    }
+    return Error::OK;
+}
+
+/** Whether the scene can be evaluated in a single pass. */
+static bool _is_combinational(Scene& scene)
+{
+    auto is_live = [](const BaseNode& n) { return !n.is_null(); };
+    return std::none_of(
+               scene._sequentials.begin(), scene._sequentials.end(), is_live)
+        && std::none_of(scene._memories.begin(), scene._memories.end(), is_live)
+        && scene.loops().empty();
+}
+
+/** Input relations of the nodes that are evaluated by the graph backends. */
+static const std::vector<relid>* _inputs_of(Scene& scene, Node node)
+{
+    switch (node.type) {
+    case Node::GATE: return &scene.get_node<Gate>(node)->inputs;
+    case Node::LUT: return &scene.get_node<Lut>(node)->inputs;
+    case Node::COMPONENT: return &scene.get_node<Component>(node)->inputs;
+    default: return nullptr;
+    }
+}
+
+/**
+ * Evaluates a node the way its on_signal does.
+ * @param scene of the node
+ * @param node to evaluate, one that _inputs_of accepts
+ * @param in values of the input relations in socket order
+ * @param scratch buffer for the gate inputs
+ * @param word bit i is the value of output socket i
+ * @returns false if the outputs are DISABLED
+ */
+static bool _evaluate(Scene& scene, Node node, const std::vector<State>& in,
+    std::vector<bool>& scratch, uint64_t& word)
+{
+    switch (node.type) {
+    case Node::GATE: {
+        auto gate = scene.get_node<Gate>(node);
+        if (!gate->is_connected()) {
+            return false;
+        }
+        scratch.clear();
+        for (State s : in) {
+            scratch.push_back(s == TRUE);
+        }
+        word = gate->evaluate(scratch);
+        return true;
+    }
+    case Node::LUT: {
+        auto lut = scene.get_node<Lut>(node);
+        if (!lut->is_connected()) {
+            return false;
+        }
+        uint32_t index = 0;
+        for (size_t i = 0; i < in.size(); i++) {
+            index |= (in[i] == TRUE ? 1u : 0u) << i;
+        }
+        word = lut->lookup(index);
+        return true;
+    }
+    case Node::COMPONENT: {
+        auto comp = scene.get_node<Component>(node);
+        if (!comp->is_connected()) {
+            // A component keeps its last outputs until it is connected.
+            word = 0;
+            for (sockid s = 0; s < 64; s++) {
+                word |= static_cast<uint64_t>(comp->get(s) == TRUE) << s;
+            }
+            return true;
+        }
+        // The first input is the most significant bit, see
+        // Component::on_signal.
+        uint64_t input = 0;
+        for (State s : in) {
+            input = (input << 1) | (s == TRUE ? 1 : 0);
+        }
+        word = scene.run_dependency(comp->dep_idx, input);
+        return true;
+    }
+    default: return false;
+    }
+}
+
+/******************************************************************************
+                                 Event Driven
+*****************************************************************************/
+
+/** Drives the scene through Input::set and Scene::step. */
+class EventBackend final : public Backend {
+public:
+    EventBackend()
+        : Backend { EVENT }
+    {
+    }
+
+    virtual void run(const std::vector<std::vector<bool>>& in, uint64_t ticks,
+        std::vector<std::vector<State>>& out) override
+    {
+        out.resize(in.size());
+        for (size_t r = 0; r < in.size(); r++) {
+            for (size_t i = 0; i < _inputs.size() && i < in[r].size(); i++) {
+                _scene->get_node<Input>(_inputs[i])->set(in[r][i]);
+            }
+            _scene->step(ticks, _scene->event_budget);
+            out[r].resize(_outputs.size());
+            for (size_t i = 0; i < _outputs.size(); i++) {
+                out[r][i] = _scene->get_node<Output>(_outputs[i])->get();
+            }
+        }
+    }
+};
+
+/******************************************************************************
+                                  Recursive
+*****************************************************************************/
+
+/** Pulls the value of each output through its cone, memoized per row. */
+class RecursiveBackend final : public Backend {
+public:
+    RecursiveBackend()
+        : Backend { RECURSIVE }
+    {
+    }
+
+    virtual Error load(Scene& scene) override
+    {
+        if (!_is_combinational(scene)) {
+            return ERROR(Error::NOT_COMBINATIONAL);
+        }
+        Error err = Backend::load(scene);
+        _input_of.clear();
+        for (size_t i = 0; i < _inputs.size(); i++) {
+            _input_of[_inputs[i].index] = i;
+        }
+        return err;
+    }
+
+    virtual void run(const std::vector<std::vector<bool>>& in, uint64_t,
+        std::vector<std::vector<State>>& out) override
+    {
+        out.resize(in.size());
+        for (size_t r = 0; r < in.size(); r++) {
+            _row = &in[r];
+            _words.clear();
+            out[r].resize(_outputs.size());
+            for (size_t i = 0; i < _outputs.size(); i++) {
+                relid id = _scene->get_node<Output>(_outputs[i])->input;
+                out[r][i] = id == 0 ? DISABLED : _value(id);
+            }
+        }
+    }
+
+private:
+    /** Value of the relation for the current row. */
+    State _value(relid id)
+    {
+        auto rel  = _scene->get_rel(id);
+        Node node = rel->from_node;
+        if (node.type == Node::INPUT) {
+            size_t i = _input_of[node.index];
+            return i < _row->size() && (*_row)[i] ? TRUE : FALSE;
+        }
+        const std::vector<relid>* inputs = _inputs_of(*_scene, node);
+        if (inputs == nullptr) {
+            return _scene->get_base(node)->get(rel->from_sock);
+        }
+        auto it = _words.find(node.numeric());
+        if (it == _words.end()) {
+            std::vector<State> values;
+            for (relid r : *inputs) {
+                values.push_back(r == 0 ? DISABLED : _value(r));
+            }
+            uint64_t word   = 0;
+            bool is_enabled = _evaluate(*_scene, node, values, _scratch, word);
+            auto entry      = std::make_pair(is_enabled, word);
+            it              = _words.emplace(node.numeric(), entry).first;
+        }
+        if (!it->second.first) {
+            return DISABLED;
+        }
+        return (it->second.second >> rel->from_sock) & 1 ? TRUE : FALSE;
+    }
+
+    const std::vector<bool>* _row = nullptr;
+    std::unordered_map<uint16_t, size_t> _input_of;
+    /** Outputs of the evaluated nodes by Node::numeric. */
+    std::unordered_map<uint32_t, std::pair<bool, uint64_t>> _words;
+    std::vector<bool> _scratch;
+};
+
+/******************************************************************************
+                                  Levelized
+*****************************************************************************/
+
+/** Evaluates every node once per row in the order of Scene::level. */
+class LevelizedBackend final : public Backend {
+public:
+    LevelizedBackend()
+        : Backend { LEVELIZED }
+    {
+    }
+
+    virtual Error load(Scene& scene) override
+    {
+        if (!_is_combinational(scene)) {
+            return ERROR(Error::NOT_COMBINATIONAL);
+        }
+        Error err = Backend::load(scene);
+        _steps.clear();
+        _sources.clear();
+        _sinks.clear();
+
+        // Relations are given dense indices, so that values are read
+        // without a lookup.
+        std::unordered_map<relid, uint32_t> index;
+        for (const auto& [id, rel] : scene._relations) {
+            index.emplace(id, index.size());
+        }
+        _values.assign(index.size(), DISABLED);
+        auto dense = [&](relid id) {
+            return id == 0 ? NONE : index.at(id);
+        };
+
+        std::unordered_map<uint16_t, size_t> input_of;
+        for (size_t i = 0; i < _inputs.size(); i++) {
+            input_of[_inputs[i].index] = i;
+        }
+        std::unordered_map<uint32_t, size_t> step_of;
+        auto add = [&](Node node, const std::vector<relid>& inputs) {
+            step_of[node.numeric()] = _steps.size();
+            Step step { node, {}, {} };
+            for (relid r : inputs) {
+                step.in.push_back(dense(r));
+            }
+            _steps.push_back(std::move(step));
+        };
+        for (size_t i = 0; i < scene._gates.size(); i++) {
+            if (!scene._gates[i].is_null()) {
+                add(Node { static_cast<uint16_t>(i), Node::GATE },
+                    scene._gates[i].inputs);
+            }
+        }
+        for (size_t i = 0; i < scene._luts.size(); i++) {
+            if (!scene._luts[i].is_null()) {
+                add(Node { static_cast<uint16_t>(i), Node::LUT },
+                    scene._luts[i].inputs);
+            }
+        }
+        for (size_t i = 0; i < scene._components.size(); i++) {
+            if (!scene._components[i].is_null()) {
+                add(Node { static_cast<uint16_t>(i), Node::COMPONENT },
+                    scene._components[i].inputs);
+            }
+        }
+        for (const auto& [id, rel] : scene._relations) {
+            auto it = step_of.find(rel.from_node.numeric());
+            if (it != step_of.end()) {
+                _steps[it->second].out.push_back({ index[id], rel.from_sock });
+            } else {
+                auto in = rel.from_node.type == Node::INPUT
+                    ? input_of.find(rel.from_node.index)
+                    : input_of.end();
+                _sources.push_back({ index[id], rel.from_node, rel.from_sock,
+                    in != input_of.end() ? in->second : NONE });
+            }
+        }
+        std::stable_sort(_steps.begin(), _steps.end(),
+            [&](const Step& a, const Step& b) {
+                return scene.level(a.node) < scene.level(b.node);
+            });
+        for (Node out : _outputs) {
+            _sinks.push_back(dense(scene.get_node<Output>(out)->input));
+        }
+        return err;
+    }
+
+    virtual void run(const std::vector<std::vector<bool>>& in, uint64_t,
+        std::vector<std::vector<State>>& out) override
+    {
+        out.resize(in.size());
+        for (size_t r = 0; r < in.size(); r++) {
+            for (const Source& s : _sources) {
+                if (s.input != NONE) {
+                    _values[s.rel] = s.input < in[r].size() && in[r][s.input]
+                        ? TRUE
+                        : FALSE;
+                } else {
+                    _values[s.rel] = _scene->get_base(s.node)->get(s.sock);
+                }
+            }
+            for (const Step& step : _steps) {
+                _in.clear();
+                for (uint32_t i : step.in) {
+                    _in.push_back(i == NONE ? DISABLED : _values[i]);
+                }
+                uint64_t word   = 0;
+                bool is_enabled = _evaluate(
+                    *_scene, step.node, _in, _scratch, word);
+                for (const auto& [rel, sock] : step.out) {
+                    _values[rel] = DISABLED;
+                    if (is_enabled) {
+                        _values[rel] = (word >> sock) & 1 ? TRUE : FALSE;
+                    }
+                }
+            }
+            out[r].resize(_sinks.size());
+            for (size_t i = 0; i < _sinks.size(); i++) {
+                out[r][i] = _sinks[i] == NONE ? DISABLED : _values[_sinks[i]];
+            }
+        }
+    }
+
+private:
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    struct Step {
+        Node node;
+        /** Dense index of each input relation, NONE if unconnected. */
+        std::vector<uint32_t> in;
+        /** Dense index and socket of each output relation. */
+        std::vector<std::pair<uint32_t, sockid>> out;
+    };
+
+    /** A relation driven by a node that is not evaluated. */
+    struct Source {
+        uint32_t rel;
+        Node node;
+        sockid sock;
+        /** Position of the Input node in the row, NONE for other nodes. */
+        size_t input;
+    };
+
+    std::vector<Step> _steps;
+    std::vector<Source> _sources;
+    /** Dense index of the input relation of each output. */
+    std::vector<uint32_t> _sinks;
+    std::vector<State> _values;
+    std::vector<State> _in;
+    std::vector<bool> _scratch;
+};
+
+/******************************************************************************
+                                 Bit Parallel
+*****************************************************************************/
+
+/** Evaluates 64 rows per pass on the compiled netlist. */
+class BitParallelBackend final : public Backend {
+public:
+    BitParallelBackend()
+        : Backend { BIT_PARALLEL }
+    {
+    }
+
+    virtual size_t batch_size(void) const override { return 64; }
+
+    virtual Error load(Scene& scene) override
+    {
+        if (Error err = Backend::load(scene); err != Error::OK) {
+            return err;
+        }
+        Netlist netlist;
+        if (Error err = netlist.compile(scene); err != Error::OK) {
+            return err;
+        }
+        netlist.optimize();
+        if (netlist.inputs.size() != _inputs.size()
+            || netlist.outputs.size() != _outputs.size()) {
+            return ERROR(Error::IO_MISMATCH);
+        }
+        _netlist.emplace(std::move(netlist));
+        if (scene.is_native && _netlist->build() != Error::OK) {
+            L_WARN("Falling back to the interpreter for %s.",
+                scene.name().data());
+        }
+        return Error::OK;
+    }
+
+    virtual void run(const std::vector<std::vector<bool>>& in, uint64_t,
+        std::vector<std::vector<State>>& out) override
+    {
+        out.resize(in.size());
+        for (size_t first = 0; first < in.size(); first += 64) {
+            size_t last = std::min(in.size(), first + 64);
+            _in.assign(_inputs.size(), 0);
+            for (size_t r = first; r < last; r++) {
+                for (size_t i = 0; i < _in.size() && i < in[r].size(); i++) {
+                    _in[i] |= static_cast<uint64_t>(in[r][i]) << (r - first);
+                }
+            }
+            _netlist->simulate(_in, _out);
+            for (size_t r = first; r < last; r++) {
+                out[r].resize(_out.size());
+                for (size_t i = 0; i < _out.size(); i++) {
+                    out[r][i] = (_out[i] >> (r - first)) & 1 ? TRUE : FALSE;
+                }
+            }
+        }
+    }
+
+private:
+    std::optional<NativeNetlist> _netlist;
+    std::vector<uint64_t> _in;
+    std::vector<uint64_t> _out;
+};
+
+std::unique_ptr<Backend> Backend::create(Type type)
+{
+    switch (type) {
+    case RECURSIVE: return std::make_unique<RecursiveBackend>();
+    case LEVELIZED: return std::make_unique<LevelizedBackend>();
+    case BIT_PARALLEL: return std::make_unique<BitParallelBackend>();
+    default: return std::make_unique<EventBackend>();
+    }
+}
+
+/******************************************************************************
+                                  Cross Check
+*****************************************************************************/
+
+CrossCheck::CrossCheck(
+    std::unique_ptr<Backend> expected, std::unique_ptr<Backend> actual)
+    : Backend { expected->type() }
+    , _expected { std::move(expected) }
+    , _actual { std::move(actual) }
+{
+}
+
+size_t CrossCheck::batch_size(void) const
+{
+    return std::max(_expected->batch_size(), _actual->batch_size());
+}
+
+Error CrossCheck::load(Scene& scene)
+{
+    _divergence.reset();
+    _step = 0;
+    if (Error err = _expected->load(scene); err != Error::OK) {
+        return err;
+    }
+    if (Error err = _actual->load(scene); err != Error::OK) {
+        return err;
+    }
+    return Backend::load(scene);
+}
+
+void CrossCheck::run(const std::vector<std::vector<bool>>& in, uint64_t ticks,
+    std::vector<std::vector<State>>& out)
+{
+    _expected->run(in, ticks, out);
+    _actual->run(in, ticks, _actual_out);
+    // Bit parallel values are two-valued, so DISABLED on the other side
+    // matches either of them.
+    bool is_two_valued = _expected->type() == BIT_PARALLEL
+        || _actual->type() == BIT_PARALLEL;
+    for (size_t r = 0; r < in.size() && !_divergence.has_value(); r++) {
+        for (size_t i = 0; i < out[r].size(); i++) {
+            State expected = out[r][i], actual = _actual_out[r][i];
+            if (expected == actual
+                || (is_two_valued
+                    && (expected == DISABLED || actual == DISABLED))) {
+                continue;
+            }
+            _divergence = Divergence { _step + r, i, expected, actual };
+            L_WARN("%s and %s diverge at step %zu on output %zu: %s != %s",
+                to_str<Type>(_expected->type()), to_str<Type>(_actual->type()),
+                _step + r, i, to_str<State>(expected), to_str<State>(actual));
+            break;
+        }
+    }
+    _step += in.size();
+}
+
+} // namespace ic
@@ -106,6 +106,7 @@ uint64_t ComponentContext::run()
             _parent->signal(in, result);
         }
     }
+    _parent->settle();
 
     for (size_t i = 0; i < outputs.size(); i++) {
         if (outputs[i] != 0) {
@@ -127,6 +128,73 @@ uint64_t ComponentContext::run(uint64_t input, size_t frame)
     return result;
 }
 
+/**
+ * Compiled dependencies are stored in the cache directory under the content
+ * hash of the dependency, so an artifact is never used once the source
+ * changes.
+ */
+static std::filesystem::path _artifact_path(uint64_t key)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.icn",
+        static_cast<unsigned long long>(key));
+    return fs::CACHE / "netlist" / name;
+}
+
+/**
+ * Loads the compiled artifact of a combinational dependency, or compiles it
+ * and stores the artifact for the next time. Dependencies from the library
+ * are looked up by the hash of their files, others have to be serialized
+ * to find their content hash.
+ * @returns whether the dependency could be compiled
+ */
+static bool _compile_dependency(const Scene& dep, Netlist& netlist)
+{
+    uint64_t hash = dep.source_hash != 0 ? dep.source_hash
+                                         : dep.content_hash();
+    uint64_t key  = hash64(&hash, sizeof(hash), Netlist::ARTIFACT_VERSION);
+    std::filesystem::path path = _artifact_path(key);
+    std::error_code ec;
+    if (std::filesystem::exists(path, ec)
+        && netlist.read_file(path, key) == Error::OK) {
+        L_DEBUG("Loaded the compiled %s.", dep.name().data());
+        return true;
+    }
+    if (netlist.compile(dep) != Error::OK) {
+        return false;
+    }
+    netlist.optimize();
+    netlist.tabulate();
+    if (netlist.write_file(path, key) != Error::OK) {
+        L_WARN("Could not store the compiled %s at %s.", dep.name().data(),
+            path.string().c_str());
+    }
+    return true;
+}
+
+uint64_t Scene::run_dependency(size_t idx, uint64_t input)
+{
+    Scene& dep = _dependencies[idx];
+    if (!dep._is_compiled) {
+        dep._is_compiled = true;
+        Netlist netlist;
+        if (dep._sequentials.empty() && dep._memories.empty()
+            && _compile_dependency(dep, netlist)) {
+            dep._netlist.emplace(std::move(netlist));
+            // A truth table lookup is already faster than native code.
+            if (is_native && dep._netlist->netlist.truth_table.empty()
+                && dep._netlist->build() != Error::OK) {
+                L_WARN("Falling back to the interpreter for %s.",
+                    dep.name().data());
+            }
+        }
+    }
+    if (dep._netlist.has_value()) {
+        return dep._netlist->run(input);
+    }
+    return dep.component_context->run(input, frame_s);
+}
+
 Component::Component(Scene* _s)
     : BaseNode { _s }
     , dep_idx { UINT8_MAX }
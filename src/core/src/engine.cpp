@@ -11,6 +11,9 @@ template <> const char* to_str<Node::Type>(Node::Type s)
     case Node::Type::OUTPUT: return _("Output");
     case Node::Type::COMPONENT_INPUT: return _("Component Input");
     case Node::Type::COMPONENT_OUTPUT: return _("Component Output");
+    case Node::Type::SEQUENTIAL: return _("Sequential");
+    case Node::Type::LUT: return _("LUT");
+    case Node::Type::MEMORY: return _("Memory");
     default: return "Unknown";
     }
 }
@@ -65,6 +68,9 @@ void BaseNode::move(Point p)
     Point oldp = _point;
     _parent->undo.push([this, oldp]() { this->move(oldp); });
     _point = p;
+    if (_parent->journal != nullptr) {
+        _parent->journal->move(*_parent, *this, p);
+    }
 }
 
 /******************************************************************************
@@ -82,6 +88,9 @@ void Input::toggle()
     _parent->undo.push([this]() { this->toggle(); });
     _value = !_value;
     on_signal();
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
+    }
 }
 
 void Input::on_signal(void)
@@ -112,6 +121,9 @@ void Input::set_freq(uint8_t freq)
     uint8_t oldfreq = _freq;
     _parent->undo.push([this, oldfreq]() { set_freq(oldfreq); });
     _freq = freq;
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
+    }
 }
 
 /******************************************************************************
@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+/** Number of 64-bit words per port in a block of patterns. */
+static constexpr size_t BLOCK_WORDS = 64;
+static constexpr uint64_t BLOCK_S   = 64 * BLOCK_WORDS;
+
+/** Values of the lowest six inputs over the 64 patterns of a word. */
+static constexpr uint64_t LOW_INPUTS[6] = {
+    0xAAAAAAAAAAAAAAAAULL,
+    0xCCCCCCCCCCCCCCCCULL,
+    0xF0F0F0F0F0F0F0F0ULL,
+    0xFF00FF00FF00FF00ULL,
+    0xFFFF0000FFFF0000ULL,
+    0xFFFFFFFF00000000ULL,
+};
+
+/** SplitMix64, seeded by the block index so that runs are repeatable. */
+static inline uint64_t _next_random(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z          = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z          = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * Fills the input words of a block. Exhaustive blocks enumerate the patterns
+ * block * BLOCK_S onwards, so pattern p assigns bit i of p to input i.
+ */
+static void _fill_block(std::vector<uint64_t>& in, size_t input_s,
+    uint64_t block, bool is_exhaustive)
+{
+    uint64_t state = block;
+    for (size_t i = 0; i < input_s; i++) {
+        for (size_t w = 0; w < BLOCK_WORDS; w++) {
+            uint64_t& word = in[i * BLOCK_WORDS + w];
+            if (!is_exhaustive) {
+                word = _next_random(state);
+            } else if (i < 6) {
+                word = LOW_INPUTS[i];
+            } else {
+                uint64_t base = block * BLOCK_S + w * 64;
+                word          = (base >> i) & 1 ? UINT64_MAX : 0;
+            }
+        }
+    }
+}
+
+/**
+ * Tseitin encoding of the miter, with a clause that requires an output to be
+ * set. Only the cone of the outputs is encoded and the variables of the
+ * solver match the nodes of the Aig.
+ */
+static void _encode(const Aig& miter, SatSolver& solver)
+{
+    using Lit = SatSolver::lit;
+    for (size_t v = 0; v < miter.nodes.size(); v++) {
+        solver.new_var();
+    }
+    solver.add_clause({ Aig::LIT_TRUE });
+    std::vector<bool> is_used(miter.nodes.size());
+    std::vector<Lit> any;
+    for (const Aig::Port& p : miter.outputs) {
+        is_used[Aig::var(p.literal)] = true;
+        any.push_back(p.literal);
+    }
+    solver.add_clause(any);
+    for (size_t v = miter.nodes.size() - 1; v > 0; v--) {
+        const Aig::And& node = miter.nodes[v];
+        if (!is_used[v] || node.left == Aig::LIT_INPUT) {
+            continue;
+        }
+        is_used[Aig::var(node.left)]  = true;
+        is_used[Aig::var(node.right)] = true;
+        // v = left AND right
+        Lit out = v << 1;
+        solver.add_clause({ Aig::negate(out), node.left });
+        solver.add_clause({ Aig::negate(out), node.right });
+        solver.add_clause(
+            { out, Aig::negate(node.left), Aig::negate(node.right) });
+    }
+}
+
+static std::filesystem::path _cache_path(void)
+{
+    return fs::CACHE / "equivalence.cache";
+}
+
+/**
+ * Each line of the cache is the key in hexadecimal followed by the output
+ * index and the counterexample, or by "=" for equivalent scenes.
+ */
+static bool _cache_find(uint64_t key, Equivalence& result)
+{
+    std::string data;
+    if (!fs::read(_cache_path(), data)) {
+        return false;
+    }
+    char prefix[17];
+    std::snprintf(prefix, sizeof(prefix), "%016llx",
+        static_cast<unsigned long long>(key));
+    std::stringstream ss { data };
+    std::string line;
+    while (std::getline(ss, line)) {
+        std::stringstream fields { line };
+        std::string hash, value, inputs;
+        fields >> hash >> value >> inputs;
+        if (hash != prefix) {
+            continue;
+        }
+        result.is_proven = true;
+        result.is_cached = true;
+        if (value != "=") {
+            result.is_equivalent = false;
+            result.output        = std::strtoull(value.c_str(), nullptr, 10);
+            for (char c : inputs) {
+                result.counterexample.push_back(c == '1');
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+static void _cache_store(uint64_t key, const Equivalence& result)
+{
+    std::string data;
+    fs::read(_cache_path(), data);
+    char line[32];
+    std::snprintf(line, sizeof(line), "%016llx ",
+        static_cast<unsigned long long>(key));
+    data += line;
+    if (result.is_equivalent) {
+        data += "=";
+    } else {
+        data += std::to_string(result.output) + " ";
+        for (bool v : result.counterexample) {
+            data += v ? '1' : '0';
+        }
+    }
+    data += "\n";
+    if (!fs::write(_cache_path(), data)) {
+        L_WARN("Failed to update the equivalence cache.");
+    }
+}
+
+/**
+ * Proves the miter unsatisfiable or sets the counterexample in result.
+ * @returns whether the solver completed within the budget
+ */
+static bool _prove(const Aig& miter, Equivalence& result, uint64_t conflicts)
+{
+    SatSolver solver;
+    _encode(miter, solver);
+    SatSolver::Result status = solver.solve(conflicts);
+    L_DEBUG("SAT solver finished after %llu conflicts.",
+        static_cast<unsigned long long>(solver.conflicts()));
+    if (status == SatSolver::UNKNOWN) {
+        return false;
+    } else if (status == SatSolver::SAT) {
+        result.is_equivalent = false;
+        std::vector<uint64_t> in, out;
+        for (const Aig::Port& p : miter.inputs) {
+            bool value = solver.value(Aig::var(p.literal));
+            result.counterexample.push_back(value);
+            in.push_back(value ? UINT64_MAX : 0);
+        }
+        Aig sim = miter;
+        sim.simulate(in, out);
+        for (size_t i = 0; i < out.size(); i++) {
+            if (out[i] != 0) {
+                result.output = i;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+Error check_equivalence(const Scene& lhs, const Scene& rhs,
+    Equivalence& result, uint64_t patterns, size_t threads, uint64_t conflicts)
+{
+    result = Equivalence {};
+    Netlist left, right;
+    if (Error err = left.compile(lhs); err != Error::OK) {
+        return err;
+    } else if (err = right.compile(rhs); err != Error::OK) {
+        return err;
+    } else if (left.inputs.size() != right.inputs.size()
+        || left.outputs.size() != right.outputs.size()) {
+        return ERROR(Error::IO_MISMATCH);
+    }
+    uint64_t rhs_hash = rhs.content_hash();
+    uint64_t key = hash64(&rhs_hash, sizeof(rhs_hash), lhs.content_hash());
+    if (_cache_find(key, result)) {
+        L_INFO("Scenes are %s, read from the cache.",
+            result.is_equivalent ? "equivalent" : "different");
+        return Error::OK;
+    }
+    left.optimize();
+    right.optimize();
+
+    // The miter is set whenever an output pair differs. Shared structure
+    // is hashed into the same nodes, so matching outputs fold to false.
+    Aig miter;
+    std::vector<Aig::lit> in;
+    for (const Netlist::Port& p : left.inputs) {
+        in.push_back(miter.add_input(p.node));
+    }
+    std::vector<Aig::lit> l_out = miter.lower(left, in);
+    std::vector<Aig::lit> r_out = miter.lower(right, in);
+    bool is_trivial = true;
+    for (size_t i = 0; i < l_out.size(); i++) {
+        Aig::lit diff = miter.make_xor(l_out[i], r_out[i]);
+        miter.add_output(left.outputs[i].node, diff);
+        is_trivial = is_trivial && diff == Aig::LIT_FALSE;
+    }
+    size_t input_s     = in.size();
+    bool is_exhaustive = input_s <= EXHAUSTIVE_INPUT_S;
+    if (is_trivial) {
+        // Every output pair hashed into the same node.
+        result.is_proven = true;
+        L_INFO("Scenes are structurally equivalent.");
+        _cache_store(key, result);
+        return Error::OK;
+    }
+    uint64_t total  = is_exhaustive ? 1ULL << input_s : patterns;
+    uint64_t blocks = (total + BLOCK_S - 1) / BLOCK_S;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min<uint64_t>(threads, blocks));
+
+    std::atomic<uint64_t> next { 0 };
+    // Blocks after a failing one are skipped, the earliest failure wins so
+    // that the counterexample does not depend on the thread count.
+    std::atomic<uint64_t> failed_block { UINT64_MAX };
+    std::atomic<uint64_t> simulated { 0 };
+    std::mutex result_mtx;
+    auto work = [&]() {
+        Aig local = miter;
+        std::vector<uint64_t> words(input_s * BLOCK_WORDS);
+        std::vector<uint64_t> out;
+        uint64_t block;
+        while ((block = next++) < blocks && block < failed_block) {
+            _fill_block(words, input_s, block, is_exhaustive);
+            local.simulate(words, out, BLOCK_WORDS);
+            simulated += BLOCK_S;
+            for (size_t i = 0; i < out.size(); i++) {
+                if (out[i] == 0) {
+                    continue;
+                }
+                size_t w   = i % BLOCK_WORDS;
+                size_t bit = 0;
+                while (((out[i] >> bit) & 1) == 0) {
+                    bit++;
+                }
+                std::lock_guard<std::mutex> lock(result_mtx);
+                if (block < failed_block) {
+                    failed_block          = block;
+                    result.is_equivalent  = false;
+                    result.output         = i / BLOCK_WORDS;
+                    result.counterexample = std::vector<bool>(input_s);
+                    for (size_t j = 0; j < input_s; j++) {
+                        result.counterexample[j]
+                            = (words[j * BLOCK_WORDS + w] >> bit) & 1;
+                    }
+                }
+                break;
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+    result.patterns  = std::min(simulated.load(), total);
+    result.is_proven = is_exhaustive || !result.is_equivalent;
+
+    // Random patterns only find the likely differences, the remaining ones
+    // are left to the solver.
+    if (!result.is_proven) {
+        result.is_proven = _prove(miter, result, conflicts);
+    }
+    if (result.is_proven) {
+        _cache_store(key, result);
+    }
+
+    if (!result.is_equivalent) {
+        L_INFO("Scenes differ at output %zu.", result.output);
+    } else if (result.is_proven) {
+        L_INFO("Scenes are equivalent.");
+    } else {
+        L_INFO("Scenes are equivalent for %llu random patterns.",
+            static_cast<unsigned long long>(result.patterns));
+    }
+    return Error::OK;
+}
+
+} // namespace ic
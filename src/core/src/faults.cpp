@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <atomic>
+#include <queue>
+#include <thread>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+using netid = Netlist::netid;
+
+/** Faults of a batch, the fault in bit lane i is at position i. */
+struct Batch {
+    size_t first;
+    size_t size;
+};
+
+/** Lanes of a batch that are forced on a net. */
+struct Force {
+    netid net;
+    uint64_t clear;
+    uint64_t set;
+};
+
+Error simulate_faults(const Scene& scene,
+    const std::vector<std::vector<bool>>& vectors, FaultCoverage& result,
+    size_t threads)
+{
+    result = FaultCoverage {};
+    Netlist n;
+    if (Error err = n.compile(scene, true); err != Error::OK) {
+        return err;
+    }
+
+    // Relations that do not reach the netlist, such as the inputs of a
+    // partially connected gate, can not be observed.
+    std::vector<Fault> faults;
+    std::vector<netid> sites;
+    for (const auto& [id, rel] : scene._relations) {
+        for (bool value : { false, true }) {
+            auto it = n.relations.find(id);
+            if (it == n.relations.end()) {
+                result.undetected.push_back({ id, value });
+            } else {
+                faults.push_back({ id, value });
+                sites.push_back(it->second);
+            }
+        }
+    }
+    result.total = faults.size() + result.undetected.size();
+
+    // Fanout of every net, for event driven propagation.
+    std::vector<uint32_t> fanout_first(n.cells.size() + 1, 0);
+    for (netid f : n.fanin) {
+        fanout_first[f + 1]++;
+    }
+    for (size_t i = 0; i < n.cells.size(); i++) {
+        fanout_first[i + 1] += fanout_first[i];
+    }
+    std::vector<netid> fanout(n.fanin.size());
+    {
+        std::vector<uint32_t> pos(fanout_first.begin(), fanout_first.end() - 1);
+        for (netid i = 0; i < n.cells.size(); i++) {
+            const Netlist::Cell& cell = n.cells[i];
+            for (uint32_t j = 0; j < cell.size; j++) {
+                fanout[pos[n.fanin[cell.first + j]]++] = i;
+            }
+        }
+    }
+    std::vector<bool> is_output(n.cells.size(), false);
+    for (const Netlist::Port& p : n.outputs) {
+        is_output[p.net] = true;
+    }
+    // Nets with a path to an output, the others never need to be evaluated.
+    std::vector<bool> is_observable(is_output);
+    for (netid i = n.cells.size(); i-- > 0;) {
+        for (uint32_t k = fanout_first[i];
+             k < fanout_first[i + 1] && !is_observable[i]; k++) {
+            is_observable[i] = is_observable[fanout[k]];
+        }
+    }
+
+    // Fault free values of every net, 64 vectors per word.
+    size_t blocks = (vectors.size() + 63) / 64;
+    std::vector<uint64_t> good(blocks * n.cells.size());
+    std::vector<uint64_t> in(n.inputs.size()), out;
+    for (size_t b = 0; b < blocks; b++) {
+        std::fill(in.begin(), in.end(), 0);
+        for (size_t v = b * 64; v < vectors.size() && v < b * 64 + 64; v++) {
+            for (size_t i = 0; i < in.size() && i < vectors[v].size(); i++) {
+                in[i] |= static_cast<uint64_t>(vectors[v][i]) << (v % 64);
+            }
+        }
+        n.simulate(in, out);
+        for (netid i = 0; i < n.cells.size(); i++) {
+            good[b * n.cells.size() + i] = n.value(i);
+        }
+    }
+    auto good_value = [&](size_t v, netid net) -> uint64_t {
+        uint64_t word = good[(v / 64) * n.cells.size() + net];
+        return (word >> (v % 64)) & 1 ? UINT64_MAX : 0;
+    };
+
+    // Faults on nearby sites share most of their fanout, so batches are
+    // formed after sorting by site.
+    std::vector<size_t> order(faults.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&](size_t a, size_t b) { return sites[a] < sites[b]; });
+    std::vector<Fault> sorted_faults;
+    std::vector<netid> sorted_sites;
+    for (size_t i : order) {
+        if (!is_observable[sites[i]]) {
+            result.undetected.push_back(faults[i]);
+            continue;
+        }
+        sorted_faults.push_back(faults[i]);
+        sorted_sites.push_back(sites[i]);
+    }
+    std::vector<Batch> batches;
+    for (size_t i = 0; i < sorted_faults.size(); i += 64) {
+        batches.push_back(
+            { i, std::min<size_t>(64, sorted_faults.size() - i) });
+    }
+    std::vector<uint64_t> detected(batches.size(), 0);
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::max<size_t>(1, std::min(threads, batches.size()));
+    std::atomic<size_t> next { 0 };
+    auto work = [&]() {
+        // A net is valid for the current vector when its stamp matches the
+        // epoch, otherwise it holds the fault free value.
+        std::vector<uint64_t> values(n.cells.size());
+        std::vector<uint32_t> loaded(n.cells.size(), 0);
+        std::vector<uint32_t> queued(n.cells.size(), 0);
+        std::vector<uint32_t> forced(n.cells.size(), 0);
+        std::vector<Force> forces;
+        std::priority_queue<netid, std::vector<netid>, std::greater<netid>>
+            pending;
+        uint32_t epoch = 0;
+        size_t b;
+        while ((b = next++) < batches.size()) {
+            const Batch& batch = batches[b];
+            forces.clear();
+            for (size_t lane = 0; lane < batch.size; lane++) {
+                netid site = sorted_sites[batch.first + lane];
+                if (forces.empty() || forces.back().net != site) {
+                    forces.push_back({ site, 0, 0 });
+                }
+                (sorted_faults[batch.first + lane].value ? forces.back().set
+                                                         : forces.back().clear)
+                    |= 1ULL << lane;
+            }
+            uint64_t all = batch.size == 64 ? UINT64_MAX
+                                            : (1ULL << batch.size) - 1;
+            uint64_t found = 0;
+            for (size_t v = 0; v < vectors.size() && found != all; v++) {
+                epoch++;
+                for (size_t i = 0; i < forces.size(); i++) {
+                    // Detected faults are no longer injected.
+                    forces[i].clear &= ~found;
+                    forces[i].set &= ~found;
+                    forced[forces[i].net] = i + 1;
+                    queued[forces[i].net] = epoch;
+                    pending.push(forces[i].net);
+                }
+                // The netlist is in topological order, so the lowest net is
+                // always ready to be evaluated.
+                while (!pending.empty()) {
+                    netid c = pending.top();
+                    pending.pop();
+                    const Netlist::Cell& cell = n.cells[c];
+                    for (uint32_t j = 0; j < cell.size; j++) {
+                        netid f = n.fanin[cell.first + j];
+                        if (loaded[f] != epoch) {
+                            loaded[f] = epoch;
+                            values[f] = good_value(v, f);
+                        }
+                    }
+                    uint64_t value = n.evaluate(c, values.data());
+                    if (forced[c] != 0) {
+                        const Force& force = forces[forced[c] - 1];
+                        value              = (value & ~force.clear) | force.set;
+                    }
+                    loaded[c]     = epoch;
+                    values[c]     = value;
+                    uint64_t diff = value ^ good_value(v, c);
+                    if (diff == 0) {
+                        continue;
+                    } else if (is_output[c]) {
+                        found |= diff;
+                    }
+                    for (uint32_t k = fanout_first[c]; k < fanout_first[c + 1];
+                         k++) {
+                        if (is_observable[fanout[k]]
+                            && queued[fanout[k]] != epoch) {
+                            queued[fanout[k]] = epoch;
+                            pending.push(fanout[k]);
+                        }
+                    }
+                }
+            }
+            for (const Force& force : forces) {
+                forced[force.net] = 0;
+            }
+            detected[b] = found & all;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+
+    for (size_t b = 0; b < batches.size(); b++) {
+        for (size_t lane = 0; lane < batches[b].size; lane++) {
+            if ((detected[b] >> lane) & 1) {
+                result.detected++;
+            } else {
+                result.undetected.push_back(
+                    sorted_faults[batches[b].first + lane]);
+            }
+        }
+    }
+    std::sort(result.undetected.begin(), result.undetected.end(),
+        [](const Fault& a, const Fault& b) {
+            return a.rel != b.rel ? a.rel < b.rel : a.value < b.value;
+        });
+    L_INFO("Detected %zu of %zu faults with %zu vectors.", result.detected,
+        result.total, vectors.size());
+    return Error::OK;
+}
+
+} // namespace ic
@@ -62,12 +62,33 @@ void Gate::on_signal(void)
             ic_assert(rel != nullptr);
             v.push_back(rel->value == TRUE ? TRUE : FALSE);
         }
-        _value = _operations[_type](v) ? State::TRUE : State::FALSE;
+        _value = evaluate(v) ? State::TRUE : State::FALSE;
     } else {
         _value = State::DISABLED;
     }
+    uint16_t ticks = delay();
     for (relid& out : output) {
-        _parent->signal(out, get());
+        _parent->schedule(out, get(), ticks);
+    }
+}
+
+bool Gate::evaluate(const std::vector<bool>& in) const
+{
+    return _operations[_type](in);
+}
+
+uint16_t Gate::delay(void) const
+{
+    return _delay != INHERIT_DELAY ? _delay : _parent->gate_delay[_type];
+}
+
+void Gate::set_delay(uint16_t delay)
+{
+    uint16_t old_delay = _delay;
+    _parent->undo.push([this, old_delay]() { set_delay(old_delay); });
+    _delay = delay;
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
     }
 }
 
@@ -79,6 +100,9 @@ bool Gate::increment()
     _parent->undo.push([this]() { this->decrement(); });
     inputs.push_back(0);
     on_signal();
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
+    }
     return true;
 }
 
@@ -93,6 +117,9 @@ bool Gate::decrement()
     _parent->undo.push([this]() { this->increment(); });
     inputs.pop_back();
     on_signal();
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
+    }
     return true;
 }
 
@@ -0,0 +1,2519 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include "common.h"
+#include "core.h"
+
+namespace ic::hdl {
+
+/******************************************************************************
+                                    Design
+*****************************************************************************/
+
+/**
+ * Both formats are read into the same form, a module for each Verilog module
+ * or BLIF model with numbered nets and cells whose pins refer to them. A
+ * cell takes a few integers, so a million of them fit in tens of megabytes,
+ * and scenes or netlists are built from it in a single pass.
+ */
+static constexpr uint32_t NO_NET = UINT32_MAX;
+/** Size of the buffer files are read through. */
+static constexpr size_t READ_S = 1 << 16;
+
+enum CellKind : uint8_t {
+    GATE,
+    LUT,
+    /** Drives its output with its input, removed while building. */
+    BUF,
+    CONST0,
+    CONST1,
+    /** D flip-flop, the inputs are D and the clock. */
+    DFF,
+    /** D latch, the inputs are D and the enable. */
+    LATCH,
+    /** Instance of another module of the design. */
+    INSTANCE,
+};
+
+/** A cell of a module, its pins are the inputs followed by the outputs. */
+struct Cell {
+    CellKind kind;
+    /** Gate::Type of gates. */
+    uint8_t type;
+    /** Table of lookup tables, module of instances and the initial value of
+     * flip-flops and latches. */
+    uint32_t arg;
+    /** Position of the first pin in Module::pins. */
+    uint32_t first;
+    uint32_t in_s;
+    uint32_t out_s;
+};
+
+struct Port {
+    std::string name;
+    bool is_input;
+    /** Nets of the bits, least significant first. */
+    std::vector<uint32_t> bits;
+};
+
+/** Instance of a module that may be defined later in the file. */
+struct Instance {
+    std::string module;
+    /** Port of each connection, empty for ordered connections. */
+    std::vector<std::string> ports;
+    std::vector<std::vector<uint32_t>> nets;
+    size_t line;
+};
+
+/** Nets of a vector declared as [msb:lsb], the lsb is at base. */
+struct Range {
+    int msb;
+    int lsb;
+    uint32_t base;
+
+    inline uint32_t size(void) const
+    {
+        return (msb > lsb ? msb - lsb : lsb - msb) + 1;
+    }
+};
+
+struct Module {
+    std::string name;
+    /** Scalar nets by name. */
+    std::unordered_map<std::string, uint32_t> nets;
+    std::unordered_map<std::string, Range> vectors;
+    /** Port names in the order of the module header. */
+    std::vector<std::string> header;
+    /** Whether each port is an input. */
+    std::unordered_map<std::string, bool> directions;
+    std::vector<Port> ports;
+    /** Bits of the input and output ports in the order of the ports. */
+    std::vector<uint32_t> inputs;
+    std::vector<uint32_t> outputs;
+    std::vector<Cell> cells;
+    std::vector<uint32_t> pins;
+    std::vector<Lut::Table> tables;
+    std::unordered_map<Lut::Table, uint32_t> table_idx;
+    std::vector<Instance> instances;
+    uint32_t net_s           = 0;
+    uint32_t constants[2]    = { NO_NET, NO_NET };
+    bool is_instantiated     = false;
+
+    inline uint32_t fresh(void) { return net_s++; }
+
+    uint32_t net(const std::string& name)
+    {
+        auto [it, is_new] = nets.try_emplace(name, net_s);
+        if (is_new) {
+            net_s++;
+        }
+        return it->second;
+    }
+
+    /** Net that is driven by a constant. */
+    uint32_t constant(bool value)
+    {
+        if (constants[value] == NO_NET) {
+            constants[value] = fresh();
+            pins.push_back(constants[value]);
+            add(value ? CONST1 : CONST0, 0, 0, 1);
+        }
+        return constants[value];
+    }
+
+    /** Index of a truth table, equal tables are stored once. */
+    uint32_t table(const Lut::Table& table)
+    {
+        auto [it, is_new] = table_idx.try_emplace(table, tables.size());
+        if (is_new) {
+            tables.push_back(table);
+        }
+        return it->second;
+    }
+
+    /** Appends a cell whose pins were just pushed to Module::pins. */
+    void add(CellKind kind, uint8_t type, uint32_t in_s, uint32_t out_s,
+        uint32_t arg = 0)
+    {
+        cells.push_back({ kind, type, arg,
+            static_cast<uint32_t>(pins.size() - in_s - out_s), in_s, out_s });
+    }
+
+    /** Fills Module::inputs and Module::outputs once the ports are known. */
+    void finish(void)
+    {
+        for (bool is_input : { true, false }) {
+            for (const Port& port : ports) {
+                if (port.is_input == is_input) {
+                    auto& bits = is_input ? inputs : outputs;
+                    bits.insert(bits.end(), port.bits.begin(), port.bits.end());
+                }
+            }
+        }
+    }
+};
+
+struct Design {
+    std::vector<Module> modules;
+    std::unordered_map<std::string, size_t> index;
+    std::filesystem::path path;
+
+    /** Starts a module, nullptr if the name is taken. */
+    Module* add(const std::string& name)
+    {
+        if (!index.try_emplace(name, modules.size()).second) {
+            return nullptr;
+        }
+        modules.emplace_back();
+        modules.back().name = name;
+        return &modules.back();
+    }
+};
+
+/** Reports a construct that can not be read at the given line. */
+static Error _unsupported(
+    const Design& design, size_t line, const char* what, const std::string& at)
+{
+    L_WARN("%s:%zu: %s \"%s\".", design.path.string().c_str(), line, what,
+        at.c_str());
+    return ERROR(Error::UNSUPPORTED_NETLIST);
+}
+
+/** Reads a file through a fixed buffer, counting the lines. */
+class Source {
+public:
+    explicit Source(std::FILE* file)
+        : _file { file }
+        , _buffer(READ_S)
+    {
+    }
+
+    int peek(void)
+    {
+        if (_pos == _size) {
+            _size = std::fread(_buffer.data(), 1, _buffer.size(), _file);
+            _pos  = 0;
+            if (_size == 0) {
+                return EOF;
+            }
+        }
+        return static_cast<unsigned char>(_buffer[_pos]);
+    }
+
+    int get(void)
+    {
+        int c = peek();
+        if (c != EOF) {
+            _pos++;
+            if (c == '\n') {
+                line++;
+            }
+        }
+        return c;
+    }
+
+    size_t line = 1;
+
+private:
+    std::FILE* _file;
+    std::vector<char> _buffer;
+    size_t _pos  = 0;
+    size_t _size = 0;
+};
+
+/** Tables of the gates with the given number of inputs. */
+static Lut::Table _gate_table(Gate::Type type, size_t input_s)
+{
+    Lut::Table table;
+    for (size_t i = 0; i < (size_t { 1 } << input_s); i++) {
+        bool all  = i == (size_t { 1 } << input_s) - 1;
+        bool any  = i != 0;
+        bool odd  = std::bitset<Lut::MAX_INPUT> { i }.count() & 1;
+        bool bits[Gate::TYPE_S];
+        bits[Gate::NOT]  = !any;
+        bits[Gate::AND]  = all;
+        bits[Gate::OR]   = any;
+        bits[Gate::XOR]  = odd;
+        bits[Gate::NAND] = !all;
+        bits[Gate::NOR]  = !any;
+        bits[Gate::XNOR] = !odd;
+        table[i]         = bits[type];
+    }
+    return table;
+}
+
+/** Gate a buffer or an inverter turns into when it only has one input. */
+static void _add_gate(
+    Module& m, Gate::Type type, const std::vector<uint32_t>& in, uint32_t out)
+{
+    m.pins.insert(m.pins.end(), in.begin(), in.end());
+    m.pins.push_back(out);
+    if (in.size() == 1 && type != Gate::NOT) {
+        bool is_inverted
+            = type == Gate::NAND || type == Gate::NOR || type == Gate::XNOR;
+        m.add(is_inverted ? GATE : BUF, Gate::NOT, 1, 1);
+    } else {
+        m.add(GATE, type, in.size(), 1);
+    }
+}
+
+/**
+ * Adds the cell of a truth table over the given inputs, which is a constant,
+ * a buffer or a gate when the table is one and a lookup table otherwise.
+ */
+static void _add_table(Module& m, const std::vector<uint32_t>& in,
+    const Lut::Table& table, uint32_t out)
+{
+    size_t size  = size_t { 1 } << in.size();
+    size_t count = table.count();
+    if (count == 0 || count == size) {
+        m.pins.push_back(out);
+        m.add(count == 0 ? CONST0 : CONST1, 0, 0, 1);
+        return;
+    } else if (in.size() == 1) {
+        _add_gate(m, table[0] ? Gate::NOT : Gate::AND, in, out);
+        return;
+    }
+    for (uint8_t type = Gate::AND; type < Gate::TYPE_S; type++) {
+        if (table == _gate_table(static_cast<Gate::Type>(type), in.size())) {
+            _add_gate(m, static_cast<Gate::Type>(type), in, out);
+            return;
+        }
+    }
+    m.pins.insert(m.pins.end(), in.begin(), in.end());
+    m.pins.push_back(out);
+    m.add(LUT, 0, in.size(), 1, m.table(table));
+}
+
+/******************************************************************************
+                                    Verilog
+*****************************************************************************/
+
+enum TokenKind : uint8_t { END, IDENT, NUMBER, PUNCT };
+
+/**
+ * Splits Verilog into tokens. Comments, attributes and compiler directives
+ * are skipped. Escaped identifiers keep their name without the backslash,
+ * so \$_AND_ is the cell $_AND_, and are never keywords.
+ */
+class Lexer {
+public:
+    explicit Lexer(std::FILE* file)
+        : _in { file }
+    {
+        next();
+    }
+
+    void next(void);
+
+    /** Whether the token is the given keyword or punctuation. */
+    inline bool is(const char* s) const
+    {
+        return (kind == PUNCT || (kind == IDENT && !is_escaped)) && text == s;
+    }
+
+    /** Moves past the token if it is the given one. */
+    inline bool accept(const char* s)
+    {
+        if (is(s)) {
+            next();
+            return true;
+        }
+        return false;
+    }
+
+    TokenKind kind;
+    std::string text;
+    bool is_escaped;
+    size_t line;
+
+private:
+    /** Skips until the two given characters follow each other. */
+    void _skip_until(int first, int second);
+
+    Source _in;
+};
+
+void Lexer::_skip_until(int first, int second)
+{
+    int last = EOF;
+    for (int c = _in.get(); c != EOF; c = _in.get()) {
+        if (last == first && c == second) {
+            return;
+        }
+        last = c;
+    }
+}
+
+void Lexer::next(void)
+{
+    text.clear();
+    is_escaped = false;
+    for (;;) {
+        int c = _in.get();
+        line  = _in.line;
+        if (c == EOF) {
+            kind = END;
+            return;
+        } else if (std::isspace(c)) {
+            continue;
+        } else if (c == '/' && _in.peek() == '/') {
+            while (c != EOF && c != '\n') {
+                c = _in.get();
+            }
+            continue;
+        } else if ((c == '/' || c == '(') && _in.peek() == '*') {
+            _in.get();
+            _skip_until('*', c == '/' ? '/' : ')');
+            continue;
+        } else if (c == '`') {
+            while (c != EOF && c != '\n') {
+                c = _in.get();
+            }
+            continue;
+        }
+
+        if (std::isalpha(c) || c == '_' || c == '$') {
+            kind = IDENT;
+            text += c;
+            while (std::isalnum(_in.peek()) || _in.peek() == '_'
+                || _in.peek() == '$') {
+                text += _in.get();
+            }
+        } else if (c == '\\') {
+            kind       = IDENT;
+            is_escaped = true;
+            while (_in.peek() != EOF && !std::isspace(_in.peek())) {
+                text += _in.get();
+            }
+        } else if (std::isdigit(c) || c == '\'') {
+            kind = NUMBER;
+            text += c;
+            while (std::isalnum(_in.peek()) || _in.peek() == '_'
+                || _in.peek() == '\'' || _in.peek() == '?') {
+                text += _in.get();
+            }
+        } else if (c == '"') {
+            // Strings only appear in skipped parameters and attributes.
+            kind = NUMBER;
+            for (c = _in.get(); c != EOF && c != '"'; c = _in.get()) {
+                text += c;
+            }
+        } else {
+            kind = PUNCT;
+            text += c;
+            if ((c == '~' && _in.peek() == '^')
+                || (c == '^' && _in.peek() == '~')) {
+                text += _in.get();
+            }
+        }
+        return;
+    }
+}
+
+/**
+ * Bits of a Verilog number, least significant first. Unsized numbers are
+ * 32 bits wide, x and z bits are read as 0.
+ * @returns whether the number is valid
+ */
+static bool _parse_number(const std::string& text, std::vector<bool>& bits)
+{
+    bits.clear();
+    size_t quote = text.find('\'');
+    if (quote == std::string::npos) {
+        char* end;
+        unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+        for (size_t i = 0; i < 32; i++) {
+            bits.push_back((value >> i) & 1);
+        }
+        return *end == '\0';
+    }
+    size_t width = quote == 0 ? 32 : std::strtoul(text.c_str(), nullptr, 10);
+    size_t pos   = quote + 1;
+    if (pos < text.size() && (text[pos] == 's' || text[pos] == 'S')) {
+        pos++;
+    }
+    if (pos >= text.size() || width == 0 || width > UINT16_MAX) {
+        return false;
+    }
+    char base = std::tolower(text[pos++]);
+    if (base == 'd') {
+        char* end;
+        unsigned long long value
+            = std::strtoull(text.c_str() + pos, &end, 10);
+        for (size_t i = 0; i < 64; i++) {
+            bits.push_back((value >> i) & 1);
+        }
+        if (*end != '\0') {
+            return false;
+        }
+    } else {
+        size_t digit_s = base == 'b' ? 1
+            : base == 'o'            ? 3
+            : base == 'h'            ? 4
+                                     : 0;
+        if (digit_s == 0) {
+            return false;
+        }
+        for (size_t i = text.size(); i > pos; i--) {
+            char c    = std::tolower(text[i - 1]);
+            int value = 0;
+            if (c == '_') {
+                continue;
+            } else if (std::isdigit(c)) {
+                value = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                value = c - 'a' + 10;
+            } else if (c != 'x' && c != 'z' && c != '?') {
+                return false;
+            }
+            if (value >= (1 << digit_s)) {
+                return false;
+            }
+            for (size_t j = 0; j < digit_s; j++) {
+                bits.push_back((value >> j) & 1);
+            }
+        }
+    }
+    bits.resize(width, false);
+    return true;
+}
+
+/**
+ * Yosys internal cells, the ports are the inputs followed by the output.
+ * Cells that are not a single gate are lookup tables.
+ */
+struct LibraryCell {
+    const char* name;
+    CellKind kind;
+    Gate::Type type;
+    uint16_t table;
+    const char* ports[5];
+};
+
+static constexpr LibraryCell LIBRARY[] = {
+    { "$_BUF_", BUF, Gate::AND, 0, { "A", "Y" } },
+    { "$_NOT_", GATE, Gate::NOT, 0, { "A", "Y" } },
+    { "$_AND_", GATE, Gate::AND, 0, { "A", "B", "Y" } },
+    { "$_OR_", GATE, Gate::OR, 0, { "A", "B", "Y" } },
+    { "$_XOR_", GATE, Gate::XOR, 0, { "A", "B", "Y" } },
+    { "$_NAND_", GATE, Gate::NAND, 0, { "A", "B", "Y" } },
+    { "$_NOR_", GATE, Gate::NOR, 0, { "A", "B", "Y" } },
+    { "$_XNOR_", GATE, Gate::XNOR, 0, { "A", "B", "Y" } },
+    { "$_ANDNOT_", LUT, Gate::AND, 0x2, { "A", "B", "Y" } },
+    { "$_ORNOT_", LUT, Gate::AND, 0xB, { "A", "B", "Y" } },
+    { "$_MUX_", LUT, Gate::AND, 0xCA, { "A", "B", "S", "Y" } },
+    { "$_NMUX_", LUT, Gate::AND, 0x35, { "A", "B", "S", "Y" } },
+    { "$_AOI3_", LUT, Gate::AND, 0x07, { "A", "B", "C", "Y" } },
+    { "$_OAI3_", LUT, Gate::AND, 0x1F, { "A", "B", "C", "Y" } },
+    { "$_AOI4_", LUT, Gate::AND, 0x0777, { "A", "B", "C", "D", "Y" } },
+    { "$_OAI4_", LUT, Gate::AND, 0x111F, { "A", "B", "C", "D", "Y" } },
+    { "$_DFF_P_", DFF, Gate::AND, 0, { "D", "C", "Q" } },
+    { "$_DLATCH_P_", LATCH, Gate::AND, 0, { "D", "E", "Q" } },
+};
+
+/** Multiplexer of a ?: with the inputs else, then and the condition. */
+static constexpr uint16_t MUX_TABLE = 0xCA;
+
+/** Reads the structural subset of Verilog described in core.h. */
+class VerilogReader {
+public:
+    VerilogReader(std::FILE* file, Design& design)
+        : _lex { file }
+        , _design { design }
+    {
+    }
+
+    LCS_ERROR read(void);
+
+private:
+    LCS_ERROR _read_module(void);
+    LCS_ERROR _read_header(void);
+    LCS_ERROR _read_declaration(int direction);
+    LCS_ERROR _read_assign(void);
+    LCS_ERROR _read_primitive(Gate::Type type, bool is_buf);
+    LCS_ERROR _read_instance(void);
+    LCS_ERROR _read_range(bool& has_range, int& msb, int& lsb);
+    LCS_ERROR _read_int(int& value);
+    LCS_ERROR _read_name(std::vector<uint32_t>& bits);
+    LCS_ERROR _read_expression(std::vector<uint32_t>& bits);
+    LCS_ERROR _read_binary(std::vector<uint32_t>& bits, int precedence);
+    LCS_ERROR _read_unary(std::vector<uint32_t>& bits);
+    LCS_ERROR _read_concat(std::vector<uint32_t>& bits);
+    LCS_ERROR _expect(const char* s);
+    /** Skips a parenthesized list, the opening parenthesis is current. */
+    LCS_ERROR _skip_parens(void);
+    /** Skips until after the next semicolon. */
+    void _skip_statement(void);
+
+    LCS_ERROR _declare(
+        const std::string& name, bool has_range, int msb, int lsb);
+    /** Drives each bit of lhs with the same bit of rhs. */
+    void _connect(
+        const std::vector<uint32_t>& lhs, std::vector<uint32_t> rhs);
+    void _extend(std::vector<uint32_t>& bits, size_t size);
+    LCS_ERROR _library_cell(const LibraryCell& cell,
+        const std::vector<std::string>& ports,
+        std::vector<std::vector<uint32_t>>& nets);
+
+    inline Error _fail(const char* what)
+    {
+        return _unsupported(_design, _lex.line, what, _lex.text);
+    }
+
+    Lexer _lex;
+    Design& _design;
+    Module* _m = nullptr;
+};
+
+enum Direction { NONE, INPUT, OUTPUT };
+
+Error VerilogReader::read(void)
+{
+    while (_lex.kind != END) {
+        if (!_lex.accept("module")) {
+            return _fail("Expected a module at");
+        } else if (Error err = _read_module(); err) {
+            return err;
+        }
+    }
+    return Error::OK;
+}
+
+Error VerilogReader::_expect(const char* s)
+{
+    if (!_lex.accept(s)) {
+        L_WARN("%s:%zu: Expected \"%s\".", _design.path.string().c_str(),
+            _lex.line, s);
+        return _fail("Unexpected");
+    }
+    return Error::OK;
+}
+
+Error VerilogReader::_skip_parens(void)
+{
+    if (Error err = _expect("("); err) {
+        return err;
+    }
+    for (size_t depth = 1; depth > 0;) {
+        if (_lex.kind == END) {
+            return _fail("Unterminated parenthesis at");
+        } else if (_lex.is("(")) {
+            depth++;
+        } else if (_lex.is(")")) {
+            depth--;
+        }
+        _lex.next();
+    }
+    return Error::OK;
+}
+
+void VerilogReader::_skip_statement(void)
+{
+    while (_lex.kind != END && !_lex.accept(";")) {
+        _lex.next();
+    }
+}
+
+Error VerilogReader::_read_module(void)
+{
+    if (_lex.kind != IDENT) {
+        return _fail("Expected a module name at");
+    }
+    _m = _design.add(_lex.text);
+    if (_m == nullptr) {
+        return _fail("Module is defined twice");
+    }
+    _lex.next();
+    if (_lex.accept("#")) {
+        if (Error err = _skip_parens(); err) {
+            return err;
+        }
+    }
+    if (_lex.is("(")) {
+        if (Error err = _read_header(); err) {
+            return err;
+        }
+    }
+    if (Error err = _expect(";"); err) {
+        return err;
+    }
+
+    while (!_lex.accept("endmodule")) {
+        Error err = Error::OK;
+        if (_lex.kind == END) {
+            return _fail("Missing endmodule in");
+        } else if (_lex.accept("input")) {
+            err = _read_declaration(INPUT);
+        } else if (_lex.accept("output")) {
+            err = _read_declaration(OUTPUT);
+        } else if (_lex.accept("wire") || _lex.accept("tri")) {
+            err = _read_declaration(NONE);
+        } else if (_lex.is("supply0") || _lex.is("supply1")) {
+            bool value = _lex.text.back() == '1';
+            _lex.next();
+            do {
+                if (_lex.kind != IDENT) {
+                    return _fail("Expected a net at");
+                }
+                uint32_t net = _m->net(_lex.text);
+                _lex.next();
+                _connect({ net }, { _m->constant(value) });
+            } while (_lex.accept(","));
+            err = _expect(";");
+        } else if (_lex.accept("assign")) {
+            err = _read_assign();
+        } else if (_lex.is("parameter") || _lex.is("localparam")
+            || _lex.is("defparam")) {
+            _skip_statement();
+        } else if (_lex.is("buf") || _lex.is("not") || _lex.is("and")
+            || _lex.is("or") || _lex.is("xor") || _lex.is("nand")
+            || _lex.is("nor") || _lex.is("xnor")) {
+            static const char* names[Gate::TYPE_S]
+                = { "not", "and", "or", "xor", "nand", "nor", "xnor" };
+            bool is_buf = _lex.is("buf");
+            uint8_t type = Gate::NOT;
+            while (!is_buf && !_lex.is(names[type])) {
+                type++;
+            }
+            _lex.next();
+            err = _read_primitive(static_cast<Gate::Type>(type), is_buf);
+        } else if (_lex.kind == IDENT && !_lex.is("inout") && !_lex.is("reg")
+            && !_lex.is("always") && !_lex.is("initial")
+            && !_lex.is("function") && !_lex.is("task")
+            && !_lex.is("generate") && !_lex.is("integer")
+            && !_lex.is("genvar") && !_lex.is("specify")) {
+            err = _read_instance();
+        } else {
+            err = _fail("Unsupported construct");
+        }
+        if (err) {
+            return err;
+        }
+    }
+
+    for (const std::string& name : _m->header) {
+        auto it = _m->directions.find(name);
+        if (it == _m->directions.end()) {
+            return _fail("Port has no direction before");
+        }
+        Port port { name, it->second, {} };
+        if (auto v = _m->vectors.find(name); v != _m->vectors.end()) {
+            for (uint32_t i = 0; i < v->second.size(); i++) {
+                port.bits.push_back(v->second.base + i);
+            }
+        } else {
+            port.bits.push_back(_m->net(name));
+        }
+        _m->ports.push_back(std::move(port));
+    }
+    _m->finish();
+    return Error::OK;
+}
+
+Error VerilogReader::_read_header(void)
+{
+    _lex.next();
+    if (_lex.accept(")")) {
+        return Error::OK;
+    }
+    int direction = NONE;
+    bool has_range = false;
+    int msb = 0, lsb = 0;
+    do {
+        if (_lex.is("input") || _lex.is("output")) {
+            direction = _lex.is("input") ? INPUT : OUTPUT;
+            _lex.next();
+            _lex.accept("wire");
+            _lex.accept("signed");
+            if (Error err = _read_range(has_range, msb, lsb); err) {
+                return err;
+            }
+        } else if (_lex.is("inout") || _lex.is("reg")) {
+            return _fail("Unsupported port");
+        }
+        if (_lex.kind != IDENT) {
+            return _fail("Expected a port at");
+        }
+        _m->header.push_back(_lex.text);
+        if (direction != NONE) {
+            _m->directions[_lex.text] = direction == INPUT;
+            if (Error err = _declare(_lex.text, has_range, msb, lsb); err) {
+                return err;
+            }
+        }
+        _lex.next();
+    } while (_lex.accept(","));
+    return _expect(")");
+}
+
+Error VerilogReader::_read_int(int& value)
+{
+    std::vector<bool> bits;
+    if (_lex.kind != NUMBER || !_parse_number(_lex.text, bits)) {
+        return _fail("Expected a number at");
+    }
+    value = 0;
+    for (size_t i = 0; i < bits.size() && i < 31; i++) {
+        value |= bits[i] << i;
+    }
+    _lex.next();
+    return Error::OK;
+}
+
+Error VerilogReader::_read_range(bool& has_range, int& msb, int& lsb)
+{
+    has_range = _lex.accept("[");
+    if (!has_range) {
+        return Error::OK;
+    }
+    if (Error err = _read_int(msb); err) {
+        return err;
+    } else if (Error err = _expect(":"); err) {
+        return err;
+    } else if (Error err = _read_int(lsb); err) {
+        return err;
+    }
+    return _expect("]");
+}
+
+Error VerilogReader::_declare(
+    const std::string& name, bool has_range, int msb, int lsb)
+{
+    if (!has_range) {
+        if (_m->vectors.find(name) != _m->vectors.end()) {
+            return _fail("Vector is declared again as a scalar");
+        }
+        _m->net(name);
+        return Error::OK;
+    } else if (_m->nets.find(name) != _m->nets.end()) {
+        return _fail("Scalar is declared again as a vector");
+    }
+    auto [it, is_new] = _m->vectors.try_emplace(name, Range { msb, lsb, 0 });
+    if (is_new) {
+        it->second.base = _m->net_s;
+        _m->net_s += it->second.size();
+    } else if (it->second.msb != msb || it->second.lsb != lsb) {
+        return _fail("Vector is declared again with another range");
+    }
+    return Error::OK;
+}
+
+Error VerilogReader::_read_declaration(int direction)
+{
+    _lex.accept("wire");
+    _lex.accept("signed");
+    if (_lex.is("reg")) {
+        return _fail("Unsupported declaration");
+    }
+    bool has_range = false;
+    int msb = 0, lsb = 0;
+    if (Error err = _read_range(has_range, msb, lsb); err) {
+        return err;
+    }
+    do {
+        if (_lex.kind != IDENT) {
+            return _fail("Expected a name at");
+        }
+        std::string name = _lex.text;
+        if (Error err = _declare(name, has_range, msb, lsb); err) {
+            return err;
+        }
+        if (direction != NONE) {
+            _m->directions[name] = direction == INPUT;
+        }
+        _lex.next();
+        if (direction == NONE && _lex.accept("=")) {
+            std::vector<uint32_t> lhs, rhs;
+            if (Error err = _read_expression(rhs); err) {
+                return err;
+            }
+            // The name is read back as an expression to get all of its bits.
+            Range range = has_range ? _m->vectors[name] : Range { 0, 0, 0 };
+            for (uint32_t i = 0; i < range.size(); i++) {
+                lhs.push_back(has_range ? range.base + i : _m->net(name));
+            }
+            _connect(lhs, rhs);
+        }
+    } while (_lex.accept(","));
+    return _expect(";");
+}
+
+void VerilogReader::_extend(std::vector<uint32_t>& bits, size_t size)
+{
+    while (bits.size() < size) {
+        bits.push_back(_m->constant(false));
+    }
+}
+
+void VerilogReader::_connect(
+    const std::vector<uint32_t>& lhs, std::vector<uint32_t> rhs)
+{
+    _extend(rhs, lhs.size());
+    for (size_t i = 0; i < lhs.size(); i++) {
+        _m->pins.push_back(rhs[i]);
+        _m->pins.push_back(lhs[i]);
+        _m->add(BUF, 0, 1, 1);
+    }
+}
+
+Error VerilogReader::_read_assign(void)
+{
+    do {
+        std::vector<uint32_t> lhs, rhs;
+        if (Error err = _read_unary(lhs); err) {
+            return err;
+        } else if (Error err = _expect("="); err) {
+            return err;
+        } else if (Error err = _read_expression(rhs); err) {
+            return err;
+        }
+        _connect(lhs, rhs);
+    } while (_lex.accept(","));
+    return _expect(";");
+}
+
+Error VerilogReader::_read_name(std::vector<uint32_t>& bits)
+{
+    std::string name = _lex.text;
+    _lex.next();
+    auto it = _m->vectors.find(name);
+    if (!_lex.accept("[")) {
+        if (it == _m->vectors.end()) {
+            // Undeclared names are implicit scalar wires.
+            bits.push_back(_m->net(name));
+        } else {
+            for (uint32_t i = 0; i < it->second.size(); i++) {
+                bits.push_back(it->second.base + i);
+            }
+        }
+        return Error::OK;
+    }
+    int msb = 0, lsb = 0;
+    if (Error err = _read_int(msb); err) {
+        return err;
+    }
+    lsb = msb;
+    if (_lex.accept(":")) {
+        if (Error err = _read_int(lsb); err) {
+            return err;
+        }
+    }
+    if (Error err = _expect("]"); err) {
+        return err;
+    } else if (it == _m->vectors.end()) {
+        return _fail("Select of a scalar before");
+    }
+    const Range& r = it->second;
+    // Offset of an index from the least significant bit of the vector.
+    auto offset
+        = [&r](int i) { return r.msb >= r.lsb ? i - r.lsb : r.lsb - i; };
+    int from = offset(lsb), to = offset(msb);
+    int step = from <= to ? 1 : -1;
+    for (int i = from;; i += step) {
+        if (i < 0 || static_cast<uint32_t>(i) >= r.size()) {
+            return _fail("Select is out of the range before");
+        }
+        bits.push_back(r.base + i);
+        if (i == to) {
+            break;
+        }
+    }
+    return Error::OK;
+}
+
+Error VerilogReader::_read_concat(std::vector<uint32_t>& bits)
+{
+    // The first element is the most significant one.
+    std::vector<std::vector<uint32_t>> elements;
+    do {
+        if (_lex.kind == NUMBER) {
+            std::string count = _lex.text;
+            std::vector<bool> value;
+            _lex.next();
+            if (!_parse_number(count, value)) {
+                return _fail("Invalid number before");
+            } else if (_lex.accept("{")) {
+                std::vector<uint32_t> once, repeated;
+                if (Error err = _read_concat(once); err) {
+                    return err;
+                }
+                size_t n = std::strtoul(count.c_str(), nullptr, 10);
+                for (size_t i = 0; i < n; i++) {
+                    repeated.insert(repeated.end(), once.begin(), once.end());
+                }
+                elements.push_back(std::move(repeated));
+            } else {
+                elements.emplace_back();
+                for (bool bit : value) {
+                    elements.back().push_back(_m->constant(bit));
+                }
+            }
+            continue;
+        }
+        elements.emplace_back();
+        if (Error err = _read_expression(elements.back()); err) {
+            return err;
+        }
+    } while (_lex.accept(","));
+    for (auto it = elements.rbegin(); it != elements.rend(); it++) {
+        bits.insert(bits.end(), it->begin(), it->end());
+    }
+    return _expect("}");
+}
+
+Error VerilogReader::_read_unary(std::vector<uint32_t>& bits)
+{
+    if (_lex.accept("~")) {
+        std::vector<uint32_t> in;
+        if (Error err = _read_unary(in); err) {
+            return err;
+        }
+        for (uint32_t net : in) {
+            bits.push_back(_m->fresh());
+            _add_gate(*_m, Gate::NOT, { net }, bits.back());
+        }
+        return Error::OK;
+    } else if (_lex.accept("(")) {
+        if (Error err = _read_expression(bits); err) {
+            return err;
+        }
+        return _expect(")");
+    } else if (_lex.accept("{")) {
+        return _read_concat(bits);
+    } else if (_lex.kind == NUMBER) {
+        std::vector<bool> value;
+        if (!_parse_number(_lex.text, value)) {
+            return _fail("Invalid number");
+        }
+        for (bool bit : value) {
+            bits.push_back(_m->constant(bit));
+        }
+        _lex.next();
+        return Error::OK;
+    } else if (_lex.kind == IDENT) {
+        return _read_name(bits);
+    }
+    return _fail("Unsupported operator");
+}
+
+Error VerilogReader::_read_binary(std::vector<uint32_t>& bits, int precedence)
+{
+    if (Error err = _read_unary(bits); err) {
+        return err;
+    }
+    for (;;) {
+        // Verilog binds & before ^ and ~^, and those before |.
+        Gate::Type type;
+        int op_precedence;
+        if (_lex.is("&")) {
+            type          = Gate::AND;
+            op_precedence = 3;
+        } else if (_lex.is("^") || _lex.is("~^") || _lex.is("^~")) {
+            type          = _lex.is("^") ? Gate::XOR : Gate::XNOR;
+            op_precedence = 2;
+        } else if (_lex.is("|")) {
+            type          = Gate::OR;
+            op_precedence = 1;
+        } else {
+            return Error::OK;
+        }
+        if (op_precedence < precedence) {
+            return Error::OK;
+        }
+        _lex.next();
+        std::vector<uint32_t> rhs;
+        if (Error err = _read_binary(rhs, op_precedence + 1); err) {
+            return err;
+        }
+        size_t size = std::max(bits.size(), rhs.size());
+        _extend(bits, size);
+        _extend(rhs, size);
+        for (size_t i = 0; i < size; i++) {
+            uint32_t out = _m->fresh();
+            _add_gate(*_m, type, { bits[i], rhs[i] }, out);
+            bits[i] = out;
+        }
+    }
+}
+
+Error VerilogReader::_read_expression(std::vector<uint32_t>& bits)
+{
+    if (Error err = _read_binary(bits, 0); err) {
+        return err;
+    } else if (!_lex.accept("?")) {
+        return Error::OK;
+    }
+    std::vector<uint32_t> cond = std::move(bits), then, other;
+    if (Error err = _read_expression(then); err) {
+        return err;
+    } else if (Error err = _expect(":"); err) {
+        return err;
+    } else if (Error err = _read_expression(other); err) {
+        return err;
+    }
+    uint32_t sel = cond[0];
+    if (cond.size() > 1) {
+        // A condition is true when any of its bits is set.
+        sel = _m->fresh();
+        _add_gate(*_m, Gate::OR, cond, sel);
+    }
+    size_t size = std::max(then.size(), other.size());
+    _extend(then, size);
+    _extend(other, size);
+    uint32_t table = _m->table(Lut::Table { MUX_TABLE });
+    bits.clear();
+    for (size_t i = 0; i < size; i++) {
+        bits.push_back(_m->fresh());
+        _m->pins.insert(_m->pins.end(), { other[i], then[i], sel, bits[i] });
+        _m->add(LUT, 0, 3, 1, table);
+    }
+    return Error::OK;
+}
+
+Error VerilogReader::_read_primitive(Gate::Type type, bool is_buf)
+{
+    if (_lex.accept("#")) {
+        if (_lex.is("(")) {
+            if (Error err = _skip_parens(); err) {
+                return err;
+            }
+        } else {
+            _lex.next();
+        }
+    }
+    do {
+        if (_lex.kind == IDENT) {
+            _lex.next();
+        }
+        if (Error err = _expect("("); err) {
+            return err;
+        }
+        std::vector<uint32_t> terminals;
+        do {
+            std::vector<uint32_t> bits;
+            if (Error err = _read_expression(bits); err) {
+                return err;
+            } else if (bits.size() != 1) {
+                return _fail("Primitive terminal is not a single bit before");
+            }
+            terminals.push_back(bits[0]);
+        } while (_lex.accept(","));
+        if (Error err = _expect(")"); err) {
+            return err;
+        } else if (terminals.size() < 2) {
+            return _fail("Primitive has too few terminals before");
+        }
+        if (is_buf || type == Gate::NOT) {
+            // Every terminal but the last is an output.
+            for (size_t i = 0; i + 1 < terminals.size(); i++) {
+                _add_gate(*_m, is_buf ? Gate::AND : Gate::NOT,
+                    { terminals.back() }, terminals[i]);
+            }
+        } else {
+            _add_gate(*_m, type, { terminals.begin() + 1, terminals.end() },
+                terminals[0]);
+        }
+    } while (_lex.accept(","));
+    return _expect(";");
+}
+
+Error VerilogReader::_library_cell(const LibraryCell& cell,
+    const std::vector<std::string>& ports,
+    std::vector<std::vector<uint32_t>>& nets)
+{
+    size_t port_s = 0;
+    while (port_s < 5 && cell.ports[port_s] != nullptr) {
+        port_s++;
+    }
+    std::vector<uint32_t> pins(port_s, NO_NET);
+    for (size_t i = 0; i < nets.size(); i++) {
+        size_t pin = i;
+        if (!ports.empty()) {
+            pin = 0;
+            while (pin < port_s && ports[i] != cell.ports[pin]) {
+                pin++;
+            }
+        }
+        if (pin >= port_s) {
+            return _fail("Unknown port of the cell before");
+        } else if (nets[i].size() > 1) {
+            return _fail("Port of the cell is not a single bit before");
+        } else if (!nets[i].empty()) {
+            pins[pin] = nets[i][0];
+        }
+    }
+    for (size_t i = 0; i < port_s; i++) {
+        if (pins[i] == NO_NET) {
+            pins[i] = i + 1 < port_s ? _m->constant(false) : _m->fresh();
+        }
+    }
+    std::vector<uint32_t> in { pins.begin(), pins.end() - 1 };
+    switch (cell.kind) {
+    case GATE: _add_gate(*_m, cell.type, in, pins.back()); break;
+    case LUT:
+        _add_table(*_m, in, Lut::Table { cell.table }, pins.back());
+        break;
+    default:
+        _m->pins.insert(_m->pins.end(), pins.begin(), pins.end());
+        _m->add(cell.kind, 0, in.size(), 1);
+    }
+    return Error::OK;
+}
+
+Error VerilogReader::_read_instance(void)
+{
+    std::string module = _lex.text;
+    _lex.next();
+    if (_lex.accept("#")) {
+        if (Error err = _skip_parens(); err) {
+            return err;
+        }
+    }
+    const LibraryCell* cell = nullptr;
+    for (const LibraryCell& c : LIBRARY) {
+        if (module == c.name) {
+            cell = &c;
+        }
+    }
+    do {
+        size_t line = _lex.line;
+        if (_lex.kind != IDENT) {
+            return _fail("Expected an instance name at");
+        }
+        _lex.next();
+        if (_lex.is("[")) {
+            return _fail("Unsupported instance array");
+        } else if (Error err = _expect("("); err) {
+            return err;
+        }
+        std::vector<std::string> ports;
+        std::vector<std::vector<uint32_t>> nets;
+        bool is_named = _lex.is(".");
+        while (!_lex.is(")")) {
+            if (is_named) {
+                if (Error err = _expect("."); err) {
+                    return err;
+                } else if (_lex.kind != IDENT) {
+                    return _fail("Expected a port at");
+                }
+                ports.push_back(_lex.text);
+                _lex.next();
+                if (Error err = _expect("("); err) {
+                    return err;
+                }
+            }
+            nets.emplace_back();
+            if (!_lex.is(")") && !_lex.is(",")) {
+                if (Error err = _read_expression(nets.back()); err) {
+                    return err;
+                }
+            }
+            if (is_named) {
+                if (Error err = _expect(")"); err) {
+                    return err;
+                }
+            }
+            if (!_lex.accept(",")) {
+                break;
+            }
+        }
+        if (Error err = _expect(")"); err) {
+            return err;
+        }
+        if (cell != nullptr) {
+            if (Error err = _library_cell(*cell, ports, nets); err) {
+                return err;
+            }
+        } else {
+            _m->instances.push_back(
+                { module, std::move(ports), std::move(nets), line });
+        }
+    } while (_lex.accept(","));
+    return _expect(";");
+}
+
+/******************************************************************************
+                                     BLIF
+*****************************************************************************/
+
+/** Reads the BLIF subset described in core.h. */
+class BlifReader {
+public:
+    BlifReader(std::FILE* file, Design& design)
+        : _in { file }
+        , _design { design }
+    {
+    }
+
+    LCS_ERROR read(void);
+
+private:
+    /** Reads a line with its continuations, split into words.
+     * @returns false at the end of the file */
+    bool _read_line(void);
+    /** Adds the cell of the .names that is being read. */
+    void _finish_names(void);
+    LCS_ERROR _read_cube(void);
+    LCS_ERROR _read_latch(void);
+    LCS_ERROR _read_subckt(void);
+    /** Starts a model, the implicit one of a file without .model if the
+     * name is empty. */
+    LCS_ERROR _start(const std::string& name);
+    void _finish(void);
+
+    inline Error _fail(const char* what)
+    {
+        return _unsupported(
+            _design, _line, what, _words.empty() ? "" : _words[0]);
+    }
+
+    Source _in;
+    Design& _design;
+    Module* _m = nullptr;
+    std::vector<std::string> _words;
+    size_t _line = 0;
+    /** Clock of latches without a control, see .clock. */
+    uint32_t _clock = NO_NET;
+
+    bool _is_names = false;
+    std::vector<uint32_t> _names_in;
+    uint32_t _names_out;
+    Lut::Table _cover;
+    char _polarity;
+};
+
+bool BlifReader::_read_line(void)
+{
+    _words.clear();
+    std::string word;
+    for (;;) {
+        int c = _in.get();
+        if (_words.empty() && word.empty()) {
+            _line = _in.line;
+        }
+        if (c == '#') {
+            while (c != EOF && c != '\n') {
+                c = _in.get();
+            }
+        }
+        if (c == '\\' && (_in.peek() == '\n' || _in.peek() == '\r')) {
+            while (_in.peek() == '\r') {
+                _in.get();
+            }
+            _in.get();
+            c = ' ';
+        }
+        if (c == EOF || std::isspace(c)) {
+            if (!word.empty()) {
+                _words.push_back(std::move(word));
+                word.clear();
+            }
+            if ((c == EOF || c == '\n') && !_words.empty()) {
+                return true;
+            } else if (c == EOF) {
+                return false;
+            }
+        } else {
+            word += c;
+        }
+    }
+}
+
+Error BlifReader::_start(const std::string& name)
+{
+    _finish();
+    _m = _design.add(
+        name.empty() ? _design.path.stem().string() : name);
+    if (_m == nullptr) {
+        return _fail("Model is defined twice");
+    }
+    _clock = NO_NET;
+    return Error::OK;
+}
+
+void BlifReader::_finish(void)
+{
+    _finish_names();
+    if (_m != nullptr) {
+        _m->finish();
+        _m = nullptr;
+    }
+}
+
+void BlifReader::_finish_names(void)
+{
+    if (!_is_names) {
+        return;
+    }
+    _is_names = false;
+    Lut::Table table = _cover;
+    if (_polarity == '0') {
+        // The rows are the off-set.
+        table.flip();
+        for (size_t i = size_t { 1 } << _names_in.size(); i < table.size();
+             i++) {
+            table[i] = false;
+        }
+    }
+    _add_table(*_m, _names_in, table, _names_out);
+}
+
+Error BlifReader::_read_cube(void)
+{
+    size_t input_s = _names_in.size();
+    if (_words.size() != (input_s == 0 ? 1 : 2)) {
+        return _fail("Invalid cube");
+    }
+    const std::string& plane = input_s == 0 ? "" : _words[0];
+    const std::string& out   = _words.back();
+    if (plane.size() != input_s || out.size() != 1
+        || (out[0] != '0' && out[0] != '1')
+        || (_polarity != 0 && _polarity != out[0])) {
+        return _fail("Invalid cube");
+    }
+    _polarity = out[0];
+    size_t care = 0, value = 0;
+    for (size_t i = 0; i < input_s; i++) {
+        if (plane[i] == '1') {
+            value |= size_t { 1 } << i;
+        } else if (plane[i] != '0' && plane[i] != '-') {
+            return _fail("Invalid cube");
+        }
+        if (plane[i] != '-') {
+            care |= size_t { 1 } << i;
+        }
+    }
+    for (size_t i = 0; i < (size_t { 1 } << input_s); i++) {
+        if ((i & care) == value) {
+            _cover[i] = true;
+        }
+    }
+    return Error::OK;
+}
+
+Error BlifReader::_read_latch(void)
+{
+    // .latch input output [type control] [init]
+    if (_words.size() < 3 || _words.size() > 6) {
+        return _fail("Invalid latch");
+    }
+    bool has_control = _words.size() >= 5;
+    CellKind kind    = DFF;
+    uint32_t control = _clock;
+    if (has_control) {
+        if (_words[3] == "ah") {
+            kind = LATCH;
+        } else if (_words[3] != "re") {
+            return _fail("Unsupported latch type");
+        }
+        if (_words[4] != "NIL") {
+            control = _m->net(_words[4]);
+        }
+    }
+    if (control == NO_NET) {
+        // Latches without a control share the global clock.
+        control = _m->net("clock");
+        _m->ports.push_back({ "clock", true, { control } });
+        _clock = control;
+    }
+    bool init = _words.size() % 2 == 0 && _words.back() == "1";
+    _m->pins.push_back(_m->net(_words[1]));
+    _m->pins.push_back(control);
+    _m->pins.push_back(_m->net(_words[2]));
+    _m->add(kind, 0, 2, 1, init);
+    return Error::OK;
+}
+
+Error BlifReader::_read_subckt(void)
+{
+    if (_words.size() < 2) {
+        return _fail("Invalid subcircuit");
+    }
+    Instance instance { _words[1], {}, {}, _line };
+    for (size_t i = 2; i < _words.size(); i++) {
+        size_t eq = _words[i].find('=');
+        if (eq == std::string::npos || eq == 0) {
+            return _fail("Invalid subcircuit");
+        }
+        instance.ports.push_back(_words[i].substr(0, eq));
+        instance.nets.push_back({});
+        if (eq + 1 < _words[i].size()) {
+            instance.nets.back().push_back(
+                _m->net(_words[i].substr(eq + 1)));
+        }
+    }
+    _m->instances.push_back(std::move(instance));
+    return Error::OK;
+}
+
+Error BlifReader::read(void)
+{
+    while (_read_line()) {
+        const std::string& directive = _words[0];
+        if (directive[0] != '.') {
+            if (!_is_names) {
+                return _fail("Cube outside of .names");
+            } else if (Error err = _read_cube(); err) {
+                return err;
+            }
+            continue;
+        }
+        _finish_names();
+        if (directive == ".model") {
+            if (Error err = _start(_words.size() > 1 ? _words[1] : "");
+                err) {
+                return err;
+            }
+            continue;
+        } else if (directive == ".end") {
+            _finish();
+            continue;
+        } else if (_m == nullptr) {
+            if (Error err = _start(""); err) {
+                return err;
+            }
+        }
+
+        if (directive == ".inputs" || directive == ".outputs") {
+            for (size_t i = 1; i < _words.size(); i++) {
+                _m->ports.push_back({ _words[i], directive == ".inputs",
+                    { _m->net(_words[i]) } });
+            }
+        } else if (directive == ".names") {
+            if (_words.size() < 2 || _words.size() - 2 > Lut::MAX_INPUT) {
+                return _fail("Unsupported cover size");
+            }
+            _is_names = true;
+            _names_in.clear();
+            for (size_t i = 1; i + 1 < _words.size(); i++) {
+                _names_in.push_back(_m->net(_words[i]));
+            }
+            _names_out = _m->net(_words.back());
+            _cover.reset();
+            _polarity = 0;
+        } else if (directive == ".latch") {
+            if (Error err = _read_latch(); err) {
+                return err;
+            }
+        } else if (directive == ".subckt") {
+            if (Error err = _read_subckt(); err) {
+                return err;
+            }
+        } else if (directive == ".conn" && _words.size() == 3) {
+            _m->pins.push_back(_m->net(_words[1]));
+            _m->pins.push_back(_m->net(_words[2]));
+            _m->add(BUF, 0, 1, 1);
+        } else if (directive == ".clock") {
+            if (_words.size() > 1) {
+                _clock = _m->net(_words[1]);
+            }
+        } else if (directive == ".attr" || directive == ".cname"
+            || directive == ".param" || directive == ".area"
+            || directive == ".delay" || directive == ".input_arrival"
+            || directive == ".output_required"
+            || directive.rfind(".default_", 0) == 0) {
+            // Attributes and timing do not change the function.
+        } else {
+            return _fail("Unsupported directive");
+        }
+    }
+    _finish();
+    return Error::OK;
+}
+
+/******************************************************************************
+                                    Reading
+*****************************************************************************/
+
+/** Turns the instances of every module into cells. */
+LCS_ERROR static _resolve(Design& design)
+{
+    for (Module& m : design.modules) {
+        for (Instance& instance : m.instances) {
+            auto it = design.index.find(instance.module);
+            if (it == design.index.end()) {
+                return _unsupported(
+                    design, instance.line, "Unknown module", instance.module);
+            }
+            Module& target        = design.modules[it->second];
+            target.is_instantiated = true;
+            std::vector<const std::vector<uint32_t>*> conns(
+                target.ports.size(), nullptr);
+            if (instance.ports.empty()
+                && instance.nets.size() > target.ports.size()) {
+                return _unsupported(design, instance.line,
+                    "Too many connections to", instance.module);
+            }
+            for (size_t i = 0; i < instance.nets.size(); i++) {
+                size_t port = i;
+                if (!instance.ports.empty()) {
+                    port = 0;
+                    while (port < target.ports.size()
+                        && target.ports[port].name != instance.ports[i]) {
+                        port++;
+                    }
+                    if (port == target.ports.size()) {
+                        return _unsupported(design, instance.line,
+                            "Unknown port", instance.ports[i]);
+                    }
+                }
+                conns[port] = &instance.nets[i];
+            }
+            // Missing input bits are false, missing output bits are unused.
+            for (bool is_input : { true, false }) {
+                for (size_t i = 0; i < target.ports.size(); i++) {
+                    if (target.ports[i].is_input != is_input) {
+                        continue;
+                    }
+                    for (size_t b = 0; b < target.ports[i].bits.size(); b++) {
+                        if (conns[i] != nullptr && b < conns[i]->size()) {
+                            m.pins.push_back((*conns[i])[b]);
+                        } else {
+                            m.pins.push_back(
+                                is_input ? m.constant(false) : m.fresh());
+                        }
+                    }
+                }
+            }
+            m.add(INSTANCE, 0, target.inputs.size(), target.outputs.size(),
+                it->second);
+        }
+        m.instances.clear();
+        m.instances.shrink_to_fit();
+    }
+    return Error::OK;
+}
+
+LCS_ERROR static _read(
+    const std::filesystem::path& path, Design& design, size_t& top)
+{
+#if defined(_WIN32)
+    std::FILE* file = _wfopen(path.c_str(), L"rb");
+#else
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+#endif
+    if (file == nullptr) {
+        return ERROR(Error::NOT_FOUND);
+    }
+    design.path = path;
+    Error err   = format_of(path) == BLIF
+          ? BlifReader { file, design }.read()
+          : VerilogReader { file, design }.read();
+    std::fclose(file);
+    if (err) {
+        return err;
+    } else if (Error err = _resolve(design); err) {
+        return err;
+    }
+    for (top = 0; top < design.modules.size(); top++) {
+        if (!design.modules[top].is_instantiated) {
+            return Error::OK;
+        }
+    }
+    return _unsupported(design, 0, "No top module in", path.string());
+}
+
+Format format_of(const std::filesystem::path& path)
+{
+    return path.extension() == ".blif" ? BLIF : VERILOG;
+}
+
+/** Node and socket that drives a net of the module that is built. */
+struct Driver {
+    Node node;
+    sockid sock;
+
+    inline bool is_driven(void) const { return node.index != UINT16_MAX; }
+};
+
+/**
+ * Builds a module into a scene. Modules it instantiates become its
+ * dependencies, each of which is built the same way.
+ * @param marks modules that are being built, to find recursive modules
+ */
+LCS_ERROR static _build(
+    Design& design, size_t idx, Scene& scene, std::vector<bool>& marks)
+{
+    const Module& m   = design.modules[idx];
+    bool is_component = scene.component_context.has_value();
+    size_t count[Node::NODE_S] {};
+    for (const Cell& cell : m.cells) {
+        switch (cell.kind) {
+        case GATE: count[Node::GATE]++; break;
+        case LUT: count[Node::LUT]++; break;
+        case DFF:
+        case LATCH: count[Node::SEQUENTIAL]++; break;
+        case INSTANCE: count[Node::COMPONENT]++; break;
+        default: break;
+        }
+    }
+    count[Node::LUT] += 2;
+    count[Node::INPUT] = is_component ? 0 : m.inputs.size();
+    count[Node::OUTPUT] = is_component ? 0 : m.outputs.size();
+    for (size_t type = 0; type < Node::NODE_S; type++) {
+        if (count[type] >= UINT16_MAX) {
+            L_WARN("%s has %zu %s nodes, more than a scene holds.",
+                m.name.c_str(), count[type],
+                to_str<Node::Type>(static_cast<Node::Type>(type)));
+            return ERROR(Error::INVALID_NODE);
+        }
+    }
+
+    scene.begin_load();
+    marks[idx] = true;
+    std::unordered_map<size_t, uint8_t> dep_of;
+    for (const Cell& cell : m.cells) {
+        if (cell.kind != INSTANCE || dep_of.count(cell.arg) != 0) {
+            continue;
+        }
+        const Module& target = design.modules[cell.arg];
+        if (marks[cell.arg]) {
+            return _unsupported(design, 0, "Recursive module", target.name);
+        } else if (target.inputs.size() > 64 || target.outputs.size() > 64
+            || scene.dependencies().size() > UINT8_MAX) {
+            return _unsupported(
+                design, 0, "Module is too large for a component", target.name);
+        }
+        Scene dep { ComponentContext { &dep,
+                        static_cast<sockid>(target.inputs.size()),
+                        static_cast<sockid>(target.outputs.size()) },
+            target.name };
+        if (Error err = _build(design, cell.arg, dep, marks); err) {
+            return err;
+        }
+        dep_of[cell.arg] = scene.dependencies().size();
+        scene.add_dependency(std::move(dep));
+    }
+    marks[idx] = false;
+
+    std::vector<Driver> drivers(m.net_s, Driver { Node {}, 0 });
+    auto drive = [&](uint32_t net, Node node, sockid sock) {
+        if (drivers[net].is_driven()) {
+            return _unsupported(
+                design, 0, "Net with several drivers in", m.name);
+        }
+        drivers[net] = { node, sock };
+        return Error::OK;
+    };
+    for (size_t i = 0; i < m.inputs.size(); i++) {
+        Node node = is_component ? scene.component_context->get_input(i)
+                                 : scene.add_node<Input>();
+        if (Error err = drive(m.inputs[i], node, 0); err) {
+            return err;
+        }
+    }
+
+    std::vector<Node> nodes(m.cells.size());
+    std::vector<uint32_t> aliases;
+    Node constants[2];
+    // Input nodes would be ports of the top module, so constants are Luts
+    // without inputs.
+    auto constant = [&](bool value) {
+        Node& node = constants[value];
+        if (node.index == UINT16_MAX) {
+            node = scene.add_node<Lut>(
+                sockid { 0 }, Lut::Table { value ? 1u : 0u });
+        }
+        return node;
+    };
+    for (size_t i = 0; i < m.cells.size(); i++) {
+        const Cell& cell = m.cells[i];
+        const uint32_t* pins = m.pins.data() + cell.first;
+        Node node;
+        switch (cell.kind) {
+        case GATE:
+            if (cell.in_s > UINT8_MAX) {
+                return _unsupported(design, 0, "Gate has too many inputs in",
+                    m.name);
+            }
+            node = scene.add_node<Gate>(static_cast<Gate::Type>(cell.type),
+                static_cast<sockid>(cell.in_s));
+            break;
+        case LUT:
+            node = scene.add_node<Lut>(
+                static_cast<sockid>(cell.in_s), m.tables[cell.arg]);
+            break;
+        case CONST0:
+        case CONST1:
+            node = constant(cell.kind == CONST1);
+            break;
+        case DFF:
+        case LATCH:
+            node = scene.add_node<Sequential>(cell.kind == DFF
+                    ? Sequential::Type::D_FLIPFLOP
+                    : Sequential::Type::D_LATCH);
+            if (cell.arg != 0) {
+                scene.get_node<Sequential>(node)->set_value(1);
+            }
+            break;
+        case INSTANCE:
+            node = scene.add_node<Component>();
+            if (Error err
+                = scene.get_node<Component>(node)->set_component(
+                    dep_of[cell.arg]);
+                err) {
+                return err;
+            }
+            break;
+        case BUF:
+            // Buffers are resolved once every other driver is known.
+            if (aliases.empty()) {
+                aliases.resize(m.net_s, NO_NET);
+            }
+            if (aliases[pins[1]] != NO_NET) {
+                return _unsupported(
+                    design, 0, "Net with several drivers in", m.name);
+            }
+            aliases[pins[1]] = pins[0];
+            continue;
+        }
+        nodes[i] = node;
+        for (uint32_t j = 0; j < cell.out_s; j++) {
+            if (Error err = drive(pins[cell.in_s + j], node, j); err) {
+                return err;
+            }
+        }
+    }
+    for (uint32_t net = 0; net < aliases.size(); net++) {
+        if (aliases[net] == NO_NET) {
+            continue;
+        }
+        uint32_t source = aliases[net];
+        for (size_t steps = 0; !drivers[source].is_driven()
+             && aliases[source] != NO_NET;
+             steps++) {
+            if (steps > aliases.size()) {
+                return _unsupported(design, 0, "Loop of buffers in", m.name);
+            }
+            source = aliases[source];
+        }
+        if (drivers[source].is_driven()) {
+            if (Error err = drive(
+                    net, drivers[source].node, drivers[source].sock);
+                err) {
+                return err;
+            }
+        }
+    }
+
+    size_t undriven = 0;
+    auto connect = [&](Node node, sockid sock, uint32_t net) {
+        const Driver& d = drivers[net];
+        if (!d.is_driven()) {
+            undriven++;
+            return Error::OK;
+        } else if (scene.connect(node, sock, d.node, d.sock) == 0) {
+            return _unsupported(design, 0, "Failed to connect a node in",
+                m.name);
+        }
+        return Error::OK;
+    };
+    for (size_t i = 0; i < m.cells.size(); i++) {
+        const Cell& cell = m.cells[i];
+        if (cell.kind == BUF || cell.kind == CONST0 || cell.kind == CONST1) {
+            continue;
+        }
+        for (uint32_t j = 0; j < cell.in_s; j++) {
+            // Component::on_signal reads its first socket as the highest
+            // input bit.
+            sockid sock = cell.kind == INSTANCE ? cell.in_s - 1 - j : j;
+            if (Error err = connect(nodes[i], sock, m.pins[cell.first + j]);
+                err) {
+                return err;
+            }
+        }
+    }
+    for (size_t i = 0; i < m.outputs.size(); i++) {
+        Node node = is_component ? scene.component_context->get_output(i)
+                                 : scene.add_node<Output>();
+        if (Error err = connect(node, 0, m.outputs[i]); err) {
+            return err;
+        }
+    }
+    if (undriven != 0) {
+        L_WARN("%s has %zu inputs without a driver.", m.name.c_str(),
+            undriven);
+    }
+    std::string name = m.name.substr(0, scene.name().size() - 1);
+    if (name.size() != m.name.size()) {
+        L_WARN("Shortened the name of %s to fit a scene.", m.name.c_str());
+    }
+    if (Error err = scene.set_name(name); err) {
+        return err;
+    }
+    scene.end_load();
+    return Error::OK;
+}
+
+Error read_scene(const std::filesystem::path& path, Scene& scene)
+{
+    Design design;
+    size_t top = 0;
+    if (Error err = _read(path, design, top); err) {
+        return err;
+    }
+    std::vector<bool> marks(design.modules.size(), false);
+    if (Error err = _build(design, top, scene, marks); err) {
+        return err;
+    }
+    L_INFO("Imported %s from %s.", design.modules[top].name.c_str(),
+        path.string().c_str());
+    return Error::OK;
+}
+
+/** A netlist whose cells are not in topological order yet. */
+struct FlatNetlist {
+    std::vector<Netlist::Cell> cells;
+    std::vector<uint32_t> fanin;
+    std::vector<Lut::Table> tables;
+    /** Position of the tables of each module in FlatNetlist::tables. */
+    std::vector<std::vector<uint32_t>> table_of;
+
+    uint32_t add(Netlist::Op op, uint32_t size, uint32_t table = 0)
+    {
+        cells.push_back({ op, table, static_cast<uint32_t>(fanin.size()),
+            size });
+        fanin.resize(fanin.size() + size, 0);
+        return cells.size() - 1;
+    }
+};
+
+/**
+ * Inlines a module into the flat netlist. Every net is driven by a single
+ * cell, instance outputs are buffers of the outputs of the inlined module.
+ * @param in nets of the input bits
+ * @param out nets of the output bits
+ */
+LCS_ERROR static _flatten(const Design& design, size_t idx,
+    const std::vector<uint32_t>& in, std::vector<uint32_t>& out,
+    FlatNetlist& flat, std::vector<bool>& marks)
+{
+    const Module& m = design.modules[idx];
+    if (marks[idx]) {
+        return _unsupported(design, 0, "Recursive module", m.name);
+    }
+    marks[idx] = true;
+    if (flat.table_of[idx].empty()) {
+        for (const Lut::Table& table : m.tables) {
+            flat.table_of[idx].push_back(flat.tables.size());
+            flat.tables.push_back(table);
+        }
+    }
+    std::vector<uint32_t> nets(m.net_s, NO_NET);
+    for (size_t i = 0; i < m.inputs.size(); i++) {
+        nets[m.inputs[i]] = in[i];
+    }
+    std::vector<uint32_t> first(m.cells.size());
+    for (size_t i = 0; i < m.cells.size(); i++) {
+        const Cell& cell = m.cells[i];
+        switch (cell.kind) {
+        case GATE: {
+            static constexpr Netlist::Op ops[Gate::TYPE_S]
+                = { Netlist::NOT, Netlist::AND, Netlist::OR, Netlist::XOR,
+                      Netlist::NAND, Netlist::NOR, Netlist::XNOR };
+            first[i] = flat.add(ops[cell.type], cell.in_s);
+            break;
+        }
+        case LUT:
+            first[i] = flat.add(
+                Netlist::LUT, cell.in_s, flat.table_of[idx][cell.arg]);
+            break;
+        case BUF: first[i] = flat.add(Netlist::BUF, 1); break;
+        case CONST0: first[i] = 0; break;
+        case CONST1: first[i] = 1; break;
+        case INSTANCE:
+            first[i] = flat.cells.size();
+            for (uint32_t j = 0; j < cell.out_s; j++) {
+                flat.add(Netlist::BUF, 1);
+            }
+            break;
+        default: return ERROR(Error::NOT_COMBINATIONAL);
+        }
+        for (uint32_t j = 0; j < cell.out_s; j++) {
+            uint32_t& net = nets[m.pins[cell.first + cell.in_s + j]];
+            if (net != NO_NET) {
+                return _unsupported(
+                    design, 0, "Net with several drivers in", m.name);
+            }
+            net = first[i] + j;
+        }
+    }
+
+    size_t undriven = 0;
+    auto source     = [&](uint32_t net) -> uint32_t {
+        if (nets[net] == NO_NET) {
+            undriven++;
+            return 0;
+        }
+        return nets[net];
+    };
+    for (size_t i = 0; i < m.cells.size(); i++) {
+        const Cell& cell     = m.cells[i];
+        const uint32_t* pins = m.pins.data() + cell.first;
+        if (cell.kind == CONST0 || cell.kind == CONST1) {
+            continue;
+        } else if (cell.kind != INSTANCE) {
+            for (uint32_t j = 0; j < cell.in_s; j++) {
+                flat.fanin[flat.cells[first[i]].first + j] = source(pins[j]);
+            }
+            continue;
+        }
+        std::vector<uint32_t> child_in, child_out;
+        for (uint32_t j = 0; j < cell.in_s; j++) {
+            child_in.push_back(source(pins[j]));
+        }
+        if (Error err = _flatten(
+                design, cell.arg, child_in, child_out, flat, marks);
+            err) {
+            return err;
+        }
+        for (uint32_t j = 0; j < cell.out_s; j++) {
+            flat.fanin[flat.cells[first[i] + j].first] = child_out[j];
+        }
+    }
+    for (uint32_t net : m.outputs) {
+        out.push_back(source(net));
+    }
+    if (undriven != 0) {
+        L_WARN("%s has %zu inputs without a driver.", m.name.c_str(),
+            undriven);
+    }
+    marks[idx] = false;
+    return Error::OK;
+}
+
+Error read_netlist(const std::filesystem::path& path, Netlist& netlist)
+{
+    Design design;
+    size_t top = 0;
+    if (Error err = _read(path, design, top); err) {
+        return err;
+    }
+    FlatNetlist flat;
+    flat.table_of.resize(design.modules.size());
+    flat.add(Netlist::CONST0, 0);
+    flat.add(Netlist::CONST1, 0);
+    std::vector<uint32_t> in, out;
+    for (size_t i = 0; i < design.modules[top].inputs.size(); i++) {
+        in.push_back(flat.add(Netlist::INPUT, 0));
+    }
+    std::vector<bool> marks(design.modules.size(), false);
+    if (Error err = _flatten(design, top, in, out, flat, marks); err) {
+        return err;
+    }
+    design = {};
+
+    // Depth first search over the fanin, a cell is added once all of its
+    // fanin is.
+    Netlist n;
+    n.tables = std::move(flat.tables);
+    std::vector<uint32_t> order(flat.cells.size(), NO_NET);
+    std::vector<bool> on_path(flat.cells.size(), false);
+    order[0] = 0;
+    order[1] = 1;
+    for (size_t i = 0; i < in.size(); i++) {
+        order[in[i]] = n.add(Netlist::INPUT, {});
+        n.inputs.push_back(
+            { Node { static_cast<uint16_t>(i), Node::INPUT }, order[in[i]] });
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    std::vector<Netlist::netid> fanin;
+    for (uint32_t root = 0; root < flat.cells.size(); root++) {
+        if (order[root] != NO_NET) {
+            continue;
+        }
+        stack.push_back({ root, 0 });
+        on_path[root] = true;
+        while (!stack.empty()) {
+            auto& [id, next]          = stack.back();
+            const Netlist::Cell& cell = flat.cells[id];
+            if (next < cell.size) {
+                uint32_t child = flat.fanin[cell.first + next++];
+                if (on_path[child]) {
+                    L_WARN("%s has a combinational loop.",
+                        path.string().c_str());
+                    return ERROR(Error::NOT_COMBINATIONAL);
+                } else if (order[child] == NO_NET) {
+                    on_path[child] = true;
+                    stack.push_back({ child, 0 });
+                }
+                continue;
+            }
+            fanin.clear();
+            for (uint32_t j = 0; j < cell.size; j++) {
+                fanin.push_back(order[flat.fanin[cell.first + j]]);
+            }
+            order[id]   = n.add(cell.op, fanin, cell.table);
+            on_path[id] = false;
+            stack.pop_back();
+        }
+    }
+    for (size_t i = 0; i < out.size(); i++) {
+        n.outputs.push_back(
+            { Node { static_cast<uint16_t>(i), Node::OUTPUT }, order[out[i]] });
+    }
+    netlist = std::move(n);
+    L_INFO("Imported %zu cells from %s.", netlist.gate_count(),
+        path.string().c_str());
+    return Error::OK;
+}
+
+/******************************************************************************
+                                    Writing
+*****************************************************************************/
+
+/** Module names of a scene and the scenes it depends on. */
+struct ModuleNames {
+    std::vector<const Scene*> scenes;
+    std::vector<std::string> names;
+    /** Module of each dependency of each scene. */
+    std::vector<std::vector<size_t>> deps;
+    std::unordered_map<std::string, size_t> index;
+    std::unordered_set<std::string> used;
+};
+
+static bool _is_keyword(const std::string& name)
+{
+    static const char* keywords[]
+        = { "module", "endmodule", "input", "output", "inout", "wire", "reg",
+              "assign", "buf", "not", "and", "or", "xor", "nand", "nor",
+              "xnor", "supply0", "supply1", "always", "initial" };
+    for (const char* keyword : keywords) {
+        if (name == keyword) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** An identifier that is valid in both formats and not used yet. */
+static std::string _identifier(const char* name, ModuleNames& names)
+{
+    std::string id;
+    for (const char* c = name; *c != '\0'; c++) {
+        id += std::isalnum(static_cast<unsigned char>(*c)) ? *c : '_';
+    }
+    if (id.empty()) {
+        id = "top";
+    } else if (std::isdigit(static_cast<unsigned char>(id[0]))) {
+        id.insert(0, "m");
+    }
+    if (_is_keyword(id)) {
+        id += '_';
+    }
+    std::string unique = id;
+    for (size_t i = 2; !names.used.insert(unique).second; i++) {
+        unique = id + "_" + std::to_string(i);
+    }
+    return unique;
+}
+
+static size_t _collect(const Scene& scene, ModuleNames& names)
+{
+    size_t idx = names.scenes.size();
+    names.scenes.push_back(&scene);
+    names.names.push_back(_identifier(scene.name().data(), names));
+    names.deps.emplace_back();
+    for (const Scene& dep : scene.dependencies()) {
+        auto it    = names.index.find(dep.to_dependency());
+        size_t dep_idx = it != names.index.end() ? it->second
+                                                 : _collect(dep, names);
+        names.index.emplace(dep.to_dependency(), dep_idx);
+        names.deps[idx].push_back(dep_idx);
+    }
+    return idx;
+}
+
+/** Name of the net a socket of a node drives, empty for constant false. */
+static std::string _net(const Scene& scene, relid id)
+{
+    auto r = scene.get_rel(id);
+    if (id == 0 || r == nullptr) {
+        return "";
+    }
+    std::string index = std::to_string(r->from_node.index);
+    std::string sock  = "_" + std::to_string(r->from_sock);
+    switch (r->from_node.type) {
+    case Node::INPUT:
+        return (scene.component_context.has_value() ? "i" : "in") + index;
+    case Node::COMPONENT_INPUT:
+        return "in" + std::to_string(r->from_node.index - 1);
+    case Node::GATE: return "g" + index;
+    case Node::LUT: return "l" + index;
+    case Node::SEQUENTIAL: return "s" + index + sock;
+    case Node::COMPONENT: return "c" + index + sock;
+    default: return "";
+    }
+}
+
+/** Ports of a scene, the net that drives each output and its constants. */
+struct ModulePorts {
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    std::vector<std::string> drivers;
+    /** Input nodes of a component, which are constants. */
+    std::vector<std::pair<std::string, bool>> constants;
+};
+
+LCS_ERROR static _ports(const Scene& scene, ModulePorts& ports)
+{
+    for (const Memory& memory : scene._memories) {
+        if (!memory.is_null()) {
+            L_WARN("%s has memories, which netlists do not have.",
+                scene.name().data());
+            return ERROR(Error::UNSUPPORTED_NETLIST);
+        }
+    }
+    for (const Sequential& seq : scene._sequentials) {
+        if (seq.is_null()) {
+            continue;
+        }
+        bool is_supported = seq.type() == Sequential::Type::D_FLIPFLOP
+            || seq.type() == Sequential::Type::D_LATCH;
+        for (sockid i = 0; i < seq.inputs.size(); i++) {
+            if (i != 0 && i != seq.clock() && seq.inputs[i] != 0) {
+                is_supported = false;
+            }
+        }
+        if (!is_supported) {
+            L_WARN("%s has a %s with enable or reset, which netlists do not "
+                   "have.",
+                scene.name().data(), to_str<Sequential::Type>(seq.type()));
+            return ERROR(Error::UNSUPPORTED_NETLIST);
+        }
+    }
+    if (scene.component_context.has_value()) {
+        const ComponentContext& ctx = *scene.component_context;
+        for (size_t i = 0; i < ctx.inputs.size(); i++) {
+            ports.inputs.push_back("in" + std::to_string(i));
+        }
+        for (size_t i = 0; i < ctx.outputs.size(); i++) {
+            ports.outputs.push_back("out" + std::to_string(i));
+            ports.drivers.push_back(_net(scene, ctx.outputs[i]));
+        }
+        for (size_t i = 0; i < scene._inputs.size(); i++) {
+            if (!scene._inputs[i].is_null()) {
+                ports.constants.push_back({ "i" + std::to_string(i),
+                    scene._inputs[i].get() == TRUE });
+            }
+        }
+        return Error::OK;
+    }
+    for (size_t i = 0; i < scene._inputs.size(); i++) {
+        if (!scene._inputs[i].is_null()) {
+            ports.inputs.push_back("in" + std::to_string(i));
+        }
+    }
+    for (size_t i = 0; i < scene._outputs.size(); i++) {
+        if (!scene._outputs[i].is_null()) {
+            ports.outputs.push_back("out" + std::to_string(i));
+            ports.drivers.push_back(_net(scene, scene._outputs[i].input));
+        }
+    }
+    return Error::OK;
+}
+
+static const char* GATE_NAMES[Gate::TYPE_S]
+    = { "not", "and", "or", "xor", "nand", "nor", "xnor" };
+
+/** Verilog operand of a net, constant false if it is not connected. */
+static std::string _operand(const std::string& net)
+{
+    return net.empty() ? "1'b0" : net;
+}
+
+LCS_ERROR static _write_verilog(const Scene& scene, const std::string& name,
+    const std::vector<std::string>& deps, std::string& out)
+{
+    ModulePorts ports;
+    if (Error err = _ports(scene, ports); err) {
+        return err;
+    }
+    out += "module " + name + "(";
+    std::vector<std::string> all = ports.inputs;
+    all.insert(all.end(), ports.outputs.begin(), ports.outputs.end());
+    for (size_t i = 0; i < all.size(); i++) {
+        out += (i == 0 ? "" : ", ") + all[i];
+    }
+    out += ");\n";
+    for (const std::string& port : ports.inputs) {
+        out += "    input " + port + ";\n";
+    }
+    for (const std::string& port : ports.outputs) {
+        out += "    output " + port + ";\n";
+    }
+    for (const auto& [net, value] : ports.constants) {
+        out += "    wire " + net + " = " + (value ? "1'b1" : "1'b0") + ";\n";
+    }
+
+    // Nets are declared first since a cell may use any of them.
+    std::string cells;
+
+    for (size_t i = 0; i < scene._gates.size(); i++) {
+        const Gate& gate = scene._gates[i];
+        if (gate.is_null()) {
+            continue;
+        }
+        std::string net = "g" + std::to_string(i);
+        out += "    wire " + net + ";\n";
+        if (!gate.is_connected()) {
+            // Netlist::compile holds gates with an open input low.
+            cells += "    assign " + net + " = 1'b0;\n";
+            continue;
+        }
+        cells += std::string { "    " } + GATE_NAMES[gate.type()] + " (" + net;
+        for (relid in : gate.inputs) {
+            cells += ", " + _operand(_net(scene, in));
+        }
+        cells += ");\n";
+    }
+    for (size_t i = 0; i < scene._luts.size(); i++) {
+        const Lut& lut = scene._luts[i];
+        if (lut.is_null()) {
+            continue;
+        }
+        std::string net = "l" + std::to_string(i);
+        std::string sum;
+        for (size_t m = 0; m < (size_t { 1 } << lut.inputs.size()); m++) {
+            if (!lut.is_connected() || !lut.lookup(m)) {
+                continue;
+            }
+            std::string product;
+            for (size_t b = 0; b < lut.inputs.size(); b++) {
+                product += (b == 0 ? "" : " & ");
+                product += ((m >> b) & 1 ? "" : "~")
+                    + _operand(_net(scene, lut.inputs[b]));
+            }
+            sum += (sum.empty() ? "" : " | ")
+                + (product.empty() ? "1'b1" : product);
+        }
+        out += "    wire " + net + ";\n";
+        cells += "    assign " + net + " = " + (sum.empty() ? "1'b0" : sum)
+            + ";\n";
+    }
+    for (size_t i = 0; i < scene._sequentials.size(); i++) {
+        const Sequential& seq = scene._sequentials[i];
+        if (seq.is_null()) {
+            continue;
+        }
+        std::string net = "s" + std::to_string(i);
+        bool is_dff     = seq.type() == Sequential::Type::D_FLIPFLOP;
+        out += "    wire " + net + "_0, " + net + "_1;\n";
+        cells += std::string { "    \\" }
+            + (is_dff ? "$_DFF_P_" : "$_DLATCH_P_") + " " + net + " (.D("
+            + _operand(_net(scene, seq.inputs[0])) + "), ."
+            + (is_dff ? "C" : "E") + "("
+            + _operand(_net(scene, seq.inputs[seq.clock()])) + "), .Q("
+            + net + "_0));\n";
+        cells += "    assign " + net + "_1 = ~" + net + "_0;\n";
+    }
+    for (size_t i = 0; i < scene._components.size(); i++) {
+        const Component& component = scene._components[i];
+        if (component.is_null()) {
+            continue;
+        }
+        std::string net = "c" + std::to_string(i);
+        size_t input_s  = component.inputs.size();
+        for (const auto& [sock, _] : component.outputs) {
+            out += "    wire " + net + "_" + std::to_string(sock) + ";\n";
+        }
+        std::vector<std::string> conns;
+        for (size_t s = 0; s < input_s; s++) {
+            // Socket s is the input of the component from the highest.
+            conns.push_back(".in" + std::to_string(input_s - 1 - s) + "("
+                + _operand(_net(scene, component.inputs[s])) + ")");
+        }
+        for (const auto& [sock, _] : component.outputs) {
+            std::string id = std::to_string(sock);
+            conns.push_back(".out" + id + "(" + net + "_" + id + ")");
+        }
+        cells += "    " + deps[component.dep_idx] + " " + net + " (";
+        for (size_t j = 0; j < conns.size(); j++) {
+            cells += (j == 0 ? "" : ", ") + conns[j];
+        }
+        cells += ");\n";
+    }
+    out += cells;
+    for (size_t i = 0; i < ports.outputs.size(); i++) {
+        out += "    assign " + ports.outputs[i] + " = "
+            + _operand(ports.drivers[i]) + ";\n";
+    }
+    out += "endmodule\n\n";
+    return Error::OK;
+}
+
+/** Net that is constant false, defined once a cover refers to it. */
+static constexpr const char* BLIF_ZERO = "zero";
+
+LCS_ERROR static _write_blif(const Scene& scene, const std::string& name,
+    const std::vector<std::string>& deps, std::string& out)
+{
+    ModulePorts ports;
+    if (Error err = _ports(scene, ports); err) {
+        return err;
+    }
+    bool has_zero = false;
+    auto net      = [&](relid id) {
+        std::string net = _net(scene, id);
+        if (net.empty()) {
+            has_zero = true;
+            return std::string { BLIF_ZERO };
+        }
+        return net;
+    };
+    out += ".model " + name + "\n.inputs";
+    for (const std::string& port : ports.inputs) {
+        out += " " + port;
+    }
+    out += "\n.outputs";
+    for (const std::string& port : ports.outputs) {
+        out += " " + port;
+    }
+    out += "\n";
+    for (const auto& [net, value] : ports.constants) {
+        out += ".names " + net + (value ? "\n1\n" : "\n");
+    }
+
+    for (size_t i = 0; i < scene._gates.size(); i++) {
+        const Gate& gate = scene._gates[i];
+        if (gate.is_null()) {
+            continue;
+        }
+        size_t input_s = gate.inputs.size();
+        if (input_s > Lut::MAX_INPUT) {
+            L_WARN("%s has a gate with more than %d inputs.",
+                scene.name().data(), Lut::MAX_INPUT);
+            return ERROR(Error::UNSUPPORTED_NETLIST);
+        }
+        if (!gate.is_connected()) {
+            out += ".names g" + std::to_string(i) + "\n";
+            continue;
+        }
+        out += ".names";
+        for (relid in : gate.inputs) {
+            out += " " + net(in);
+        }
+        out += " g" + std::to_string(i) + "\n";
+        // Cubes of the on-set, each a row of the inputs and the output.
+        switch (gate.type()) {
+        case Gate::NOT: out += "0 1\n"; break;
+        case Gate::AND: out += std::string(input_s, '1') + " 1\n"; break;
+        case Gate::NOR: out += std::string(input_s, '0') + " 1\n"; break;
+        case Gate::OR:
+        case Gate::NAND:
+            for (size_t b = 0; b < input_s; b++) {
+                std::string row(input_s, '-');
+                row[b] = gate.type() == Gate::OR ? '1' : '0';
+                out += row + " 1\n";
+            }
+            break;
+        default: {
+            Lut::Table table = _gate_table(gate.type(), input_s);
+            for (size_t m = 0; m < (size_t { 1 } << input_s); m++) {
+                if (table[m]) {
+                    for (size_t b = 0; b < input_s; b++) {
+                        out += (m >> b) & 1 ? '1' : '0';
+                    }
+                    out += " 1\n";
+                }
+            }
+        }
+        }
+    }
+    for (size_t i = 0; i < scene._luts.size(); i++) {
+        const Lut& lut = scene._luts[i];
+        if (lut.is_null()) {
+            continue;
+        }
+        if (!lut.is_connected()) {
+            out += ".names l" + std::to_string(i) + "\n";
+            continue;
+        }
+        out += ".names";
+        for (relid in : lut.inputs) {
+            out += " " + net(in);
+        }
+        out += " l" + std::to_string(i) + "\n";
+        for (size_t m = 0; m < (size_t { 1 } << lut.inputs.size()); m++) {
+            if (!lut.lookup(m)) {
+                continue;
+            }
+            for (size_t b = 0; b < lut.inputs.size(); b++) {
+                out += (m >> b) & 1 ? '1' : '0';
+            }
+            out += lut.inputs.empty() ? "1\n" : " 1\n";
+        }
+    }
+    for (size_t i = 0; i < scene._sequentials.size(); i++) {
+        const Sequential& seq = scene._sequentials[i];
+        if (seq.is_null()) {
+            continue;
+        }
+        std::string q = "s" + std::to_string(i) + "_0";
+        out += ".latch " + net(seq.inputs[0]) + " " + q + " "
+            + (seq.type() == Sequential::Type::D_FLIPFLOP ? "re " : "ah ")
+            + net(seq.inputs[seq.clock()]) + " "
+            + std::to_string(seq.value() & 1) + "\n";
+        out += ".names " + q + " s" + std::to_string(i) + "_1\n0 1\n";
+    }
+    for (size_t i = 0; i < scene._components.size(); i++) {
+        const Component& component = scene._components[i];
+        if (component.is_null()) {
+            continue;
+        }
+        size_t input_s = component.inputs.size();
+        out += ".subckt " + deps[component.dep_idx];
+        for (size_t s = 0; s < input_s; s++) {
+            out += " in" + std::to_string(input_s - 1 - s) + "="
+                + net(component.inputs[s]);
+        }
+        for (const auto& [sock, _] : component.outputs) {
+            std::string id = std::to_string(sock);
+            out += " out" + id + "=c" + std::to_string(i) + "_" + id;
+        }
+        out += "\n";
+    }
+    for (size_t i = 0; i < ports.outputs.size(); i++) {
+        if (ports.drivers[i].empty()) {
+            out += ".names " + ports.outputs[i] + "\n";
+        } else {
+            out += ".names " + ports.drivers[i] + " " + ports.outputs[i]
+                + "\n1 1\n";
+        }
+    }
+    if (has_zero) {
+        out += ".names " + std::string { BLIF_ZERO } + "\n";
+    }
+    out += ".end\n\n";
+    return Error::OK;
+}
+
+Error write_scene(const Scene& scene, const std::filesystem::path& path)
+{
+    ModuleNames names;
+    _collect(scene, names);
+    std::string out;
+    for (size_t i = 0; i < names.scenes.size(); i++) {
+        std::vector<std::string> deps;
+        for (size_t dep : names.deps[i]) {
+            deps.push_back(names.names[dep]);
+        }
+        Error err = format_of(path) == BLIF
+            ? _write_blif(*names.scenes[i], names.names[i], deps, out)
+            : _write_verilog(*names.scenes[i], names.names[i], deps, out);
+        if (err) {
+            return err;
+        }
+    }
+
+    if (!fs::write_atomic(path, out)) {
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+    return Error::OK;
+}
+
+} // namespace ic::hdl
@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <queue>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+uint32_t Scene::level(Node node) const
+{
+    auto l = _levels.find(node.numeric());
+    return l != _levels.end() ? l->second : 0;
+}
+
+bool Scene::is_feedback(relid id) const
+{
+    return _feedback.find(id) != _feedback.end();
+}
+
+void Scene::_fanout(Node node, const std::function<void(relid)>& fn)
+{
+    switch (node.type) {
+    case Node::Type::GATE: {
+        auto g = get_node<Gate>(node);
+        if (g != nullptr) {
+            std::for_each(g->output.begin(), g->output.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::COMPONENT: {
+        auto c = get_node<Component>(node);
+        if (c != nullptr) {
+            for (const auto& [_, out] : c->outputs) {
+                std::for_each(out.begin(), out.end(), fn);
+            }
+        }
+        break;
+    }
+    case Node::Type::INPUT: {
+        auto in = get_node<Input>(node);
+        if (in != nullptr) {
+            std::for_each(in->output.begin(), in->output.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::SEQUENTIAL: {
+        auto seq = get_node<Sequential>(node);
+        if (seq != nullptr) {
+            for (const auto& [_, out] : seq->outputs) {
+                std::for_each(out.begin(), out.end(), fn);
+            }
+        }
+        break;
+    }
+    case Node::Type::LUT: {
+        auto lut = get_node<Lut>(node);
+        if (lut != nullptr) {
+            std::for_each(lut->output.begin(), lut->output.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::MEMORY: {
+        auto memory = get_node<Memory>(node);
+        if (memory != nullptr) {
+            for (const auto& [_, out] : memory->outputs) {
+                std::for_each(out.begin(), out.end(), fn);
+            }
+        }
+        break;
+    }
+    case Node::Type::COMPONENT_INPUT:
+        if (component_context.has_value()
+            && component_context->inputs.size() > node.index - 1u) {
+            const auto& out = component_context->inputs[node.index - 1];
+            std::for_each(out.begin(), out.end(), fn);
+        }
+        break;
+    default: break;
+    }
+}
+
+void Scene::_fanin(Node node, const std::function<void(relid)>& fn)
+{
+    switch (node.type) {
+    case Node::Type::GATE: {
+        auto g = get_node<Gate>(node);
+        if (g != nullptr) {
+            std::for_each(g->inputs.begin(), g->inputs.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::COMPONENT: {
+        auto c = get_node<Component>(node);
+        if (c != nullptr) {
+            std::for_each(c->inputs.begin(), c->inputs.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::SEQUENTIAL: {
+        auto seq = get_node<Sequential>(node);
+        if (seq != nullptr) {
+            std::for_each(seq->inputs.begin(), seq->inputs.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::LUT: {
+        auto lut = get_node<Lut>(node);
+        if (lut != nullptr) {
+            std::for_each(lut->inputs.begin(), lut->inputs.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::MEMORY: {
+        auto memory = get_node<Memory>(node);
+        if (memory != nullptr) {
+            std::for_each(memory->inputs.begin(), memory->inputs.end(), fn);
+        }
+        break;
+    }
+    case Node::Type::OUTPUT: {
+        auto o = get_node<Output>(node);
+        if (o != nullptr) {
+            fn(o->input);
+        }
+        break;
+    }
+    case Node::Type::COMPONENT_OUTPUT:
+        if (component_context.has_value()
+            && component_context->outputs.size() > node.index - 1u) {
+            fn(component_context->outputs[node.index - 1]);
+        }
+        break;
+    default: break;
+    }
+}
+
+bool Scene::_is_clocked(Node node)
+{
+    if (node.type != Node::Type::SEQUENTIAL) {
+        return false;
+    }
+    auto seq = get_node<Sequential>(node);
+    return seq != nullptr && seq->is_clocked();
+}
+
+uint32_t Scene::_source_level(Node node)
+{
+    return _is_clocked(node) ? 0 : level(node);
+}
+
+/** Pending node of a level update, ordered by the level it had before. */
+struct LevelEntry {
+    uint32_t level;
+    uint32_t key;
+    bool operator>(const LevelEntry& e) const { return level > e.level; }
+};
+using LevelQueue = std::priority_queue<LevelEntry, std::vector<LevelEntry>,
+    std::greater<LevelEntry>>;
+
+bool Scene::_raise_levels(Node from, Node to)
+{
+    uint32_t from_key  = from.numeric();
+    uint32_t min_level = _source_level(from) + 1;
+    if (level(to) >= min_level) {
+        return true;
+    }
+    // Nodes are visited in the order of their old level. All predecessors
+    // of a node in the cone have a smaller level, so each node is only
+    // updated once.
+    std::unordered_map<uint32_t, uint32_t> proposed { { to.numeric(),
+        min_level } };
+    std::vector<std::pair<uint32_t, uint32_t>> changed;
+    LevelQueue queue;
+    queue.push({ level(to), to.numeric() });
+    while (!queue.empty()) {
+        uint32_t key = queue.top().key;
+        queue.pop();
+        if (key == from_key && !_is_clocked(from)) {
+            // The source is reachable from the target, so the relation
+            // closes a loop. Undo the partial update.
+            for (auto it = changed.rbegin(); it != changed.rend(); it++) {
+                _levels[it->first] = it->second;
+            }
+            return false;
+        }
+        uint32_t& current = _levels[key];
+        uint32_t next     = proposed[key];
+        if (current >= next) {
+            continue;
+        }
+        changed.emplace_back(key, current);
+        current = next;
+        if (_is_clocked(Node::from_numeric(key))) {
+            continue;
+        }
+        _fanout(Node::from_numeric(key), [&](relid id) {
+            auto r = get_rel(id);
+            if (r == nullptr || is_feedback(id)) {
+                return;
+            }
+            uint32_t out = r->to_node.numeric();
+            auto p       = proposed.find(out);
+            if (p == proposed.end()) {
+                proposed.emplace(out, next + 1);
+                queue.push({ level(r->to_node), out });
+            } else if (p->second < next + 1) {
+                p->second = next + 1;
+            }
+        });
+    }
+    L_DEBUG("Raised the levels of %zu nodes.", changed.size());
+    return true;
+}
+
+void Scene::_lower_levels(Node node)
+{
+    std::unordered_set<uint32_t> queued { node.numeric() };
+    LevelQueue queue;
+    queue.push({ level(node), node.numeric() });
+    size_t count = 0;
+    while (!queue.empty()) {
+        uint32_t key = queue.top().key;
+        queue.pop();
+        Node n         = Node::from_numeric(key);
+        uint32_t lower = 0;
+        _fanin(n, [&](relid id) {
+            auto r = get_rel(id);
+            if (r != nullptr && !is_feedback(id)) {
+                lower = std::max(lower, _source_level(r->from_node) + 1);
+            }
+        });
+        auto l = _levels.find(key);
+        if (l == _levels.end() || l->second <= lower) {
+            continue;
+        }
+        count++;
+        if (lower == 0) {
+            _levels.erase(l);
+        } else {
+            l->second = lower;
+        }
+        if (_is_clocked(n)) {
+            continue;
+        }
+        _fanout(n, [&](relid id) {
+            auto r = get_rel(id);
+            if (r != nullptr && !is_feedback(id)
+                && queued.insert(r->to_node.numeric()).second) {
+                queue.push({ level(r->to_node), r->to_node.numeric() });
+            }
+        });
+    }
+    L_DEBUG("Lowered the levels of %zu nodes.", count);
+}
+
+bool Scene::_reaches(Node from, Node to)
+{
+    uint32_t to_key = to.numeric();
+    std::unordered_set<uint32_t> visited { from.numeric() };
+    std::vector<Node> stack { from };
+    while (!stack.empty()) {
+        Node n = stack.back();
+        stack.pop_back();
+        if (n.numeric() == to_key) {
+            return true;
+        } else if (_is_clocked(n)) {
+            continue;
+        }
+        _fanout(n, [&](relid id) {
+            auto r = get_rel(id);
+            if (r != nullptr && visited.insert(r->to_node.numeric()).second) {
+                stack.push_back(r->to_node);
+            }
+        });
+    }
+    return false;
+}
+
+void Scene::_compute_levels(void)
+{
+    _levels.clear();
+    _feedback.clear();
+    // Depth first search over the relations that do not leave a clocked
+    // node. A relation to a node on the current path closes a loop and
+    // becomes a feedback relation, the rest form a DAG whose reverse
+    // postorder is a topological order.
+    enum Mark : uint8_t { NEW, ON_PATH, DONE };
+    std::unordered_map<uint32_t, Mark> marks;
+    std::vector<Node> order;
+    struct Frame {
+        Node node;
+        std::vector<relid> fanout;
+        size_t next;
+    };
+    std::vector<Frame> stack;
+    auto visit = [&](Node node) {
+        marks[node.numeric()] = ON_PATH;
+        stack.push_back({ node, {}, 0 });
+        if (!_is_clocked(node)) {
+            _fanout(node, [&](relid id) { stack.back().fanout.push_back(id); });
+        }
+    };
+    for (const auto& [_, root] : _relations) {
+        if (marks[root.from_node.numeric()] != NEW) {
+            continue;
+        }
+        visit(root.from_node);
+        while (!stack.empty()) {
+            Frame& frame = stack.back();
+            if (frame.next == frame.fanout.size()) {
+                marks[frame.node.numeric()] = DONE;
+                order.push_back(frame.node);
+                stack.pop_back();
+                continue;
+            }
+            relid id = frame.fanout[frame.next++];
+            auto r   = get_rel(id);
+            if (r == nullptr) {
+                continue;
+            }
+            Mark mark = marks[r->to_node.numeric()];
+            if (mark == ON_PATH) {
+                _feedback.insert(id);
+            } else if (mark == NEW) {
+                visit(r->to_node);
+            }
+        }
+    }
+
+    // Clocked nodes are sources at level zero, so their fanout is at least
+    // at level one whatever order they are visited in.
+    for (const auto& [_, r] : _relations) {
+        if (_is_clocked(r.from_node)) {
+            _levels[r.to_node.numeric()] = 1;
+        }
+    }
+    for (auto it = order.rbegin(); it != order.rend(); it++) {
+        if (_is_clocked(*it)) {
+            continue;
+        }
+        uint32_t next = level(*it) + 1;
+        _fanout(*it, [&](relid id) {
+            auto r = get_rel(id);
+            if (r != nullptr && !is_feedback(id) && level(r->to_node) < next) {
+                _levels[r->to_node.numeric()] = next;
+            }
+        });
+    }
+    L_DEBUG("Computed the levels of %zu nodes.", _levels.size());
+}
+
+} // namespace ic
@@ -0,0 +1,313 @@
+#include <cstring>
+#include <mutex>
+#include "common.h"
+#include "core.h"
+
+namespace ic::library {
+
+/**
+ * The index is "ICP", INDEX_VERSION, the number of packages and the number
+ * of slots, followed by the slots and then the names. A slot is empty when
+ * its key is zero, otherwise it holds a package whose name hashes to the
+ * key. A package is placed at the first empty slot starting from its key
+ * modulo the number of slots, which is a power of two that is at least
+ * twice the number of packages. Integers are little endian.
+ *
+ * A slot is the key, the blob hash, the size, the offset of the name in the
+ * file, the length of the name, the number of inputs and outputs and four
+ * reserved bytes.
+ */
+static constexpr uint8_t INDEX_VERSION = 1;
+static constexpr size_t INDEX_HEADER_S = 3 + 1 + 4 + 4;
+static constexpr size_t SLOT_S         = 32;
+static constexpr size_t MIN_SLOTS      = 8;
+
+/** Mapping of the index, replaced whenever the index file is. */
+static fs::MappedFile _index;
+static std::filesystem::file_time_type _index_time;
+/** Whether the index file has to be checked before the next lookup. */
+static bool _is_stale = true;
+static std::mutex _index_mtx;
+
+static uint64_t _load(const uint8_t* data, size_t size)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; i++) {
+        value |= static_cast<uint64_t>(data[i]) << (i * 8);
+    }
+    return value;
+}
+
+static void _store(uint8_t* data, uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        data[i] = value >> (i * 8);
+    }
+}
+
+/** Key of a name in the index, zero marks empty slots. */
+static uint64_t _key(const std::string& name)
+{
+    uint64_t key = hash64(name.data(), name.size());
+    return key == 0 ? 1 : key;
+}
+
+static std::filesystem::path _index_path(void)
+{
+    return fs::LIBRARY / "index";
+}
+
+std::filesystem::path blob_path(uint64_t hash)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ic",
+        static_cast<unsigned long long>(hash));
+    return fs::LIBRARY / "store" / name;
+}
+
+/**
+ * Maps the index again if the file was replaced since it was mapped.
+ * _index_mtx must be held.
+ * @returns whether there is a valid index
+ */
+static bool _sync(void)
+{
+    _is_stale = false;
+    std::error_code ec;
+    std::filesystem::path path = _index_path();
+    auto time                  = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        _index.close();
+        return false;
+    }
+    if (_index.data() != nullptr && time == _index_time
+        && std::filesystem::file_size(path, ec) == _index.size()) {
+        return true;
+    }
+    if (!_index.open(path)) {
+        return false;
+    }
+    const uint8_t* data = _index.data();
+    size_t size         = _index.size();
+    uint64_t slot_s     = size < INDEX_HEADER_S ? 0 : _load(data + 8, 4);
+    if (size < INDEX_HEADER_S || std::memcmp(data, "ICP", 3) != 0
+        || data[3] != INDEX_VERSION || slot_s < MIN_SLOTS
+        || (slot_s & (slot_s - 1)) != 0
+        || (size - INDEX_HEADER_S) / SLOT_S < slot_s
+        || _load(data + 4, 4) > slot_s / 2) {
+        L_WARN("Ignoring the damaged package index %s.",
+            path.string().c_str());
+        _index.close();
+        return false;
+    }
+    _index_time = time;
+    return true;
+}
+
+/** Reads slot i of the mapped index, false if it is empty or damaged. */
+static bool _read_slot(size_t i, Package& package)
+{
+    const uint8_t* slot = _index.data() + INDEX_HEADER_S + i * SLOT_S;
+    if (_load(slot, 8) == 0) {
+        return false;
+    }
+    size_t offset = _load(slot + 20, 4);
+    size_t name_s = _load(slot + 24, 2);
+    if (offset > _index.size() || name_s > _index.size() - offset) {
+        return false;
+    }
+    package.name.assign(
+        reinterpret_cast<const char*>(_index.data() + offset), name_s);
+    package.hash     = _load(slot + 8, 8);
+    package.size     = _load(slot + 16, 4);
+    package.input_s  = slot[26];
+    package.output_s = slot[27];
+    return true;
+}
+
+/**
+ * Reads every package of the index, _index_mtx must be held. A missing
+ * index has no packages, a damaged one is an error so that it is not
+ * overwritten with the packages that are known.
+ */
+LCS_ERROR static _read_all(std::vector<Package>& packages)
+{
+    packages.clear();
+    if (!_sync()) {
+        std::error_code ec;
+        return std::filesystem::exists(_index_path(), ec)
+            ? ERROR(Error::DAMAGED_INDEX)
+            : Error::OK;
+    }
+    size_t slot_s = _load(_index.data() + 8, 4);
+    Package package;
+    for (size_t i = 0; i < slot_s; i++) {
+        if (_read_slot(i, package)) {
+            packages.push_back(package);
+        }
+    }
+    return Error::OK;
+}
+
+/** Replaces the index with the given packages, _index_mtx must be held. */
+static bool _write_all(const std::vector<Package>& packages)
+{
+    size_t slot_s = MIN_SLOTS;
+    while (slot_s < packages.size() * 2) {
+        slot_s *= 2;
+    }
+    std::vector<uint8_t> data(INDEX_HEADER_S + slot_s * SLOT_S, 0);
+    std::memcpy(data.data(), "ICP", 3);
+    data[3] = INDEX_VERSION;
+    _store(data.data() + 4, packages.size(), 4);
+    _store(data.data() + 8, slot_s, 4);
+    for (const Package& package : packages) {
+        uint64_t key = _key(package.name);
+        uint8_t* slot;
+        for (size_t i = key;; i++) {
+            slot = data.data() + INDEX_HEADER_S + (i & (slot_s - 1)) * SLOT_S;
+            if (_load(slot, 8) == 0) {
+                break;
+            }
+        }
+        _store(slot, key, 8);
+        _store(slot + 8, package.hash, 8);
+        _store(slot + 16, package.size, 4);
+        _store(slot + 20, data.size(), 4);
+        _store(slot + 24, package.name.size(), 2);
+        slot[26] = package.input_s;
+        slot[27] = package.output_s;
+        data.insert(data.end(), package.name.begin(), package.name.end());
+    }
+    // The mapping would outlive the file it was taken from.
+    _index.close();
+    _is_stale = true;
+    return fs::write_atomic(_index_path(), data);
+}
+
+/** Deletes the blob unless one of the packages still refers to it. */
+static void _release(const std::vector<Package>& packages, uint64_t hash)
+{
+    for (const Package& package : packages) {
+        if (package.hash == hash) {
+            return;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::remove(blob_path(hash), ec);
+}
+
+Error install(const Scene& component)
+{
+    if (!component.component_context.has_value()) {
+        return ERROR(Error::NOT_A_COMPONENT);
+    }
+    std::vector<uint8_t> data;
+    uint8_t format = component.is_compressed
+        ? Scene::FORMAT_VERSION | Scene::FORMAT_COMPRESSED
+        : Scene::FORMAT_VERSION;
+    if (Error err = component.write_to(data, format); err) {
+        return err;
+    }
+    Package package {};
+    package.name     = component.to_dependency();
+    package.hash     = hash64(data.data(), data.size());
+    package.size     = data.size();
+    package.input_s  = component.component_context->inputs.size();
+    package.output_s = component.component_context->outputs.size();
+    if (package.name.size() > UINT16_MAX) {
+        return ERROR(Error::INVALID_DEPENDENCY_FORMAT);
+    }
+    std::filesystem::path path = blob_path(package.hash);
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec) && !fs::write_atomic(path, data)) {
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+
+    std::lock_guard<std::mutex> lock(_index_mtx);
+    std::vector<Package> packages;
+    if (Error err = _read_all(packages); err) {
+        return err;
+    }
+    uint64_t old_hash = package.hash;
+    for (size_t i = 0; i < packages.size(); i++) {
+        if (packages[i].name == package.name) {
+            old_hash = packages[i].hash;
+            packages.erase(packages.begin() + i);
+            break;
+        }
+    }
+    packages.push_back(package);
+    if (!_write_all(packages)) {
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+    _release(packages, old_hash);
+    forget_dependency(package.name);
+    L_INFO("%s is installed.", package.name.c_str());
+    return Error::OK;
+}
+
+Error remove(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_index_mtx);
+    std::vector<Package> packages;
+    if (Error err = _read_all(packages); err) {
+        return err;
+    }
+    for (size_t i = 0; i < packages.size(); i++) {
+        if (packages[i].name == name) {
+            uint64_t hash = packages[i].hash;
+            packages.erase(packages.begin() + i);
+            if (!_write_all(packages)) {
+                return ERROR(Error::NO_SAVE_PATH_DEFINED);
+            }
+            _release(packages, hash);
+            forget_dependency(name);
+            return Error::OK;
+        }
+    }
+    return ERROR(Error::COMPONENT_NOT_FOUND);
+}
+
+bool find(const std::string& name, Package& package)
+{
+    uint64_t key = _key(name);
+    std::lock_guard<std::mutex> lock(_index_mtx);
+    if (_is_stale) {
+        _sync();
+    }
+    if (_index.data() == nullptr) {
+        return false;
+    }
+    size_t slot_s = _load(_index.data() + 8, 4);
+    for (size_t i = 0; i < slot_s; i++) {
+        size_t slot = (key + i) & (slot_s - 1);
+        uint64_t slot_key
+            = _load(_index.data() + INDEX_HEADER_S + slot * SLOT_S, 8);
+        if (slot_key == 0) {
+            return false;
+        } else if (slot_key == key && _read_slot(slot, package)
+            && package.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void refresh(void)
+{
+    std::lock_guard<std::mutex> lock(_index_mtx);
+    _is_stale = true;
+}
+
+std::vector<Package> list(void)
+{
+    std::lock_guard<std::mutex> lock(_index_mtx);
+    std::vector<Package> packages;
+    if (_read_all(packages) != Error::OK) {
+        return {};
+    }
+    return packages;
+}
+
+} // namespace ic::library
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+const std::vector<Scene::FeedbackLoop>& Scene::loops(void)
+{
+    if (_loops_dirty) {
+        _find_loops();
+    }
+    return _loops;
+}
+
+bool Scene::is_oscillating(void) const
+{
+    return std::any_of(_loops.begin(), _loops.end(),
+        [](const FeedbackLoop& loop) { return loop.oscillating; });
+}
+
+void Scene::_find_loops(void)
+{
+    std::unordered_map<uint32_t, std::vector<uint32_t>> edges;
+    for (const auto& [id, rel] : _relations) {
+        // The output of a flip-flop does not depend on its inputs until the
+        // next clock edge, so it can not be a part of a combinational loop.
+        if (!_is_clocked(rel.from_node)) {
+            edges[rel.from_node.numeric()].push_back(rel.to_node.numeric());
+        }
+    }
+
+    // Iterative Tarjan, the recursive version overflows the stack on long
+    // chains of gates.
+    struct Frame {
+        uint32_t node;
+        size_t edge;
+    };
+    struct Visit {
+        uint32_t index;
+        uint32_t low;
+        bool on_stack;
+    };
+    std::unordered_map<uint32_t, Visit> visits;
+    std::vector<uint32_t> stack;
+    std::vector<Frame> calls;
+    uint32_t counter = 0;
+    auto visit       = [&](uint32_t node) {
+        visits[node] = Visit { counter, counter, true };
+        counter++;
+        stack.push_back(node);
+        calls.push_back(Frame { node, 0 });
+    };
+
+    std::vector<FeedbackLoop> loops;
+    for (const auto& [root, _] : edges) {
+        if (visits.find(root) != visits.end()) {
+            continue;
+        }
+        visit(root);
+        while (!calls.empty()) {
+            uint32_t node = calls.back().node;
+            auto out      = edges.find(node);
+            if (out != edges.end() && calls.back().edge < out->second.size()) {
+                uint32_t next = out->second[calls.back().edge++];
+                auto v        = visits.find(next);
+                if (v == visits.end()) {
+                    visit(next);
+                } else if (v->second.on_stack) {
+                    Visit& current = visits[node];
+                    current.low    = std::min(current.low, v->second.index);
+                }
+                continue;
+            }
+            calls.pop_back();
+            Visit& v = visits[node];
+            if (!calls.empty()) {
+                Visit& caller = visits[calls.back().node];
+                caller.low    = std::min(caller.low, v.low);
+            }
+            if (v.low != v.index) {
+                continue;
+            }
+            FeedbackLoop loop {};
+            uint32_t member = 0;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                visits[member].on_stack = false;
+                loop.nodes.push_back(Node::from_numeric(member));
+            } while (member != node);
+            // A single node is only a loop if it is connected to itself.
+            if (loop.nodes.size() > 1
+                || (out != edges.end()
+                    && std::find(out->second.begin(), out->second.end(), node)
+                        != out->second.end())) {
+                loops.push_back(std::move(loop));
+            }
+        }
+    }
+
+    // Keep the oscillation state of the loops that still exist.
+    std::unordered_set<uint32_t> oscillating;
+    for (const auto& loop : _loops) {
+        if (loop.oscillating) {
+            for (const auto& node : loop.nodes) {
+                oscillating.insert(node.numeric());
+            }
+        }
+    }
+    _loop_of.clear();
+    for (size_t i = 0; i < loops.size(); i++) {
+        for (const auto& node : loops[i].nodes) {
+            _loop_of[node.numeric()] = i;
+            if (oscillating.find(node.numeric()) != oscillating.end()) {
+                loops[i].oscillating = true;
+            }
+        }
+    }
+    _loops       = std::move(loops);
+    _loops_dirty = false;
+
+    // A feedback edge stops being one when its loop is broken, in which case
+    // it is ordered like any other relation.
+    std::vector<relid> broken;
+    for (relid id : _feedback) {
+        auto r = get_rel(id);
+        if (r == nullptr) {
+            broken.push_back(id);
+            continue;
+        }
+        auto from = _loop_of.find(r->from_node.numeric());
+        auto to   = _loop_of.find(r->to_node.numeric());
+        if (from == _loop_of.end() || to == _loop_of.end()
+            || from->second != to->second) {
+            broken.push_back(id);
+        }
+    }
+    for (relid id : broken) {
+        _feedback.erase(id);
+        auto r = get_rel(id);
+        if (r != nullptr && !_raise_levels(r->from_node, r->to_node)) {
+            _feedback.insert(id);
+        }
+    }
+    L_DEBUG("%s has %zu feedback loops.", name().data(), _loops.size());
+}
+
+void Scene::_converge(void)
+{
+    _converging = true;
+    std::unordered_set<uint32_t> failed;
+    while (!_pending.empty()) {
+        Node node = _pending.front();
+        _pending.pop_front();
+        uint32_t key = node.numeric();
+        _queued.erase(key);
+        auto loop = _loop_of.find(key);
+        if (loop == _loop_of.end()) {
+            // The loop was broken while the node was waiting.
+            get_base(node)->on_signal();
+            continue;
+        }
+        size_t& count = _evals[key];
+        if (count >= loop_limit) {
+            if (failed.insert(loop->second).second) {
+                L_WARN("%s: Feedback loop of %s@%d did not converge after %zu "
+                       "iterations.",
+                    name().data(), to_str<Node::Type>(node.type), node.index,
+                    loop_limit);
+            }
+            continue;
+        }
+        count++;
+        get_base(node)->on_signal();
+    }
+    for (const auto& [key, _] : _evals) {
+        auto loop = _loop_of.find(key);
+        if (loop != _loop_of.end()) {
+            _loops[loop->second].oscillating
+                = failed.find(loop->second) != failed.end();
+        }
+    }
+    _evals.clear();
+    _converging = false;
+}
+
+} // namespace ic
@@ -0,0 +1,228 @@
+#include <algorithm>
+#include <deque>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+Lut::Lut(Scene* _scene, sockid input_s, const Table& table)
+    : BaseNode { _scene }
+    , _table { table }
+{
+    inputs.resize(std::min(input_s, MAX_INPUT), 0);
+}
+
+void Lut::set_table(const Table& table)
+{
+    Table old_table = _table;
+    _parent->undo.push([this, old_table]() { set_table(old_table); });
+    _table = table;
+    on_signal();
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
+    }
+}
+
+bool Lut::is_connected(void) const
+{
+    return std::all_of(
+        inputs.begin(), inputs.end(), [](relid i) { return i != 0; });
+}
+
+State Lut::get(sockid) const { return _value; }
+
+void Lut::on_signal(void)
+{
+    if (is_connected()) {
+        uint32_t index = 0;
+        for (size_t i = 0; i < inputs.size(); i++) {
+            auto rel = _parent->get_rel(inputs[i]);
+            ic_assert(rel != nullptr);
+            if (rel->value == TRUE) {
+                index |= 1u << i;
+            }
+        }
+        _value = lookup(index) ? State::TRUE : State::FALSE;
+    } else {
+        _value = State::DISABLED;
+    }
+    for (relid out : output) {
+        _parent->signal(out, _value);
+    }
+}
+
+void Lut::clean(void)
+{
+    // disconnect removes the id from the vector that is being iterated.
+    std::vector<relid> copy = output;
+    for (relid r : copy) {
+        _parent->disconnect(r);
+    }
+    for (relid r : inputs) {
+        if (r != 0) {
+            _parent->disconnect(r);
+        }
+    }
+}
+
+/** Where a node of the collapsed group reads one of its inputs from. */
+struct Operand {
+    /** Whether the value comes from another node in the group. */
+    bool internal;
+    /** Position in the evaluation order, or the input of the Lut. */
+    size_t index;
+};
+
+Error Scene::collapse(const std::vector<Node>& nodes, Node& lut)
+{
+    // Maps Node::numeric of each node in the group to its position in the
+    // evaluation order.
+    std::unordered_map<uint32_t, size_t> group;
+    std::vector<Node> members;
+    for (Node n : nodes) {
+        if ((n.type != Node::GATE && n.type != Node::LUT)
+            || get_base(n) == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        if (group.emplace(n.numeric(), 0).second) {
+            members.push_back(n);
+        }
+    }
+
+    std::vector<std::pair<Node, sockid>> sources;
+    std::map<std::pair<uint32_t, sockid>, size_t> source_of;
+    std::unordered_map<uint32_t, size_t> fanin;
+    std::vector<Node> roots;
+    bool is_connected = true;
+    for (Node n : members) {
+        size_t& internal = fanin[n.numeric()];
+        _fanin(n, [&](relid id) {
+            auto r = get_rel(id);
+            if (r == nullptr) {
+                is_connected = false;
+            } else if (group.find(r->from_node.numeric()) != group.end()) {
+                internal++;
+            } else if (source_of
+                           .emplace(std::make_pair(r->from_node.numeric(),
+                                        r->from_sock),
+                               sources.size())
+                           .second) {
+                sources.emplace_back(r->from_node, r->from_sock);
+            }
+        });
+        // The output of the group is the node that is either used outside
+        // of it or not used at all.
+        bool is_used_inside  = false;
+        bool is_used_outside = false;
+        _fanout(n, [&](relid id) {
+            auto r = get_rel(id);
+            if (r == nullptr) {
+                return;
+            } else if (group.find(r->to_node.numeric()) != group.end()) {
+                is_used_inside = true;
+            } else {
+                is_used_outside = true;
+            }
+        });
+        if (!is_used_inside || is_used_outside) {
+            roots.push_back(n);
+        }
+    }
+    if (!is_connected) {
+        return ERROR(Error::NOT_CONNECTED);
+    } else if (roots.size() != 1 || sources.empty()
+        || sources.size() > Lut::MAX_INPUT) {
+        return ERROR(Error::NOT_COLLAPSIBLE);
+    }
+
+    // Kahn's algorithm, a group that can not be ordered contains a loop.
+    std::vector<Node> order;
+    std::deque<Node> ready;
+    for (Node n : members) {
+        if (fanin[n.numeric()] == 0) {
+            ready.push_back(n);
+        }
+    }
+    while (!ready.empty()) {
+        Node n = ready.front();
+        ready.pop_front();
+        group[n.numeric()] = order.size();
+        order.push_back(n);
+        _fanout(n, [&](relid id) {
+            auto r = get_rel(id);
+            if (r == nullptr) {
+                return;
+            }
+            auto f = fanin.find(r->to_node.numeric());
+            if (f != fanin.end() && --f->second == 0) {
+                ready.push_back(r->to_node);
+            }
+        });
+    }
+    if (order.size() != members.size()) {
+        return ERROR(Error::NOT_COLLAPSIBLE);
+    }
+
+    std::vector<std::vector<Operand>> operands(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        _fanin(order[i], [&](relid id) {
+            auto r  = get_rel(id);
+            auto in = group.find(r->from_node.numeric());
+            if (in != group.end()) {
+                operands[i].push_back({ true, in->second });
+            } else {
+                operands[i].push_back({ false,
+                    source_of[{ r->from_node.numeric(), r->from_sock }] });
+            }
+        });
+    }
+
+    // Evaluate the group for every input combination.
+    Lut::Table table;
+    std::vector<bool> values(order.size());
+    std::vector<bool> in;
+    for (uint32_t index = 0; index < (1u << sources.size()); index++) {
+        for (size_t i = 0; i < order.size(); i++) {
+            in.clear();
+            for (const Operand& op : operands[i]) {
+                in.push_back(
+                    op.internal ? values[op.index] : (index >> op.index) & 1);
+            }
+            if (order[i].type == Node::GATE) {
+                values[i] = get_node<Gate>(order[i])->evaluate(in);
+            } else {
+                uint32_t sub = 0;
+                for (size_t j = 0; j < in.size(); j++) {
+                    sub |= static_cast<uint32_t>(in[j]) << j;
+                }
+                values[i] = get_node<Lut>(order[i])->lookup(sub);
+            }
+        }
+        table[index] = values[group[roots[0].numeric()]];
+    }
+
+    std::vector<std::pair<Node, sockid>> targets;
+    _fanout(roots[0], [&](relid id) {
+        auto r = get_rel(id);
+        if (r != nullptr) {
+            targets.emplace_back(r->to_node, r->to_sock);
+        }
+    });
+    Point point = get_base(roots[0])->point();
+    for (Node n : order) {
+        remove_node(n);
+    }
+    lut = add_node<Lut>(static_cast<sockid>(sources.size()), table);
+    get_base(lut)->move(point);
+    for (size_t i = 0; i < sources.size(); i++) {
+        connect(lut, i, sources[i].first, sources[i].second);
+    }
+    for (const auto& [to_node, to_sock] : targets) {
+        connect(to_node, to_sock, lut);
+    }
+    L_INFO("Collapsed %zu nodes into LUT@%d with %zu inputs.", order.size(),
+        lut.index, sources.size());
+    return Error::OK;
+}
+
+} // namespace ic
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <sstream>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+template <> const char* to_str<Memory::Type>(Memory::Type s)
+{
+    switch (s) {
+    case Memory::Type::ROM: return "ROM";
+    case Memory::Type::RAM: return "RAM";
+    default: return "null";
+    }
+}
+
+Memory::Memory(Scene* _s, Type type, sockid address_s, sockid data_s)
+    : BaseNode { _s }
+    , _type { type }
+    , _address_s { std::max<sockid>(1, std::min(address_s, MAX_ADDRESS)) }
+    , _data_s { std::max<sockid>(1, std::min(data_s, MAX_DATA)) }
+{
+    _data.resize(size() * word_s(), 0);
+    inputs.resize(_type == Type::RAM ? clock() + 1 : _address_s, 0);
+    for (sockid i = 0; i < _data_s; i++) {
+        outputs[i] = {};
+    }
+}
+
+uint32_t Memory::read(uint32_t address) const
+{
+    if (address >= size()) {
+        return 0;
+    }
+    uint32_t value = 0;
+    const uint8_t* word = &_data[address * word_s()];
+    for (size_t i = 0; i < word_s(); i++) {
+        value |= static_cast<uint32_t>(word[i]) << (i * 8);
+    }
+    return value;
+}
+
+void Memory::write(uint32_t address, uint32_t value)
+{
+    if (address >= size()) {
+        return;
+    }
+    uint32_t old_value = read(address);
+    _parent->undo.push(
+        [this, address, old_value]() { write(address, old_value); });
+    uint8_t* word = &_data[address * word_s()];
+    for (size_t i = 0; i < word_s(); i++) {
+        word[i] = value >> (i * 8);
+    }
+    if (address == _address) {
+        _notify();
+    }
+    if (_parent->journal != nullptr) {
+        _parent->journal->write(*_parent, *this, address, value);
+    }
+}
+
+void Memory::load(const std::vector<uint8_t>& raw)
+{
+    std::vector<uint8_t> old_data = _data;
+    _parent->undo.push([this, old_data]() { load(old_data); });
+    size_t copy_s = std::min(raw.size(), _data.size());
+    std::copy(raw.begin(), raw.begin() + copy_s, _data.begin());
+    std::fill(_data.begin() + copy_s, _data.end(), 0);
+    _notify();
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
+    }
+}
+
+Error Memory::load_hex(const std::string& text)
+{
+    std::vector<uint8_t> raw(_data.size(), 0);
+    std::istringstream lines { text };
+    std::string line;
+    size_t address = 0;
+    while (std::getline(lines, line)) {
+        std::istringstream tokens { line.substr(0, line.find("//")) };
+        std::string token;
+        while (tokens >> token) {
+            bool is_address = token[0] == '@';
+            uint64_t value  = 0;
+            try {
+                size_t end = 0;
+                value = std::stoull(token.substr(is_address), &end, 16);
+                if (end != token.size() - is_address) {
+                    return ERROR(Error::INVALID_ARGUMENT);
+                }
+            } catch (const std::exception&) {
+                return ERROR(Error::INVALID_ARGUMENT);
+            }
+            if (is_address) {
+                address = value;
+                continue;
+            } else if (address >= size() || value >> _data_s != 0) {
+                return ERROR(Error::INVALID_ARGUMENT);
+            }
+            for (size_t i = 0; i < word_s(); i++) {
+                raw[address * word_s() + i] = value >> (i * 8);
+            }
+            address++;
+        }
+    }
+    load(raw);
+    return Error::OK;
+}
+
+Error Memory::load_file(const std::filesystem::path& path)
+{
+    if (path.extension() == ".hex") {
+        std::string text;
+        if (!fs::read(path, text)) {
+            return ERROR(Error::NOT_FOUND);
+        }
+        return load_hex(text);
+    }
+    std::vector<uint8_t> raw;
+    if (!fs::read(path, raw)) {
+        return ERROR(Error::NOT_FOUND);
+    }
+    load(raw);
+    return Error::OK;
+}
+
+bool Memory::is_connected(void) const
+{
+    return std::all_of(
+        inputs.begin(), inputs.end(), [](relid i) { return i != 0; });
+}
+
+State Memory::get(sockid slot) const
+{
+    if (_is_disabled) {
+        return DISABLED;
+    }
+    return (read(_address) >> slot) & 1 ? TRUE : FALSE;
+}
+
+State Memory::_input(sockid sock) const
+{
+    if (sock >= inputs.size() || inputs[sock] == 0) {
+        return DISABLED;
+    }
+    auto rel = _parent->get_rel(inputs[sock]);
+    ic_assert(rel != nullptr);
+    return rel->value;
+}
+
+void Memory::on_signal(void)
+{
+    _is_disabled = !is_connected();
+    if (!_is_disabled) {
+        _address = 0;
+        for (sockid i = 0; i < _address_s; i++) {
+            if (_input(i) == TRUE) {
+                _address |= 1u << i;
+            }
+        }
+        if (_type == Type::RAM) {
+            State clk    = _input(clock());
+            bool is_edge = _clock == FALSE && clk == TRUE;
+            _clock       = clk == TRUE ? TRUE : FALSE;
+            if (is_edge && _input(write_enable()) == TRUE) {
+                uint8_t* word = &_data[_address * word_s()];
+                std::fill(word, word + word_s(), 0);
+                for (sockid i = 0; i < _data_s; i++) {
+                    if (_input(_address_s + i) == TRUE) {
+                        word[i / 8] |= 1u << (i % 8);
+                    }
+                }
+            }
+        }
+    }
+    _notify();
+}
+
+void Memory::_notify(void)
+{
+    for (const auto& [sock, rels] : outputs) {
+        State value = get(sock);
+        for (relid out : rels) {
+            auto rel = _parent->get_rel(out);
+            if (rel != nullptr && rel->value != value) {
+                _parent->signal(out, value);
+            }
+        }
+    }
+}
+
+void Memory::clean(void)
+{
+    for (const auto& [sock, rels] : outputs) {
+        // disconnect removes the id from the vector that is being iterated.
+        std::vector<relid> copy = rels;
+        for (relid r : copy) {
+            _parent->disconnect(r);
+        }
+    }
+    for (relid r : inputs) {
+        if (r != 0) {
+            _parent->disconnect(r);
+        }
+    }
+}
+
+} // namespace ic
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cstdlib>
+#include "common.h"
+#include "core.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#define LIBRARY_EXT ".dll"
+#define NULL_DEVICE "nul"
+#else
+#include <dlfcn.h>
+#define LIBRARY_EXT ".so"
+#define NULL_DEVICE "/dev/null"
+#endif
+
+namespace ic {
+
+using netid = Netlist::netid;
+
+static std::string _net(netid net) { return "n" + std::to_string(net); }
+
+/**
+ * Shannon expansion of a lookup table over its inputs, from the last input
+ * to the first. Constant and equal branches are folded.
+ * @param table of the cell
+ * @param in names of the inputs
+ * @param i number of inputs left to expand
+ * @param base index of the first entry of the sub table
+ */
+static std::string _lut_expr(const Lut::Table& table,
+    const std::vector<std::string>& in, uint32_t i, uint32_t base)
+{
+    if (i == 0) {
+        return table[base] ? "UINT64_MAX" : "0";
+    }
+    const std::string& x = in[i - 1];
+    std::string lo       = _lut_expr(table, in, i - 1, base);
+    std::string hi       = _lut_expr(table, in, i - 1, base | 1u << (i - 1));
+    if (lo == hi) {
+        return lo;
+    } else if (lo == "0" && hi == "UINT64_MAX") {
+        return x;
+    } else if (lo == "UINT64_MAX" && hi == "0") {
+        return "~" + x;
+    } else if (lo == "0") {
+        return "(" + x + " & " + hi + ")";
+    } else if (hi == "0") {
+        return "(~" + x + " & " + lo + ")";
+    }
+    return "((" + x + " & " + hi + ") | (~" + x + " & " + lo + "))";
+}
+
+std::string NativeNetlist::generate(const Netlist& n)
+{
+    std::vector<int64_t> input_of(n.cells.size(), -1);
+    for (size_t i = 0; i < n.inputs.size(); i++) {
+        input_of[n.inputs[i].net] = i;
+    }
+
+    std::string src;
+    src += "// Generated by " APPNAME ", do not edit.\n"
+           "#include <stdint.h>\n"
+           "#if defined(_WIN32)\n"
+           "#define IC_EXPORT __declspec(dllexport)\n"
+           "#else\n"
+           "#define IC_EXPORT __attribute__((visibility(\"default\")))\n"
+           "#endif\n\n"
+           "extern \"C\" IC_EXPORT void ";
+    src += SYMBOL;
+    src += "(const uint64_t* in, uint64_t* out)\n{\n";
+    std::vector<std::string> in;
+    for (netid i = 0; i < n.cells.size(); i++) {
+        const Netlist::Cell& cell = n.cells[i];
+        in.clear();
+        for (uint32_t j = 0; j < cell.size; j++) {
+            in.push_back(_net(n.fanin[cell.first + j]));
+        }
+        std::string expr;
+        const char* join     = nullptr;
+        const char* identity = nullptr;
+        bool is_inverted     = false;
+        switch (cell.op) {
+        case Netlist::CONST0: expr = "0"; break;
+        case Netlist::CONST1: expr = "UINT64_MAX"; break;
+        case Netlist::INPUT:
+            expr = input_of[i] < 0
+                ? "0"
+                : "in[" + std::to_string(input_of[i]) + "]";
+            break;
+        case Netlist::BUF: expr = in[0]; break;
+        case Netlist::NOT: expr = "~" + in[0]; break;
+        case Netlist::NAND: is_inverted = true; [[fallthrough]];
+        case Netlist::AND:
+            join     = " & ";
+            identity = "UINT64_MAX";
+            break;
+        case Netlist::NOR: is_inverted = true; [[fallthrough]];
+        case Netlist::OR:
+            join     = " | ";
+            identity = "0";
+            break;
+        case Netlist::XNOR: is_inverted = true; [[fallthrough]];
+        case Netlist::XOR:
+            join     = " ^ ";
+            identity = "0";
+            break;
+        case Netlist::LUT:
+            expr = _lut_expr(n.tables[cell.table], in, cell.size, 0);
+            break;
+        default: expr = "0"; break;
+        }
+        if (join != nullptr) {
+            expr = in.empty() ? identity : in[0];
+            for (size_t j = 1; j < in.size(); j++) {
+                expr += join + in[j];
+            }
+            if (is_inverted) {
+                expr = "~(" + expr + ")";
+            }
+        }
+        src += "    const uint64_t " + _net(i) + " = " + expr + ";\n";
+    }
+    for (size_t i = 0; i < n.outputs.size(); i++) {
+        src += "    out[" + std::to_string(i) + "] = " + _net(n.outputs[i].net)
+            + ";\n";
+    }
+    src += "}\n";
+    return src;
+}
+
+NativeNetlist::NativeNetlist(Netlist&& _netlist)
+    : netlist { std::move(_netlist) }
+{
+}
+
+void NativeNetlist::Library::operator()(void* handle) const
+{
+#if defined(_WIN32)
+    FreeLibrary(static_cast<HMODULE>(handle));
+#else
+    dlclose(handle);
+#endif
+}
+
+Error NativeNetlist::build(void)
+{
+    if (is_native()) {
+        return Error::OK;
+    }
+    const char* cxx = std::getenv("CXX");
+    std::string compiler { cxx != nullptr && *cxx != '\0' ? cxx : "c++" };
+    if (std::system(
+            (compiler + " --version > " NULL_DEVICE " 2>&1").c_str())
+        != 0) {
+        return ERROR(Error::COMPILER_NOT_FOUND);
+    }
+
+    std::string src = generate(netlist);
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx",
+        static_cast<unsigned long long>(hash64(src.data(), src.size())));
+    std::filesystem::path dir = fs::CACHE / "native";
+    std::filesystem::path lib = dir / (std::string { name } + LIBRARY_EXT);
+    std::error_code ec;
+    if (!std::filesystem::exists(lib, ec)) {
+        std::filesystem::create_directories(dir, ec);
+        std::filesystem::path src_path = dir / (std::string { name } + ".cpp");
+        // Other processes may build the same library, so each compiles into
+        // its own temporary file, which is only moved into place once it is
+        // complete.
+        std::filesystem::path tmp_path = fs::temp_path(lib);
+        if (!fs::write_atomic(src_path, src)) {
+            return ERROR(Error::NATIVE_BUILD_FAILED);
+        }
+        std::string cmd = compiler + " -std=c++11 -O2 -shared -fPIC -o \""
+            + tmp_path.string() + "\" \"" + src_path.string()
+            + "\" > " NULL_DEVICE " 2>&1";
+        bool is_built = std::system(cmd.c_str()) == 0;
+        if (is_built) {
+            std::filesystem::rename(tmp_path, lib, ec);
+        }
+        if (!is_built || ec) {
+            std::filesystem::remove(tmp_path, ec);
+            return ERROR(Error::NATIVE_BUILD_FAILED);
+        }
+    }
+
+#if defined(_WIN32)
+    void* handle = LoadLibraryW(lib.c_str());
+    void* fn     = handle == nullptr
+            ? nullptr
+            : reinterpret_cast<void*>(
+                  GetProcAddress(static_cast<HMODULE>(handle), SYMBOL));
+#else
+    void* handle = dlopen(lib.c_str(), RTLD_NOW | RTLD_LOCAL);
+    void* fn     = handle == nullptr ? nullptr : dlsym(handle, SYMBOL);
+#endif
+    if (handle == nullptr) {
+        return ERROR(Error::NATIVE_BUILD_FAILED);
+    }
+    _library.reset(handle);
+    if (fn == nullptr) {
+        _library.reset();
+        return ERROR(Error::NATIVE_BUILD_FAILED);
+    }
+    _fn = reinterpret_cast<Fn>(fn);
+    L_INFO("Loaded native code of %zu gates from %s.", netlist.gate_count(),
+        lib.string().c_str());
+    return Error::OK;
+}
+
+void NativeNetlist::simulate(
+    const std::vector<uint64_t>& in, std::vector<uint64_t>& out)
+{
+    if (!is_native()) {
+        netlist.simulate(in, out);
+        return;
+    }
+    _in.assign(netlist.inputs.size(), 0);
+    std::copy_n(in.begin(), std::min(in.size(), _in.size()), _in.begin());
+    out.resize(netlist.outputs.size());
+    _fn(_in.data(), out.data());
+}
+
+uint64_t NativeNetlist::run(uint64_t input)
+{
+    if (!is_native()) {
+        return netlist.run(input);
+    }
+    _in.resize(netlist.inputs.size());
+    for (size_t i = 0; i < _in.size(); i++) {
+        _in[i] = i < 64 && (input >> i) & 1 ? UINT64_MAX : 0;
+    }
+    _out.resize(netlist.outputs.size());
+    _fn(_in.data(), _out.data());
+    uint64_t output = 0;
+    for (size_t i = 0; i < _out.size() && i < 64; i++) {
+        output |= (_out[i] & 1) << i;
+    }
+    return output;
+}
+
+} // namespace ic
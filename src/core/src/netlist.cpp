@@ -0,0 +1,908 @@
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <tuple>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+using netid = Netlist::netid;
+
+static constexpr netid CONST0_NET = 0;
+static constexpr netid CONST1_NET = 1;
+
+Netlist::Netlist(void)
+{
+    add(CONST0, {});
+    add(CONST1, {});
+}
+
+netid Netlist::add(Op op, const std::vector<netid>& in, uint32_t table)
+{
+    cells.push_back({ op, table, static_cast<uint32_t>(fanin.size()),
+        static_cast<uint32_t>(in.size()) });
+    fanin.insert(fanin.end(), in.begin(), in.end());
+    return cells.size() - 1;
+}
+
+size_t Netlist::gate_count(void) const
+{
+    return std::count_if(cells.begin(), cells.end(),
+        [](const Cell& c) { return c.op > INPUT; });
+}
+
+/******************************************************************************
+                                  Compilation
+*****************************************************************************/
+
+static Netlist::Op _as_op(Gate::Type type)
+{
+    switch (type) {
+    case Gate::Type::NOT: return Netlist::NOT;
+    case Gate::Type::AND: return Netlist::AND;
+    case Gate::Type::OR: return Netlist::OR;
+    case Gate::Type::XOR: return Netlist::XOR;
+    case Gate::Type::NAND: return Netlist::NAND;
+    case Gate::Type::NOR: return Netlist::NOR;
+    case Gate::Type::XNOR: return Netlist::XNOR;
+    default: return Netlist::BUF;
+    }
+}
+
+/**
+ * Inlines a scene into the netlist. Nodes are visited by their topological
+ * level, so the sources of a node are always compiled before it.
+ * @param n netlist to extend
+ * @param s scene to inline
+ * @param ports nets of the component inputs
+ * @param is_top whether the Input nodes of the scene are ports
+ * @param input_ports nets of the Input nodes by index when is_top is set
+ * @param nets compiled output nets of each node by Node::numeric
+ * @param relations if set, each relation is given a BUF cell and its net
+ */
+static Error _inline(Netlist& n, const Scene& s,
+    const std::vector<netid>& ports, bool is_top,
+    const std::vector<netid>& input_ports,
+    std::unordered_map<uint32_t, std::vector<netid>>& nets,
+    std::map<relid, netid>* relations)
+{
+    if (!s._sequentials.empty() || !s._memories.empty()) {
+        return ERROR(Error::NOT_COMBINATIONAL);
+    }
+    // Resolves the net that drives the given relation.
+    auto source = [&](relid id, netid& net) -> Error {
+        auto r = s.get_rel(id);
+        if (r == nullptr) {
+            net = CONST0_NET;
+            return Error::OK;
+        } else if (s.is_feedback(id)) {
+            return ERROR(Error::NOT_COMBINATIONAL);
+        }
+        Node from = r->from_node;
+        switch (from.type) {
+        case Node::INPUT:
+            if (is_top) {
+                net = input_ports[from.index];
+            } else {
+                net = s._inputs[from.index].get() == TRUE ? CONST1_NET
+                                                          : CONST0_NET;
+            }
+            return Error::OK;
+        case Node::COMPONENT_INPUT:
+            net = from.index > 0 && from.index <= ports.size()
+                ? ports[from.index - 1]
+                : CONST0_NET;
+            return Error::OK;
+        default: break;
+        }
+        auto it = nets.find(from.numeric());
+        if (it == nets.end() || r->from_sock >= it->second.size()) {
+            return ERROR(Error::NOT_COMBINATIONAL);
+        }
+        net = it->second[r->from_sock];
+        return Error::OK;
+    };
+    auto sources = [&](const std::vector<relid>& rels,
+                       std::vector<netid>& in) -> Error {
+        in.clear();
+        for (relid id : rels) {
+            netid net;
+            if (Error err = source(id, net); err != Error::OK) {
+                return err;
+            }
+            if (relations != nullptr && s.get_rel(id) != nullptr) {
+                net              = n.add(Netlist::BUF, { net });
+                (*relations)[id] = net;
+            }
+            in.push_back(net);
+        }
+        return Error::OK;
+    };
+
+    std::vector<Node> order;
+    for (size_t i = 0; i < s._gates.size(); i++) {
+        if (!s._gates[i].is_null()) {
+            order.push_back(Node { static_cast<uint16_t>(i), Node::GATE });
+        }
+    }
+    for (size_t i = 0; i < s._luts.size(); i++) {
+        if (!s._luts[i].is_null()) {
+            order.push_back(Node { static_cast<uint16_t>(i), Node::LUT });
+        }
+    }
+    for (size_t i = 0; i < s._components.size(); i++) {
+        if (!s._components[i].is_null()) {
+            order.push_back(
+                Node { static_cast<uint16_t>(i), Node::COMPONENT });
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+        [&](Node a, Node b) { return s.level(a) < s.level(b); });
+
+    std::vector<netid> in;
+    for (Node node : order) {
+        std::vector<netid>& out = nets[node.numeric()];
+        if (node.type == Node::GATE) {
+            const Gate& gate = s._gates[node.index];
+            if (!gate.is_connected()) {
+                out = { CONST0_NET };
+            } else if (Error err = sources(gate.inputs, in); err != Error::OK) {
+                return err;
+            } else {
+                out = { n.add(_as_op(gate.type()), in) };
+            }
+        } else if (node.type == Node::LUT) {
+            const Lut& lut = s._luts[node.index];
+            if (!lut.is_connected()) {
+                out = { CONST0_NET };
+            } else if (Error err = sources(lut.inputs, in); err != Error::OK) {
+                return err;
+            } else {
+                n.tables.push_back(lut.table());
+                out = { n.add(Netlist::LUT, in, n.tables.size() - 1) };
+            }
+        } else {
+            const Component& comp = s._components[node.index];
+            if (comp.dep_idx >= s.dependencies().size()) {
+                return ERROR(Error::COMPONENT_NOT_FOUND);
+            }
+            const Scene& dep = s.dependencies()[comp.dep_idx];
+            if (!dep.component_context.has_value()) {
+                return ERROR(Error::COMPONENT_NOT_FOUND);
+            }
+            const ComponentContext& ctx = *dep.component_context;
+            out.assign(ctx.outputs.size(), CONST0_NET);
+            if (!comp.is_connected()) {
+                continue;
+            } else if (Error err = sources(comp.inputs, in); err != Error::OK) {
+                return err;
+            }
+            // Component::on_signal shifts the first socket into the highest
+            // bit, so socket i drives the context input size - 1 - i.
+            std::reverse(in.begin(), in.end());
+            in.resize(ctx.inputs.size(), CONST0_NET);
+            std::unordered_map<uint32_t, std::vector<netid>> dep_nets;
+            if (Error err = _inline(n, dep, in, false, {}, dep_nets, nullptr);
+                err != Error::OK) {
+                return err;
+            }
+            for (size_t i = 0; i < ctx.outputs.size(); i++) {
+                auto r = dep.get_rel(ctx.outputs[i]);
+                if (r == nullptr) {
+                    continue;
+                }
+                Node from = r->from_node;
+                if (from.type == Node::COMPONENT_INPUT) {
+                    out[i] = from.index > 0 && from.index <= in.size()
+                        ? in[from.index - 1]
+                        : CONST0_NET;
+                } else if (from.type == Node::INPUT) {
+                    out[i] = dep._inputs[from.index].get() == TRUE
+                        ? CONST1_NET
+                        : CONST0_NET;
+                } else {
+                    auto it = dep_nets.find(from.numeric());
+                    if (it == dep_nets.end()
+                        || r->from_sock >= it->second.size()) {
+                        return ERROR(Error::NOT_COMBINATIONAL);
+                    }
+                    out[i] = it->second[r->from_sock];
+                }
+            }
+        }
+    }
+    return Error::OK;
+}
+
+Error Netlist::compile(const Scene& scene, bool keep_relations)
+{
+    *this = Netlist {};
+    std::vector<netid> ports;
+    std::vector<netid> input_ports;
+    bool is_component = scene.component_context.has_value();
+    if (is_component) {
+        const ComponentContext& ctx = *scene.component_context;
+        for (size_t i = 0; i < ctx.inputs.size(); i++) {
+            ports.push_back(add(INPUT, {}));
+            inputs.push_back({ ctx.get_input(i), ports.back() });
+        }
+    } else {
+        for (size_t i = 0; i < scene._inputs.size(); i++) {
+            if (!scene._inputs[i].is_null()) {
+                input_ports.push_back(add(INPUT, {}));
+                inputs.push_back({ Node { static_cast<uint16_t>(i),
+                                       Node::INPUT },
+                    input_ports.back() });
+            } else {
+                input_ports.push_back(CONST0_NET);
+            }
+        }
+    }
+
+    std::unordered_map<uint32_t, std::vector<netid>> nets;
+    if (Error err = _inline(*this, scene, ports, !is_component, input_ports,
+            nets, keep_relations ? &relations : nullptr);
+        err != Error::OK) {
+        *this = Netlist {};
+        return err;
+    }
+
+    auto resolve = [&](relid id) -> netid {
+        auto r = scene.get_rel(id);
+        if (r == nullptr) {
+            return CONST0_NET;
+        }
+        switch (r->from_node.type) {
+        case Node::INPUT:
+            return is_component ? (scene._inputs[r->from_node.index].get()
+                                                  == TRUE
+                                          ? CONST1_NET
+                                          : CONST0_NET)
+                                : input_ports[r->from_node.index];
+        case Node::COMPONENT_INPUT:
+            return r->from_node.index > 0
+                    && r->from_node.index <= ports.size()
+                ? ports[r->from_node.index - 1]
+                : CONST0_NET;
+        default: {
+            auto it = nets.find(r->from_node.numeric());
+            return it != nets.end() && r->from_sock < it->second.size()
+                ? it->second[r->from_sock]
+                : CONST0_NET;
+        }
+        }
+    };
+    auto driver = [&](relid id) -> netid {
+        netid net = resolve(id);
+        if (keep_relations && scene.get_rel(id) != nullptr) {
+            net           = add(BUF, { net });
+            relations[id] = net;
+        }
+        return net;
+    };
+    if (is_component) {
+        const ComponentContext& ctx = *scene.component_context;
+        for (size_t i = 0; i < ctx.outputs.size(); i++) {
+            outputs.push_back({ ctx.get_output(i), driver(ctx.outputs[i]) });
+        }
+    } else {
+        for (size_t i = 0; i < scene._outputs.size(); i++) {
+            if (!scene._outputs[i].is_null()) {
+                outputs.push_back(
+                    { Node { static_cast<uint16_t>(i), Node::OUTPUT },
+                        driver(scene._outputs[i].input) });
+            }
+        }
+    }
+    L_INFO("Compiled %zu gates, %zu inputs and %zu outputs.", gate_count(),
+        inputs.size(), outputs.size());
+    return Error::OK;
+}
+
+/******************************************************************************
+                                  Optimization
+*****************************************************************************/
+
+/**
+ * Builds a simplified copy of a netlist. Each cell is reduced against its
+ * already simplified fanin before it is added, and cells with the same
+ * operation and fanin are shared.
+ */
+class Rewriter {
+public:
+    Rewriter(Netlist& _out)
+        : out { _out }
+    {
+    }
+
+    /** Adds the simplified form of a cell and returns the net computing it.
+     */
+    netid add(Netlist::Op op, std::vector<netid> in, const Lut::Table& table)
+    {
+        switch (op) {
+        case Netlist::CONST0: return CONST0_NET;
+        case Netlist::CONST1: return CONST1_NET;
+        case Netlist::INPUT: return out.add(Netlist::INPUT, {});
+        case Netlist::BUF: return in[0];
+        case Netlist::NOT: return invert(in[0]);
+        case Netlist::AND:
+        case Netlist::NAND:
+        case Netlist::OR:
+        case Netlist::NOR: return _and_or(op, in);
+        case Netlist::XOR:
+        case Netlist::XNOR: return _xor(op == Netlist::XNOR, in);
+        case Netlist::LUT: return _lut(in, table);
+        default: return CONST0_NET;
+        }
+    }
+
+    /** Returns the complement of a net, reusing an existing inverter. */
+    netid invert(netid net)
+    {
+        if (net == CONST0_NET || net == CONST1_NET) {
+            return net ^ 1;
+        }
+        const Netlist::Cell& cell = out.cells[net];
+        switch (cell.op) {
+        case Netlist::NOT: return out.fanin[cell.first];
+        case Netlist::AND:
+        case Netlist::OR:
+        case Netlist::XOR:
+        case Netlist::NAND:
+        case Netlist::NOR:
+        case Netlist::XNOR: {
+            // Push the inverter into the gate, the original is removed
+            // later if nothing else uses it.
+            static constexpr Netlist::Op complement[] = { Netlist::CONST1,
+                Netlist::CONST0, Netlist::INPUT, Netlist::NOT, Netlist::BUF,
+                Netlist::NAND, Netlist::NOR, Netlist::XNOR, Netlist::AND,
+                Netlist::OR, Netlist::XOR };
+            return _hash(complement[cell.op],
+                std::vector<netid>(out.fanin.begin() + cell.first,
+                    out.fanin.begin() + cell.first + cell.size));
+        }
+        default: return _hash(Netlist::NOT, { net });
+        }
+    }
+
+    Netlist& out;
+
+private:
+    netid _and_or(Netlist::Op op, std::vector<netid>& in)
+    {
+        bool is_and    = op == Netlist::AND || op == Netlist::NAND;
+        bool is_invert = op == Netlist::NAND || op == Netlist::NOR;
+        // A controlling input decides the output, an identity input is
+        // ignored.
+        netid controlling = is_and ? CONST0_NET : CONST1_NET;
+        netid identity    = is_and ? CONST1_NET : CONST0_NET;
+        std::vector<netid> rest;
+        for (netid net : in) {
+            if (net == controlling) {
+                return controlling ^ is_invert;
+            } else if (net != identity) {
+                rest.push_back(net);
+            }
+        }
+        std::sort(rest.begin(), rest.end());
+        rest.erase(std::unique(rest.begin(), rest.end()), rest.end());
+        for (netid net : rest) {
+            const Netlist::Cell& cell = out.cells[net];
+            if (cell.op == Netlist::NOT
+                && std::binary_search(
+                    rest.begin(), rest.end(), out.fanin[cell.first])) {
+                return controlling ^ is_invert;
+            }
+        }
+        if (rest.empty()) {
+            return identity ^ is_invert;
+        } else if (rest.size() == 1) {
+            return is_invert ? invert(rest[0]) : rest[0];
+        }
+        return _hash(is_and ? (is_invert ? Netlist::NAND : Netlist::AND)
+                            : (is_invert ? Netlist::NOR : Netlist::OR),
+            rest);
+    }
+
+    netid _xor(bool is_invert, std::vector<netid>& in)
+    {
+        std::vector<netid> rest;
+        for (netid net : in) {
+            if (net == CONST1_NET) {
+                is_invert = !is_invert;
+            } else if (net != CONST0_NET) {
+                const Netlist::Cell& cell = out.cells[net];
+                if (cell.op == Netlist::NOT) {
+                    is_invert = !is_invert;
+                    net       = out.fanin[cell.first];
+                }
+                rest.push_back(net);
+            }
+        }
+        // x ^ x = 0, so inputs that appear twice cancel out.
+        std::sort(rest.begin(), rest.end());
+        std::vector<netid> odd;
+        for (size_t i = 0; i < rest.size(); i++) {
+            if (i + 1 < rest.size() && rest[i] == rest[i + 1]) {
+                i++;
+            } else {
+                odd.push_back(rest[i]);
+            }
+        }
+        if (odd.empty()) {
+            return is_invert ? CONST1_NET : CONST0_NET;
+        } else if (odd.size() == 1) {
+            return is_invert ? invert(odd[0]) : odd[0];
+        }
+        return _hash(is_invert ? Netlist::XNOR : Netlist::XOR, odd);
+    }
+
+    netid _lut(std::vector<netid>& in, Lut::Table table)
+    {
+        // Removes input i, keeping the half of the table where it is set to
+        // the given value or, if from is set, equal to input from.
+        auto remove = [&](size_t i, bool value, size_t from = SIZE_MAX) {
+            Lut::Table reduced;
+            uint32_t low = (1u << i) - 1;
+            for (uint32_t m = 0; m < (1u << (in.size() - 1)); m++) {
+                bool bit = from == SIZE_MAX ? value : (m >> from) & 1;
+                uint32_t full
+                    = (m & low) | (bit << i) | ((m & ~low) << 1);
+                reduced[m] = table[full];
+            }
+            table = reduced;
+            in.erase(in.begin() + i);
+        };
+        bool is_changed = true;
+        while (is_changed) {
+            is_changed = false;
+            for (size_t i = 0; i < in.size() && !is_changed; i++) {
+                if (in[i] == CONST0_NET || in[i] == CONST1_NET) {
+                    remove(i, in[i] == CONST1_NET);
+                    is_changed = true;
+                    break;
+                }
+                for (size_t j = 0; j < i; j++) {
+                    if (in[j] == in[i]) {
+                        remove(i, false, j);
+                        is_changed = true;
+                        break;
+                    }
+                }
+                if (is_changed) {
+                    break;
+                }
+                // Inputs that the table does not depend on are dropped.
+                bool is_used = false;
+                for (uint32_t m = 0; m < (1u << in.size()) && !is_used; m++) {
+                    is_used = table[m] != table[m ^ (1u << i)];
+                }
+                if (!is_used) {
+                    remove(i, false);
+                    is_changed = true;
+                }
+            }
+        }
+        if (in.empty()) {
+            return table[0] ? CONST1_NET : CONST0_NET;
+        } else if (in.size() == 1) {
+            // The only input is used, so the table is either 0b10 or 0b01.
+            return table[1] ? in[0] : invert(in[0]);
+        }
+        for (uint32_t m = 1u << in.size(); m < table.size(); m++) {
+            table[m] = false;
+        }
+        auto it = _tables.find(table);
+        if (it == _tables.end()) {
+            it = _tables.emplace(table, out.tables.size()).first;
+            out.tables.push_back(table);
+        }
+        return _hash(Netlist::LUT, in, it->second);
+    }
+
+    /** Returns an existing cell with the same function or adds a new one. */
+    netid _hash(Netlist::Op op, std::vector<netid> in, uint32_t table = 0)
+    {
+        if (op != Netlist::LUT) {
+            std::sort(in.begin(), in.end());
+        }
+        auto key = std::make_tuple(op, table, in);
+        auto it  = _cells.find(key);
+        if (it != _cells.end()) {
+            return it->second;
+        }
+        netid net = out.add(op, in, table);
+        _cells.emplace(std::move(key), net);
+        return net;
+    }
+
+    std::map<std::tuple<Netlist::Op, uint32_t, std::vector<netid>>, netid>
+        _cells;
+    std::unordered_map<Lut::Table, uint32_t> _tables;
+};
+
+Netlist::Stats Netlist::optimize(void)
+{
+    Stats stats { gate_count(), 0 };
+    Netlist next;
+    Rewriter rewriter { next };
+    std::vector<netid> map(cells.size(), CONST0_NET);
+    std::vector<netid> in;
+    for (netid i = 0; i < cells.size(); i++) {
+        const Cell& cell = cells[i];
+        in.clear();
+        for (uint32_t j = 0; j < cell.size; j++) {
+            in.push_back(map[fanin[cell.first + j]]);
+        }
+        map[i] = rewriter.add(cell.op, in,
+            cell.op == LUT ? tables[cell.table] : Lut::Table {});
+    }
+
+    // Dead-logic elimination, only the cone of the outputs is kept. Inputs
+    // are kept so that the ports do not move.
+    std::vector<bool> is_live(next.cells.size(), false);
+    is_live[CONST0_NET] = true;
+    is_live[CONST1_NET] = true;
+    for (const Port& p : outputs) {
+        is_live[map[p.net]] = true;
+    }
+    for (netid i = next.cells.size(); i-- > 0;) {
+        const Cell& cell = next.cells[i];
+        if (cell.op == INPUT) {
+            is_live[i] = true;
+        } else if (is_live[i]) {
+            for (uint32_t j = 0; j < cell.size; j++) {
+                is_live[next.fanin[cell.first + j]] = true;
+            }
+        }
+    }
+
+    Netlist result;
+    std::vector<netid> live_map(next.cells.size(), CONST0_NET);
+    live_map[CONST1_NET] = CONST1_NET;
+    std::unordered_map<uint32_t, uint32_t> table_map;
+    for (netid i = 2; i < next.cells.size(); i++) {
+        if (!is_live[i]) {
+            continue;
+        }
+        const Cell& cell = next.cells[i];
+        in.clear();
+        for (uint32_t j = 0; j < cell.size; j++) {
+            in.push_back(live_map[next.fanin[cell.first + j]]);
+        }
+        uint32_t table = 0;
+        if (cell.op == LUT) {
+            auto it = table_map.find(cell.table);
+            if (it == table_map.end()) {
+                it = table_map.emplace(cell.table, result.tables.size()).first;
+                result.tables.push_back(next.tables[cell.table]);
+            }
+            table = it->second;
+        }
+        live_map[i] = result.add(cell.op, in, table);
+    }
+    for (const Port& p : inputs) {
+        result.inputs.push_back({ p.node, live_map[map[p.net]] });
+    }
+    for (const Port& p : outputs) {
+        result.outputs.push_back({ p.node, live_map[map[p.net]] });
+    }
+    *this             = std::move(result);
+    stats.gates_after = gate_count();
+    L_INFO("Optimized the netlist from %zu to %zu gates.", stats.gates_before,
+        stats.gates_after);
+    return stats;
+}
+
+/******************************************************************************
+                                  Simulation
+*****************************************************************************/
+
+uint64_t Netlist::evaluate(netid net, const uint64_t* values) const
+{
+    const Cell& cell = cells[net];
+    const netid* in = &fanin[cell.first];
+    uint64_t value  = 0;
+    switch (cell.op) {
+    case CONST0: return 0;
+    case CONST1: return UINT64_MAX;
+    case BUF: return values[in[0]];
+    case NOT: return ~values[in[0]];
+    case AND:
+    case NAND:
+        value = UINT64_MAX;
+        for (uint32_t i = 0; i < cell.size; i++) {
+            value &= values[in[i]];
+        }
+        return cell.op == AND ? value : ~value;
+    case OR:
+    case NOR:
+        for (uint32_t i = 0; i < cell.size; i++) {
+            value |= values[in[i]];
+        }
+        return cell.op == OR ? value : ~value;
+    case XOR:
+    case XNOR:
+        for (uint32_t i = 0; i < cell.size; i++) {
+            value ^= values[in[i]];
+        }
+        return cell.op == XOR ? value : ~value;
+    case LUT: {
+        // Reduce the table one input at a time, selecting between the
+        // entries where the input is clear and where it is set.
+        const Lut::Table& table = tables[cell.table];
+        uint64_t entries[1 << Lut::MAX_INPUT];
+        uint32_t size = 1u << cell.size;
+        for (uint32_t m = 0; m < size; m++) {
+            entries[m] = table[m] ? UINT64_MAX : 0;
+        }
+        for (uint32_t i = 0; i < cell.size; i++) {
+            uint64_t x = values[in[i]];
+            size >>= 1;
+            for (uint32_t m = 0; m < size; m++) {
+                entries[m] = (entries[2 * m] & ~x) | (entries[2 * m + 1] & x);
+            }
+        }
+        return entries[0];
+    }
+    default: return 0;
+    }
+}
+
+void Netlist::simulate(
+    const std::vector<uint64_t>& in, std::vector<uint64_t>& out)
+{
+    _values.resize(cells.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+        _values[inputs[i].net] = i < in.size() ? in[i] : 0;
+    }
+    for (netid i = 0; i < cells.size(); i++) {
+        if (cells[i].op != INPUT) {
+            _values[i] = evaluate(i, _values.data());
+        }
+    }
+    out.resize(outputs.size());
+    for (size_t i = 0; i < outputs.size(); i++) {
+        out[i] = _values[outputs[i].net];
+    }
+}
+
+uint64_t Netlist::run(uint64_t input)
+{
+    if (!truth_table.empty()) {
+        return truth_table[input & (truth_table.size() - 1)];
+    }
+    _values.resize(cells.size());
+    for (size_t i = 0; i < inputs.size() && i < 64; i++) {
+        _values[inputs[i].net] = (input >> i) & 1 ? UINT64_MAX : 0;
+    }
+    for (netid i = 0; i < cells.size(); i++) {
+        if (cells[i].op != INPUT) {
+            _values[i] = evaluate(i, _values.data());
+        }
+    }
+    uint64_t output = 0;
+    for (size_t i = 0; i < outputs.size() && i < 64; i++) {
+        output |= (_values[outputs[i].net] & 1) << i;
+    }
+    return output;
+}
+
+bool Netlist::tabulate(void)
+{
+    truth_table.clear();
+    if (inputs.size() > TABULATE_S || outputs.size() > 64) {
+        return false;
+    }
+    size_t pattern_s = 1 << inputs.size();
+    std::vector<uint64_t> table(pattern_s, 0);
+    std::vector<uint64_t> in(inputs.size());
+    std::vector<uint64_t> out;
+    // Pattern j of a batch is the input value first + j.
+    for (size_t first = 0; first < pattern_s; first += 64) {
+        for (size_t i = 0; i < in.size(); i++) {
+            in[i] = 0;
+            for (size_t j = 0; j < 64 && first + j < pattern_s; j++) {
+                in[i] |= static_cast<uint64_t>(((first + j) >> i) & 1) << j;
+            }
+        }
+        simulate(in, out);
+        for (size_t j = 0; j < 64 && first + j < pattern_s; j++) {
+            for (size_t o = 0; o < out.size(); o++) {
+                table[first + j] |= ((out[o] >> j) & 1) << o;
+            }
+        }
+    }
+    truth_table = std::move(table);
+    return true;
+}
+
+/******************************************************************************
+                                   Artifacts
+*****************************************************************************/
+
+/**
+ * An artifact is "ICN", Netlist::ARTIFACT_VERSION, the key and the hash64 of
+ * the body, followed by the body. The body holds the cells, the fanin, the
+ * lookup tables, the ports and the truth table, each prefixed with its
+ * length. Integers are little endian.
+ */
+static constexpr size_t ARTIFACT_HEADER_S = 3 + 1 + 8 + 8;
+static constexpr size_t TABLE_S           = (1 << Lut::MAX_INPUT) / 8;
+
+static void _put(std::vector<uint8_t>& out, uint64_t value, size_t size)
+{
+    for (size_t i = 0; i < size; i++) {
+        out.push_back(value >> (i * 8));
+    }
+}
+
+static bool _get(const uint8_t*& cursor, const uint8_t* end, uint64_t& value,
+    size_t size)
+{
+    if (static_cast<size_t>(end - cursor) < size) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < size; i++) {
+        value |= static_cast<uint64_t>(*cursor++) << (i * 8);
+    }
+    return true;
+}
+
+static void _put_ports(
+    std::vector<uint8_t>& out, const std::vector<Netlist::Port>& ports)
+{
+    _put(out, ports.size(), 4);
+    for (const auto& port : ports) {
+        _put(out, port.node.numeric(), 4);
+        _put(out, port.net, 4);
+    }
+}
+
+static bool _get_ports(const uint8_t*& cursor, const uint8_t* end,
+    size_t cell_s, std::vector<Netlist::Port>& ports)
+{
+    uint64_t size = 0;
+    if (!_get(cursor, end, size, 4)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < size; i++) {
+        uint64_t node = 0, net = 0;
+        if (!_get(cursor, end, node, 4) || !_get(cursor, end, net, 4)
+            || net >= cell_s) {
+            return false;
+        }
+        ports.push_back({ Node::from_numeric(node), static_cast<netid>(net) });
+    }
+    return true;
+}
+
+Error Netlist::write_file(const std::filesystem::path& path, uint64_t key) const
+{
+    std::vector<uint8_t> body;
+    _put(body, cells.size(), 4);
+    for (const Cell& cell : cells) {
+        _put(body, cell.op, 1);
+        _put(body, cell.table, 4);
+        _put(body, cell.first, 4);
+        _put(body, cell.size, 4);
+    }
+    _put(body, fanin.size(), 4);
+    for (netid net : fanin) {
+        _put(body, net, 4);
+    }
+    _put(body, tables.size(), 4);
+    for (const Lut::Table& table : tables) {
+        for (size_t i = 0; i < TABLE_S; i++) {
+            uint8_t byte = 0;
+            for (size_t j = 0; j < 8; j++) {
+                byte |= table.test(i * 8 + j) << j;
+            }
+            body.push_back(byte);
+        }
+    }
+    _put_ports(body, inputs);
+    _put_ports(body, outputs);
+    _put(body, truth_table.size(), 4);
+    for (uint64_t value : truth_table) {
+        _put(body, value, 8);
+    }
+
+    std::vector<uint8_t> data { 'I', 'C', 'N', ARTIFACT_VERSION };
+    data.reserve(ARTIFACT_HEADER_S + body.size());
+    _put(data, key, 8);
+    _put(data, hash64(body.data(), body.size()), 8);
+    data.insert(data.end(), body.begin(), body.end());
+
+    // Other processes may store the same artifact at once.
+    if (!fs::write_atomic(path, data)) {
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+    return Error::OK;
+}
+
+Error Netlist::read_file(const std::filesystem::path& path, uint64_t key)
+{
+    std::vector<uint8_t> data;
+    if (!fs::read(path, data) || data.empty()) {
+        return ERROR(Error::NOT_FOUND);
+    }
+    const uint8_t* cursor = data.data();
+    const uint8_t* end    = data.data() + data.size();
+    uint64_t saved_key = 0, checksum = 0;
+    if (data.size() < ARTIFACT_HEADER_S || std::memcmp(cursor, "ICN", 3) != 0
+        || cursor[3] != ARTIFACT_VERSION) {
+        return ERROR(Error::INVALID_FILE);
+    }
+    cursor += 4;
+    _get(cursor, end, saved_key, 8);
+    _get(cursor, end, checksum, 8);
+    if (saved_key != key || hash64(cursor, end - cursor) != checksum) {
+        return ERROR(Error::INVALID_FILE);
+    }
+
+    // The checksum only catches damage, the layout is still verified so a
+    // netlist never reads outside of its own vectors.
+    Netlist netlist;
+    netlist.cells.clear();
+    uint64_t size = 0;
+    bool is_valid = _get(cursor, end, size, 4);
+    for (uint64_t i = 0; is_valid && i < size; i++) {
+        uint64_t op = 0, table = 0, first = 0, fanin_s = 0;
+        is_valid = _get(cursor, end, op, 1) && _get(cursor, end, table, 4)
+            && _get(cursor, end, first, 4) && _get(cursor, end, fanin_s, 4)
+            && op < OP_S;
+        netlist.cells.push_back({ static_cast<Op>(op),
+            static_cast<uint32_t>(table), static_cast<uint32_t>(first),
+            static_cast<uint32_t>(fanin_s) });
+    }
+    is_valid = is_valid && _get(cursor, end, size, 4);
+    for (uint64_t i = 0; is_valid && i < size; i++) {
+        uint64_t net = 0;
+        is_valid = _get(cursor, end, net, 4);
+        netlist.fanin.push_back(net);
+    }
+    is_valid = is_valid && _get(cursor, end, size, 4)
+        && size <= static_cast<size_t>(end - cursor) / TABLE_S;
+    for (uint64_t i = 0; is_valid && i < size; i++) {
+        Lut::Table table;
+        for (size_t j = 0; j < table.size(); j++) {
+            table.set(j, (cursor[j / 8] >> (j % 8)) & 1);
+        }
+        cursor += TABLE_S;
+        netlist.tables.push_back(table);
+    }
+    is_valid = is_valid
+        && _get_ports(cursor, end, netlist.cells.size(), netlist.inputs)
+        && _get_ports(cursor, end, netlist.cells.size(), netlist.outputs)
+        && _get(cursor, end, size, 4)
+        && (size == 0
+            || (netlist.inputs.size() <= TABULATE_S
+                && size == (1u << netlist.inputs.size())));
+    for (uint64_t i = 0; is_valid && i < size; i++) {
+        uint64_t value = 0;
+        is_valid       = _get(cursor, end, value, 8);
+        netlist.truth_table.push_back(value);
+    }
+    // Cells are in topological order, a fanin always comes before its cell.
+    for (netid i = 0; is_valid && i < netlist.cells.size(); i++) {
+        const Cell& cell = netlist.cells[i];
+        is_valid         = static_cast<uint64_t>(cell.first) + cell.size
+                <= netlist.fanin.size()
+            && (cell.op != LUT
+                || (cell.table < netlist.tables.size()
+                    && cell.size <= Lut::MAX_INPUT));
+        for (uint32_t j = 0; is_valid && j < cell.size; j++) {
+            is_valid = netlist.fanin[cell.first + j] < i;
+        }
+    }
+    if (!is_valid || cursor != end) {
+        return ERROR(Error::INVALID_FILE);
+    }
+    *this = std::move(netlist);
+    return Error::OK;
+}
+
+} // namespace ic
@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstring>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include "common.h"
 #include "core.h"
 
@@ -71,6 +78,24 @@ enum Instruction : uint8_t {
     CONNECT = 0x13,
     /** ADD_<T> is about to insert a valid Node. */
     NODE_VALUE = 0x14,
+    /** Set the propagation delay of a gate type. fmt: UINT8 type, UINT32
+       delay */
+    SET_DELAY = 0x15,
+    /** Override the propagation delay of a gate. fmt: UINT32 gate index,
+       UINT32 delay */
+    SET_GATE_DELAY = 0x16,
+    /** Add a sequential node. fmt: UINT8 null, UINT32 pos.x, UINT32 pos.y,
+       UINT8 type, UINT8 width, UINT32 value */
+    ADD_SEQ = 0x17,
+    /** Add a lookup table. fmt: UINT8 null, UINT32 pos.x, UINT32 pos.y,
+       UINT8 input_s, UINT8[max(1, 2^input_s / 8)] table */
+    ADD_LUT = 0x18,
+    /** Add a memory block. fmt: UINT8 null, UINT32 pos.x, UINT32 pos.y,
+       UINT8 type, UINT8 address_s, UINT8 data_s, UINT32 size, UINT8[size]
+       data. Trailing zero bytes of the data are omitted. */
+    ADD_MEMORY = 0x19,
+    /** Set the simulation backend. fmt: UINT8 engine, UINT8 is_native */
+    SET_ENGINE = 0x1A,
 };
 
 static void _push_uint(std::vector<uint8_t>& vec, uint32_t value)
@@ -115,11 +140,23 @@ static void _encode_meta(const Scene& s, std::vector<uint8_t>& buffer)
     }
     buffer.push_back(SET_VERSION);
     _push_uint(buffer, s.version);
+    for (uint8_t type = 0; type < Gate::TYPE_S; type++) {
+        if (s.gate_delay[type] != 0) {
+            buffer.push_back(SET_DELAY);
+            buffer.push_back(type);
+            _push_uint(buffer, s.gate_delay[type]);
+        }
+    }
     if (s.component_context.has_value()) {
         buffer.push_back(SET_COMP);
         _push_uint(buffer, s.component_context->inputs.size());
         _push_uint(buffer, s.component_context->outputs.size());
     }
+    if (s.engine != Backend::EVENT || s.is_native) {
+        buffer.push_back(SET_ENGINE);
+        buffer.push_back(s.engine);
+        buffer.push_back(s.is_native);
+    }
     for (const auto& dep : s.dependencies()) {
         std::string name = dep.to_dependency();
         buffer.push_back(INCLUDE);
@@ -142,6 +179,21 @@ template <typename T> static constexpr Instruction _get_instr(void)
     if constexpr (std::is_same<T, Component>()) {
         return ADD_COMP;
     }
+    if constexpr (std::is_same<T, Sequential>()) {
+        return ADD_SEQ;
+    }
+    if constexpr (std::is_same<T, Lut>()) {
+        return ADD_LUT;
+    }
+    if constexpr (std::is_same<T, Memory>()) {
+        return ADD_MEMORY;
+    }
+}
+
+/** Number of bytes the truth table of a lookup table is stored in. */
+static inline size_t _lut_table_s(size_t input_s)
+{
+    return std::max<size_t>(1, (1u << input_s) / 8);
 }
 
 template <typename T>
@@ -169,6 +221,29 @@ static inline void _encode_node(std::vector<uint8_t>& buffer, const T& it)
             _push_uint(buffer, static_cast<uint32_t>(it.inputs.size()));
         } else if constexpr (std::is_same<T, Component>()) {
             buffer.push_back(it.dep_idx);
+        } else if constexpr (std::is_same<T, Sequential>()) {
+            buffer.push_back(it.type());
+            buffer.push_back(it.width());
+            _push_uint(buffer, static_cast<uint32_t>(it.value()));
+        } else if constexpr (std::is_same<T, Lut>()) {
+            buffer.push_back(it.inputs.size());
+            for (size_t i = 0; i < _lut_table_s(it.inputs.size()); i++) {
+                uint8_t byte = 0;
+                for (size_t bit = 0; bit < 8; bit++) {
+                    byte |= it.table()[i * 8 + bit] << bit;
+                }
+                buffer.push_back(byte);
+            }
+        } else if constexpr (std::is_same<T, Memory>()) {
+            buffer.push_back(it.type());
+            buffer.push_back(it.address_s());
+            buffer.push_back(it.data_s());
+            const std::vector<uint8_t>& data = it.data();
+            auto last = std::find_if(data.rbegin(), data.rend(),
+                [](uint8_t byte) { return byte != 0; });
+            size_t data_s = data.rend() - last;
+            _push_uint(buffer, data_s);
+            buffer.insert(buffer.end(), data.begin(), data.begin() + data_s);
         }
     }
 }
@@ -187,6 +262,26 @@ static void _encode_nodes(const Scene& s, std::vector<uint8_t>& buffer)
     for (const auto& it : s._components) {
         _encode_node<Component>(buffer, it);
     }
+    for (const auto& it : s._sequentials) {
+        _encode_node<Sequential>(buffer, it);
+    }
+    for (const auto& it : s._luts) {
+        _encode_node<Lut>(buffer, it);
+    }
+    for (const auto& it : s._memories) {
+        _encode_node<Memory>(buffer, it);
+    }
+}
+
+static void _encode_delays(const Scene& s, std::vector<uint8_t>& buffer)
+{
+    for (size_t i = 0; i < s._gates.size(); i++) {
+        if (!s._gates[i].is_null() && s._gates[i].has_delay()) {
+            buffer.push_back(SET_GATE_DELAY);
+            _push_uint(buffer, i);
+            _push_uint(buffer, s._gates[i].delay());
+        }
+    }
 }
 
 static void _encode_rel(const Scene& s, std::vector<uint8_t>& buffer)
@@ -198,17 +293,442 @@ static void _encode_rel(const Scene& s, std::vector<uint8_t>& buffer)
     }
 }
 
-Error Scene::write_to(std::vector<uint8_t>& buffer) const
+/**
+ * Version 2 documents start with a fixed header that is followed by a
+ * section table and the sections in the order of the table. Every integer
+ * is a LEB128 varint, signed values are zigzag encoded. Unknown sections are
+ * skipped, so new sections can be added without changing the version.
+ *
+ * fmt: UINT8 version, UINT8[3] "ICS", UINT64 checksum (little endian),
+ * VARINT section_s, section_s * (UINT8 type, VARINT length), sections
+ *
+ * The checksum is the hash64 of everything after it.
+ *
+ * When Scene::FORMAT_COMPRESSED is set in the version, the header is followed
+ * by the blocks of the LZ4 compressed section table and sections. A block
+ * holds up to SectionWriter::CHUNK_S bytes of the document and is stored as
+ * is if it does not compress. The checksum is the hash64 of the decompressed
+ * bytes, so it does not change with the compression.
+ *
+ * fmt: UINT8 version | 0x80, UINT8[3] "ICS", UINT64 checksum (little endian),
+ * VARINT raw_s, blocks * (VARINT block_s, VARINT packed_s, UINT8[packed_s])
+ */
+static constexpr uint8_t FORMAT_MAGIC[3] = { 'I', 'C', 'S' };
+static constexpr size_t FORMAT_HEADER_S  = 4 + sizeof(uint64_t);
+
+enum Section : uint8_t {
+    /** fmt: STRING name, STRING desc, STRING author, VARINT version, VARINT
+       delay_s, delay_s * VARINT delay, UINT8 is_component, (VARINT input_s,
+       VARINT output_s), UINT8 engine, UINT8 is_native. Older files end
+       before the engine. */
+    SECTION_META = 0x1,
+    /** fmt: VARINT dep_s, dep_s * STRING dependency */
+    SECTION_DEPS = 0x2,
+    /** Node sections share a layout. fmt: VARINT slot_s, VARINT null_s,
+       null_s * VARINT null slot (delta), then for every other slot SVARINT
+       pos.x, SVARINT pos.y (delta of the previous node) and the fields
+       of the node. */
+    SECTION_GATES       = 0x3,
+    SECTION_INPUTS      = 0x4,
+    SECTION_OUTPUTS     = 0x5,
+    SECTION_COMPONENTS  = 0x6,
+    SECTION_SEQUENTIALS = 0x7,
+    SECTION_LUTS        = 0x8,
+    SECTION_MEMORIES    = 0x9,
+    /** fmt: VARINT rel_s, rel_s * (UINT8 to.type << 4 | from.type, VARINT
+       from_sock << 8 | to_sock, SVARINT to.index, SVARINT from.index) where
+       indices are deltas of the previous relation. */
+    SECTION_RELATIONS = 0xA,
+};
+
+/**
+ * Destination of the version 2 encoders. Bytes are collected in a chunk that
+ * is appended to the buffer or written to the file once it is full, as a
+ * compressed block after SectionWriter::compress. Without either, the bytes
+ * are only counted.
+ */
+class SectionWriter {
+public:
+    static constexpr size_t CHUNK_S = 1 << 16;
+
+    SectionWriter() = default;
+    explicit SectionWriter(std::vector<uint8_t>& buffer)
+        : _buffer { &buffer }
+    {
+        _chunk.reserve(CHUNK_S);
+    }
+    explicit SectionWriter(std::FILE* file)
+        : _file { file }
+    {
+        _chunk.reserve(CHUNK_S);
+    }
+
+    void push_back(uint8_t byte)
+    {
+        _size++;
+        if (_buffer != nullptr || _file != nullptr) {
+            _chunk.push_back(byte);
+            if (_chunk.size() == CHUNK_S) {
+                flush();
+            }
+        }
+    }
+
+    void write(const void* data, size_t size)
+    {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            push_back(bytes[i]);
+        }
+    }
+
+    /**
+     * Hashes the bytes that are written from now on.
+     * @param size number of bytes that will be hashed
+     */
+    void begin_hash(size_t size)
+    {
+        flush();
+        _hash.emplace(size);
+    }
+
+    /** Compresses the bytes that are written from now on in blocks. */
+    void compress(void)
+    {
+        flush();
+        _is_compressed = true;
+    }
+
+    /** Returns the hash of the bytes since SectionWriter::begin_hash. */
+    uint64_t digest(void)
+    {
+        flush();
+        return _hash.has_value() ? _hash->digest() : 0;
+    }
+
+    /**
+     * Passes the collected bytes to the buffer or the file.
+     * @returns whether all bytes so far are written
+     */
+    bool flush(void)
+    {
+        if (_hash.has_value()) {
+            _hash->update(_chunk.data(), _chunk.size());
+        }
+        if (!_is_compressed) {
+            _emit(_chunk.data(), _chunk.size());
+        } else if (!_chunk.empty()) {
+            _block.clear();
+            size_t packed_s
+                = lz4_compress(_chunk.data(), _chunk.size(), _block);
+            bool is_stored = packed_s >= _chunk.size();
+            uint8_t frame[2 * 10];
+            size_t frame_s = _varint(frame, _chunk.size());
+            frame_s += _varint(
+                frame + frame_s, is_stored ? _chunk.size() : packed_s);
+            _emit(frame, frame_s);
+            if (is_stored) {
+                _emit(_chunk.data(), _chunk.size());
+            } else {
+                _emit(_block.data(), packed_s);
+            }
+        }
+        _chunk.clear();
+        return !_is_failed;
+    }
+
+    /** Reserves space for size more bytes in the buffer. */
+    void reserve(size_t size)
+    {
+        if (_buffer != nullptr) {
+            _buffer->reserve(_buffer->size() + size);
+        }
+    }
+
+    size_t size(void) const { return _size; }
+
+private:
+    void _emit(const uint8_t* data, size_t size)
+    {
+        if (_buffer != nullptr) {
+            _buffer->insert(_buffer->end(), data, data + size);
+        } else if (_file != nullptr && size != 0
+            && std::fwrite(data, 1, size, _file) != size) {
+            _is_failed = true;
+        }
+    }
+
+    static size_t _varint(uint8_t* out, uint64_t value)
+    {
+        size_t size = 0;
+        while (value >= 0x80) {
+            out[size++] = static_cast<uint8_t>(value) | 0x80;
+            value >>= 7;
+        }
+        out[size++] = static_cast<uint8_t>(value);
+        return size;
+    }
+
+    std::vector<uint8_t>* _buffer = nullptr;
+    std::FILE* _file              = nullptr;
+    std::vector<uint8_t> _chunk;
+    /** Compressed chunk. */
+    std::vector<uint8_t> _block;
+    std::optional<Hash64> _hash;
+    size_t _size        = 0;
+    bool _is_failed     = false;
+    bool _is_compressed = false;
+};
+
+static void _push_varint(SectionWriter& out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void _push_svarint(SectionWriter& out, int64_t value)
+{
+    uint64_t sign = static_cast<uint64_t>(value >> 63);
+    _push_varint(out, (static_cast<uint64_t>(value) << 1) ^ sign);
+}
+
+static void _push_string(SectionWriter& out, const char* str, size_t max)
+{
+    size_t len = strnlen(str, max);
+    _push_varint(out, len);
+    out.write(str, len);
+}
+
+static void _encode_meta_v2(const Scene& s, SectionWriter& out)
+{
+    _push_string(out, s.name().data(), s.name().size());
+    _push_string(out, s.description().data(), s.description().size());
+    _push_string(out, s.author().data(), s.author().size());
+    _push_varint(out, static_cast<uint32_t>(s.version));
+    _push_varint(out, Gate::TYPE_S);
+    for (uint16_t delay : s.gate_delay) {
+        _push_varint(out, delay);
+    }
+    out.push_back(s.component_context.has_value());
+    if (s.component_context.has_value()) {
+        _push_varint(out, s.component_context->inputs.size());
+        _push_varint(out, s.component_context->outputs.size());
+    }
+    out.push_back(s.engine);
+    out.push_back(s.is_native);
+}
+
+static void _encode_deps_v2(const Scene& s, SectionWriter& out)
+{
+    _push_varint(out, s.dependencies().size());
+    for (const auto& dep : s.dependencies()) {
+        std::string name = dep.to_dependency();
+        _push_string(out, name.data(), name.size());
+    }
+}
+
+template <typename T>
+static void _encode_fields_v2(const T& it, SectionWriter& out)
+{
+    if constexpr (std::is_same<T, Input>()) {
+        _push_varint(out,
+            it.is_timer() ? (it.freq() << 1) | 1u
+                          : (it.get() == State::TRUE ? 2u : 0u));
+    } else if constexpr (std::is_same<T, Gate>()) {
+        out.push_back(it.type());
+        _push_varint(out, it.inputs.size());
+        _push_varint(out, it.has_delay() ? it.delay() + 1u : 0u);
+    } else if constexpr (std::is_same<T, Component>()) {
+        _push_varint(out, it.dep_idx);
+    } else if constexpr (std::is_same<T, Sequential>()) {
+        out.push_back(it.type());
+        out.push_back(it.width());
+        _push_varint(out, static_cast<uint32_t>(it.value()));
+    } else if constexpr (std::is_same<T, Lut>()) {
+        out.push_back(it.inputs.size());
+        for (size_t i = 0; i < _lut_table_s(it.inputs.size()); i++) {
+            uint8_t byte = 0;
+            for (size_t bit = 0; bit < 8; bit++) {
+                byte |= it.table()[i * 8 + bit] << bit;
+            }
+            out.push_back(byte);
+        }
+    } else if constexpr (std::is_same<T, Memory>()) {
+        out.push_back(it.type());
+        out.push_back(it.address_s());
+        out.push_back(it.data_s());
+        const std::vector<uint8_t>& data = it.data();
+        auto last = std::find_if(data.rbegin(), data.rend(),
+            [](uint8_t byte) { return byte != 0; });
+        size_t data_s = data.rend() - last;
+        _push_varint(out, data_s);
+        out.write(data.data(), data_s);
+    }
+}
+
+template <typename T>
+static void _encode_nodes_v2(const std::vector<T>& nodes, SectionWriter& out)
+{
+    _push_varint(out, nodes.size());
+    size_t null_s = std::count_if(
+        nodes.begin(), nodes.end(), [](const T& it) { return it.is_null(); });
+    _push_varint(out, null_s);
+    size_t last = 0;
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].is_null()) {
+            _push_varint(out, i - last);
+            last = i + 1;
+        }
+    }
+    Point prev {};
+    for (const T& it : nodes) {
+        if (it.is_null()) {
+            continue;
+        }
+        _push_svarint(out, it.point().x - prev.x);
+        _push_svarint(out, it.point().y - prev.y);
+        prev = it.point();
+        _encode_fields_v2(it, out);
+    }
+}
+
+static void _encode_rel_v2(const Scene& s, SectionWriter& out)
+{
+    _push_varint(out, s._relations.size());
+    Node prev_to {}, prev_from {};
+    for (const auto& [id, rel] : s._relations) {
+        out.push_back(rel.to_node.type << 4 | rel.from_node.type);
+        _push_varint(out, rel.from_sock << 8 | rel.to_sock);
+        _push_svarint(out, rel.to_node.index - prev_to.index);
+        _push_svarint(out, rel.from_node.index - prev_from.index);
+        prev_to   = rel.to_node;
+        prev_from = rel.from_node;
+    }
+}
+
+/** Sections of the scene, in the order they are written. */
+static std::vector<Section> _sections_of(const Scene& s)
+{
+    std::vector<Section> sections { SECTION_META };
+    if (!s.dependencies().empty()) {
+        sections.push_back(SECTION_DEPS);
+    }
+    for (uint8_t type = SECTION_GATES; type <= SECTION_RELATIONS; type++) {
+        sections.push_back(static_cast<Section>(type));
+    }
+    return sections;
+}
+
+static void _encode_section(const Scene& s, Section type, SectionWriter& out)
+{
+    switch (type) {
+    case SECTION_META: _encode_meta_v2(s, out); break;
+    case SECTION_DEPS: _encode_deps_v2(s, out); break;
+    case SECTION_GATES: _encode_nodes_v2(s._gates, out); break;
+    case SECTION_INPUTS: _encode_nodes_v2(s._inputs, out); break;
+    case SECTION_OUTPUTS: _encode_nodes_v2(s._outputs, out); break;
+    case SECTION_COMPONENTS: _encode_nodes_v2(s._components, out); break;
+    case SECTION_SEQUENTIALS: _encode_nodes_v2(s._sequentials, out); break;
+    case SECTION_LUTS: _encode_nodes_v2(s._luts, out); break;
+    case SECTION_MEMORIES: _encode_nodes_v2(s._memories, out); break;
+    case SECTION_RELATIONS: _encode_rel_v2(s, out); break;
+    }
+}
+
+/**
+ * Writes a version 2 document. Sections are encoded twice, first only to
+ * measure them for the section table, so the document is never held in
+ * memory as a whole.
+ * @param s scene to write
+ * @param out to write into
+ * @param is_compressed whether to compress the sections
+ * @returns checksum to store at the offset 4 of the document
+ */
+static uint64_t _write_v2(
+    const Scene& s, SectionWriter& out, bool is_compressed)
+{
+    std::vector<uint8_t> table_bytes;
+    std::vector<Section> sections = _sections_of(s);
+    size_t body_s                 = 0;
+    {
+        SectionWriter tab { table_bytes };
+        _push_varint(tab, sections.size());
+        for (Section type : sections) {
+            SectionWriter counter;
+            _encode_section(s, type, counter);
+            tab.push_back(type);
+            _push_varint(tab, counter.size());
+            body_s += counter.size();
+        }
+        tab.flush();
+    }
+    size_t size = FORMAT_HEADER_S + table_bytes.size() + body_s;
+    if (!is_compressed) {
+        out.reserve(size);
+    }
+
+    out.push_back(is_compressed ? 2u | Scene::FORMAT_COMPRESSED : 2u);
+    out.write(FORMAT_MAGIC, sizeof(FORMAT_MAGIC));
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        out.push_back(0);
+    }
+    if (is_compressed) {
+        _push_varint(out, size - FORMAT_HEADER_S);
+        out.compress();
+    }
+    out.begin_hash(size - FORMAT_HEADER_S);
+    out.write(table_bytes.data(), table_bytes.size());
+    for (Section type : sections) {
+        _encode_section(s, type, out);
+    }
+    return out.digest();
+}
+
+Error Scene::write_to(std::vector<uint8_t>& buffer, uint8_t format) const
 {
     buffer.clear();
-    buffer.reserve(sizeof(*this));
+    if ((format & ~FORMAT_COMPRESSED) == 2) {
+        SectionWriter out { buffer };
+        uint64_t checksum
+            = _write_v2(*this, out, (format & FORMAT_COMPRESSED) != 0);
+        for (size_t i = 0; i < sizeof(uint64_t); i++) {
+            buffer[4 + i] = checksum >> (i * 8);
+        }
+        return Error::OK;
+    } else if (format != 1) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    }
     buffer.push_back(1u);
     _encode_meta(*this, buffer);
     _encode_nodes(*this, buffer);
+    _encode_delays(*this, buffer);
     _encode_rel(*this, buffer);
     return Error::OK;
 }
 
+Error Scene::write_file(const std::filesystem::path& path) const
+{
+    // A crash never leaves a partially written scene.
+    bool is_written = fs::write_atomic(path, [&](std::FILE* file) {
+        SectionWriter out { file };
+        uint64_t checksum = _write_v2(*this, out, is_compressed);
+        uint8_t bytes[sizeof(uint64_t)];
+        for (size_t i = 0; i < sizeof(uint64_t); i++) {
+            bytes[i] = checksum >> (i * 8);
+        }
+        return out.flush() && std::fseek(file, 4, SEEK_SET) == 0
+            && std::fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+    });
+    if (!is_written) {
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+    L_INFO("%s is saved.", path.string().c_str());
+    return Error::OK;
+}
+
 LCS_ERROR static inline _strdecode(const uint8_t** buf_r, const uint8_t* endptr,
     const char* buf_w, size_t buf_w_s)
 {
@@ -228,7 +748,7 @@ LCS_ERROR static inline _strdecode(const uint8_t** buf_r, const uint8_t* endptr,
 LCS_ERROR static inline _decode_dep(
     const uint8_t** bgnptr, const uint8_t* endptr, Scene& s)
 {
-    static std::array<char, 300> dependency {};
+    std::array<char, 300> dependency {};
     Error err
         = _strdecode(bgnptr, endptr, dependency.data(), dependency.max_size());
     if (err) {
@@ -296,6 +816,58 @@ LCS_ERROR static inline _decode_node(const uint8_t** bgnptr,
     if constexpr (std::is_same<T, Output>()) {
         n = s.add_node<Output>();
     }
+    if constexpr (std::is_same<T, Sequential>()) {
+        expect_at_least(cursor, endptr, uint16_t);
+        uint8_t type  = *cursor;
+        uint8_t width = *(cursor + 1);
+        cursor += 2;
+        uint32_t value = _pop_uint(&cursor, endptr);
+        if (type >= Sequential::TYPE_S || width == 0
+            || width > Sequential::MAX_WIDTH) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        n = s.add_node<Sequential>(static_cast<Sequential::Type>(type), width);
+        s.get_node<Sequential>(n)->set_value(value);
+    }
+    if constexpr (std::is_same<T, Lut>()) {
+        expect_at_least(cursor, endptr, uint8_t);
+        uint8_t input_s = *cursor;
+        cursor++;
+        if (input_s > Lut::MAX_INPUT) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        size_t table_s = _lut_table_s(input_s);
+        if (endptr - cursor < static_cast<ptrdiff_t>(table_s)) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        }
+        Lut::Table table;
+        for (size_t i = 0; i < table_s; i++) {
+            for (size_t bit = 0; bit < 8; bit++) {
+                table[i * 8 + bit] = (cursor[i] >> bit) & 1;
+            }
+        }
+        cursor += table_s;
+        n = s.add_node<Lut>(input_s, table);
+    }
+    if constexpr (std::is_same<T, Memory>()) {
+        expect_at_least(cursor, endptr, uint8_t[3]);
+        uint8_t type      = cursor[0];
+        uint8_t address_s = cursor[1];
+        uint8_t data_s    = cursor[2];
+        cursor += 3;
+        uint32_t size = _pop_uint(&cursor, endptr);
+        if (type >= Memory::TYPE_S || address_s == 0
+            || address_s > Memory::MAX_ADDRESS || data_s == 0
+            || data_s > Memory::MAX_DATA) {
+            return ERROR(Error::INVALID_NODE);
+        } else if (static_cast<size_t>(endptr - cursor) < size) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        }
+        n = s.add_node<Memory>(
+            static_cast<Memory::Type>(type), address_s, data_s);
+        s.get_node<Memory>(n)->load({ cursor, cursor + size });
+        cursor += size;
+    }
     s.get_node<T>(n)->move(
         { static_cast<int16_t>(pos_x), static_cast<int16_t>(pos_y) });
     *bgnptr = cursor;
@@ -335,6 +907,41 @@ LCS_ERROR static inline _decode_branch(const uint8_t** bgnptr,
         s.component_context->setup(input_s, output_s);
         break;
     }
+    case SET_DELAY: {
+        L_DEBUG("Instr::SET_DELAY");
+        expect_at_least(cursor, endptr, uint8_t);
+        uint8_t type = *cursor;
+        cursor++;
+        uint32_t delay = _pop_uint(&cursor, endptr);
+        if (type >= Gate::TYPE_S || delay >= Gate::INHERIT_DELAY) {
+            return ERROR(Error::INVALID_BYTE);
+        }
+        s.gate_delay[type] = delay;
+        break;
+    }
+    case SET_ENGINE: {
+        L_DEBUG("Instr::SET_ENGINE");
+        expect_at_least(cursor, endptr, uint16_t);
+        if (cursor[0] >= Backend::TYPE_S) {
+            return ERROR(Error::INVALID_BYTE);
+        }
+        s.engine    = static_cast<Backend::Type>(cursor[0]);
+        s.is_native = cursor[1];
+        cursor += 2;
+        break;
+    }
+    case SET_GATE_DELAY: {
+        L_DEBUG("Instr::SET_GATE_DELAY");
+        uint32_t idx   = _pop_uint(&cursor, endptr);
+        uint32_t delay = _pop_uint(&cursor, endptr);
+        auto gate = s.get_node<Gate>(Node { static_cast<uint16_t>(idx) });
+        if (idx >= UINT16_MAX || gate == nullptr
+            || delay >= Gate::INHERIT_DELAY) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        gate->set_delay(delay);
+        break;
+    }
     case INCLUDE:
         L_DEBUG("Instr::INCLUDE");
         err = _decode_dep(&cursor, endptr, s);
@@ -355,6 +962,18 @@ LCS_ERROR static inline _decode_branch(const uint8_t** bgnptr,
         L_DEBUG("Instr::ADD_COMP");
         err = _decode_node<Component>(&cursor, endptr, s, null_list);
         break;
+    case ADD_SEQ:
+        L_DEBUG("Instr::ADD_SEQ");
+        err = _decode_node<Sequential>(&cursor, endptr, s, null_list);
+        break;
+    case ADD_LUT:
+        L_DEBUG("Instr::ADD_LUT");
+        err = _decode_node<Lut>(&cursor, endptr, s, null_list);
+        break;
+    case ADD_MEMORY:
+        L_DEBUG("Instr::ADD_MEMORY");
+        err = _decode_node<Memory>(&cursor, endptr, s, null_list);
+        break;
     case CONNECT: {
         L_DEBUG("Instr::CONNECT");
         uint32_t from_u = _pop_uint(&cursor, endptr);
@@ -377,84 +996,1244 @@ LCS_ERROR static inline _decode_branch(const uint8_t** bgnptr,
     return err;
 }
 
-LCS_ERROR Scene::read_from(const std::vector<uint8_t>& buffer)
-{
-    const uint8_t* cursor = buffer.data();
-    uint8_t ic_version   = *cursor;
-    if (ic_version != 1) {
-        return ERROR(Error::INVALID_SCENE_FORMAT);
+/**
+ * Cursor over a section of a version 2 document. Reading past the end of the
+ * section marks the reader as failed and returns zeros, so the decoders only
+ * check once per record.
+ */
+struct SectionReader {
+    const uint8_t* cursor;
+    const uint8_t* endptr;
+    bool is_failed = false;
+
+    uint8_t byte(void)
+    {
+        if (cursor >= endptr) {
+            is_failed = true;
+            return 0;
+        }
+        return *cursor++;
     }
-    cursor++; // skip version
-    // NOTE: Generate null slot's like regular nodes. Then set all items in
-    // null_list to null using BaseNode::set_null function. The reason is
-    // Scene::add_node function tries to put next item in a available slot, thus
-    // making null item insertion impossible.
-    std::vector<Node> null_list {};
-    const uint8_t* endptr = buffer.data() + buffer.size();
 
-    while (cursor + sizeof(uint16_t) < buffer.data() + buffer.size()) {
-        Error err = _decode_branch(&cursor, endptr, *this, null_list);
-        if (err) {
-            return err;
+    uint64_t varint(void)
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            value |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
         }
+        is_failed = true;
+        return 0;
     }
-    for (auto& n : null_list) {
-        get_base(n)->set_null();
-        L_INFO("Removed %s@%d from the scene.", to_str(n.type), n.index);
+
+    int64_t svarint(void)
+    {
+        uint64_t value = varint();
+        int64_t sign   = -static_cast<int64_t>(value & 1);
+        return static_cast<int64_t>(value >> 1) ^ sign;
+    }
+
+    /** Returns the next size bytes, or nullptr if there are not enough. */
+    const uint8_t* bytes(uint64_t size)
+    {
+        if (static_cast<uint64_t>(endptr - cursor) < size) {
+            is_failed = true;
+            return nullptr;
+        }
+        const uint8_t* begin = cursor;
+        cursor += size;
+        return begin;
     }
-    return Error::OK;
-}
 
-static Error _check_fs(const std::string& name, Scene& s)
+    std::string string(void)
+    {
+        uint64_t len     = varint();
+        const uint8_t* s = bytes(len);
+        return s == nullptr ? "" : std::string { s, s + len };
+    }
+};
+
+LCS_ERROR static _decode_meta_v2(SectionReader& r, Scene& s)
 {
-    std::string n { name };
-    std::vector<std::string> tokens = split(n, '/');
-    if (tokens.size() != 3) {
-        return ERROR(Error::INVALID_DEPENDENCY_FORMAT);
+    std::string name   = r.string();
+    std::string desc   = r.string();
+    std::string author = r.string();
+    s.version          = static_cast<int>(r.varint());
+    uint64_t delay_s   = r.varint();
+    if (r.is_failed || delay_s > Gate::TYPE_S) {
+        return ERROR(Error::INCOMPLETE_INSTR);
     }
-    std::filesystem::path path = fs::LIBRARY / (base64_encode(name) + ".ic");
-    std::vector<uint8_t> data;
-    if (!fs::read(path, data)) {
-        return ERROR(Error::COMPONENT_NOT_FOUND);
+    for (size_t type = 0; type < delay_s; type++) {
+        uint64_t delay = r.varint();
+        if (delay >= Gate::INHERIT_DELAY) {
+            return ERROR(Error::INVALID_BYTE);
+        }
+        s.gate_delay[type] = delay;
     }
-    Error err = s.read_from(data);
-    if (err) {
-        return err;
+    if (r.byte()) {
+        uint64_t input_s  = r.varint();
+        uint64_t output_s = r.varint();
+        if (input_s > UINT8_MAX || output_s > UINT8_MAX) {
+            return ERROR(Error::INVALID_BYTE);
+        }
+        s.component_context.emplace(ComponentContext { &s });
+        s.component_context->setup(input_s, output_s);
+    }
+    if (r.cursor < r.endptr) {
+        uint8_t engine = r.byte();
+        s.is_native    = r.byte();
+        if (engine >= Backend::TYPE_S) {
+            return ERROR(Error::INVALID_BYTE);
+        }
+        s.engine = static_cast<Backend::Type>(engine);
     }
-    if (!s.component_context.has_value()) {
-        return ERROR(Error::NOT_A_COMPONENT);
+    if (r.is_failed) {
+        return ERROR(Error::INCOMPLETE_INSTR);
     }
-    return OK;
+    if (s.set_name(name) || s.set_description(desc) || s.set_author(author)) {
+        return ERROR(Error::INVALID_STRING);
+    }
+    return Error::OK;
 }
 
-static Error _check_src(const std::string& path, Scene&)
+static std::vector<std::shared_ptr<const Scene>> _prefetch(
+    const std::vector<std::string>& names, std::vector<Error>& errors);
+LCS_ERROR static _load_resolved(const std::string& name, Error err,
+    std::shared_ptr<const Scene> source, Scene& scene);
+
+LCS_ERROR static _decode_deps_v2(SectionReader& r, Scene& s)
 {
-    std::string url = API_ENDPOINT "/" + path;
-    std::vector<uint8_t> resp;
-    //  net::get_request_then(
-    //          [](net::HttpResponse&resp) {
-    //          Scene scene;
-    //          if(resp.err==Error::OK && resp.status_code ==200 &&
-    //          !resp.data.empty())
-    //          {
-    //          fs::write(fs::LIBRARY / (base64_encode(resp.path) + ".ic"),
-    //          resp);
-    //          }
-    //          },url, ""
-    //          );
+    uint64_t dep_s = r.varint();
+    std::vector<std::string> names;
+    for (uint64_t i = 0; i < dep_s && !r.is_failed; i++) {
+        names.push_back(r.string());
+        if (names.back().empty()) {
+            return ERROR(Error::INVALID_STRING);
+        }
+    }
+    if (r.is_failed) {
+        return ERROR(Error::INCOMPLETE_INSTR);
+    }
+    // Dependencies are resolved together first, then added in their order.
+    library::refresh();
+    std::vector<Error> errors;
+    std::vector<std::shared_ptr<const Scene>> resolved
+        = _prefetch(names, errors);
+    for (size_t i = 0; i < names.size(); i++) {
+        Scene dep {};
+        if (Error err = _load_resolved(
+                names[i], errors[i], std::move(resolved[i]), dep);
+            err) {
+            return err;
+        }
+        s.add_dependency(std::move(dep));
+    }
     return Error::OK;
 }
 
-Error load_dependency(const std::string& name, Scene& scene)
+/** Reads the truth table of a lookup table with the given inputs. */
+LCS_ERROR static _pop_lut_table(
+    SectionReader& r, uint8_t input_s, Lut::Table& table)
 {
-    L_DEBUG("Fetching %s", name.c_str());
-    Error err = _check_fs(name, scene);
-    if (err == COMPONENT_NOT_FOUND) {
-        err = _check_src(name, scene);
-    } else if (err) {
-        return err;
+    if (input_s > Lut::MAX_INPUT) {
+        return ERROR(Error::INVALID_NODE);
     }
-    return OK;
+    const uint8_t* bytes = r.bytes(_lut_table_s(input_s));
+    if (bytes == nullptr) {
+        return ERROR(Error::INCOMPLETE_INSTR);
+    }
+    for (size_t i = 0; i < _lut_table_s(input_s); i++) {
+        for (size_t bit = 0; bit < 8; bit++) {
+            table[i * 8 + bit] = (bytes[i] >> bit) & 1;
+        }
+    }
+    return Error::OK;
+}
+
+template <typename T>
+LCS_ERROR static _decode_fields_v2(SectionReader& r, Scene& s, Node& n)
+{
+    if constexpr (std::is_same<T, Gate>()) {
+        uint8_t type   = r.byte();
+        uint64_t size  = r.varint();
+        uint64_t delay = r.varint();
+        if (type >= Gate::TYPE_S || size > UINT8_MAX
+            || delay > Gate::INHERIT_DELAY) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        n = s.add_node<Gate>(
+            static_cast<Gate::Type>(type), static_cast<sockid>(size));
+        if (delay != 0) {
+            s.get_node<Gate>(n)->set_delay(delay - 1);
+        }
+    } else if constexpr (std::is_same<T, Input>()) {
+        uint64_t value = r.varint();
+        if (value >> 1 > UINT8_MAX) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        if (value & 1) {
+            n = s.add_node<Input>(static_cast<uint8_t>(value >> 1));
+        } else {
+            n = s.add_node<Input>();
+            s.get_node<Input>(n)->set(value >> 1 ? State::TRUE : State::FALSE);
+        }
+    } else if constexpr (std::is_same<T, Output>()) {
+        n = s.add_node<Output>();
+    } else if constexpr (std::is_same<T, Component>()) {
+        uint64_t dep_idx = r.varint();
+        if (dep_idx >= s.dependencies().size()) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        n = s.add_node<Component>();
+        return s.get_node<Component>(n)->set_component(dep_idx);
+    } else if constexpr (std::is_same<T, Sequential>()) {
+        uint8_t type   = r.byte();
+        uint8_t width  = r.byte();
+        uint64_t value = r.varint();
+        if (type >= Sequential::TYPE_S || width == 0
+            || width > Sequential::MAX_WIDTH) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        n = s.add_node<Sequential>(static_cast<Sequential::Type>(type), width);
+        s.get_node<Sequential>(n)->set_value(static_cast<uint32_t>(value));
+    } else if constexpr (std::is_same<T, Lut>()) {
+        uint8_t input_s = r.byte();
+        Lut::Table table;
+        if (Error err = _pop_lut_table(r, input_s, table); err) {
+            return err;
+        }
+        n = s.add_node<Lut>(input_s, table);
+    } else if constexpr (std::is_same<T, Memory>()) {
+        uint8_t type         = r.byte();
+        uint8_t address_s    = r.byte();
+        uint8_t data_s       = r.byte();
+        uint64_t size        = r.varint();
+        const uint8_t* bytes = r.bytes(size);
+        if (type >= Memory::TYPE_S || address_s == 0
+            || address_s > Memory::MAX_ADDRESS || data_s == 0
+            || data_s > Memory::MAX_DATA) {
+            return ERROR(Error::INVALID_NODE);
+        } else if (bytes == nullptr) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        }
+        n = s.add_node<Memory>(
+            static_cast<Memory::Type>(type), address_s, data_s);
+        s.get_node<Memory>(n)->load({ bytes, bytes + size });
+    }
+    return Error::OK;
+}
+
+template <typename T>
+LCS_ERROR static _decode_nodes_v2(
+    SectionReader& r, Scene& s, std::vector<Node>& null_list)
+{
+    uint64_t slot_s = r.varint();
+    uint64_t null_s = r.varint();
+    if (slot_s >= UINT16_MAX || null_s > slot_s) {
+        return ERROR(Error::INVALID_NODE);
+    }
+    std::vector<bool> is_null(slot_s, false);
+    uint64_t slot = 0;
+    for (uint64_t i = 0; i < null_s; i++) {
+        slot += r.varint();
+        if (slot >= slot_s) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        is_null[slot++] = true;
+    }
+    s.vector<T>().reserve(s.vector<T>().size() + slot_s);
+    Point pos {};
+    for (size_t i = 0; i < slot_s; i++) {
+        if (is_null[i]) {
+            null_list.push_back(s.add_node<T>());
+            continue;
+        }
+        pos.x += r.svarint();
+        pos.y += r.svarint();
+        Node n;
+        if (Error err = _decode_fields_v2<T>(r, s, n); err) {
+            return err;
+        } else if (r.is_failed) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        }
+        s.get_node<T>(n)->move(pos);
+    }
+    return Error::OK;
+}
+
+LCS_ERROR static _decode_rel_v2(SectionReader& r, Scene& s)
+{
+    uint64_t rel_s = r.varint();
+    Node to {}, from {};
+    for (uint64_t i = 0; i < rel_s; i++) {
+        uint8_t types = r.byte();
+        uint64_t sock = r.varint();
+        to.index += r.svarint();
+        from.index += r.svarint();
+        if (r.is_failed) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        } else if ((types >> 4) >= Node::NODE_S || (types & 0xF) >= Node::NODE_S
+            || sock > UINT16_MAX) {
+            return ERROR(Error::INVALID_RELID);
+        }
+        to.type   = static_cast<Node::Type>(types >> 4);
+        from.type = static_cast<Node::Type>(types & 0xF);
+        if (!s.connect(to, sock & 0xFF, from, sock >> 8)) {
+            return ERROR(Error::INVALID_RELID);
+        }
+    }
+    return Error::OK;
+}
+
+static uint64_t _checksum_of(const uint8_t* data)
+{
+    uint64_t checksum = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        checksum |= static_cast<uint64_t>(data[4 + i]) << (i * 8);
+    }
+    return checksum;
+}
+
+/**
+ * Decodes a plain version 2 document.
+ * @param is_verified whether the checksum was verified by _inflate_v2
+ */
+LCS_ERROR static _read_v2(const uint8_t* data, size_t size, Scene& s,
+    std::vector<Node>& null_list, bool is_verified)
+{
+    if (size < FORMAT_HEADER_S
+        || !std::equal(FORMAT_MAGIC, FORMAT_MAGIC + 3, data + 1)) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    } else if (!is_verified
+        && _checksum_of(data)
+            != hash64(data + FORMAT_HEADER_S, size - FORMAT_HEADER_S)) {
+        return ERROR(Error::CHECKSUM_MISMATCH);
+    }
+
+    SectionReader table { data + FORMAT_HEADER_S, data + size };
+    uint64_t section_s = table.varint();
+    std::vector<std::pair<uint8_t, uint64_t>> entries;
+    for (uint64_t i = 0; i < section_s && !table.is_failed; i++) {
+        uint8_t type    = table.byte();
+        uint64_t length = table.varint();
+        entries.emplace_back(type, length);
+    }
+    if (table.is_failed) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    }
+    // Sections are decoded in a fixed order whatever their order in the
+    // table is, since nodes need the dependencies and relations the nodes.
+    std::array<std::optional<SectionReader>, SECTION_RELATIONS + 1> sections;
+    for (const auto& [type, length] : entries) {
+        const uint8_t* body = table.bytes(length);
+        if (body == nullptr) {
+            return ERROR(Error::INVALID_SCENE_FORMAT);
+        } else if (type >= sections.size()) {
+            L_DEBUG("Skipped unknown section %d.", type);
+            continue;
+        } else if (sections[type].has_value()) {
+            return ERROR(Error::INVALID_SCENE_FORMAT);
+        }
+        sections[type] = SectionReader { body, body + length };
+    }
+    if (!sections[SECTION_META].has_value()) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    }
+
+    Error err = _decode_meta_v2(*sections[SECTION_META], s);
+    if (!err && sections[SECTION_DEPS].has_value()) {
+        err = _decode_deps_v2(*sections[SECTION_DEPS], s);
+    }
+    auto nodes = [&](Section type, auto decode) {
+        if (!err && sections[type].has_value()) {
+            err = decode(*sections[type], s, null_list);
+        }
+    };
+    nodes(SECTION_GATES, _decode_nodes_v2<Gate>);
+    nodes(SECTION_INPUTS, _decode_nodes_v2<Input>);
+    nodes(SECTION_OUTPUTS, _decode_nodes_v2<Output>);
+    nodes(SECTION_COMPONENTS, _decode_nodes_v2<Component>);
+    nodes(SECTION_SEQUENTIALS, _decode_nodes_v2<Sequential>);
+    nodes(SECTION_LUTS, _decode_nodes_v2<Lut>);
+    nodes(SECTION_MEMORIES, _decode_nodes_v2<Memory>);
+    if (!err && sections[SECTION_RELATIONS].has_value()) {
+        err = _decode_rel_v2(*sections[SECTION_RELATIONS], s);
+    }
+    return err;
+}
+
+/**
+ * Decompresses a compressed version 2 document into a plain one. Blocks are
+ * decompressed one after another into their place in the document and
+ * hashed while they are still in the cache, so the checksum is verified
+ * here.
+ */
+LCS_ERROR static _inflate_v2(
+    const uint8_t* data, size_t size, std::vector<uint8_t>& doc)
+{
+    if (size < FORMAT_HEADER_S) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    }
+    SectionReader r { data + FORMAT_HEADER_S, data + size };
+    uint64_t raw_s = r.varint();
+    // A block can not grow more than 255 times when it is decompressed.
+    if (r.is_failed || raw_s / 255 > size) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    }
+    doc.resize(FORMAT_HEADER_S + raw_s);
+    std::copy(data, data + FORMAT_HEADER_S, doc.begin());
+    doc[0]         = 2;
+    size_t written = FORMAT_HEADER_S;
+    Hash64 hash { raw_s };
+    while (written < doc.size()) {
+        uint64_t block_s     = r.varint();
+        uint64_t packed_s    = r.varint();
+        const uint8_t* block = r.bytes(packed_s);
+        if (r.is_failed || block_s == 0 || block_s > doc.size() - written
+            || packed_s > block_s) {
+            return ERROR(Error::INVALID_SCENE_FORMAT);
+        } else if (packed_s == block_s) {
+            std::copy(block, block + packed_s, doc.begin() + written);
+        } else if (!lz4_decompress(
+                       block, packed_s, doc.data() + written, block_s)) {
+            return ERROR(Error::INVALID_SCENE_FORMAT);
+        }
+        hash.update(doc.data() + written, block_s);
+        written += block_s;
+    }
+    if (hash.digest() != _checksum_of(data)) {
+        return ERROR(Error::CHECKSUM_MISMATCH);
+    }
+    return Error::OK;
+}
+
+LCS_ERROR Scene::read_from(const std::vector<uint8_t>& buffer)
+{
+    return read_from(buffer.data(), buffer.size());
+}
+
+LCS_ERROR Scene::read_file(const std::filesystem::path& path)
+{
+    fs::MappedFile file;
+    if (!file.open(path)) {
+        return ERROR(Error::NOT_FOUND);
+    }
+    return read_from(file.data(), file.size());
+}
+
+LCS_ERROR Scene::read_from(const uint8_t* data, size_t size)
+{
+    if (size == 0) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    }
+    const uint8_t* cursor = data;
+    uint8_t ic_version    = *cursor;
+    if (ic_version != 1 && (ic_version & ~FORMAT_COMPRESSED) != 2) {
+        return ERROR(Error::INVALID_SCENE_FORMAT);
+    }
+    cursor++; // skip version
+    // NOTE: Generate null slot's like regular nodes. Then set all items in
+    // null_list to null using BaseNode::set_null function. The reason is
+    // Scene::add_node function tries to put next item in a available slot, thus
+    // making null item insertion impossible.
+    std::vector<Node> null_list {};
+    const uint8_t* endptr = data + size;
+
+    is_compressed = (ic_version & FORMAT_COMPRESSED) != 0;
+    if (is_compressed) {
+        std::vector<uint8_t> doc;
+        if (Error err = _inflate_v2(data, size, doc); err) {
+            return err;
+        } else if (err = _read_v2(
+                       doc.data(), doc.size(), *this, null_list, true);
+            err) {
+            return err;
+        }
+    } else if (ic_version == 2) {
+        if (Error err = _read_v2(data, size, *this, null_list, false); err) {
+            return err;
+        }
+    }
+    while (ic_version == 1 && cursor + sizeof(uint16_t) < endptr) {
+        Error err = _decode_branch(&cursor, endptr, *this, null_list);
+        if (err) {
+            return err;
+        }
+    }
+    for (auto& n : null_list) {
+        get_base(n)->set_null();
+        L_INFO("Removed %s@%d from the scene.", to_str(n.type), n.index);
+    }
+    return Error::OK;
+}
+
+/**
+ * A journal starts with a header that identifies the scene file it belongs
+ * to, followed by records that are appended as the scene is edited.
+ *
+ * fmt: UINT8[3] "ICJ", UINT8 version, UINT64 base (little endian), records
+ * record: VARINT length, UINT8[length] payload, UINT32 check (little endian)
+ *
+ * The base is the checksum of a version 2 scene file or the hash64 of any
+ * other, the check is the low half of the hash64 of the payload.
+ */
+static constexpr uint8_t JOURNAL_MAGIC[3] = { 'I', 'C', 'J' };
+static constexpr size_t JOURNAL_HEADER_S  = 4 + sizeof(uint64_t);
+
+enum JournalOp : uint8_t {
+    /** fmt: UINT8 type, VARINT index, SVARINT pos.x, SVARINT pos.y, fields
+       of the node as in the node sections. */
+    JOURNAL_ADD = 0x1,
+    /** fmt: UINT8 type, VARINT index */
+    JOURNAL_REMOVE = 0x2,
+    /** fmt: UINT8 type, VARINT index, SVARINT pos.x, SVARINT pos.y */
+    JOURNAL_MOVE = 0x3,
+    /** fmt: UINT8 to.type, VARINT to.index, UINT8 to_sock, UINT8 from.type,
+       VARINT from.index, UINT8 from_sock */
+    JOURNAL_CONNECT    = 0x4,
+    JOURNAL_DISCONNECT = 0x5,
+    /** fmt: UINT8 type, VARINT index, fields of the node as in the node
+       sections. */
+    JOURNAL_UPDATE = 0x6,
+    /** fmt: UINT8 type, VARINT index, VARINT address, VARINT value */
+    JOURNAL_WRITE = 0x7,
+};
+
+/**
+ * Calls fn with a null pointer of the node class of the given type.
+ * @returns false if the type is not stored in a node vector
+ */
+template <typename Fn> static bool _visit_type(Node::Type type, Fn fn)
+{
+    switch (type) {
+    case Node::GATE: fn(static_cast<Gate*>(nullptr)); break;
+    case Node::COMPONENT: fn(static_cast<Component*>(nullptr)); break;
+    case Node::INPUT: fn(static_cast<Input*>(nullptr)); break;
+    case Node::OUTPUT: fn(static_cast<Output*>(nullptr)); break;
+    case Node::SEQUENTIAL: fn(static_cast<Sequential*>(nullptr)); break;
+    case Node::LUT: fn(static_cast<Lut*>(nullptr)); break;
+    case Node::MEMORY: fn(static_cast<Memory*>(nullptr)); break;
+    default: return false;
+    }
+    return true;
+}
+
+template <typename T>
+static inline const std::vector<T>& _nodes_of(const Scene& s)
+{
+    return const_cast<Scene&>(s).vector<T>();
+}
+
+/**
+ * Identifies the contents of a scene document. Version 2 documents already
+ * carry a checksum, others are hashed.
+ */
+static uint64_t _base_of(const uint8_t* data, size_t size)
+{
+    if (size >= FORMAT_HEADER_S
+        && (data[0] & ~Scene::FORMAT_COMPRESSED) == 2) {
+        return _checksum_of(data);
+    }
+    return hash64(data, size);
+}
+
+static uint64_t _base_of(const std::filesystem::path& path)
+{
+    fs::MappedFile file;
+    if (!file.open(path)) {
+        return 0;
+    }
+    return _base_of(file.data(), file.size());
+}
+
+static uint32_t _record_check(const uint8_t* data, size_t size)
+{
+    return static_cast<uint32_t>(hash64(data, size));
+}
+
+static void _push_node(SectionWriter& out, Node node)
+{
+    out.push_back(node.type);
+    _push_varint(out, node.index);
+}
+
+static Node _pop_node(SectionReader& r)
+{
+    Node::Type type = static_cast<Node::Type>(r.byte());
+    uint64_t index  = r.varint();
+    if (index >= UINT16_MAX || type >= Node::NODE_S) {
+        r.is_failed = true;
+    }
+    return Node { static_cast<uint16_t>(index), type };
+}
+
+LCS_ERROR static _replay_add(SectionReader& r, Scene& s)
+{
+    Node node  = _pop_node(r);
+    int16_t x  = r.svarint();
+    int16_t y  = r.svarint();
+    Error err  = Error::INVALID_NODE;
+    bool is_ok = !r.is_failed && _visit_type(node.type, [&](auto* tag) {
+        using T             = std::remove_pointer_t<decltype(tag)>;
+        std::vector<T>& vec = s.vector<T>();
+        if (node.index > vec.size()
+            || (node.index < vec.size() && !vec[node.index].is_null())) {
+            err = Error::INVALID_NODEID;
+            return;
+        }
+        // Scene::add_node fills the slot that is marked as the next one.
+        s._last_node[node.type].index = node.index;
+        Node n;
+        err = _decode_fields_v2<T>(r, s, n);
+        if (!err && !r.is_failed) {
+            s.get_node<T>(n)->move({ x, y });
+        }
+    });
+    if (!is_ok || r.is_failed) {
+        return ERROR(Error::INVALID_NODE);
+    }
+    return err ? ERROR(err) : Error::OK;
+}
+
+/**
+ * Sets the properties of an existing node to the fields of a node section,
+ * through the same functions that edited them. Fields that are fixed once
+ * the node is created have to match.
+ */
+template <typename T>
+LCS_ERROR static _apply_fields_v2(SectionReader& r, T& it)
+{
+    if constexpr (std::is_same<T, Gate>()) {
+        uint8_t type   = r.byte();
+        uint64_t size  = r.varint();
+        uint64_t delay = r.varint();
+        if (type != it.type() || size > UINT8_MAX
+            || delay > Gate::INHERIT_DELAY) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        while (it.inputs.size() < size && it.increment()) { }
+        while (it.inputs.size() > size && it.decrement()) { }
+        if (it.inputs.size() != size) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        it.set_delay(delay == 0 ? Gate::INHERIT_DELAY : delay - 1);
+    } else if constexpr (std::is_same<T, Input>()) {
+        uint64_t value = r.varint();
+        if (value >> 1 > UINT8_MAX || (value & 1) != it.is_timer()) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        if (value & 1) {
+            it.set_freq(static_cast<uint8_t>(value >> 1));
+        } else {
+            it.set(value >> 1);
+        }
+    } else if constexpr (std::is_same<T, Component>()) {
+        if (r.varint() != it.dep_idx) {
+            return ERROR(Error::INVALID_NODE);
+        }
+    } else if constexpr (std::is_same<T, Sequential>()) {
+        uint8_t type   = r.byte();
+        uint8_t width  = r.byte();
+        uint64_t value = r.varint();
+        if (type != it.type() || width != it.width()) {
+            return ERROR(Error::INVALID_NODE);
+        }
+        it.set_value(static_cast<uint32_t>(value));
+    } else if constexpr (std::is_same<T, Lut>()) {
+        uint8_t input_s = r.byte();
+        Lut::Table table;
+        if (input_s != it.inputs.size()) {
+            return ERROR(Error::INVALID_NODE);
+        } else if (Error err = _pop_lut_table(r, input_s, table); err) {
+            return err;
+        }
+        it.set_table(table);
+    } else if constexpr (std::is_same<T, Memory>()) {
+        uint8_t type         = r.byte();
+        uint8_t address_s    = r.byte();
+        uint8_t data_s       = r.byte();
+        uint64_t size        = r.varint();
+        const uint8_t* bytes = r.bytes(size);
+        if (type != it.type() || address_s != it.address_s()
+            || data_s != it.data_s()) {
+            return ERROR(Error::INVALID_NODE);
+        } else if (bytes == nullptr) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        }
+        it.load({ bytes, bytes + size });
+    }
+    return Error::OK;
+}
+
+LCS_ERROR static _replay_update(SectionReader& r, Scene& s)
+{
+    Node node = _pop_node(r);
+    Error err = Error::INVALID_NODE;
+    if (r.is_failed) {
+        return ERROR(Error::INCOMPLETE_INSTR);
+    }
+    _visit_type(node.type, [&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        auto n  = s.get_node<T>(node);
+        err     = n == nullptr ? Error::NODE_NOT_FOUND
+                               : _apply_fields_v2<T>(r, *n);
+    });
+    if (!err && r.is_failed) {
+        err = Error::INCOMPLETE_INSTR;
+    }
+    return err ? ERROR(err) : Error::OK;
+}
+
+/** Returns the relation between the given sockets, 0 if there is none. */
+static relid _find_rel(
+    const Scene& s, Node to, sockid to_sock, Node from, sockid from_sock)
+{
+    for (const auto& [id, rel] : s._relations) {
+        if (rel.to_node.numeric() == to.numeric() && rel.to_sock == to_sock
+            && rel.from_node.numeric() == from.numeric()
+            && rel.from_sock == from_sock) {
+            return id;
+        }
+    }
+    return 0;
+}
+
+LCS_ERROR static _replay(SectionReader& r, Scene& s)
+{
+    uint8_t op = r.byte();
+    if (op == JOURNAL_ADD) {
+        return _replay_add(r, s);
+    } else if (op == JOURNAL_UPDATE) {
+        return _replay_update(r, s);
+    } else if (op == JOURNAL_REMOVE || op == JOURNAL_MOVE) {
+        Node node = _pop_node(r);
+        int16_t x = op == JOURNAL_MOVE ? r.svarint() : 0;
+        int16_t y = op == JOURNAL_MOVE ? r.svarint() : 0;
+        if (r.is_failed) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        } else if (op == JOURNAL_REMOVE) {
+            return s.remove_node(node);
+        }
+        auto base = s.get_base(node);
+        if (base == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        base->move({ x, y });
+        return Error::OK;
+    } else if (op == JOURNAL_WRITE) {
+        Node node        = _pop_node(r);
+        uint64_t address = r.varint();
+        uint64_t value   = r.varint();
+        if (r.is_failed) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        }
+        auto memory = s.get_node<Memory>(node);
+        if (memory == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        } else if (address >= memory->size() || value > UINT32_MAX) {
+            return ERROR(Error::INVALID_BYTE);
+        }
+        memory->write(address, value);
+        return Error::OK;
+    } else if (op == JOURNAL_CONNECT || op == JOURNAL_DISCONNECT) {
+        Node to           = _pop_node(r);
+        sockid to_sock    = r.byte();
+        Node from         = _pop_node(r);
+        sockid from_sock  = r.byte();
+        if (r.is_failed) {
+            return ERROR(Error::INCOMPLETE_INSTR);
+        } else if (op == JOURNAL_CONNECT) {
+            return s.connect(to, to_sock, from, from_sock)
+                ? Error::OK
+                : ERROR(Error::INVALID_RELID);
+        }
+        relid id = _find_rel(s, to, to_sock, from, from_sock);
+        return id == 0 ? ERROR(Error::REL_NOT_FOUND) : s.disconnect(id);
+    }
+    return ERROR(Error::INVALID_BYTE);
+}
+
+Journal::~Journal() { close(); }
+
+std::filesystem::path Journal::path_of(const std::filesystem::path& path)
+{
+    std::filesystem::path journal = path;
+    journal += ".journal";
+    return journal;
+}
+
+Error Journal::open(const std::filesystem::path& path, Scene& scene)
+{
+    close();
+    _path          = path;
+    _pending       = 0;
+    uint64_t base  = _base_of(path);
+    if (base == 0) {
+        return ERROR(Error::NOT_FOUND);
+    }
+    std::filesystem::path journal_path = path_of(path);
+    std::vector<uint8_t> data;
+    if (!std::filesystem::exists(journal_path)
+        || !fs::read(journal_path, data) || data.size() < JOURNAL_HEADER_S
+        || !std::equal(JOURNAL_MAGIC, JOURNAL_MAGIC + 3, data.data())
+        || data[3] != 1) {
+        return _restart(scene);
+    }
+    uint64_t journal_base = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        journal_base |= static_cast<uint64_t>(data[4 + i]) << (i * 8);
+    }
+    if (journal_base != base) {
+        L_WARN("Discarded the journal of an older %s.", path.string().c_str());
+        return _restart(scene);
+    }
+
+    SectionReader r { data.data() + JOURNAL_HEADER_S,
+        data.data() + data.size() };
+    size_t valid_s = JOURNAL_HEADER_S;
+    // The replayed edits are part of the file, so they can not be undone.
+    size_t undo_s = scene.undo.size();
+    while (r.cursor < r.endptr) {
+        uint64_t length        = r.varint();
+        const uint8_t* payload = r.bytes(length);
+        const uint8_t* check   = r.bytes(sizeof(uint32_t));
+        if (r.is_failed) {
+            break;
+        }
+        uint32_t expected = 0;
+        for (size_t i = 0; i < sizeof(uint32_t); i++) {
+            expected |= static_cast<uint32_t>(check[i]) << (i * 8);
+        }
+        if (expected != _record_check(payload, length)) {
+            break;
+        }
+        SectionReader record { payload, payload + length };
+        Error err = _replay(record, scene);
+        while (scene.undo.size() > undo_s) {
+            scene.undo.pop();
+        }
+        if (err) {
+            return err;
+        }
+        _pending++;
+        valid_s = r.cursor - data.data();
+    }
+    if (valid_s != data.size()) {
+        L_WARN("Dropped a partially written edit of %s.",
+            path.string().c_str());
+        std::error_code ec;
+        std::filesystem::resize_file(journal_path, valid_s, ec);
+    }
+#if defined(_WIN32)
+    _file = _wfopen(journal_path.c_str(), L"ab");
+#else
+    _file = std::fopen(journal_path.c_str(), "ab");
+#endif
+    if (_file == nullptr) {
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+    _size         = valid_s;
+    scene.journal = this;
+    L_INFO("Replayed %zu edits of %s.", _pending, path.string().c_str());
+    return Error::OK;
+}
+
+Error Journal::compact(const std::filesystem::path& path, Scene& scene)
+{
+    if (Error err = scene.write_file(path); err) {
+        return err;
+    }
+    if (!_path.empty() && _path != path) {
+        close(true);
+    }
+    _path = path;
+    if (Error err = _restart(scene); err) {
+        return err;
+    }
+    scene.journal = this;
+    return Error::OK;
+}
+
+void Journal::close(bool discard)
+{
+    if (_file != nullptr) {
+        std::fclose(_file);
+        _file = nullptr;
+    }
+    if (discard && !_path.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(path_of(_path), ec);
+    }
+    _size    = 0;
+    _pending = 0;
+}
+
+Error Journal::_restart(const Scene& scene)
+{
+    if (_file != nullptr) {
+        std::fclose(_file);
+    }
+    std::filesystem::path journal_path = path_of(_path);
+#if defined(_WIN32)
+    _file = _wfopen(journal_path.c_str(), L"wb");
+#else
+    _file = std::fopen(journal_path.c_str(), "wb");
+#endif
+    if (_file == nullptr) {
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+    uint8_t header[JOURNAL_HEADER_S] = { JOURNAL_MAGIC[0], JOURNAL_MAGIC[1],
+        JOURNAL_MAGIC[2], 1 };
+    uint64_t base = _base_of(_path);
+    for (size_t i = 0; i < sizeof(uint64_t); i++) {
+        header[4 + i] = base >> (i * 8);
+    }
+    if (std::fwrite(header, 1, sizeof(header), _file) != sizeof(header)
+        || std::fflush(_file) != 0) {
+        close();
+        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    }
+    _size    = sizeof(header);
+    _pending = 0;
+    const_cast<Scene&>(scene).journal = this;
+    return Error::OK;
+}
+
+void Journal::_append(const Scene& scene, const std::vector<uint8_t>& record)
+{
+    if (_file == nullptr) {
+        return;
+    }
+    std::vector<uint8_t> frame;
+    SectionWriter out { frame };
+    _push_varint(out, record.size());
+    out.write(record.data(), record.size());
+    uint32_t check = _record_check(record.data(), record.size());
+    for (size_t i = 0; i < sizeof(uint32_t); i++) {
+        out.push_back(check >> (i * 8));
+    }
+    out.flush();
+    // Flushing every edit keeps it when the application crashes.
+    if (std::fwrite(frame.data(), 1, frame.size(), _file) != frame.size()
+        || std::fflush(_file) != 0) {
+        L_ERROR("Failed to journal an edit of %s.", _path.string().c_str());
+        return;
+    }
+    _size += frame.size();
+    _pending++;
+    if (_size >= COMPACT_S) {
+        L_INFO("Compacting the journal of %s.", _path.string().c_str());
+        if (!scene.write_file(_path) && _restart(scene)) {
+            // The edits are in the scene file, but the next ones would be
+            // appended to a journal that is not there.
+            L_ERROR("Stopped journaling %s.", _path.string().c_str());
+            close();
+        }
+    }
+}
+
+void Journal::add(const Scene& scene, Node node)
+{
+    std::vector<uint8_t> record;
+    SectionWriter out { record };
+    out.push_back(JOURNAL_ADD);
+    _push_node(out, node);
+    _visit_type(node.type, [&](auto* tag) {
+        using T    = std::remove_pointer_t<decltype(tag)>;
+        const T& n = _nodes_of<T>(scene)[node.index];
+        _push_svarint(out, n.point().x);
+        _push_svarint(out, n.point().y);
+        _encode_fields_v2(n, out);
+    });
+    out.flush();
+    _append(scene, record);
+}
+
+void Journal::remove(const Scene& scene, Node node)
+{
+    std::vector<uint8_t> record;
+    SectionWriter out { record };
+    out.push_back(JOURNAL_REMOVE);
+    _push_node(out, node);
+    out.flush();
+    _append(scene, record);
+}
+
+/** Nodes do not know their own index, so it is found from the address. */
+static Node _node_of(const Scene& scene, const BaseNode& node)
+{
+    Node id;
+    for (uint8_t type = 0; type < Node::NODE_S; type++) {
+        _visit_type(static_cast<Node::Type>(type), [&](auto* tag) {
+            using T                   = std::remove_pointer_t<decltype(tag)>;
+            const std::vector<T>& vec = _nodes_of<T>(scene);
+            const BaseNode* begin     = vec.data();
+            const BaseNode* end       = vec.data() + vec.size();
+            if (!vec.empty() && &node >= begin && &node < end) {
+                id = Node { static_cast<uint16_t>(
+                                static_cast<const T*>(&node) - vec.data()),
+                    static_cast<Node::Type>(type) };
+            }
+        });
+    }
+    return id;
+}
+
+void Journal::move(const Scene& scene, const BaseNode& node, Point p)
+{
+    Node id = _node_of(scene, node);
+    if (id.index == UINT16_MAX) {
+        return;
+    }
+    std::vector<uint8_t> record;
+    SectionWriter out { record };
+    out.push_back(JOURNAL_MOVE);
+    _push_node(out, id);
+    _push_svarint(out, p.x);
+    _push_svarint(out, p.y);
+    out.flush();
+    _append(scene, record);
+}
+
+void Journal::update(const Scene& scene, const BaseNode& node)
+{
+    Node id = _node_of(scene, node);
+    if (id.index == UINT16_MAX) {
+        return;
+    }
+    std::vector<uint8_t> record;
+    SectionWriter out { record };
+    out.push_back(JOURNAL_UPDATE);
+    _push_node(out, id);
+    _visit_type(id.type, [&](auto* tag) {
+        using T = std::remove_pointer_t<decltype(tag)>;
+        _encode_fields_v2(static_cast<const T&>(node), out);
+    });
+    out.flush();
+    _append(scene, record);
+}
+
+void Journal::write(const Scene& scene, const Memory& memory,
+    uint32_t address, uint32_t value)
+{
+    Node id = _node_of(scene, memory);
+    if (id.index == UINT16_MAX) {
+        return;
+    }
+    std::vector<uint8_t> record;
+    SectionWriter out { record };
+    out.push_back(JOURNAL_WRITE);
+    _push_node(out, id);
+    _push_varint(out, address);
+    _push_varint(out, value);
+    out.flush();
+    _append(scene, record);
+}
+
+static std::vector<uint8_t> _rel_record(JournalOp op, const Rel& rel)
+{
+    std::vector<uint8_t> record;
+    SectionWriter out { record };
+    out.push_back(op);
+    _push_node(out, rel.to_node);
+    out.push_back(rel.to_sock);
+    _push_node(out, rel.from_node);
+    out.push_back(rel.from_sock);
+    out.flush();
+    return record;
+}
+
+void Journal::connect(const Scene& scene, const Rel& rel)
+{
+    _append(scene, _rel_record(JOURNAL_CONNECT, rel));
+}
+
+void Journal::disconnect(const Scene& scene, const Rel& rel)
+{
+    _append(scene, _rel_record(JOURNAL_DISCONNECT, rel));
+}
+
+/** Parsed dependency that is shared by the scenes that include it. */
+struct CachedDependency {
+    /** Identifies the contents of the file it was parsed from. */
+    uint64_t base;
+    std::weak_ptr<const Scene> scene;
+};
+
+/**
+ * Dependencies by their dependency string. An entry lives as long as a copy
+ * of it does, see Scene::source, expired entries are erased when they are
+ * looked up or when another dependency is added.
+ */
+static std::map<std::string, CachedDependency> DEPENDENCIES;
+static std::mutex _dependencies_mtx;
+
+/**
+ * Returns the parsed component from the dependency cache, reads it from the
+ * library if it is not cached or its file has changed. Packages of the
+ * index are identified by their blob hash, so a cached one is returned
+ * without opening its file.
+ */
+LCS_ERROR static _resolve(
+    const std::string& name, std::shared_ptr<const Scene>& source)
+{
+    std::string n { name };
+    std::vector<std::string> tokens = split(n, '/');
+    if (tokens.size() != 3) {
+        return ERROR(Error::INVALID_DEPENDENCY_FORMAT);
+    }
+    library::Package package {};
+    fs::MappedFile file;
+    uint64_t base              = 0;
+    bool is_indexed            = library::find(name, package);
+    std::filesystem::path path = is_indexed
+        ? library::blob_path(package.hash)
+        : fs::LIBRARY / (base64_encode(name) + ".ic");
+    if (is_indexed) {
+        base = package.hash;
+    } else if (!std::filesystem::exists(path) || !file.open(path)) {
+        return ERROR(Error::COMPONENT_NOT_FOUND);
+    } else {
+        base = _base_of(file.data(), file.size());
+    }
+    {
+        std::lock_guard<std::mutex> lock(_dependencies_mtx);
+        auto entry = DEPENDENCIES.find(name);
+        if (entry != DEPENDENCIES.end() && entry->second.base == base) {
+            source = entry->second.scene.lock();
+        }
+        if (entry != DEPENDENCIES.end() && source == nullptr) {
+            DEPENDENCIES.erase(entry);
+        }
+    }
+    if (source != nullptr) {
+        L_DEBUG("Found %s in the dependency cache.", name.c_str());
+    } else {
+        if (is_indexed && !file.open(path)) {
+            return ERROR(Error::COMPONENT_NOT_FOUND);
+        }
+        // Parsed without the lock, since nested dependencies are looked up
+        // in the cache as well.
+        auto parsed = std::make_shared<Scene>();
+        if (Error err = parsed->read_from(file.data(), file.size()); err) {
+            return err;
+        }
+        if (!parsed->component_context.has_value()) {
+            return ERROR(Error::NOT_A_COMPONENT);
+        }
+        uint64_t hash  = base;
+        bool is_hashed = true;
+        for (const Scene& dep : parsed->dependencies()) {
+            is_hashed = is_hashed && dep.source_hash != 0;
+            hash      = hash64(&hash, sizeof(hash), dep.source_hash);
+        }
+        parsed->source_hash = is_hashed ? hash : 0;
+        source = parsed;
+        std::lock_guard<std::mutex> lock(_dependencies_mtx);
+        for (auto it = DEPENDENCIES.begin(); it != DEPENDENCIES.end();) {
+            it = it->second.scene.expired() ? DEPENDENCIES.erase(it)
+                                            : std::next(it);
+        }
+        DEPENDENCIES[name] = CachedDependency { base, source };
+    }
+    return OK;
+}
+
+void forget_dependency(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(_dependencies_mtx);
+    DEPENDENCIES.erase(name);
+}
+
+/** Number of threads that are resolving dependencies for _prefetch. */
+static std::atomic<size_t> _resolvers { 0 };
+
+/**
+ * Resolves dependencies through the dependency cache concurrently. Nested
+ * dependencies are resolved the same way while their parents are parsed,
+ * so the whole hierarchy spreads over the cores. Threads are only started
+ * while there are idle cores, otherwise the caller resolves them itself.
+ * A component that is shared by two of them may be parsed twice.
+ * @param names of the dependencies
+ * @param errors to fill with the result of each dependency
+ * @returns the resolved dependencies, null where resolving failed
+ */
+static std::vector<std::shared_ptr<const Scene>> _prefetch(
+    const std::vector<std::string>& names, std::vector<Error>& errors)
+{
+    std::vector<std::shared_ptr<const Scene>> resolved(names.size());
+    errors.assign(names.size(), Error::OK);
+    std::atomic<size_t> next { 0 };
+    auto work = [&]() {
+        size_t i;
+        while ((i = next++) < names.size()) {
+            errors[i] = _resolve(names[i], resolved[i]);
+        }
+    };
+    size_t limit = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < names.size(); i++) {
+        if (_resolvers++ + 1 >= limit) {
+            _resolvers--;
+            break;
+        }
+        workers.emplace_back([&]() {
+            work();
+            _resolvers--;
+        });
+    }
+    work();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+    return resolved;
+}
+
+static Error _check_src(const std::string& path, Scene&)
+{
+    std::string url = API_ENDPOINT "/" + path;
+    std::vector<uint8_t> resp;
+    //  net::get_request_then(
+    //          [](net::HttpResponse&resp) {
+    //          Scene scene;
+    //          if(resp.err==Error::OK && resp.status_code ==200 &&
+    //          !resp.data.empty())
+    //          {
+    //          fs::write(fs::LIBRARY / (base64_encode(resp.path) + ".ic"),
+    //          resp);
+    //          }
+    //          },url, ""
+    //          );
+    return Error::OK;
+}
+
+/**
+ * Copies a dependency that was resolved from the file system into the
+ * scene, or pulls it from a mirror if it was not found there.
+ */
+static Error _load_resolved(const std::string& name, Error err,
+    std::shared_ptr<const Scene> source, Scene& scene)
+{
+    if (err == COMPONENT_NOT_FOUND) {
+        return _check_src(name, scene);
+    } else if (err) {
+        return err;
+    }
+    scene.clone(*source);
+    scene.source = std::move(source);
+    return OK;
+}
+
+Error load_dependency(const std::string& name, Scene& scene)
+{
+    L_DEBUG("Fetching %s", name.c_str());
+    library::refresh();
+    std::shared_ptr<const Scene> source;
+    Error err = _resolve(name, source);
+    return _load_resolved(name, err, std::move(source), scene);
 }
 
 } // namespace ic
@@ -0,0 +1,341 @@
+#include <algorithm>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+using lit = SatSolver::lit;
+
+static inline lit _negate(lit l) { return l ^ 1; }
+static inline uint32_t _var(lit l) { return l >> 1; }
+
+/** Conflicts before the first restart, scaled by the Luby sequence. */
+static constexpr uint64_t RESTART_BASE = 100;
+static constexpr double ACTIVITY_DECAY = 0.95;
+static constexpr double ACTIVITY_LIMIT = 1e100;
+
+/** Element i of the Luby sequence 1, 1, 2, 1, 1, 2, 4, 1, ... */
+static uint64_t _luby(uint64_t i)
+{
+    uint64_t size = 1, seq = 0;
+    while (size < i + 1) {
+        seq++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) >> 1;
+        seq--;
+        i = i % size;
+    }
+    return 1ULL << seq;
+}
+
+uint32_t SatSolver::new_var(void)
+{
+    uint32_t v = _assign.size();
+    _assign.push_back(UNASSIGNED);
+    _phase.push_back(0);
+    _level.push_back(0);
+    _reason.push_back(NO_REASON);
+    _activity.push_back(0);
+    _seen.push_back(0);
+    _heap_pos.push_back(SIZE_MAX);
+    _watches.resize(_watches.size() + 2);
+    _heap_insert(v);
+    return v;
+}
+
+uint8_t SatSolver::_value(lit l) const
+{
+    uint8_t v = _assign[_var(l)];
+    return v == UNASSIGNED ? UNASSIGNED : v ^ (l & 1);
+}
+
+bool SatSolver::add_clause(std::vector<lit> clause)
+{
+    if (_is_unsat) {
+        return false;
+    }
+    // Clauses are added at the root level, where satisfied clauses and
+    // false literals can be dropped for good.
+    _backtrack(0);
+    std::sort(clause.begin(), clause.end());
+    size_t size = 0;
+    for (size_t i = 0; i < clause.size(); i++) {
+        lit l = clause[i];
+        if (_value(l) == 1 || (size > 0 && clause[size - 1] == _negate(l))) {
+            return true;
+        } else if (_value(l) != 0 && (size == 0 || clause[size - 1] != l)) {
+            clause[size++] = l;
+        }
+    }
+    clause.resize(size);
+    if (clause.empty()) {
+        _is_unsat = true;
+        return false;
+    } else if (clause.size() == 1) {
+        _enqueue(clause[0], NO_REASON);
+        if (_propagate() != NO_REASON) {
+            _is_unsat = true;
+            return false;
+        }
+        return true;
+    }
+    uint32_t id = _clauses.size();
+    _watches[clause[0]].push_back(id);
+    _watches[clause[1]].push_back(id);
+    _clauses.push_back(std::move(clause));
+    return true;
+}
+
+void SatSolver::_enqueue(lit l, uint32_t reason)
+{
+    uint32_t v = _var(l);
+    _assign[v] = (l & 1) ^ 1;
+    _level[v]  = _trail_lim.size();
+    _reason[v] = reason;
+    _trail.push_back(l);
+}
+
+uint32_t SatSolver::_propagate(void)
+{
+    while (_qhead < _trail.size()) {
+        lit false_lit             = _negate(_trail[_qhead++]);
+        std::vector<uint32_t>& ws = _watches[false_lit];
+        size_t keep               = 0;
+        for (size_t i = 0; i < ws.size(); i++) {
+            uint32_t id         = ws[i];
+            std::vector<lit>& c = _clauses[id];
+            // The false literal is kept second, so the first one is the
+            // other watch.
+            if (c[0] == false_lit) {
+                std::swap(c[0], c[1]);
+            }
+            if (_value(c[0]) == 1) {
+                ws[keep++] = id;
+                continue;
+            }
+            bool is_moved = false;
+            for (size_t k = 2; k < c.size(); k++) {
+                if (_value(c[k]) != 0) {
+                    std::swap(c[1], c[k]);
+                    _watches[c[1]].push_back(id);
+                    is_moved = true;
+                    break;
+                }
+            }
+            if (is_moved) {
+                continue;
+            }
+            ws[keep++] = id;
+            if (_value(c[0]) == 0) {
+                for (i++; i < ws.size(); i++) {
+                    ws[keep++] = ws[i];
+                }
+                ws.resize(keep);
+                _qhead = _trail.size();
+                return id;
+            }
+            _enqueue(c[0], id);
+        }
+        ws.resize(keep);
+    }
+    return NO_REASON;
+}
+
+uint32_t SatSolver::_analyze(uint32_t conflict, std::vector<lit>& learnt)
+{
+    // Resolves the conflict with the reasons of the current level in trail
+    // order until a single literal of the current level remains.
+    learnt.assign(1, 0);
+    uint32_t level  = _trail_lim.size();
+    size_t pending  = 0;
+    size_t index    = _trail.size();
+    lit p           = UINT32_MAX;
+    uint32_t reason = conflict;
+    do {
+        const std::vector<lit>& c = _clauses[reason];
+        for (size_t i = p == UINT32_MAX ? 0 : 1; i < c.size(); i++) {
+            uint32_t v = _var(c[i]);
+            if (_seen[v] || _level[v] == 0) {
+                continue;
+            }
+            _seen[v] = 1;
+            _bump(v);
+            if (_level[v] == level) {
+                pending++;
+            } else {
+                learnt.push_back(c[i]);
+            }
+        }
+        while (!_seen[_var(_trail[--index])]) { }
+        p              = _trail[index];
+        reason         = _reason[_var(p)];
+        _seen[_var(p)] = 0;
+        pending--;
+    } while (pending > 0);
+    learnt[0] = _negate(p);
+
+    uint32_t back = 0;
+    size_t max_i  = 1;
+    for (size_t i = 1; i < learnt.size(); i++) {
+        _seen[_var(learnt[i])] = 0;
+        if (_level[_var(learnt[i])] > back) {
+            back  = _level[_var(learnt[i])];
+            max_i = i;
+        }
+    }
+    // The second watch must be the last literal to be unassigned.
+    if (learnt.size() > 1) {
+        std::swap(learnt[1], learnt[max_i]);
+    }
+    return back;
+}
+
+void SatSolver::_backtrack(uint32_t level)
+{
+    if (_trail_lim.size() <= level) {
+        return;
+    }
+    for (size_t i = _trail.size(); i > _trail_lim[level]; i--) {
+        uint32_t v = _var(_trail[i - 1]);
+        _phase[v]  = _assign[v];
+        _assign[v] = UNASSIGNED;
+        _reason[v] = NO_REASON;
+        _heap_insert(v);
+    }
+    _trail.resize(_trail_lim[level]);
+    _trail_lim.resize(level);
+    _qhead = _trail.size();
+}
+
+void SatSolver::_bump(uint32_t var)
+{
+    if ((_activity[var] += _var_inc) > ACTIVITY_LIMIT) {
+        for (double& a : _activity) {
+            a /= ACTIVITY_LIMIT;
+        }
+        _var_inc /= ACTIVITY_LIMIT;
+    }
+    if (_heap_pos[var] != SIZE_MAX) {
+        _heap_up(_heap_pos[var]);
+    }
+}
+
+void SatSolver::_heap_insert(uint32_t var)
+{
+    if (_heap_pos[var] != SIZE_MAX) {
+        return;
+    }
+    _heap_pos[var] = _heap.size();
+    _heap.push_back(var);
+    _heap_up(_heap.size() - 1);
+}
+
+void SatSolver::_heap_up(size_t i)
+{
+    uint32_t var = _heap[i];
+    while (i > 0 && _activity[_heap[(i - 1) / 2]] < _activity[var]) {
+        _heap[i]            = _heap[(i - 1) / 2];
+        _heap_pos[_heap[i]] = i;
+        i                   = (i - 1) / 2;
+    }
+    _heap[i]       = var;
+    _heap_pos[var] = i;
+}
+
+void SatSolver::_heap_down(size_t i)
+{
+    uint32_t var = _heap[i];
+    while (2 * i + 1 < _heap.size()) {
+        size_t child = 2 * i + 1;
+        if (child + 1 < _heap.size()
+            && _activity[_heap[child + 1]] > _activity[_heap[child]]) {
+            child++;
+        }
+        if (_activity[_heap[child]] <= _activity[var]) {
+            break;
+        }
+        _heap[i]            = _heap[child];
+        _heap_pos[_heap[i]] = i;
+        i                   = child;
+    }
+    _heap[i]       = var;
+    _heap_pos[var] = i;
+}
+
+uint32_t SatSolver::_pick(void)
+{
+    while (!_heap.empty()) {
+        uint32_t var   = _heap[0];
+        _heap_pos[var] = SIZE_MAX;
+        _heap[0]       = _heap.back();
+        _heap.pop_back();
+        if (!_heap.empty()) {
+            _heap_down(0);
+        }
+        if (_assign[var] == UNASSIGNED) {
+            return var;
+        }
+    }
+    return UINT32_MAX;
+}
+
+SatSolver::Result SatSolver::solve(uint64_t conflicts)
+{
+    _conflicts = 0;
+    if (_is_unsat) {
+        return UNSAT;
+    }
+    _backtrack(0);
+    if (_propagate() != NO_REASON) {
+        _is_unsat = true;
+        return UNSAT;
+    }
+    std::vector<lit> learnt;
+    uint64_t restarts = 0;
+    uint64_t limit    = RESTART_BASE * _luby(0);
+    uint64_t since    = 0;
+    while (true) {
+        uint32_t conflict = _propagate();
+        if (conflict != NO_REASON) {
+            _conflicts++;
+            since++;
+            if (_trail_lim.empty()) {
+                _is_unsat = true;
+                return UNSAT;
+            }
+            uint32_t back = _analyze(conflict, learnt);
+            _backtrack(back);
+            if (learnt.size() == 1) {
+                _enqueue(learnt[0], NO_REASON);
+            } else {
+                uint32_t id = _clauses.size();
+                _watches[learnt[0]].push_back(id);
+                _watches[learnt[1]].push_back(id);
+                _clauses.push_back(learnt);
+                _enqueue(learnt[0], id);
+            }
+            _var_inc /= ACTIVITY_DECAY;
+            continue;
+        }
+        if (_conflicts >= conflicts) {
+            _backtrack(0);
+            return UNKNOWN;
+        } else if (since >= limit) {
+            since = 0;
+            limit = RESTART_BASE * _luby(++restarts);
+            _backtrack(0);
+            continue;
+        }
+        uint32_t var = _pick();
+        if (var == UINT32_MAX) {
+            // Every variable is assigned, the trail is kept as the model.
+            return SAT;
+        }
+        _trail_lim.push_back(_trail.size());
+        _enqueue((var << 1) | (_phase[var] ^ 1), NO_REASON);
+    }
+}
+
+} // namespace ic
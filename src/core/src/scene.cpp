@@ -15,6 +15,12 @@ Scene::Scene(const std::string& _name, const std::string& _author,
             Node { 0, Node::Type::COMPONENT },
             Node { 0, Node::Type::INPUT },
             Node { 0, Node::Type::OUTPUT },
+            Node { 0, Node::Type::LABEL },
+            Node { 0, Node::Type::COMPONENT_INPUT },
+            Node { 0, Node::Type::COMPONENT_OUTPUT },
+            Node { 0, Node::Type::SEQUENTIAL },
+            Node { 0, Node::Type::LUT },
+            Node { 0, Node::Type::MEMORY },
         },
         _last_rel { 0 }
 {
@@ -31,6 +37,12 @@ Scene::Scene(ComponentContext ctx, const std::string& _name,
             Node { 0, Node::Type::COMPONENT },
             Node { 0, Node::Type::INPUT },
             Node { 0, Node::Type::OUTPUT },
+            Node { 0, Node::Type::LABEL },
+            Node { 0, Node::Type::COMPONENT_INPUT },
+            Node { 0, Node::Type::COMPONENT_OUTPUT },
+            Node { 0, Node::Type::SEQUENTIAL },
+            Node { 0, Node::Type::LUT },
+            Node { 0, Node::Type::MEMORY },
         },
         _last_rel { 0 }
 {
@@ -67,10 +79,25 @@ void Scene::clone(const Scene& other)
     }
 
     frame_s           = other.frame_s;
+    gate_delay        = other.gate_delay;
+    event_budget      = other.event_budget;
+    loop_limit        = other.loop_limit;
+    is_native         = other.is_native;
+    engine            = other.engine;
+    is_compressed     = other.is_compressed;
+    source            = other.source;
+    source_hash       = other.source_hash;
+    _wheel            = other._wheel;
+    _levels           = other._levels;
+    _feedback         = other._feedback;
+    _loops_dirty      = true;
     _gates            = other._gates;
     _components       = other._components;
     _inputs           = other._inputs;
     _outputs          = other._outputs;
+    _sequentials      = other._sequentials;
+    _luts             = other._luts;
+    _memories         = other._memories;
     _relations        = other._relations;
     component_context = other.component_context;
     for (size_t i = 0; i < Node::Type::NODE_S; i++) {
@@ -89,6 +116,15 @@ void Scene::clone(const Scene& other)
     for (auto& output : _outputs) {
         output.reload(this);
     }
+    for (auto& seq : _sequentials) {
+        seq.reload(this);
+    }
+    for (auto& lut : _luts) {
+        lut.reload(this);
+    }
+    for (auto& memory : _memories) {
+        memory.reload(this);
+    }
     if (component_context.has_value()) {
         component_context->reload(this);
     }
@@ -156,17 +192,36 @@ void Scene::_move_from(Scene&& other)
     _author           = std::move(other._author);
     version           = other.version;
     _dependencies     = std::move(other._dependencies);
+    source            = std::move(other.source);
+    source_hash       = other.source_hash;
     frame_s           = other.frame_s;
+    gate_delay        = other.gate_delay;
+    event_budget      = other.event_budget;
+    loop_limit        = other.loop_limit;
+    is_native         = other.is_native;
+    engine            = other.engine;
+    is_compressed     = other.is_compressed;
+    _wheel            = std::move(other._wheel);
+    _levels           = std::move(other._levels);
+    _feedback         = std::move(other._feedback);
+    _loops_dirty      = true;
+    _netlist          = std::move(other._netlist);
+    _is_compiled      = other._is_compiled;
     _gates            = std::move(other._gates);
     _components       = std::move(other._components);
     _inputs           = std::move(other._inputs);
     _outputs          = std::move(other._outputs);
+    _sequentials      = std::move(other._sequentials);
+    _luts             = std::move(other._luts);
+    _memories         = std::move(other._memories);
     _relations        = std::move(other._relations);
     component_context = std::move(other.component_context);
     for (size_t i = 0; i < Node::Type::NODE_S; i++) {
         _last_node[i] = other._last_node[i];
     }
-    _last_rel = other._last_rel;
+    _last_rel     = other._last_rel;
+    journal       = other.journal;
+    other.journal = nullptr;
 
     for (auto& gate : _gates) {
         gate.reload(this);
@@ -180,6 +235,15 @@ void Scene::_move_from(Scene&& other)
     for (auto& output : _outputs) {
         output.reload(this);
     }
+    for (auto& seq : _sequentials) {
+        seq.reload(this);
+    }
+    for (auto& lut : _luts) {
+        lut.reload(this);
+    }
+    for (auto& memory : _memories) {
+        memory.reload(this);
+    }
     for (auto& dep : _dependencies) {
         dep._parent = this;
     }
@@ -188,6 +252,24 @@ void Scene::_move_from(Scene&& other)
     }
 }
 
+/** Disconnects a copy of a node, the relations belong to the original. */
+template <typename T> static void _unlink(T& node)
+{
+    if constexpr (std::is_same<T, Output>()) {
+        node.input = 0;
+    } else {
+        if constexpr (!std::is_same<T, Input>()) {
+            std::fill(node.inputs.begin(), node.inputs.end(), 0);
+        }
+        if constexpr (std::is_same<T, Input>() || std::is_same<T, Gate>()
+            || std::is_same<T, Lut>()) {
+            node.output.clear();
+        } else {
+            node.outputs.clear();
+        }
+    }
+}
+
 Error Scene::duplicate_node(Node& id)
 {
     // Add node to the back regardless to make it simpler
@@ -200,6 +282,7 @@ Error Scene::duplicate_node(Node& id)
         }
         auto g { *node };
         g.reload(this);
+        _unlink(g);
         if (_last_node[id.type].index == _gates.size()) {
             _last_node[id.type].index++;
         }
@@ -214,6 +297,7 @@ Error Scene::duplicate_node(Node& id)
         }
         auto g { *node };
         g.reload(this);
+        _unlink(g);
         if (_last_node[id.type].index == _components.size()) {
             _last_node[id.type].index++;
         }
@@ -228,6 +312,7 @@ Error Scene::duplicate_node(Node& id)
         }
         auto g { *node };
         g.reload(this);
+        _unlink(g);
         if (_last_node[id.type].index == _inputs.size()) {
             _last_node[id.type].index++;
         }
@@ -242,6 +327,7 @@ Error Scene::duplicate_node(Node& id)
         }
         auto g { *node };
         g.reload(this);
+        _unlink(g);
         if (_last_node[id.type].index == _outputs.size()) {
             _last_node[id.type].index++;
         }
@@ -249,8 +335,56 @@ Error Scene::duplicate_node(Node& id)
         id.index = _outputs.size() - 1;
         break;
     }
+    case Node::SEQUENTIAL: {
+        auto node = get_node<Sequential>(id);
+        if (node == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        auto g { *node };
+        g.reload(this);
+        _unlink(g);
+        if (_last_node[id.type].index == _sequentials.size()) {
+            _last_node[id.type].index++;
+        }
+        _sequentials.push_back(g);
+        id.index = _sequentials.size() - 1;
+        break;
+    }
+    case Node::LUT: {
+        auto node = get_node<Lut>(id);
+        if (node == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        auto g { *node };
+        g.reload(this);
+        _unlink(g);
+        if (_last_node[id.type].index == _luts.size()) {
+            _last_node[id.type].index++;
+        }
+        _luts.push_back(g);
+        id.index = _luts.size() - 1;
+        break;
+    }
+    case Node::MEMORY: {
+        auto node = get_node<Memory>(id);
+        if (node == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        auto g { *node };
+        g.reload(this);
+        _unlink(g);
+        if (_last_node[id.type].index == _memories.size()) {
+            _last_node[id.type].index++;
+        }
+        _memories.push_back(g);
+        id.index = _memories.size() - 1;
+        break;
+    }
     default: return ERROR(Error::INVALID_NODE);
     }
+    if (journal != nullptr) {
+        journal->add(*this, id);
+    }
     return Error::OK;
 }
 
@@ -262,6 +396,7 @@ Error Scene::remove_node(Node id)
     }
     node->clean();
     node->set_null();
+    _levels.erase(id.numeric());
     if (_last_node[id.type].index >= id.index) {
         _last_node[id.type].index = id.index;
     }
@@ -270,6 +405,9 @@ Error Scene::remove_node(Node id)
         _last_node[id.type].index);
     L_INFO(
         "Removed %s@%d from the scene.", to_str<Node::Type>(id.type), id.index);
+    if (journal != nullptr) {
+        journal->remove(*this, id);
+    }
     return Error::OK;
 }
 
@@ -306,6 +444,14 @@ Error Scene::connect_with_id(
         && from_sock >= dependencies()[get_node<Component>(from_node)->dep_idx]
                 .component_context->outputs.size()) {
         return ERROR(Error::INVALID_NODEID);
+    } else if (from_node.type == Node::Type::SEQUENTIAL
+        && (get_node<Sequential>(from_node) == nullptr
+            || from_sock >= get_node<Sequential>(from_node)->outputs.size())) {
+        return ERROR(Error::INVALID_NODEID);
+    } else if (from_node.type == Node::Type::MEMORY
+        && (get_node<Memory>(from_node) == nullptr
+            || from_sock >= get_node<Memory>(from_node)->outputs.size())) {
+        return ERROR(Error::INVALID_NODEID);
     }
     if (!component_context.has_value()
         && (to_node.type == Node::Type::COMPONENT_OUTPUT
@@ -334,6 +480,36 @@ Error Scene::connect_with_id(
         comp->inputs[to_sock] = id;
         break;
     }
+    case Node::Type::SEQUENTIAL: {
+        auto seq = get_node<Sequential>(to_node);
+        if (seq == nullptr || to_sock >= seq->inputs.size()) {
+            return ERROR(Error::INVALID_TO_TYPE);
+        } else if (seq->inputs[to_sock] != 0) {
+            return ERROR(Error::ALREADY_CONNECTED);
+        }
+        seq->inputs[to_sock] = id;
+        break;
+    }
+    case Node::Type::LUT: {
+        auto lut = get_node<Lut>(to_node);
+        if (lut == nullptr || to_sock >= lut->inputs.size()) {
+            return ERROR(Error::INVALID_TO_TYPE);
+        } else if (lut->inputs[to_sock] != 0) {
+            return ERROR(Error::ALREADY_CONNECTED);
+        }
+        lut->inputs[to_sock] = id;
+        break;
+    }
+    case Node::Type::MEMORY: {
+        auto memory = get_node<Memory>(to_node);
+        if (memory == nullptr || to_sock >= memory->inputs.size()) {
+            return ERROR(Error::INVALID_TO_TYPE);
+        } else if (memory->inputs[to_sock] != 0) {
+            return ERROR(Error::ALREADY_CONNECTED);
+        }
+        memory->inputs[to_sock] = id;
+        break;
+    }
     case Node::Type::OUTPUT: {
         auto out = get_node<Output>(to_node);
         if (out == nullptr) {
@@ -373,6 +549,22 @@ Error Scene::connect_with_id(
         from->outputs[from_sock].push_back(id);
         break;
     }
+    case Node::Type::SEQUENTIAL: {
+        get_node<Sequential>(from_node)->outputs[from_sock].push_back(id);
+        break;
+    }
+    case Node::Type::MEMORY: {
+        get_node<Memory>(from_node)->outputs[from_sock].push_back(id);
+        break;
+    }
+    case Node::Type::LUT: {
+        auto from = get_node<Lut>(from_node);
+        if (from == nullptr) {
+            return ERROR(Error::INVALID_FROM_TYPE);
+        }
+        from->output.push_back(id);
+        break;
+    }
     case Node::Type::INPUT: {
         auto from = get_node<Input>(from_node);
         if (from == nullptr) {
@@ -397,15 +589,35 @@ Error Scene::connect_with_id(
     default: return ERROR(Error::INVALID_TO_TYPE);
     }
     _relations.emplace(id, Rel { id, from_node, to_node, from_sock, to_sock });
-    if (from_node.type != Node::COMPONENT_INPUT) {
-        get_base(from_node)->on_signal();
-    } else {
+    if (_is_loading) {
+        // Levels and values are computed once by Scene::end_load.
+        return OK;
+    }
+    if (!_raise_levels(from_node, to_node)) {
+        _feedback.insert(id);
+        _loops_dirty = true;
+    } else if (!_loops_dirty && !_feedback.empty()
+        && _reaches(to_node, from_node)) {
+        // The new loop passes through an existing feedback edge.
+        _loops_dirty = true;
+    }
+    if (from_node.type == Node::COMPONENT_INPUT) {
         component_context->run(0, 0);
+    } else if (from_node.type == Node::SEQUENTIAL
+        || from_node.type == Node::MEMORY) {
+        // Sequential and memory nodes only signal the relations that are out
+        // of date.
+        signal(id, get_base(from_node)->get(from_sock));
+    } else {
+        get_base(from_node)->on_signal();
     }
     L_INFO("Created connection between %s@%d and %s@%d with the id %d.",
         to_str<Node::Type>(from_node.type), from_node.index,
         to_str<Node::Type>(to_node.type), to_node.index, id);
     undo.push([this, id]() { disconnect(id); });
+    if (journal != nullptr) {
+        journal->connect(*this, _relations.at(id));
+    }
     return OK;
 }
 
@@ -444,6 +656,27 @@ Error Scene::disconnect(relid id)
         v.erase(std::remove_if(v.begin(), v.end(), remove_fn));
         break;
     }
+    case Node::Type::SEQUENTIAL: {
+        auto& v = get_node<Sequential>(r->second.from_node)
+                      ->outputs[r->second.from_sock];
+        v.erase(std::remove_if(v.begin(), v.end(), remove_fn));
+        break;
+    }
+    case Node::Type::MEMORY: {
+        auto& v = get_node<Memory>(r->second.from_node)
+                      ->outputs[r->second.from_sock];
+        v.erase(std::remove_if(v.begin(), v.end(), remove_fn));
+        break;
+    }
+    case Node::Type::LUT: {
+        auto node = get_node<Lut>(r->second.from_node);
+        if (node == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        node->output.erase(std::remove_if(
+            node->output.begin(), node->output.end(), remove_fn));
+        break;
+    }
     case Node::Type::INPUT: {
         auto node = get_node<Input>(r->second.from_node);
         if (node->is_null()) {
@@ -485,6 +718,33 @@ Error Scene::disconnect(relid id)
         c->on_signal();
         break;
     }
+    case Node::Type::SEQUENTIAL: {
+        auto seq = get_node<Sequential>(r->second.to_node);
+        if (seq == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        seq->inputs[r->second.to_sock] = 0;
+        seq->on_signal();
+        break;
+    }
+    case Node::Type::LUT: {
+        auto lut = get_node<Lut>(r->second.to_node);
+        if (lut == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        lut->inputs[r->second.to_sock] = 0;
+        lut->on_signal();
+        break;
+    }
+    case Node::Type::MEMORY: {
+        auto memory = get_node<Memory>(r->second.to_node);
+        if (memory == nullptr) {
+            return ERROR(Error::NODE_NOT_FOUND);
+        }
+        memory->inputs[r->second.to_sock] = 0;
+        memory->on_signal();
+        break;
+    }
     case Node::Type::OUTPUT: {
         auto o = get_node<Output>(r->second.to_node);
         if (o->is_null()) {
@@ -513,7 +773,24 @@ Error Scene::disconnect(relid id)
         Error _ = this->connect_with_id(r->first, r->second.to_node,
             r->second.to_sock, r->second.from_node, r->second.from_sock);
     });
+    if (journal != nullptr) {
+        journal->disconnect(*this, r->second);
+    }
+    Node from_node = r->second.from_node;
+    Node to_node   = r->second.to_node;
     _relations.erase(id);
+    if (_feedback.erase(id) != 0) {
+        _loops_dirty = true;
+    } else if (!_loops_dirty) {
+        // Removing a relation only changes the loops it was a part of.
+        auto from = _loop_of.find(from_node.numeric());
+        auto to   = _loop_of.find(to_node.numeric());
+        if (from != _loop_of.end() && to != _loop_of.end()
+            && from->second == to->second) {
+            _loops_dirty = true;
+        }
+    }
+    _lower_levels(to_node);
     return OK;
 }
 
@@ -523,22 +800,124 @@ void Scene::signal(relid id, State value)
     auto r = get_rel(id);
     ic_assert(r != nullptr);
     if (r->value != value || r->value == DISABLED) {
-        r->value = value;
+        bool changed = r->value != value;
+        r->value     = value;
+        if (recorder != nullptr && changed) {
+            recorder->record(id, value, tick());
+        }
+        if (_is_loading) {
+            // Scene::end_load evaluates the nodes in order instead.
+            if (r->to_node.type == Node::Type::COMPONENT_OUTPUT) {
+                component_context->set_value(r->to_node.index, r->value);
+            }
+            return;
+        }
         L_DEBUG("%s:rel@%-2d %s@%d:%d sent %s to %s@%d:%d",
             _parent != nullptr ? name().data() : "root", id,
             to_str<Node::Type>(r->from_node.type), r->from_node.index,
             r->from_sock, to_str<State>(r->value),
             to_str<Node::Type>(r->to_node.type), r->to_node.index, r->to_sock);
-        if (r->to_node.type != Node::Type::COMPONENT_OUTPUT) {
+        if (_loops_dirty) {
+            _find_loops();
+        }
+        if (r->to_node.type == Node::Type::COMPONENT_OUTPUT) {
+            component_context->set_value(r->to_node.index, r->value);
+        } else if (_loop_of.find(r->to_node.numeric()) != _loop_of.end()) {
+            // Nodes of a feedback loop are evaluated iteratively instead of
+            // recursively. A repeated DISABLED signal is only forwarded once,
+            // otherwise a loop of disconnected gates would never settle.
+            uint32_t key = r->to_node.numeric();
+            if ((changed || _evals.find(key) == _evals.end())
+                && _queued.insert(key).second) {
+                _pending.push_back(r->to_node);
+            }
+            if (!_converging) {
+                _converge();
+            }
+        } else {
             auto n = get_base(r->to_node);
             ic_assert(n != nullptr);
             n->on_signal();
-        } else {
-            component_context->set_value(r->to_node.index, r->value);
         }
     }
 }
 
+void Scene::begin_load(void) { _is_loading = true; }
+
+void Scene::end_load(void)
+{
+    if (!_is_loading) {
+        return;
+    }
+    _compute_levels();
+    _loops_dirty = true;
+    std::vector<Node> nodes;
+    std::unordered_set<uint32_t> is_added;
+    for (const auto& [_, r] : _relations) {
+        for (Node n : { r.from_node, r.to_node }) {
+            if (n.type != Node::Type::COMPONENT_INPUT
+                && n.type != Node::Type::COMPONENT_OUTPUT
+                && is_added.insert(n.numeric()).second) {
+                nodes.push_back(n);
+            }
+        }
+    }
+    std::stable_sort(nodes.begin(), nodes.end(),
+        [this](Node a, Node b) { return level(a) < level(b); });
+    // Signals are not forwarded yet, so each node is evaluated once after
+    // the nodes it depends on.
+    for (Node n : nodes) {
+        get_base(n)->on_signal();
+    }
+    _is_loading = false;
+    // Nodes behind a feedback relation saw its value before it was settled.
+    for (relid id : std::vector<relid> { _feedback.begin(), _feedback.end() }) {
+        auto r      = get_rel(id);
+        State value = r->value;
+        r->value    = DISABLED;
+        signal(id, value);
+    }
+    if (component_context.has_value()) {
+        component_context->run(0, 0);
+    }
+    L_INFO("Loaded %zu nodes and %zu relations.", nodes.size(),
+        _relations.size());
+}
+
+void Scene::schedule(relid id, State value, uint16_t delay)
+{
+    if (delay == 0) {
+        signal(id, value);
+    } else {
+        _wheel.push(delay, id, value);
+    }
+}
+
+size_t Scene::step(uint64_t ticks, size_t budget)
+{
+    return _wheel.advance(
+        _wheel.now() + ticks, budget, [this](relid id, State value) {
+            // The relation might have been removed while the event was
+            // waiting.
+            if (get_rel(id) != nullptr) {
+                signal(id, value);
+            }
+        });
+}
+
+bool Scene::settle(size_t budget)
+{
+    size_t delivered = 0;
+    while (!_wheel.empty() && delivered < budget) {
+        delivered += step(1, budget - delivered);
+    }
+    if (!_wheel.empty()) {
+        L_WARN("%s did not settle after %zu events.", name().data(), budget);
+        return false;
+    }
+    return true;
+}
+
 Ref<BaseNode> Scene::get_base(Node id)
 {
     switch (id.type) {
@@ -546,6 +925,9 @@ Ref<BaseNode> Scene::get_base(Node id)
     case Node::Type::COMPONENT: return get_node<Component>(id)->base();
     case Node::Type::INPUT: return get_node<Input>(id)->base();
     case Node::Type::OUTPUT: return get_node<Output>(id)->base();
+    case Node::Type::SEQUENTIAL: return get_node<Sequential>(id)->base();
+    case Node::Type::LUT: return get_node<Lut>(id)->base();
+    case Node::Type::MEMORY: return get_node<Memory>(id)->base();
     default: break;
     }
     return nullptr;
@@ -565,6 +947,17 @@ std::string Scene::to_dependency() const
     return dep_str.str();
 }
 
+uint64_t Scene::content_hash(void) const
+{
+    std::vector<uint8_t> buffer;
+    write_to(buffer);
+    uint64_t h = hash64(buffer.data(), buffer.size());
+    for (const Scene& dep : _dependencies) {
+        h = hash64(&h, sizeof(h), dep.content_hash());
+    }
+    return h;
+}
+
 void Scene::run(float delta)
 {
     uint32_t frame_pre = frame_s * 10;
@@ -579,6 +972,10 @@ void Scene::run(float delta)
             }
         }
     }
+    uint64_t target = static_cast<uint64_t>(frame_s * TICK_RATE);
+    if (target > tick()) {
+        step(target - tick(), event_budget);
+    }
 }
 
 Error Scene::add_dependency(const std::string& name)
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+template <> const char* to_str<Sequential::Type>(Sequential::Type s)
+{
+    switch (s) {
+    case Sequential::Type::D_FLIPFLOP: return "DFF";
+    case Sequential::Type::JK_FLIPFLOP: return "JKFF";
+    case Sequential::Type::SR_LATCH: return "SR";
+    case Sequential::Type::D_LATCH: return "DLATCH";
+    case Sequential::Type::REGISTER: return "REG";
+    default: return "null";
+    }
+}
+
+Sequential::Sequential(Scene* _s, Type type, sockid width)
+    : BaseNode { _s }
+    , _type { type }
+    , _width { type == Type::REGISTER
+              ? std::max<sockid>(1, std::min(width, MAX_WIDTH))
+              : sockid { 1 } }
+{
+    // Reset is the last input of every type that has one.
+    inputs.resize(_type == Type::SR_LATCH ? 2 : reset() + 1, 0);
+    sockid output_s = _type == Type::REGISTER ? _width : 2;
+    for (sockid i = 0; i < output_s; i++) {
+        outputs[i] = {};
+    }
+}
+
+bool Sequential::is_clocked(void) const
+{
+    return _type == Type::D_FLIPFLOP || _type == Type::JK_FLIPFLOP
+        || _type == Type::REGISTER;
+}
+
+sockid Sequential::clock(void) const
+{
+    switch (_type) {
+    case Type::D_FLIPFLOP:
+    case Type::D_LATCH: return 1;
+    case Type::JK_FLIPFLOP: return 2;
+    case Type::REGISTER: return _width;
+    default: return NO_SOCK;
+    }
+}
+
+sockid Sequential::enable(void) const
+{
+    return is_clocked() ? clock() + 1 : NO_SOCK;
+}
+
+sockid Sequential::reset(void) const
+{
+    switch (_type) {
+    case Type::D_LATCH: return 2;
+    case Type::SR_LATCH: return NO_SOCK;
+    default: return clock() + 2;
+    }
+}
+
+void Sequential::set_value(uint64_t value)
+{
+    uint64_t old_value = _value;
+    _parent->undo.push([this, old_value]() { set_value(old_value); });
+    _value = value;
+    _notify();
+    if (_parent->journal != nullptr) {
+        _parent->journal->update(*_parent, *this);
+    }
+}
+
+bool Sequential::is_connected(void) const
+{
+    for (sockid i = 0; i < inputs.size(); i++) {
+        if (inputs[i] == 0 && i != enable() && i != reset()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+State Sequential::get(sockid slot) const
+{
+    if (_is_disabled) {
+        return DISABLED;
+    }
+    if (_type == Type::REGISTER) {
+        return (_value >> slot) & 1 ? TRUE : FALSE;
+    }
+    return ((_value & 1) != 0) != (slot == 1) ? TRUE : FALSE;
+}
+
+State Sequential::_input(sockid sock) const
+{
+    if (sock >= inputs.size() || inputs[sock] == 0) {
+        return DISABLED;
+    }
+    auto rel = _parent->get_rel(inputs[sock]);
+    ic_assert(rel != nullptr);
+    return rel->value;
+}
+
+void Sequential::on_signal(void)
+{
+    _is_disabled = !is_connected();
+    if (!_is_disabled) {
+        bool is_reset   = reset() != NO_SOCK && _input(reset()) == TRUE;
+        bool is_enabled = enable() == NO_SOCK || inputs[enable()] == 0
+            || _input(enable()) == TRUE;
+        State clk = clock() != NO_SOCK ? _input(clock()) : DISABLED;
+        bool is_edge = _clock == FALSE && clk == TRUE;
+        _clock       = clk == TRUE ? TRUE : FALSE;
+
+        if (is_reset) {
+            _value = 0;
+        } else {
+            switch (_type) {
+            case Type::D_FLIPFLOP:
+                if (is_edge && is_enabled) {
+                    _value = _input(0) == TRUE;
+                }
+                break;
+            case Type::JK_FLIPFLOP:
+                if (is_edge && is_enabled) {
+                    bool j = _input(0) == TRUE;
+                    bool k = _input(1) == TRUE;
+                    if (j && k) {
+                        _value ^= 1;
+                    } else if (j || k) {
+                        _value = j;
+                    }
+                }
+                break;
+            case Type::SR_LATCH: {
+                // Reset wins when both inputs are set.
+                bool s = _input(0) == TRUE;
+                bool r = _input(1) == TRUE;
+                if (r) {
+                    _value = 0;
+                } else if (s) {
+                    _value = 1;
+                }
+                break;
+            }
+            case Type::D_LATCH:
+                if (clk == TRUE) {
+                    _value = _input(0) == TRUE;
+                }
+                break;
+            case Type::REGISTER:
+                if (is_edge && is_enabled) {
+                    _value = 0;
+                    for (sockid i = 0; i < _width; i++) {
+                        if (_input(i) == TRUE) {
+                            _value |= 1ull << i;
+                        }
+                    }
+                }
+                break;
+            default: break;
+            }
+        }
+    }
+    _notify();
+}
+
+void Sequential::_notify(void)
+{
+    // Only relations whose value is out of date are signalled, so a node that
+    // feeds itself does not recurse while it is disabled.
+    for (const auto& [sock, rels] : outputs) {
+        State value = get(sock);
+        for (relid out : rels) {
+            auto rel = _parent->get_rel(out);
+            if (rel != nullptr && rel->value != value) {
+                _parent->signal(out, value);
+            }
+        }
+    }
+}
+
+void Sequential::clean(void)
+{
+    for (const auto& [sock, rels] : outputs) {
+        // disconnect removes the id from the vector that is being iterated.
+        std::vector<relid> copy = rels;
+        for (relid r : copy) {
+            _parent->disconnect(r);
+        }
+    }
+    for (relid r : inputs) {
+        if (r != 0) {
+            _parent->disconnect(r);
+        }
+    }
+}
+
+} // namespace ic
@@ -0,0 +1,185 @@
+#include <cstring>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+/**
+ * Reads the next CSV row into values.
+ * @returns false at the end of the stream
+ */
+static bool _read_csv(std::istream& in, std::string& line,
+    std::vector<bool>& values, bool& is_valid)
+{
+    while (std::getline(in, line)) {
+        values.clear();
+        is_valid = true;
+        for (char c : line) {
+            if (c == '0' || c == '1') {
+                values.push_back(c == '1');
+            } else if (c != ',' && c != ' ' && c != '\t' && c != '\r') {
+                is_valid = false;
+            }
+        }
+        if (!values.empty() || !is_valid) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void _write_header(std::ostream& out, uint16_t size)
+{
+    out.write(STREAM_MAGIC, sizeof(STREAM_MAGIC));
+    char bytes[2] = { static_cast<char>(size & 0xFF),
+        static_cast<char>(size >> 8) };
+    out.write(bytes, sizeof(bytes));
+}
+
+static bool _read_header(std::istream& in, uint16_t& size)
+{
+    char magic[sizeof(STREAM_MAGIC)];
+    unsigned char bytes[2];
+    if (!in.read(magic, sizeof(magic))
+        || std::memcmp(magic, STREAM_MAGIC, sizeof(magic)) != 0
+        || !in.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) {
+        return false;
+    }
+    size = bytes[0] | (bytes[1] << 8);
+    return true;
+}
+
+/**
+ * Reads the next row of the stimulus.
+ * @returns false at the end of the stream or on error
+ */
+static bool _read_row(std::istream& stimulus, StreamFormat format,
+    size_t size, std::string& line, std::vector<unsigned char>& bytes,
+    std::vector<bool>& values, size_t steps, Error& err)
+{
+    if (format == StreamFormat::BINARY) {
+        bytes.resize((size + 7) / 8);
+        if (!stimulus.read(reinterpret_cast<char*>(bytes.data()), bytes.size())
+            || (bytes.empty() && stimulus.peek() == EOF)) {
+            if (stimulus.gcount() != 0) {
+                err = ERROR(Error::INVALID_FILE);
+            }
+            return false;
+        }
+        values.resize(size);
+        for (size_t i = 0; i < size; i++) {
+            values[i] = (bytes[i / 8] >> (i % 8)) & 1;
+        }
+        return true;
+    }
+    bool is_valid = true;
+    while (_read_csv(stimulus, line, values, is_valid)) {
+        if (!is_valid) {
+            // A header is only allowed on the first row.
+            if (steps != 0) {
+                err = ERROR(Error::INVALID_FILE);
+                return false;
+            }
+            continue;
+        } else if (values.size() != size) {
+            err = ERROR(Error::IO_MISMATCH);
+            return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+Error run_stimulus(Scene& scene, std::istream& stimulus,
+    StreamFormat in_format, std::ostream& samples, StreamFormat out_format,
+    uint64_t ticks)
+{
+    std::unique_ptr<Backend> backend = Backend::create(scene.engine);
+    if (Error err = backend->load(scene); err != Error::OK) {
+        return err;
+    }
+    return run_stimulus(
+        *backend, stimulus, in_format, samples, out_format, ticks);
+}
+
+Error run_stimulus(Backend& backend, std::istream& stimulus,
+    StreamFormat in_format, std::ostream& samples, StreamFormat out_format,
+    uint64_t ticks)
+{
+    size_t input_s  = backend.input_size();
+    size_t output_s = backend.output_size();
+    if (in_format == StreamFormat::BINARY) {
+        uint16_t size = 0;
+        if (!_read_header(stimulus, size)) {
+            return ERROR(Error::INVALID_FILE);
+        } else if (size != input_s) {
+            return ERROR(Error::IO_MISMATCH);
+        }
+    }
+    if (out_format == StreamFormat::BINARY) {
+        _write_header(samples, output_s);
+    } else {
+        samples << "tick";
+        for (size_t i = 0; i < output_s; i++) {
+            samples << ",out_" << i;
+        }
+        samples << '\n';
+    }
+
+    // Rows are read in batches, so that bit parallel backends are filled.
+    std::vector<std::vector<bool>> rows(backend.batch_size());
+    std::vector<std::vector<State>> outputs;
+    std::string line, text;
+    std::vector<unsigned char> bytes;
+    // Only the event driven backend advances the clock of the scene.
+    uint64_t start = backend.scene()->tick();
+    size_t steps   = 0;
+    Error err    = Error::OK;
+    bool is_done = false;
+    while (!is_done) {
+        size_t count = 0;
+        while (count < rows.size()
+            && _read_row(stimulus, in_format, input_s, line, bytes,
+                rows[count], steps + count, err)) {
+            count++;
+        }
+        if (err != Error::OK) {
+            return err;
+        }
+        is_done = count < rows.size();
+        rows.resize(count);
+        backend.run(rows, ticks, outputs);
+        rows.resize(backend.batch_size());
+
+        for (size_t r = 0; r < count; r++) {
+            steps++;
+            const std::vector<State>& out = outputs[r];
+            if (out_format == StreamFormat::BINARY) {
+                bytes.assign((output_s + 7) / 8, 0);
+                for (size_t i = 0; i < output_s; i++) {
+                    if (out[i] == TRUE) {
+                        bytes[i / 8] |= 1 << (i % 8);
+                    }
+                }
+                samples.write(
+                    reinterpret_cast<char*>(bytes.data()), bytes.size());
+            } else {
+                text = std::to_string(start + steps * ticks);
+                for (State value : out) {
+                    text += ',';
+                    text += value == TRUE ? '1' : value == FALSE ? '0' : 'x';
+                }
+                text += '\n';
+                samples << text;
+            }
+        }
+        if (!samples) {
+            return ERROR(Error::INVALID_FILE);
+        }
+    }
+    L_INFO("Simulated %zu steps with the %s backend.", steps,
+        to_str<Backend::Type>(backend.type()));
+    return Error::OK;
+}
+
+} // namespace ic
@@ -28,14 +28,32 @@ LCS_ERROR open(const std::filesystem::path& path)
             return OK;
         }
     }
-    std::vector<uint8_t> data;
-    if (!fs::read(path, data)) {
-        return ERROR(Error::NOT_FOUND);
-    }
     Tab inode { Scene {}, true, path };
-    if (Error err = inode.scene.read_from(data); err) {
+    if (Error err = inode.scene.read_file(path); err) {
         return err;
     }
+    inode.journal = std::make_unique<Journal>();
+    if (inode.journal->open(path, inode.scene)) {
+        // The journal must never keep the file from opening. It is kept for
+        // inspection and the file is opened as it was last saved.
+        std::filesystem::path journal_path = Journal::path_of(path);
+        std::filesystem::path bad_path     = journal_path;
+        bad_path += ".bad";
+        L_WARN("Could not replay %s, it is moved to %s.",
+            journal_path.string().c_str(), bad_path.string().c_str());
+        std::error_code ec;
+        std::filesystem::rename(journal_path, bad_path, ec);
+        inode.scene = Scene {};
+        if (Error err = inode.scene.read_file(path); err) {
+            return err;
+        }
+        if (inode.journal->open(path, inode.scene)) {
+            L_WARN("%s is opened without a journal.", path.string().c_str());
+            inode.scene.journal = nullptr;
+            inode.journal.reset();
+        }
+    }
+    inode.is_saved = inode.journal == nullptr || inode.journal->pending() == 0;
     TABS.push_back(std::move(inode));
     old_selected = selected;
     selected     = TABS.size() - 1;
@@ -56,6 +74,11 @@ LCS_ERROR close(size_t idx)
     } else {
         L_INFO("Active tab(%zu) is closed.", selected);
     }
+    if (TABS[idx].journal != nullptr) {
+        // Closing a tab throws its unsaved edits away.
+        TABS[idx].journal->close(true);
+        TABS[idx].scene.journal = nullptr;
+    }
     TABS.erase(TABS.begin() + idx);
     if (TABS.empty()) {
         selected = SIZE_MAX;
@@ -74,7 +97,8 @@ bool is_saved(size_t idx)
         idx = selected;
     }
     ic_assert(idx < TABS.size());
-    return TABS[idx].is_saved;
+    return TABS[idx].is_saved
+        && (TABS[idx].journal == nullptr || TABS[idx].journal->pending() == 0);
 }
 
 LCS_ERROR save(size_t idx)
@@ -84,16 +108,15 @@ LCS_ERROR save(size_t idx)
     }
     ic_assert(idx < TABS.size());
     Tab& inode = TABS[idx];
-    if (inode.is_saved) {
+    if (inode.is_saved
+        && (inode.journal == nullptr || inode.journal->pending() == 0)) {
         return OK;
     }
-    std::vector<uint8_t> scene_bin;
-    Error err = inode.scene.write_to(scene_bin);
-    if (err) {
-        return err;
+    if (inode.journal == nullptr) {
+        inode.journal = std::make_unique<Journal>();
     }
-    if (!fs::write(inode.path, scene_bin)) {
-        return ERROR(Error::NO_SAVE_PATH_DEFINED);
+    if (Error err = inode.journal->compact(inode.path, inode.scene); err) {
+        return err;
     }
     inode.is_saved = true;
     if (idx != selected) {
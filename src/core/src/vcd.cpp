@@ -0,0 +1,137 @@
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+static_assert(Scene::TICK_RATE == 1000, "VCD time scale must match ticks");
+
+/** Printable ASCII from '!' to '~' is the alphabet of VCD identifiers. */
+static std::string _vcd_code(size_t index)
+{
+    std::string code;
+    do {
+        code.push_back(static_cast<char>('!' + index % 94));
+        index /= 94;
+    } while (index > 0);
+    return code;
+}
+
+static char _vcd_value(State value)
+{
+    switch (value) {
+    case FALSE: return '0';
+    case TRUE: return '1';
+    default: return 'z';
+    }
+}
+
+/** VCD identifiers can not contain white space. */
+static std::string _vcd_name(std::string name)
+{
+    for (char& c : name) {
+        if (c <= ' ' || c > '~') {
+            c = '_';
+        }
+    }
+    return name.empty() ? "scene" : name;
+}
+
+WaveRecorder::~WaveRecorder() { close(); }
+
+void WaveRecorder::add(relid id, const std::string& name)
+{
+    _signals.push_back(
+        { id, _vcd_name(name.empty() ? "rel_" + std::to_string(id) : name) });
+}
+
+void WaveRecorder::add_outputs(const Scene& scene)
+{
+    for (size_t i = 0; i < scene._outputs.size(); i++) {
+        const Output& out = scene._outputs[i];
+        if (!out.is_null() && out.input != 0) {
+            add(out.input, "out_" + std::to_string(i));
+        }
+    }
+}
+
+Error WaveRecorder::open(Scene& scene, const std::filesystem::path& path)
+{
+    close();
+    for (const Signal& sig : _signals) {
+        if (scene.get_rel(sig.id) == nullptr) {
+            return ERROR(Error::REL_NOT_FOUND);
+        }
+    }
+    _file.open(path, std::ios::binary | std::ios::trunc);
+    if (!_file) {
+        return ERROR(Error::NOT_FOUND);
+    }
+
+    _buffer.clear();
+    _codes.clear();
+    _buffer += "$version " APPNAME " $end\n";
+    _buffer += "$timescale 1ms $end\n";
+    _buffer += "$scope module " + _vcd_name(scene.name().data()) + " $end\n";
+    for (const Signal& sig : _signals) {
+        auto it = _codes.find(sig.id);
+        if (it == _codes.end()) {
+            it = _codes.emplace(sig.id, _vcd_code(_codes.size())).first;
+        }
+        _buffer += "$var wire 1 " + it->second + " " + sig.name + " $end\n";
+    }
+    _buffer += "$upscope $end\n$enddefinitions $end\n";
+    _last_tick = scene.tick();
+    _buffer += "#" + std::to_string(_last_tick) + "\n$dumpvars\n";
+    std::unordered_set<relid> dumped;
+    for (const Signal& sig : _signals) {
+        if (dumped.insert(sig.id).second) {
+            _buffer += _vcd_value(scene.get_rel(sig.id)->value);
+            _buffer += _codes[sig.id] + "\n";
+        }
+    }
+    _buffer += "$end\n";
+
+    _scene         = &scene;
+    scene.recorder = this;
+    L_INFO("Recording %zu signals into %s.", _codes.size(), path.c_str());
+    return Error::OK;
+}
+
+void WaveRecorder::close(void)
+{
+    if (_scene == nullptr) {
+        return;
+    }
+    if (_scene->recorder == this) {
+        _scene->recorder = nullptr;
+    }
+    _scene = nullptr;
+    _flush();
+    _file.close();
+}
+
+void WaveRecorder::record(relid id, State value, uint64_t tick)
+{
+    auto it = _codes.find(id);
+    if (it == _codes.end()) {
+        return;
+    }
+    if (tick != _last_tick) {
+        _last_tick = tick;
+        _buffer += "#" + std::to_string(tick) + "\n";
+    }
+    _buffer += _vcd_value(value);
+    _buffer += it->second;
+    _buffer += '\n';
+    if (_buffer.size() >= BUFFER_S) {
+        _flush();
+    }
+}
+
+void WaveRecorder::_flush(void)
+{
+    _file.write(_buffer.data(), _buffer.size());
+    _buffer.clear();
+}
+
+} // namespace ic
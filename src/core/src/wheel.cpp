@@ -0,0 +1,74 @@
+#include <algorithm>
+#include "common.h"
+#include "core.h"
+
+namespace ic {
+
+void EventWheel::push(uint16_t delay, relid id, State value)
+{
+    ic_assert(delay != 0);
+    if (_slots.size() <= delay) {
+        // Grow the ring so that every pending event has its own bucket.
+        // Events of the same tick share a bucket, so their order is kept.
+        size_t slot_s = std::max(_slots.size(), SLOT_S);
+        while (slot_s <= delay) {
+            slot_s <<= 1;
+        }
+        std::vector<std::vector<Event>> slots(slot_s);
+        for (auto& slot : _slots) {
+            for (const Event& ev : slot) {
+                slots[ev.tick & (slot_s - 1)].push_back(ev);
+            }
+        }
+        _slots = std::move(slots);
+        L_DEBUG("Event wheel is resized to %zu slots.", slot_s);
+    }
+    uint64_t tick = _now + delay;
+    _slots[tick & (_slots.size() - 1)].push_back({ tick, id, value });
+    _size++;
+}
+
+size_t EventWheel::advance(uint64_t until, size_t budget,
+    const std::function<void(relid, State)>& deliver)
+{
+    size_t delivered = 0;
+    while (_size > 0) {
+        std::vector<Event>& slot = _slots[_now & (_slots.size() - 1)];
+        if (!slot.empty()) {
+            if (delivered >= budget) {
+                return delivered;
+            }
+            // deliver may schedule new events, which might resize the ring.
+            std::vector<Event> batch;
+            batch.swap(slot);
+            size_t i = 0;
+            while (i < batch.size() && delivered < budget) {
+                _size--;
+                delivered++;
+                deliver(batch[i].id, batch[i].value);
+                i++;
+            }
+            if (i < batch.size()) {
+                std::vector<Event>& rest = _slots[_now & (_slots.size() - 1)];
+                rest.insert(rest.begin(), batch.begin() + i, batch.end());
+                return delivered;
+            }
+        }
+        if (_now >= until) {
+            return delivered;
+        }
+        _now++;
+    }
+    _now = std::max(_now, until);
+    return delivered;
+}
+
+void EventWheel::clear(void)
+{
+    for (auto& slot : _slots) {
+        slot.clear();
+    }
+    _size = 0;
+}
+
+} // namespace ic
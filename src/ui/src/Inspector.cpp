@@ -29,6 +29,9 @@ private:
     void _inspector_output(Ref<Scene>, Node);
     void _inspector_component(Ref<Scene>, Node);
     void _inspector_gate(Ref<Scene>, Node);
+    void _inspector_sequential(Ref<Scene>, Node);
+    void _inspector_lut(Ref<Scene>, Node);
+    void _inspector_memory(Ref<Scene>, Node);
     void _inspector_component_context(Ref<Scene>, Node);
     void _inspector_tab(Ref<Scene>, Node);
 };
@@ -102,6 +105,9 @@ void Inspector::_inspector_tab(Ref<Scene> scene, Node node)
         case Node::Type::OUTPUT: _inspector_output(scene, node); break;
         case Node::Type::GATE: _inspector_gate(scene, node); break;
         case Node::Type::COMPONENT: _inspector_component(scene, node); break;
+        case Node::Type::SEQUENTIAL: _inspector_sequential(scene, node); break;
+        case Node::Type::LUT: _inspector_lut(scene, node); break;
+        case Node::Type::MEMORY: _inspector_memory(scene, node); break;
         default: _inspector_component_context(scene, node); break;
         }
     };
@@ -216,6 +222,137 @@ void Inspector::_inspector_gate(Ref<Scene> scene, Node node)
     ImGui::EndTable();
 }
 
+void Inspector::_inspector_sequential(Ref<Scene> scene, Node node)
+{
+    auto _node = scene->get_node<Sequential>(node);
+    TablePair(Field(_("Value")),
+        ImGui::Text("0x%llx", static_cast<unsigned long long>(_node->value())));
+    TablePair(Field(_("Sequential Type")),
+        ImGui::Text("%s", to_str<Sequential::Type>(_node->type())));
+    TablePair(Field(_("Width")), ImGui::Text("%u", _node->width()));
+    TablePair(Field(_("Inputs")), _input_table(scene, _node->inputs));
+    TableKey(Field(_("Outputs")));
+    if (ImGui::BeginTable("InputList", 3,
+            ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn(_("Socket"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(
+            _("Connection"), ImGuiTableColumnFlags_WidthStretch);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(_("Value"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+
+        for (auto& out : _node->outputs) {
+            TablePair(Field("%d", out.first), _output_table(scene, out.second));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%s", to_str(_node->get(out.first)));
+        }
+
+        ImGui::EndTable();
+    }
+    ImGui::EndTable();
+}
+
+void Inspector::_inspector_lut(Ref<Scene> scene, Node node)
+{
+    auto _node = scene->get_node<Lut>(node);
+    TablePair(Field(_("Value")), ImGui::Text("%s", to_str(_node->get())));
+    TableKey(Field(_("Truth Table")));
+    if (ImGui::BeginTable("TruthTable", 2,
+            ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn(_("Index"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(_("Value"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+        for (size_t i = 0; i < (1u << _node->inputs.size()); i++) {
+            TableKey(Field("%zu", i));
+            ImGui::PushID(i);
+            bool value = _node->lookup(i);
+            if (ImGui::Checkbox("##Bit", &value)) {
+                Lut::Table table = _node->table();
+                table[i]         = value;
+                _node->set_table(table);
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    TablePair(Field(_("Inputs")), _input_table(scene, _node->inputs));
+    TableKey(Field(_("Outputs")));
+    if (ImGui::BeginTable("InputList", 3,
+            ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn(_("Socket"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(
+            _("Connection"), ImGuiTableColumnFlags_WidthStretch);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(_("Value"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+        TableKey(Field("1"));
+        _output_table(scene, _node->output);
+        ImGui::TableSetColumnIndex(2);
+        ImGui::Text("%s", to_str(_node->get()));
+        ImGui::EndTable();
+    }
+    ImGui::EndTable();
+}
+
+void Inspector::_inspector_memory(Ref<Scene> scene, Node node)
+{
+    static char path[512] = { 0 };
+    auto _node            = scene->get_node<Memory>(node);
+    TablePair(Field(_("Memory Type")),
+        ImGui::Text("%s", to_str<Memory::Type>(_node->type())));
+    TablePair(Field(_("Size")),
+        ImGui::Text("%zu x %u", _node->size(), _node->data_s()));
+    TableKey(Field(_("Contents")));
+    ImGui::InputText("##MemoryPath", path, sizeof(path));
+    ImGui::SameLine();
+    if (IconButton(ICON_LC_FOLDER_OPEN, _("Load"))) {
+        _node->load_file(path);
+    }
+    if (ImGui::BeginTable("MemoryWords", 2,
+            ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg
+                | ImGuiTableFlags_ScrollY,
+            ImVec2(0, ImGui::GetTextLineHeightWithSpacing() * 8))) {
+        ImGui::TableSetupColumn(_("Address"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(_("Value"), ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+        ImGuiListClipper clipper;
+        clipper.Begin(_node->size());
+        while (clipper.Step()) {
+            for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+                TablePair(Field("%04x", i),
+                    ImGui::Text("%0*x", (_node->data_s() + 3) / 4,
+                        _node->read(i)));
+            }
+        }
+        ImGui::EndTable();
+    }
+    TablePair(Field(_("Inputs")), _input_table(scene, _node->inputs));
+    TableKey(Field(_("Outputs")));
+    if (ImGui::BeginTable("InputList", 3,
+            ImGuiTableFlags_BordersInner | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn(_("Socket"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(
+            _("Connection"), ImGuiTableColumnFlags_WidthStretch);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn(_("Value"), ImGuiTableColumnFlags_WidthFixed);
+        ImGui::TableHeadersRow();
+
+        for (auto& out : _node->outputs) {
+            TablePair(Field("%d", out.first), _output_table(scene, out.second));
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%s", to_str(_node->get(out.first)));
+        }
+
+        ImGui::EndTable();
+    }
+    ImGui::EndTable();
+}
+
 void Inspector::_inspector_component(Ref<Scene> scene, Node node)
 {
     auto _node = scene->get_node<Component>(node);
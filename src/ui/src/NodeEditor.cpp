@@ -27,6 +27,9 @@ private:
     void _show_node(Output& node, uint16_t id, bool is_changed);
     void _show_node(Gate& node, uint16_t id, bool is_changed);
     void _show_node(Component& node, uint16_t id, bool is_changed);
+    void _show_node(Sequential& node, uint16_t id, bool is_changed);
+    void _show_node(Lut& node, uint16_t id, bool is_changed);
+    void _show_node(Memory& node, uint16_t id, bool is_changed);
     void _show_node(ComponentContext& node, uint16_t, bool);
     void _sync_position(BaseNode& node, uint32_t node_id, bool is_changed);
 
@@ -88,6 +91,21 @@ void Editor::show(Ref<Scene> scene, bool is_changed)
                 _show_node(scene->_components[i], i, is_changed);
             }
         }
+        for (size_t i = 0; i < scene->_sequentials.size(); i++) {
+            if (!scene->_sequentials[i].is_null()) {
+                _show_node(scene->_sequentials[i], i, is_changed);
+            }
+        }
+        for (size_t i = 0; i < scene->_luts.size(); i++) {
+            if (!scene->_luts[i].is_null()) {
+                _show_node(scene->_luts[i], i, is_changed);
+            }
+        }
+        for (size_t i = 0; i < scene->_memories.size(); i++) {
+            if (!scene->_memories[i].is_null()) {
+                _show_node(scene->_memories[i], i, is_changed);
+            }
+        }
         for (auto& r : scene->_relations) {
 
             ImNodes::PushColorStyle(ImNodesCol_Link,
@@ -258,6 +276,17 @@ void Editor::show(Ref<Scene> scene, bool is_changed)
                         scene->remove_node(decode_pair(nodeids[i]));
                     }
                 }
+                if (IconButton(ICON_LC_COMBINE, _("Collapse into LUT"))) {
+                    std::vector<Node> selected;
+                    for (int i = 0; i < len; i++) {
+                        selected.push_back(decode_pair(nodeids[i]));
+                    }
+                    Node lut;
+                    if (scene->collapse(selected, lut) == Error::OK) {
+                        ImNodes::ClearNodeSelection();
+                        ImGui::CloseCurrentPopup();
+                    }
+                }
             }
 
             if (ImGui::BeginMenu("Create")) {
@@ -283,6 +312,26 @@ void Editor::show(Ref<Scene> scene, bool is_changed)
                     node = scene->add_node<Gate>(Gate::Type::XOR);
                 } else if (ImGui::MenuItem(_("XNOR Gate"))) {
                     node = scene->add_node<Gate>(Gate::Type::XNOR);
+                } else if (ImGui::MenuItem(_("LUT"))) {
+                    node = scene->add_node<Lut>(static_cast<sockid>(2));
+                } else if (ImGui::MenuItem(_("D Flip-Flop"))) {
+                    node = scene->add_node<Sequential>(
+                        Sequential::Type::D_FLIPFLOP);
+                } else if (ImGui::MenuItem(_("JK Flip-Flop"))) {
+                    node = scene->add_node<Sequential>(
+                        Sequential::Type::JK_FLIPFLOP);
+                } else if (ImGui::MenuItem(_("SR Latch"))) {
+                    node
+                        = scene->add_node<Sequential>(Sequential::Type::SR_LATCH);
+                } else if (ImGui::MenuItem(_("D Latch"))) {
+                    node = scene->add_node<Sequential>(Sequential::Type::D_LATCH);
+                } else if (ImGui::MenuItem(_("Register"))) {
+                    node = scene->add_node<Sequential>(
+                        Sequential::Type::REGISTER, static_cast<sockid>(8));
+                } else if (ImGui::MenuItem(_("ROM"))) {
+                    node = scene->add_node<Memory>(Memory::Type::ROM);
+                } else if (ImGui::MenuItem(_("RAM"))) {
+                    node = scene->add_node<Memory>(Memory::Type::RAM);
                 } else {
                     created = false;
                 }
@@ -441,6 +490,118 @@ void Editor::_show_node(Component& node, uint16_t id, bool is_changed)
     ImNodes::EndNode();
 }
 
+void Editor::_show_node(Sequential& node, uint16_t id, bool is_changed)
+{
+    Node nodeinfo   = Node { id, Node::Type::SEQUENTIAL };
+    uint32_t nodeid = nodeinfo.numeric();
+    ImNodes::BeginNode(nodeid);
+    _sync_position(node, nodeid, is_changed);
+    ImNodes::BeginNodeTitleBar();
+    ImGui::Text("%s %u", to_str<Sequential::Type>(node.type()), id);
+    ImNodes::EndNodeTitleBar();
+
+    for (size_t i = 0; i < node.inputs.size(); i++) {
+        if (i == node.inputs.size() / 2) {
+            for (const auto& [sock, out] : node.outputs) {
+                ImNodes::BeginOutputAttribute(encode_pair(nodeinfo, sock, true),
+                    to_shape(!out.empty(), false));
+                ImGui::SetCursorPosX(ImGui::GetCursorPosX()
+                    + ImGui::CalcTextSize("         ").x);
+                ImGui::Text("%d", sock + 1);
+                ImNodes::EndOutputAttribute();
+            }
+        }
+        const char* name = i == node.clock() ? "CLK"
+            : i == node.enable()             ? "EN"
+            : i == node.reset()              ? "RST"
+                                             : nullptr;
+        ImNodes::BeginInputAttribute(encode_pair(nodeinfo, i, false),
+            to_shape(node.inputs[i] != 0, true));
+        if (name != nullptr) {
+            ImGui::Text("%s", name);
+        } else {
+            ImGui::Text("%zu", i + 1);
+        }
+        ImNodes::EndInputAttribute();
+    }
+
+    ImNodes::EndNode();
+}
+
+void Editor::_show_node(Lut& node, uint16_t id, bool is_changed)
+{
+    Node nodeinfo   = Node { id, Node::Type::LUT };
+    uint32_t nodeid = nodeinfo.numeric();
+    ImNodes::BeginNode(nodeid);
+    _sync_position(node, nodeid, is_changed);
+    ImNodes::BeginNodeTitleBar();
+    ImGui::Text(_("LUT %u"), id);
+    ImNodes::EndNodeTitleBar();
+
+    auto output = [&]() {
+        ImNodes::BeginOutputAttribute(encode_pair(nodeinfo, 0, true),
+            to_shape(node.output.size() > 0, false));
+        ImGui::SetCursorPosX(
+            ImGui::GetCursorPosX() + ImGui::CalcTextSize("         ").x);
+        ImGui::Text("1");
+        ImNodes::EndOutputAttribute();
+    };
+    for (size_t i = 0; i < node.inputs.size(); i++) {
+        if (i == node.inputs.size() / 2) {
+            output();
+        }
+        ImNodes::BeginInputAttribute(encode_pair(nodeinfo, i, false),
+            to_shape(node.is_connected(), true));
+        ImGui::Text("%zu", i + 1);
+        ImNodes::EndInputAttribute();
+    }
+    // A constant has no inputs to place its output between.
+    if (node.inputs.empty()) {
+        output();
+    }
+
+    ImNodes::EndNode();
+}
+
+void Editor::_show_node(Memory& node, uint16_t id, bool is_changed)
+{
+    Node nodeinfo   = Node { id, Node::Type::MEMORY };
+    uint32_t nodeid = nodeinfo.numeric();
+    ImNodes::BeginNode(nodeid);
+    _sync_position(node, nodeid, is_changed);
+    ImNodes::BeginNodeTitleBar();
+    ImGui::Text("%s %u (%zux%u)", to_str<Memory::Type>(node.type()), id,
+        node.size(), node.data_s());
+    ImNodes::EndNodeTitleBar();
+
+    for (size_t i = 0; i < node.inputs.size(); i++) {
+        if (i == node.inputs.size() / 2) {
+            for (const auto& [sock, out] : node.outputs) {
+                ImNodes::BeginOutputAttribute(encode_pair(nodeinfo, sock, true),
+                    to_shape(!out.empty(), false));
+                ImGui::SetCursorPosX(ImGui::GetCursorPosX()
+                    + ImGui::CalcTextSize("         ").x);
+                ImGui::Text("Q%d", sock);
+                ImNodes::EndOutputAttribute();
+            }
+        }
+        ImNodes::BeginInputAttribute(encode_pair(nodeinfo, i, false),
+            to_shape(node.inputs[i] != 0, true));
+        if (i < node.address_s()) {
+            ImGui::Text("A%zu", i);
+        } else if (i == node.write_enable()) {
+            ImGui::Text("WE");
+        } else if (i == node.clock()) {
+            ImGui::Text("CLK");
+        } else {
+            ImGui::Text("D%zu", i - node.address_s());
+        }
+        ImNodes::EndInputAttribute();
+    }
+
+    ImNodes::EndNode();
+}
+
 void Editor::_sync_position(BaseNode& node, uint32_t node_id, bool is_changed)
 {
     if (is_changed) {
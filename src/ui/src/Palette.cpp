@@ -75,6 +75,57 @@ void Palette::show(Ref<Scene> scene, bool)
                 dragged_node = scene->add_node<Gate>(Gate::Type::XNOR);
                 is_dragging  = true;
             });
+        TablePair(
+            if (ImGui::Button(_("LUT"))) {
+                dragged_node = scene->add_node<Lut>(static_cast<sockid>(2));
+                is_dragging  = true;
+            },
+            ImGui::Text(" "));
+        ImGui::EndTable();
+    }
+    if (ImGui::CollapsingHeader(_("Sequential"))) {
+        ImGui::BeginTable("##SequentialPalette", 2);
+        ImGui::TableSetupColumn("##S1", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::NextColumn();
+        ImGui::TableSetupColumn("##S2", ImGuiTableColumnFlags_WidthStretch);
+        TablePair(
+            if (ImGui::Button(_("D Flip-Flop"))) {
+                dragged_node
+                    = scene->add_node<Sequential>(Sequential::Type::D_FLIPFLOP);
+                is_dragging = true;
+            },
+            if (ImGui::Button(_("JK Flip-Flop"))) {
+                dragged_node = scene->add_node<Sequential>(
+                    Sequential::Type::JK_FLIPFLOP);
+                is_dragging = true;
+            });
+        TablePair(
+            if (ImGui::Button(_("SR Latch"))) {
+                dragged_node
+                    = scene->add_node<Sequential>(Sequential::Type::SR_LATCH);
+                is_dragging = true;
+            },
+            if (ImGui::Button(_("D Latch"))) {
+                dragged_node
+                    = scene->add_node<Sequential>(Sequential::Type::D_LATCH);
+                is_dragging = true;
+            });
+        TablePair(
+            if (ImGui::Button(_("Register"))) {
+                dragged_node = scene->add_node<Sequential>(
+                    Sequential::Type::REGISTER, static_cast<sockid>(8));
+                is_dragging = true;
+            },
+            ImGui::Text(" "));
+        TablePair(
+            if (ImGui::Button(_("ROM"))) {
+                dragged_node = scene->add_node<Memory>(Memory::Type::ROM);
+                is_dragging  = true;
+            },
+            if (ImGui::Button(_("RAM"))) {
+                dragged_node = scene->add_node<Memory>(Memory::Type::RAM);
+                is_dragging  = true;
+            });
         ImGui::EndTable();
     }
 
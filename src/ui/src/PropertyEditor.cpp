@@ -156,6 +156,13 @@ void Properties::_show_gate(Ref<Scene> scene, Node id)
     auto gate = scene->get_node<Gate>(id);
     ImGui::BeginGroup();
     ImGui::BulletText(_("Type: %s"), to_str<Gate::Type>(gate->type()));
+    int delay = gate->delay();
+    ImGui::Bullet();
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("000000000").x);
+    if (ImGui::InputInt(_("Delay"), &delay) && delay >= 0
+        && delay < Gate::INHERIT_DELAY) {
+        gate->set_delay(delay);
+    }
     if (ImGui::TreeNode(_("Inputs"))) {
         for (size_t i = 0; i < gate->inputs.size(); i++) {
             if (gate->inputs[i] == 0) {
@@ -74,6 +74,35 @@ void SceneInfo::show(Ref<Scene> scene, bool switched)
             }
 
     );
+    if (scene != nullptr) {
+        static const char* engines[Backend::TYPE_S] = {
+            to_str<Backend::Type>(Backend::EVENT),
+            to_str<Backend::Type>(Backend::RECURSIVE),
+            to_str<Backend::Type>(Backend::LEVELIZED),
+            to_str<Backend::Type>(Backend::BIT_PARALLEL),
+        };
+        int engine = scene->engine;
+        AnonTable(
+            "EngineTable", TABLE_SIZE,
+            TablePair(
+                Field(_("Engine")),
+                if (ImGui::Combo("##SceneEngine", &engine, engines,
+                        Backend::TYPE_S)) {
+                    scene->engine = static_cast<Backend::Type>(engine);
+                });
+            TablePair(Field(_("Native Code")),
+                ImGui::Checkbox("##SceneNative", &scene->is_native));
+            TablePair(Field(_("Compressed")),
+                ImGui::Checkbox("##SceneCompressed", &scene->is_compressed));)
+    }
+    if (scene != nullptr && !scene->loops().empty()) {
+        ImGui::Text(_("Feedback Loops: %zu"), scene->loops().size());
+        if (scene->is_oscillating()) {
+            ImGui::SameLine();
+            ImGui::TextColored(get_active_style().yellow, "%s %s",
+                ICON_LC_TRIANGLE_ALERT, _("Oscillating"));
+        }
+    }
     ImGui::EndChild();
 
     if (scene != nullptr && !scene->dependencies().empty()) {
@@ -0,0 +1,195 @@
+#include <doctest.h>
+#include "core.h"
+
+using namespace ic;
+
+/** Checks that the levels form a topological order with no gaps. */
+static bool is_levelized(Scene& s)
+{
+    for (const auto& [id, rel] : s._relations) {
+        if (!s.is_feedback(id)
+            && s.level(rel.to_node) <= s.level(rel.from_node)) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < s._gates.size(); i++) {
+        Node n { static_cast<uint16_t>(i), Node::Type::GATE };
+        if (s._gates[i].is_null()) {
+            continue;
+        }
+        uint32_t expected = 0;
+        for (relid in : s._gates[i].inputs) {
+            auto r = s.get_rel(in);
+            if (r != nullptr && !s.is_feedback(in)) {
+                expected = std::max(expected, s.level(r->from_node) + 1);
+            }
+        }
+        if (s.level(n) != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST_CASE("levels-of-a-chain")
+{
+    Scene s;
+    Node i  = s.add_node<Input>();
+    Node g1 = s.add_node<Gate>(Gate::Type::NOT);
+    Node g2 = s.add_node<Gate>(Gate::Type::NOT);
+    Node o  = s.add_node<Output>();
+    REQUIRE(s.connect(g2, 0, g1));
+    REQUIRE(s.connect(o, 0, g2));
+    REQUIRE_EQ(s.level(g1), 0);
+    REQUIRE_EQ(s.level(o), 2);
+
+    relid r = s.connect(g1, 0, i);
+    REQUIRE(r);
+    REQUIRE_EQ(s.level(i), 0);
+    REQUIRE_EQ(s.level(g1), 1);
+    REQUIRE_EQ(s.level(g2), 2);
+    REQUIRE_EQ(s.level(o), 3);
+
+    REQUIRE_EQ(s.disconnect(r), Error::OK);
+    REQUIRE_EQ(s.level(g1), 0);
+    REQUIRE_EQ(s.level(o), 2);
+}
+
+TEST_CASE("levels-take-the-longest-path")
+{
+    Scene s;
+    Node i     = s.add_node<Input>();
+    Node g_not = s.add_node<Gate>(Gate::Type::NOT);
+    Node g_and = s.add_node<Gate>(Gate::Type::AND);
+    REQUIRE(s.connect(g_and, 0, i));
+    REQUIRE_EQ(s.level(g_and), 1);
+    REQUIRE(s.connect(g_not, 0, i));
+    relid r = s.connect(g_and, 1, g_not);
+    REQUIRE(r);
+    REQUIRE_EQ(s.level(g_and), 2);
+    REQUIRE_EQ(s.disconnect(r), Error::OK);
+    REQUIRE_EQ(s.level(g_and), 1);
+    REQUIRE(is_levelized(s));
+}
+
+TEST_CASE("feedback-edges-are-not-ordered")
+{
+    Scene s;
+    Node i     = s.add_node<Input>();
+    Node g_or  = s.add_node<Gate>(Gate::Type::OR);
+    Node g_and = s.add_node<Gate>(Gate::Type::AND);
+    REQUIRE(s.connect(g_or, 0, i));
+    REQUIRE(s.connect(g_and, 0, i));
+    REQUIRE(s.connect(g_and, 1, g_or));
+    relid back = s.connect(g_or, 1, g_and);
+    REQUIRE(back);
+    REQUIRE(s.is_feedback(back));
+    REQUIRE_EQ(s.loops().size(), 1);
+    REQUIRE(is_levelized(s));
+
+    // Once the loop is broken the remaining edge is ordered again.
+    relid forward = s.get_node<Gate>(g_and)->inputs[1];
+    REQUIRE_EQ(s.disconnect(forward), Error::OK);
+    REQUIRE(s.loops().empty());
+    REQUIRE_FALSE(s.is_feedback(back));
+    REQUIRE_EQ(s.level(g_or), 2);
+    REQUIRE(is_levelized(s));
+}
+
+TEST_CASE("levels-after-remove-node")
+{
+    Scene s;
+    Node i  = s.add_node<Input>();
+    Node g1 = s.add_node<Gate>(Gate::Type::NOT);
+    Node g2 = s.add_node<Gate>(Gate::Type::NOT);
+    REQUIRE(s.connect(g1, 0, i));
+    REQUIRE(s.connect(g2, 0, g1));
+    REQUIRE_EQ(s.level(g2), 2);
+    REQUIRE_EQ(s.remove_node(g1), Error::OK);
+    REQUIRE_EQ(s.level(g2), 0);
+    REQUIRE(is_levelized(s));
+}
+
+TEST_CASE("levels-of-a-large-scene")
+{
+    Scene s;
+    const size_t GATE_S = 2000;
+    Node i              = s.add_node<Input>();
+    std::vector<Node> gates;
+    Node prev = i;
+    for (size_t k = 0; k < GATE_S; k++) {
+        gates.push_back(s.add_node<Gate>(Gate::Type::NOT));
+        REQUIRE(s.connect(gates.back(), 0, prev));
+        prev = gates.back();
+    }
+    REQUIRE_EQ(s.level(gates.back()), GATE_S);
+    REQUIRE(s.loops().empty());
+
+    // Rewiring the middle of the chain only touches its cone.
+    relid mid = s.get_node<Gate>(gates[GATE_S / 2])->inputs[0];
+    REQUIRE_EQ(s.disconnect(mid), Error::OK);
+    REQUIRE_EQ(s.level(gates.back()), GATE_S / 2 - 1);
+    REQUIRE(s.connect(gates[GATE_S / 2], 0, i));
+    REQUIRE_EQ(s.level(gates.back()), GATE_S / 2);
+
+    relid back = s.connect(gates[GATE_S / 4], 0, gates.back());
+    REQUIRE(back == 0);
+    relid first = s.get_node<Gate>(gates[0])->inputs[0];
+    REQUIRE_EQ(s.disconnect(first), Error::OK);
+    back = s.connect(gates[0], 0, gates[GATE_S / 2 - 1]);
+    REQUIRE(back);
+    REQUIRE(s.is_feedback(back));
+    REQUIRE_EQ(s.loops().size(), 1);
+    REQUIRE(is_levelized(s));
+}
+
+TEST_CASE("levels-after-bulk-load")
+{
+    // The same scene is built node by node and in bulk.
+    Scene bulk, incremental;
+    size_t undo_s = bulk.undo.size();
+    bulk.begin_load();
+    std::vector<Node> outputs;
+    for (Scene* s : { &bulk, &incremental }) {
+        Node a = s->add_node<Input>();
+        Node b = s->add_node<Input>();
+        std::vector<Node> gates;
+        for (size_t k = 0; k < 200; k++) {
+            Gate::Type type = k % 3 == 0 ? Gate::Type::XOR
+                : k % 3 == 1             ? Gate::Type::NAND
+                                         : Gate::Type::OR;
+            Node g          = s->add_node<Gate>(type);
+            REQUIRE(s->connect(g, 0, k == 0 ? a : gates[k - 1]));
+            REQUIRE(s->connect(g, 1, k % 2 == 1 || k < 2 ? b : gates[k - 2]));
+            gates.push_back(g);
+        }
+        // SR latch, a resets and b sets it.
+        Node q  = s->add_node<Gate>(Gate::Type::NOR);
+        Node nq = s->add_node<Gate>(Gate::Type::NOR);
+        REQUIRE(s->connect(q, 0, a));
+        REQUIRE(s->connect(q, 1, nq));
+        REQUIRE(s->connect(nq, 0, b));
+        REQUIRE(s->connect(nq, 1, q));
+        outputs = { s->add_node<Output>(), s->add_node<Output>() };
+        REQUIRE(s->connect(outputs[0], 0, gates.back()));
+        REQUIRE(s->connect(outputs[1], 0, q));
+    }
+    bulk.end_load();
+    REQUIRE(is_levelized(bulk));
+    REQUIRE_EQ(bulk.level(outputs[0]), incremental.level(outputs[0]));
+    REQUIRE_EQ(bulk.loops().size(), 1);
+    REQUIRE_EQ(bulk.undo.size(), undo_s);
+
+    const bool patterns[][2]
+        = { { 1, 0 }, { 0, 1 }, { 1, 1 }, { 0, 0 }, { 1, 0 } };
+    for (const auto& pattern : patterns) {
+        for (Scene* s : { &bulk, &incremental }) {
+            s->get_node<Input>(Node { 0, Node::Type::INPUT })->set(pattern[0]);
+            s->get_node<Input>(Node { 1, Node::Type::INPUT })->set(pattern[1]);
+        }
+        for (Node o : outputs) {
+            REQUIRE_EQ(bulk.get_node<Output>(o)->get(),
+                incremental.get_node<Output>(o)->get());
+        }
+    }
+}
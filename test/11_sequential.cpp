@@ -0,0 +1,176 @@
+#include <doctest.h>
+#include "core.h"
+
+using namespace ic;
+
+TEST_CASE("d-flipflop")
+{
+    Scene s;
+    Node d   = s.add_node<Input>();
+    Node clk = s.add_node<Input>();
+    Node dff = s.add_node<Sequential>(Sequential::Type::D_FLIPFLOP);
+    Node q   = s.add_node<Output>();
+    Node qn  = s.add_node<Output>();
+    REQUIRE(s.connect(q, 0, dff, 0));
+    REQUIRE(s.connect(qn, 0, dff, 1));
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::DISABLED);
+    REQUIRE(s.connect(dff, 0, d));
+    REQUIRE(s.connect(dff, 1, clk));
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+    REQUIRE_EQ(s.get_node<Output>(qn)->get(), State::TRUE);
+
+    s.get_node<Input>(d)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+    s.get_node<Input>(clk)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::TRUE);
+    REQUIRE_EQ(s.get_node<Output>(qn)->get(), State::FALSE);
+
+    // Only the rising edge captures.
+    s.get_node<Input>(d)->set(false);
+    s.get_node<Input>(clk)->set(false);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::TRUE);
+    s.get_node<Input>(clk)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+}
+
+TEST_CASE("d-flipflop-enable-reset")
+{
+    Scene s;
+    Node d   = s.add_node<Input>();
+    Node clk = s.add_node<Input>();
+    Node en  = s.add_node<Input>();
+    Node rst = s.add_node<Input>();
+    Node dff = s.add_node<Sequential>(Sequential::Type::D_FLIPFLOP);
+    Node q   = s.add_node<Output>();
+    auto seq = s.get_node<Sequential>(dff);
+    REQUIRE(s.connect(dff, 0, d));
+    REQUIRE(s.connect(dff, seq->clock(), clk));
+    REQUIRE(s.connect(dff, seq->enable(), en));
+    REQUIRE(s.connect(dff, seq->reset(), rst));
+    REQUIRE(s.connect(q, 0, dff, 0));
+
+    s.get_node<Input>(d)->set(true);
+    s.get_node<Input>(clk)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+    s.get_node<Input>(clk)->set(false);
+    s.get_node<Input>(en)->set(true);
+    s.get_node<Input>(clk)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::TRUE);
+
+    s.get_node<Input>(rst)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+}
+
+TEST_CASE("jk-flipflop-toggles")
+{
+    Scene s;
+    Node one = s.add_node<Input>();
+    Node clk = s.add_node<Input>();
+    Node jk  = s.add_node<Sequential>(Sequential::Type::JK_FLIPFLOP);
+    Node q   = s.add_node<Output>();
+    s.get_node<Input>(one)->set(true);
+    REQUIRE(s.connect(jk, 0, one));
+    REQUIRE(s.connect(jk, 1, one));
+    REQUIRE(s.connect(jk, 2, clk));
+    REQUIRE(s.connect(q, 0, jk, 0));
+    for (int i = 0; i < 4; i++) {
+        s.get_node<Input>(clk)->toggle();
+        s.get_node<Input>(clk)->toggle();
+        REQUIRE_EQ(s.get_node<Output>(q)->get(),
+            i % 2 == 0 ? State::TRUE : State::FALSE);
+    }
+}
+
+TEST_CASE("sr-and-d-latch")
+{
+    Scene s;
+    Node a  = s.add_node<Input>();
+    Node b  = s.add_node<Input>();
+    Node sr = s.add_node<Sequential>(Sequential::Type::SR_LATCH);
+    Node dl = s.add_node<Sequential>(Sequential::Type::D_LATCH);
+    Node q1 = s.add_node<Output>();
+    Node q2 = s.add_node<Output>();
+    REQUIRE(s.connect(sr, 0, a));
+    REQUIRE(s.connect(sr, 1, b));
+    REQUIRE(s.connect(dl, 0, a));
+    REQUIRE(s.connect(dl, 1, b));
+    REQUIRE(s.connect(q1, 0, sr, 0));
+    REQUIRE(s.connect(q2, 0, dl, 0));
+
+    s.get_node<Input>(a)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::TRUE);
+    REQUIRE_EQ(s.get_node<Output>(q2)->get(), State::FALSE);
+    s.get_node<Input>(b)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::FALSE);
+    REQUIRE_EQ(s.get_node<Output>(q2)->get(), State::TRUE);
+    s.get_node<Input>(b)->set(false);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::TRUE);
+    REQUIRE_EQ(s.get_node<Output>(q2)->get(), State::TRUE);
+    // Both hold their value once the inputs are released.
+    s.get_node<Input>(a)->set(false);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::TRUE);
+    REQUIRE_EQ(s.get_node<Output>(q2)->get(), State::TRUE);
+}
+
+TEST_CASE("register-counter-has-no-loop")
+{
+    // q = q + 1 on every clock, built from a 2-bit register and gates.
+    Scene s;
+    Node clk   = s.add_node<Input>();
+    Node reg   = s.add_node<Sequential>(
+        Sequential::Type::REGISTER, sockid { 2 });
+    Node g_not = s.add_node<Gate>(Gate::Type::NOT);
+    Node g_xor = s.add_node<Gate>(Gate::Type::XOR);
+    REQUIRE_EQ(s.get_node<Sequential>(reg)->inputs.size(), 5);
+    REQUIRE(s.connect(g_not, 0, reg, 0));
+    REQUIRE(s.connect(g_xor, 0, reg, 0));
+    REQUIRE(s.connect(g_xor, 1, reg, 1));
+    REQUIRE(s.connect(reg, 0, g_not));
+    REQUIRE(s.connect(reg, 1, g_xor));
+    REQUIRE(s.connect(reg, 2, clk));
+    REQUIRE(s.loops().empty());
+    REQUIRE_EQ(s.level(reg), 2);
+
+    for (uint64_t i = 1; i <= 5; i++) {
+        s.get_node<Input>(clk)->set(true);
+        s.get_node<Input>(clk)->set(false);
+        REQUIRE_EQ(s.get_node<Sequential>(reg)->value(), i % 4);
+    }
+}
+
+TEST_CASE("flipflop-feeding-itself")
+{
+    Scene s;
+    Node clk = s.add_node<Input>();
+    Node dff = s.add_node<Sequential>(Sequential::Type::D_FLIPFLOP);
+    REQUIRE(s.connect(dff, 0, dff, 1));
+    REQUIRE(s.connect(dff, 1, clk));
+    REQUIRE_EQ(s.get_node<Sequential>(dff)->get(0), State::FALSE);
+    s.get_node<Input>(clk)->set(true);
+    REQUIRE_EQ(s.get_node<Sequential>(dff)->get(0), State::TRUE);
+}
+
+TEST_CASE("save-load-sequential")
+{
+    Scene s { "sequential" };
+    Node in  = s.add_node<Input>();
+    Node reg = s.add_node<Sequential>(Sequential::Type::REGISTER, sockid { 8 });
+    Node jk  = s.add_node<Sequential>(Sequential::Type::JK_FLIPFLOP);
+    s.get_node<Sequential>(reg)->set_value(0xA5);
+    REQUIRE(s.connect(jk, 0, reg, 7));
+    REQUIRE(s.connect(reg, 8, in));
+
+    std::vector<uint8_t> data;
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(data), Error::OK);
+    auto loaded = s_loaded.get_node<Sequential>(reg);
+    REQUIRE(loaded != nullptr);
+    REQUIRE_EQ(loaded->type(), Sequential::Type::REGISTER);
+    REQUIRE_EQ(loaded->width(), 8);
+    REQUIRE_EQ(loaded->value(), 0xA5);
+    REQUIRE(loaded->inputs[8] != 0);
+    REQUIRE_EQ(s_loaded.get_node<Sequential>(jk)->type(),
+        Sequential::Type::JK_FLIPFLOP);
+    REQUIRE(s_loaded.get_node<Sequential>(jk)->inputs[0] != 0);
+}
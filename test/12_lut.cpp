@@ -0,0 +1,156 @@
+#include <doctest.h>
+#include "core.h"
+
+using namespace ic;
+
+TEST_CASE("lut-lookup")
+{
+    Scene s;
+    Node a = s.add_node<Input>();
+    Node b = s.add_node<Input>();
+    // Table of a XOR b, bit i is the output for a + 2b = i.
+    Node lut = s.add_node<Lut>(sockid { 2 }, Lut::Table { 0b0110 });
+    Node o   = s.add_node<Output>();
+    REQUIRE(s.connect(lut, 0, a));
+    REQUIRE(s.connect(o, 0, lut));
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::DISABLED);
+    REQUIRE(s.connect(lut, 1, b));
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::FALSE);
+    s.get_node<Input>(a)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+    s.get_node<Input>(b)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::FALSE);
+
+    s.get_node<Lut>(lut)->set_table(Lut::Table { 0b1000 });
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+    REQUIRE_FALSE(s.connect(lut, 2, a));
+}
+
+TEST_CASE("collapse-full-adder")
+{
+    Scene s;
+    Node a    = s.add_node<Input>();
+    Node b    = s.add_node<Input>();
+    Node cin  = s.add_node<Input>();
+    Node x1   = s.add_node<Gate>(Gate::Type::XOR);
+    Node x2   = s.add_node<Gate>(Gate::Type::XOR);
+    Node a1   = s.add_node<Gate>(Gate::Type::AND);
+    Node a2   = s.add_node<Gate>(Gate::Type::AND);
+    Node c    = s.add_node<Gate>(Gate::Type::OR);
+    Node sum  = s.add_node<Output>();
+    Node cout = s.add_node<Output>();
+    REQUIRE(s.connect(x1, 0, a));
+    REQUIRE(s.connect(x1, 1, b));
+    REQUIRE(s.connect(x2, 0, x1));
+    REQUIRE(s.connect(x2, 1, cin));
+    REQUIRE(s.connect(a1, 0, a));
+    REQUIRE(s.connect(a1, 1, b));
+    REQUIRE(s.connect(a2, 0, x1));
+    REQUIRE(s.connect(a2, 1, cin));
+    REQUIRE(s.connect(c, 0, a1));
+    REQUIRE(s.connect(c, 1, a2));
+    REQUIRE(s.connect(sum, 0, x2));
+    REQUIRE(s.connect(cout, 0, c));
+
+    // x1 is also used by the sum, so the group would have two outputs.
+    Node lut;
+    REQUIRE_EQ(s.collapse({ x1, a1, a2, c }, lut), Error::NOT_COLLAPSIBLE);
+    REQUIRE_EQ(s.collapse({ a1, a2, c }, lut), Error::OK);
+    REQUIRE(s.get_node<Gate>(c) == nullptr);
+    REQUIRE_EQ(s.get_node<Lut>(lut)->inputs.size(), 4);
+    REQUIRE(s.get_node<Gate>(x2)->is_connected());
+
+    for (uint32_t i = 0; i < 8; i++) {
+        s.get_node<Input>(a)->set(i & 1);
+        s.get_node<Input>(b)->set(i & 2);
+        s.get_node<Input>(cin)->set(i & 4);
+        int total = (i & 1) + ((i >> 1) & 1) + ((i >> 2) & 1);
+        REQUIRE_EQ(s.get_node<Output>(sum)->get(),
+            total & 1 ? State::TRUE : State::FALSE);
+        REQUIRE_EQ(s.get_node<Output>(cout)->get(),
+            total >= 2 ? State::TRUE : State::FALSE);
+    }
+}
+
+TEST_CASE("collapse-rejects-invalid-groups")
+{
+    Scene s;
+    Node i  = s.add_node<Input>();
+    Node g1 = s.add_node<Gate>(Gate::Type::AND);
+    Node g2 = s.add_node<Gate>(Gate::Type::OR);
+    Node lut;
+    REQUIRE(s.connect(g1, 0, i));
+    REQUIRE_EQ(s.collapse({ g1 }, lut), Error::NOT_CONNECTED);
+    REQUIRE_EQ(s.collapse({ i }, lut), Error::NODE_NOT_FOUND);
+
+    REQUIRE(s.connect(g1, 1, g2));
+    REQUIRE(s.connect(g2, 0, g1));
+    REQUIRE(s.connect(g2, 1, i));
+    REQUIRE_EQ(s.collapse({ g1, g2 }, lut), Error::NOT_COLLAPSIBLE);
+
+    Scene wide;
+    std::vector<Node> gates;
+    for (size_t k = 0; k < 5; k++) {
+        gates.push_back(wide.add_node<Gate>(Gate::Type::AND));
+        REQUIRE(wide.connect(gates.back(), 0, wide.add_node<Input>()));
+        REQUIRE(wide.connect(gates.back(), 1, wide.add_node<Input>()));
+    }
+    // Joining the five gates needs another gate with 5 inputs.
+    Node join = wide.add_node<Gate>(Gate::Type::OR, sockid { 5 });
+    for (size_t k = 0; k < 5; k++) {
+        REQUIRE(wide.connect(join, k, gates[k]));
+    }
+    gates.push_back(join);
+    REQUIRE_EQ(wide.collapse(gates, lut), Error::NOT_COLLAPSIBLE);
+}
+
+TEST_CASE("collapse-into-existing-lut")
+{
+    Scene s;
+    Node a = s.add_node<Input>();
+    Node b = s.add_node<Input>();
+    Node l = s.add_node<Lut>(sockid { 2 }, Lut::Table { 0b1000 });
+    Node n = s.add_node<Gate>(Gate::Type::NOT);
+    Node o = s.add_node<Output>();
+    REQUIRE(s.connect(l, 0, a));
+    REQUIRE(s.connect(l, 1, b));
+    REQUIRE(s.connect(n, 0, l));
+    REQUIRE(s.connect(o, 0, n));
+    Node lut;
+    REQUIRE_EQ(s.collapse({ l, n }, lut), Error::OK);
+    REQUIRE_EQ(s.get_node<Lut>(lut)->table(), Lut::Table { 0b0111 });
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+    REQUIRE_EQ(s.level(o), 2);
+}
+
+TEST_CASE("save-load-lut")
+{
+    Scene s { "lut" };
+    Node a    = s.add_node<Input>();
+    Node wide = s.add_node<Lut>(Lut::MAX_INPUT);
+    Node l    = s.add_node<Lut>(sockid { 1 }, Lut::Table { 0b01 });
+    Node one  = s.add_node<Lut>(sockid { 0 }, Lut::Table { 1 });
+    Node o    = s.add_node<Output>();
+    Lut::Table table;
+    table[0]   = true;
+    table[200] = true;
+    table[255] = true;
+    s.get_node<Lut>(wide)->set_table(table);
+    REQUIRE(s.connect(l, 0, a));
+    REQUIRE(s.connect(wide, 3, l));
+    REQUIRE(s.connect(o, 0, one));
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+
+    std::vector<uint8_t> data;
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(data), Error::OK);
+    REQUIRE_EQ(s_loaded.get_node<Lut>(wide)->inputs.size(), Lut::MAX_INPUT);
+    REQUIRE_EQ(s_loaded.get_node<Lut>(wide)->table(), table);
+    REQUIRE_EQ(s_loaded.get_node<Lut>(l)->table(), Lut::Table { 0b01 });
+    REQUIRE(s_loaded.get_node<Lut>(wide)->inputs[3] != 0);
+    REQUIRE_EQ(s_loaded.get_node<Lut>(l)->get(), State::TRUE);
+    // A Lut without inputs is a constant.
+    REQUIRE(s_loaded.get_node<Lut>(one)->inputs.empty());
+    REQUIRE_EQ(s_loaded.get_node<Output>(o)->get(), State::TRUE);
+}
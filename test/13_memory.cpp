@@ -0,0 +1,130 @@
+#include <doctest.h>
+#include "common.h"
+#include "core.h"
+
+using namespace ic;
+
+/** Connects the given inputs to the sockets of a memory starting from
+ * first. */
+static void connect_all(
+    Scene& s, Node memory, sockid first, const std::vector<Node>& nodes)
+{
+    for (size_t i = 0; i < nodes.size(); i++) {
+        REQUIRE(s.connect(memory, first + i, nodes[i]));
+    }
+}
+
+TEST_CASE("rom-read")
+{
+    Scene s;
+    Node rom = s.add_node<Memory>(
+        Memory::Type::ROM, sockid { 2 }, sockid { 12 });
+    auto mem = s.get_node<Memory>(rom);
+    REQUIRE_EQ(mem->word_s(), 2);
+    REQUIRE_EQ(mem->data().size(), 8);
+    REQUIRE_EQ(mem->load_hex("// comment\n123 abc\n@3 fff"), Error::OK);
+    REQUIRE_EQ(mem->read(0), 0x123);
+    REQUIRE_EQ(mem->read(1), 0xABC);
+    REQUIRE_EQ(mem->read(2), 0);
+    REQUIRE_EQ(mem->read(3), 0xFFF);
+    REQUIRE_NE(mem->load_hex("1000"), Error::OK);
+    REQUIRE_NE(mem->load_hex("@4 1"), Error::OK);
+    REQUIRE_NE(mem->load_hex("xyz"), Error::OK);
+
+    Node a0 = s.add_node<Input>();
+    Node a1 = s.add_node<Input>();
+    Node q  = s.add_node<Output>();
+    REQUIRE(s.connect(q, 0, rom, 11));
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::DISABLED);
+    connect_all(s, rom, 0, { a0, a1 });
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+    s.get_node<Input>(a0)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::TRUE);
+    s.get_node<Input>(a1)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::TRUE);
+    s.get_node<Input>(a0)->set(false);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+}
+
+TEST_CASE("ram-write")
+{
+    Scene s;
+    Node ram = s.add_node<Memory>(
+        Memory::Type::RAM, sockid { 1 }, sockid { 2 });
+    auto mem = s.get_node<Memory>(ram);
+    REQUIRE_EQ(mem->inputs.size(), 5);
+    Node a   = s.add_node<Input>();
+    Node d0  = s.add_node<Input>();
+    Node d1  = s.add_node<Input>();
+    Node we  = s.add_node<Input>();
+    Node clk = s.add_node<Input>();
+    Node q1  = s.add_node<Output>();
+    connect_all(s, ram, 0, { a, d0, d1, we, clk });
+    REQUIRE(s.connect(q1, 0, ram, 1));
+
+    s.get_node<Input>(d1)->set(true);
+    s.get_node<Input>(clk)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::FALSE);
+    s.get_node<Input>(clk)->set(false);
+    s.get_node<Input>(we)->set(true);
+    s.get_node<Input>(clk)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::TRUE);
+    REQUIRE_EQ(mem->read(0), 2);
+    REQUIRE_EQ(mem->read(1), 0);
+
+    s.get_node<Input>(a)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::FALSE);
+    mem->write(1, 3);
+    REQUIRE_EQ(s.get_node<Output>(q1)->get(), State::TRUE);
+}
+
+TEST_CASE("memory-load-file")
+{
+    Scene s;
+    Node rom = s.add_node<Memory>(
+        Memory::Type::ROM, sockid { 4 }, sockid { 16 });
+    auto mem = s.get_node<Memory>(rom);
+    std::vector<uint8_t> raw { 0x34, 0x12, 0x78, 0x56 };
+    REQUIRE(fs::write(fs::CACHE / "rom.bin", raw));
+    REQUIRE(fs::write(fs::CACHE / "rom.hex", std::string { "@2 beef\n" }));
+    REQUIRE_EQ(mem->load_file(fs::CACHE / "rom.bin"), Error::OK);
+    REQUIRE_EQ(mem->read(0), 0x1234);
+    REQUIRE_EQ(mem->read(1), 0x5678);
+    REQUIRE_EQ(mem->load_file(fs::CACHE / "rom.hex"), Error::OK);
+    REQUIRE_EQ(mem->read(0), 0);
+    REQUIRE_EQ(mem->read(2), 0xBEEF);
+    REQUIRE_EQ(mem->load_file(fs::CACHE / "missing.bin"), Error::NOT_FOUND);
+}
+
+TEST_CASE("save-load-memory")
+{
+    Scene s { "memory" };
+    Node a   = s.add_node<Input>();
+    Node rom = s.add_node<Memory>(
+        Memory::Type::ROM, sockid { 8 }, sockid { 8 });
+    Node ram = s.add_node<Memory>(
+        Memory::Type::RAM, sockid { 16 }, sockid { 32 });
+    auto mem = s.get_node<Memory>(rom);
+    for (uint32_t i = 0; i < 16; i++) {
+        mem->write(i, i * 3);
+    }
+    s.get_node<Memory>(ram)->write(2, 0xDEADBEEF);
+    REQUIRE(s.connect(rom, 0, a));
+
+    std::vector<uint8_t> data;
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    // Only the used prefix of the buffers is stored.
+    REQUIRE_LT(data.size(), 256);
+
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(data), Error::OK);
+    auto loaded = s_loaded.get_node<Memory>(rom);
+    REQUIRE_EQ(loaded->type(), Memory::Type::ROM);
+    REQUIRE_EQ(loaded->data(), mem->data());
+    REQUIRE(loaded->inputs[0] != 0);
+    auto loaded_ram = s_loaded.get_node<Memory>(ram);
+    REQUIRE_EQ(loaded_ram->type(), Memory::Type::RAM);
+    REQUIRE_EQ(loaded_ram->address_s(), 16);
+    REQUIRE_EQ(loaded_ram->data_s(), 32);
+    REQUIRE_EQ(loaded_ram->read(2), 0xDEADBEEF);
+}
@@ -0,0 +1,244 @@
+#include <doctest.h>
+#include <random>
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+/** Every combination of three inputs, pattern i is in bit i. */
+static const std::vector<uint64_t> exhaustive3 { 0xAA, 0xCC, 0xF0 };
+
+TEST_CASE("netlist-compile-full-adder")
+{
+    Scene s;
+    _create_full_adder_io(s);
+    _create_full_adder(s);
+    Netlist n;
+    REQUIRE_EQ(n.compile(s), Error::OK);
+    REQUIRE_EQ(n.gate_count(), 5);
+    REQUIRE_EQ(n.inputs.size(), 3);
+    REQUIRE_EQ(n.outputs.size(), 2);
+    REQUIRE_EQ(n.outputs[0].node.numeric(), c_out.numeric());
+
+    std::vector<uint64_t> out;
+    n.simulate(exhaustive3, out);
+    for (uint32_t i = 0; i < 8; i++) {
+        int total = (i & 1) + ((i >> 1) & 1) + ((i >> 2) & 1);
+        REQUIRE_EQ(((out[0] >> i) & 1) == 1, total >= 2);
+        REQUIRE_EQ(((out[1] >> i) & 1) == 1, (total & 1) == 1);
+    }
+    REQUIRE_EQ(n.run(0b011), 0b01);
+    REQUIRE_EQ(n.run(0b111), 0b11);
+}
+
+TEST_CASE("netlist-optimize")
+{
+    Scene s;
+    Node a = s.add_node<Input>();
+    Node b = s.add_node<Input>();
+    Node c = s.add_node<Input>();
+    // Double inverter.
+    Node n1 = s.add_node<Gate>(Gate::Type::NOT);
+    Node n2 = s.add_node<Gate>(Gate::Type::NOT);
+    REQUIRE(s.connect(n1, 0, a));
+    REQUIRE(s.connect(n2, 0, n1));
+    // Identical gates with swapped inputs.
+    Node g1 = s.add_node<Gate>(Gate::Type::AND);
+    Node g2 = s.add_node<Gate>(Gate::Type::AND);
+    Node o1 = s.add_node<Gate>(Gate::Type::OR);
+    REQUIRE(s.connect(g1, 0, a));
+    REQUIRE(s.connect(g1, 1, b));
+    REQUIRE(s.connect(g2, 0, b));
+    REQUIRE(s.connect(g2, 1, a));
+    REQUIRE(s.connect(o1, 0, g1));
+    REQUIRE(s.connect(o1, 1, g2));
+    // A disconnected gate is constant false.
+    Node u  = s.add_node<Gate>(Gate::Type::AND);
+    Node o2 = s.add_node<Gate>(Gate::Type::OR);
+    REQUIRE(s.connect(u, 0, c));
+    REQUIRE(s.connect(o2, 0, n2));
+    REQUIRE(s.connect(o2, 1, u));
+    // Unused logic.
+    Node dead = s.add_node<Gate>(Gate::Type::XOR);
+    REQUIRE(s.connect(dead, 0, a));
+    REQUIRE(s.connect(dead, 1, c));
+
+    Node out1 = s.add_node<Output>();
+    Node out2 = s.add_node<Output>();
+    REQUIRE(s.connect(out1, 0, o1));
+    REQUIRE(s.connect(out2, 0, o2));
+
+    Netlist n;
+    REQUIRE_EQ(n.compile(s), Error::OK);
+    Netlist original = n;
+    std::vector<uint64_t> expected, actual;
+    original.simulate(exhaustive3, expected);
+
+    Netlist::Stats stats = n.optimize();
+    REQUIRE_EQ(stats.gates_before, 7);
+    REQUIRE_EQ(stats.gates_after, 1);
+    REQUIRE_EQ(n.gate_count(), 1);
+    REQUIRE_EQ(n.inputs.size(), 3);
+    REQUIRE_EQ(n.outputs[1].net, n.inputs[0].net);
+    n.simulate(exhaustive3, actual);
+    REQUIRE_EQ(actual, expected);
+
+    // The scene is left as is.
+    REQUIRE(s.get_node<Gate>(dead) != nullptr);
+    REQUIRE(s.get_node<Gate>(n1)->output.size() == 1);
+}
+
+TEST_CASE("netlist-optimize-lut")
+{
+    Scene s;
+    Node a = s.add_node<Input>();
+    Node b = s.add_node<Input>();
+    // a XOR b XOR a, where the third input duplicates the first.
+    Node l = s.add_node<Lut>(sockid { 3 }, Lut::Table { 0b10010110 });
+    Node n = s.add_node<Gate>(Gate::Type::NOT);
+    Node x = s.add_node<Gate>(Gate::Type::XNOR);
+    Node o = s.add_node<Output>();
+    REQUIRE(s.connect(l, 0, a));
+    REQUIRE(s.connect(l, 1, b));
+    REQUIRE(s.connect(l, 2, a));
+    REQUIRE(s.connect(n, 0, b));
+    REQUIRE(s.connect(x, 0, l));
+    REQUIRE(s.connect(x, 1, n));
+    REQUIRE(s.connect(o, 0, x));
+
+    Netlist net;
+    REQUIRE_EQ(net.compile(s), Error::OK);
+    REQUIRE_EQ(net.gate_count(), 3);
+    // b XNOR NOT b is always false.
+    net.optimize();
+    REQUIRE_EQ(net.gate_count(), 0);
+    REQUIRE_EQ(net.outputs[0].net, 0);
+    REQUIRE_EQ(net.run(0b11), 0);
+}
+
+TEST_CASE("netlist-random-equivalence")
+{
+    std::mt19937 rng { 42 };
+    for (int round = 0; round < 10; round++) {
+        Scene s;
+        std::vector<Node> nodes;
+        for (int i = 0; i < 6; i++) {
+            nodes.push_back(s.add_node<Input>());
+        }
+        for (int i = 0; i < 60; i++) {
+            Gate::Type type = static_cast<Gate::Type>(rng() % Gate::TYPE_S);
+            Node g          = s.add_node<Gate>(type);
+            auto gate       = s.get_node<Gate>(g);
+            for (size_t j = 0; j < gate->inputs.size(); j++) {
+                // Leave some inputs open so that constants show up.
+                if (rng() % 40 != 0) {
+                    REQUIRE(s.connect(g, j, nodes[rng() % nodes.size()]));
+                }
+            }
+            nodes.push_back(g);
+        }
+        std::vector<Node> outputs;
+        for (int i = 0; i < 4; i++) {
+            outputs.push_back(s.add_node<Output>());
+            REQUIRE(s.connect(outputs.back(), 0,
+                nodes[nodes.size() - 1 - rng() % 20]));
+        }
+
+        Netlist n;
+        REQUIRE_EQ(n.compile(s), Error::OK);
+        Netlist optimized = n;
+        optimized.optimize();
+        REQUIRE_LE(optimized.gate_count(), n.gate_count());
+
+        std::vector<uint64_t> in(6), expected, actual;
+        for (int k = 0; k < 4; k++) {
+            for (uint64_t& word : in) {
+                word = (static_cast<uint64_t>(rng()) << 32) | rng();
+            }
+            n.simulate(in, expected);
+            optimized.simulate(in, actual);
+            REQUIRE_EQ(actual, expected);
+        }
+
+        // The compiled form agrees with the event driven simulation.
+        for (uint32_t pattern = 0; pattern < 64; pattern++) {
+            for (size_t i = 0; i < 6; i++) {
+                s.get_node<Input>(nodes[i])->set((pattern >> i) & 1);
+            }
+            uint64_t result = optimized.run(pattern);
+            for (size_t i = 0; i < outputs.size(); i++) {
+                REQUIRE_EQ(s.get_node<Output>(outputs[i])->get() == TRUE,
+                    static_cast<bool>((result >> i) & 1));
+            }
+        }
+    }
+}
+
+TEST_CASE("netlist-inline-component")
+{
+    // IN1 = 1, IN2 = 2, IN3 = SEL
+    Scene mux { ComponentContext { &mux, 3, 1 }, "2x1-mux" };
+    Node g_and   = mux.add_node<Gate>(Gate::Type::AND);
+    Node g_and_2 = mux.add_node<Gate>(Gate::Type::AND);
+    Node g_not   = mux.add_node<Gate>(Gate::Type::NOT);
+    Node g_out   = mux.add_node<Gate>(Gate::Type::OR);
+    mux.connect(g_and, 0, mux.component_context->get_input(0));
+    mux.connect(g_and_2, 0, mux.component_context->get_input(1));
+    mux.connect(g_and, 1, mux.component_context->get_input(2));
+    mux.connect(g_not, 0, mux.component_context->get_input(2));
+    mux.connect(g_and_2, 1, g_not);
+    mux.connect(g_out, 0, g_and);
+    mux.connect(g_out, 1, g_and_2);
+    mux.connect(mux.component_context->get_output(0), 0, g_out);
+
+    Netlist compiled;
+    REQUIRE_EQ(compiled.compile(mux), Error::OK);
+    REQUIRE_EQ(compiled.inputs.size(), 3);
+    for (uint64_t in = 0; in < 8; in++) {
+        REQUIRE_EQ(compiled.run(in), mux.component_context->run(in));
+    }
+
+    Scene s;
+    s.add_dependency(std::move(mux));
+    Node c = s.add_node<Component>();
+    REQUIRE_EQ(s.get_node<Component>(c)->set_component(0), Error::OK);
+    std::vector<Node> in;
+    for (sockid i = 0; i < 3; i++) {
+        in.push_back(s.add_node<Input>());
+        REQUIRE(s.connect(c, i, in.back()));
+    }
+    Node o = s.add_node<Output>();
+    REQUIRE(s.connect(o, 0, c, 0));
+
+    Netlist n;
+    REQUIRE_EQ(n.compile(s), Error::OK);
+    REQUIRE_EQ(n.gate_count(), 4);
+    for (uint32_t pattern = 0; pattern < 8; pattern++) {
+        for (size_t i = 0; i < 3; i++) {
+            s.get_node<Input>(in[i])->set((pattern >> i) & 1);
+        }
+        REQUIRE_EQ(n.run(pattern),
+            s.get_node<Output>(o)->get() == TRUE ? 1u : 0u);
+    }
+}
+
+TEST_CASE("netlist-rejects-state")
+{
+    Scene s;
+    Node d  = s.add_node<Input>();
+    Node ff = s.add_node<Sequential>(Sequential::Type::D_FLIPFLOP);
+    REQUIRE(s.connect(ff, 0, d));
+    Netlist n;
+    REQUIRE_EQ(n.compile(s), Error::NOT_COMBINATIONAL);
+    REQUIRE_EQ(n.gate_count(), 0);
+
+    Scene loop;
+    Node g1 = loop.add_node<Gate>(Gate::Type::NOR);
+    Node g2 = loop.add_node<Gate>(Gate::Type::NOR);
+    Node i  = loop.add_node<Input>();
+    REQUIRE(loop.connect(g1, 0, i));
+    REQUIRE(loop.connect(g1, 1, g2));
+    REQUIRE(loop.connect(g2, 0, g1));
+    REQUIRE(loop.connect(g2, 1, i));
+    REQUIRE_EQ(n.compile(loop), Error::NOT_COMBINATIONAL);
+}
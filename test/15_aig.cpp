@@ -0,0 +1,104 @@
+#include <doctest.h>
+#include <random>
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+TEST_CASE("aig-structural-hashing")
+{
+    Aig g;
+    Aig::lit a = g.add_input();
+    Aig::lit b = g.add_input();
+    REQUIRE_EQ(g.make_and(a, b), g.make_and(b, a));
+    REQUIRE_EQ(g.and_count(), 1);
+    REQUIRE_EQ(g.make_and(a, Aig::negate(a)), Aig::LIT_FALSE);
+    REQUIRE_EQ(g.make_and(a, Aig::LIT_TRUE), a);
+    REQUIRE_EQ(g.make_or(a, Aig::LIT_TRUE), Aig::LIT_TRUE);
+    // NAND and OR of the complements share the same node.
+    REQUIRE_EQ(g.make_or(Aig::negate(a), Aig::negate(b)),
+        Aig::negate(g.make_and(a, b)));
+    REQUIRE_EQ(g.and_count(), 1);
+    Aig::lit x = g.make_xor(a, b);
+    REQUIRE_EQ(g.and_count(), 4);
+    REQUIRE_EQ(g.make_xor(b, a), x);
+    REQUIRE_EQ(g.make_mux(a, b, b), b);
+}
+
+TEST_CASE("aig-full-adder")
+{
+    Scene s;
+    _create_full_adder_io(s);
+    _create_full_adder(s);
+    Aig g;
+    REQUIRE_EQ(g.build(s), Error::OK);
+    REQUIRE_EQ(g.inputs.size(), 3);
+    REQUIRE_EQ(g.outputs.size(), 2);
+    // Two XORs take three nodes each, the carry shares one of them.
+    REQUIRE_LE(g.and_count(), 9);
+    for (uint64_t in = 0; in < 8; in++) {
+        int total = (in & 1) + ((in >> 1) & 1) + ((in >> 2) & 1);
+        REQUIRE_EQ(g.run(in), (total >= 2 ? 1u : 0u) | (total & 1) << 1);
+    }
+}
+
+TEST_CASE("aig-matches-netlist")
+{
+    std::mt19937 rng { 7 };
+    for (int round = 0; round < 10; round++) {
+        Scene s;
+        std::vector<Node> nodes;
+        for (int i = 0; i < 8; i++) {
+            nodes.push_back(s.add_node<Input>());
+        }
+        for (int i = 0; i < 40; i++) {
+            Node n;
+            if (rng() % 4 == 0) {
+                Lut::Table table;
+                for (size_t m = 0; m < 8; m++) {
+                    table[m] = rng() & 1;
+                }
+                n = s.add_node<Lut>(sockid { 3 }, table);
+                for (sockid j = 0; j < 3; j++) {
+                    REQUIRE(s.connect(n, j, nodes[rng() % nodes.size()]));
+                }
+            } else {
+                n = s.add_node<Gate>(
+                    static_cast<Gate::Type>(rng() % Gate::TYPE_S));
+                auto gate = s.get_node<Gate>(n);
+                for (size_t j = 0; j < gate->inputs.size(); j++) {
+                    REQUIRE(s.connect(n, j, nodes[rng() % nodes.size()]));
+                }
+            }
+            nodes.push_back(n);
+        }
+        for (int i = 0; i < 3; i++) {
+            REQUIRE(s.connect(s.add_node<Output>(), 0,
+                nodes[nodes.size() - 1 - rng() % 10]));
+        }
+
+        Netlist n;
+        REQUIRE_EQ(n.compile(s), Error::OK);
+        Aig g;
+        g.build(n);
+
+        // Four words per port, 256 patterns in a single pass.
+        const size_t words = 4;
+        std::vector<uint64_t> in(8 * words), expected(3 * words), actual;
+        for (uint64_t& word : in) {
+            word = (static_cast<uint64_t>(rng()) << 32) | rng();
+        }
+        std::vector<uint64_t> n_in(8), n_out;
+        for (size_t w = 0; w < words; w++) {
+            for (size_t i = 0; i < 8; i++) {
+                n_in[i] = in[i * words + w];
+            }
+            n.simulate(n_in, n_out);
+            for (size_t i = 0; i < 3; i++) {
+                expected[i * words + w] = n_out[i];
+            }
+        }
+        g.simulate(in, actual, words);
+        REQUIRE_EQ(actual, expected);
+    }
+}
@@ -0,0 +1,118 @@
+#include <doctest.h>
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+/** Builds a chain of XOR gates over the given number of inputs. */
+static void _create_parity(Scene& s, size_t input_s, bool is_broken = false)
+{
+    Node last = s.add_node<Input>();
+    for (size_t i = 1; i < input_s; i++) {
+        Node in = s.add_node<Input>();
+        Node g  = s.add_node<Gate>(
+            is_broken && i == input_s - 1 ? Gate::Type::OR : Gate::Type::XOR);
+        REQUIRE(s.connect(g, 0, last));
+        REQUIRE(s.connect(g, 1, in));
+        last = g;
+    }
+    REQUIRE(s.connect(s.add_node<Output>(), 0, last));
+}
+
+/**
+ * Builds the full adder of _create_full_adder out of two lookup tables, with
+ * the same input and output order.
+ */
+static void _create_lut_adder(Scene& s)
+{
+    Node in[3] = { s.add_node<Input>(), s.add_node<Input>(),
+        s.add_node<Input>() };
+    Node c_out = s.add_node<Output>();
+    Node sum   = s.add_node<Output>();
+    // Carry and sum of a + 2b + 4c as lookup tables.
+    Node carry = s.add_node<Lut>(sockid { 3 }, Lut::Table { 0b11101000 });
+    Node total = s.add_node<Lut>(sockid { 3 }, Lut::Table { 0b10010110 });
+    for (sockid i = 0; i < 3; i++) {
+        REQUIRE(s.connect(carry, i, in[i]));
+        REQUIRE(s.connect(total, i, in[i]));
+    }
+    REQUIRE(s.connect(c_out, 0, carry));
+    REQUIRE(s.connect(sum, 0, total));
+}
+
+TEST_CASE("equivalence-exhaustive")
+{
+    Scene gates;
+    _create_full_adder_io(gates);
+    _create_full_adder(gates);
+
+    Scene luts;
+    _create_lut_adder(luts);
+
+    Equivalence result;
+    REQUIRE_EQ(check_equivalence(gates, luts, result), Error::OK);
+    REQUIRE(result.is_equivalent);
+    REQUIRE(result.is_proven);
+    REQUIRE_EQ(result.patterns, 8);
+
+    // Break the sum of the lookup table version for a = b = c = 1.
+    luts.get_node<Lut>(Node { 1, Node::LUT })
+        ->set_table(Lut::Table { 0b00010110 });
+    REQUIRE_EQ(check_equivalence(gates, luts, result), Error::OK);
+    REQUIRE_FALSE(result.is_equivalent);
+    REQUIRE_EQ(result.output, 1);
+    REQUIRE_EQ(result.counterexample, (std::vector<bool> { true, true, true }));
+}
+
+TEST_CASE("equivalence-structural")
+{
+    Scene a, b;
+    _create_parity(a, 40);
+    _create_parity(b, 40);
+    Equivalence result;
+    REQUIRE_EQ(check_equivalence(a, b, result), Error::OK);
+    REQUIRE(result.is_equivalent);
+    // Identical structure is proven without simulation.
+    REQUIRE(result.is_proven);
+    REQUIRE_EQ(result.patterns, 0);
+}
+
+TEST_CASE("equivalence-random")
+{
+    Scene a, b;
+    _create_parity(a, 30);
+    _create_parity(b, 30, true);
+    Equivalence result;
+    REQUIRE_EQ(check_equivalence(a, b, result, 1 << 16, 4), Error::OK);
+    REQUIRE_FALSE(result.is_equivalent);
+    REQUIRE(result.is_proven);
+    REQUIRE_EQ(result.counterexample.size(), 30);
+
+    // The counterexample reproduces on both scenes.
+    Netlist n_a, n_b;
+    REQUIRE_EQ(n_a.compile(a), Error::OK);
+    REQUIRE_EQ(n_b.compile(b), Error::OK);
+    std::vector<uint64_t> in, out_a, out_b;
+    for (bool v : result.counterexample) {
+        in.push_back(v ? UINT64_MAX : 0);
+    }
+    n_a.simulate(in, out_a);
+    n_b.simulate(in, out_b);
+    REQUIRE_NE(out_a[0], out_b[0]);
+
+    // The same counterexample is found with a single thread once the cached
+    // result is gone.
+    std::filesystem::remove(fs::CACHE / "equivalence.cache");
+    Equivalence single;
+    REQUIRE_EQ(check_equivalence(a, b, single, 1 << 16, 1), Error::OK);
+    REQUIRE_EQ(single.counterexample, result.counterexample);
+}
+
+TEST_CASE("equivalence-io-mismatch")
+{
+    Scene a, b;
+    _create_parity(a, 4);
+    _create_parity(b, 5);
+    Equivalence result;
+    REQUIRE_EQ(check_equivalence(a, b, result), Error::IO_MISMATCH);
+}
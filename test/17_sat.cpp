@@ -0,0 +1,147 @@
+#include <doctest.h>
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+static Node _gate(Scene& s, Gate::Type type, Node a, Node b)
+{
+    Node g = s.add_node<Gate>(type);
+    REQUIRE(s.connect(g, 0, a));
+    REQUIRE(s.connect(g, 1, b));
+    return g;
+}
+
+/**
+ * Builds a ripple carry adder over two numbers of the given width and a
+ * carry in. The alternative form computes the same sums and carries with a
+ * different structure.
+ */
+static void _create_adder(Scene& s, size_t width, bool is_alternative)
+{
+    std::vector<Node> a, b;
+    for (size_t i = 0; i < width; i++) {
+        a.push_back(s.add_node<Input>());
+        b.push_back(s.add_node<Input>());
+    }
+    Node carry = s.add_node<Input>();
+    for (size_t i = 0; i < width; i++) {
+        Node total, next;
+        if (!is_alternative) {
+            Node half = _gate(s, Gate::Type::XOR, a[i], b[i]);
+            total     = _gate(s, Gate::Type::XOR, half, carry);
+            next      = _gate(s, Gate::Type::OR,
+                _gate(s, Gate::Type::AND, a[i], b[i]),
+                _gate(s, Gate::Type::AND, half, carry));
+        } else {
+            total = _gate(s, Gate::Type::XOR, a[i],
+                _gate(s, Gate::Type::XOR, b[i], carry));
+            next  = _gate(s, Gate::Type::OR,
+                _gate(s, Gate::Type::OR,
+                    _gate(s, Gate::Type::AND, a[i], b[i]),
+                    _gate(s, Gate::Type::AND, a[i], carry)),
+                _gate(s, Gate::Type::AND, b[i], carry));
+        }
+        REQUIRE(s.connect(s.add_node<Output>(), 0, total));
+        carry = next;
+    }
+    REQUIRE(s.connect(s.add_node<Output>(), 0, carry));
+}
+
+TEST_CASE("sat-solver")
+{
+    using lit = SatSolver::lit;
+    // Four pigeons do not fit into three holes.
+    SatSolver pigeons;
+    std::vector<uint32_t> v;
+    for (size_t i = 0; i < 12; i++) {
+        v.push_back(pigeons.new_var());
+    }
+    auto in = [&](size_t p, size_t h) -> lit { return v[p * 3 + h] << 1; };
+    for (size_t p = 0; p < 4; p++) {
+        REQUIRE(pigeons.add_clause({ in(p, 0), in(p, 1), in(p, 2) }));
+    }
+    for (size_t h = 0; h < 3; h++) {
+        for (size_t p = 0; p < 4; p++) {
+            for (size_t q = p + 1; q < 4; q++) {
+                pigeons.add_clause({ in(p, h) | 1, in(q, h) | 1 });
+            }
+        }
+    }
+    REQUIRE_EQ(pigeons.solve(), SatSolver::UNSAT);
+    REQUIRE_GT(pigeons.conflicts(), 0);
+
+    // (a OR b) AND (NOT a OR c) AND (NOT b OR NOT c) AND (a OR c) has the
+    // single model a = c = 1, b = 0.
+    SatSolver s;
+    lit a = s.new_var() << 1, b = s.new_var() << 1, c = s.new_var() << 1;
+    std::vector<std::vector<lit>> clauses {
+        { a, b }, { a | 1, c }, { b | 1, c | 1 }, { a, c } };
+    for (const auto& clause : clauses) {
+        REQUIRE(s.add_clause(clause));
+    }
+    REQUIRE_EQ(s.solve(), SatSolver::SAT);
+    for (const auto& clause : clauses) {
+        bool is_satisfied = false;
+        for (lit l : clause) {
+            is_satisfied = is_satisfied || s.value(l >> 1) != (l & 1);
+        }
+        REQUIRE(is_satisfied);
+    }
+    REQUIRE(s.value(a >> 1));
+    REQUIRE_FALSE(s.value(b >> 1));
+    REQUIRE(s.value(c >> 1));
+
+    // A contradiction at the root level.
+    REQUIRE_FALSE(s.add_clause({ a | 1 }));
+    REQUIRE_EQ(s.solve(), SatSolver::UNSAT);
+}
+
+TEST_CASE("sat-equivalence-proof")
+{
+    Scene lhs, rhs;
+    _create_adder(lhs, 16, false);
+    _create_adder(rhs, 16, true);
+    Equivalence result;
+    REQUIRE_EQ(check_equivalence(lhs, rhs, result, 1 << 12), Error::OK);
+    REQUIRE(result.is_equivalent);
+    REQUIRE(result.is_proven);
+    REQUIRE_FALSE(result.is_cached);
+    REQUIRE_EQ(result.patterns, 1 << 12);
+
+    // Repeated checks are answered from the cache.
+    Equivalence cached;
+    REQUIRE_EQ(check_equivalence(lhs, rhs, cached, 1 << 12), Error::OK);
+    REQUIRE(cached.is_equivalent);
+    REQUIRE(cached.is_proven);
+    REQUIRE(cached.is_cached);
+}
+
+TEST_CASE("sat-equivalence-counterexample")
+{
+    // A 40-input AND differs from a constant for a single pattern, which
+    // random simulation is unlikely to find.
+    Scene lhs, rhs;
+    Node last = lhs.add_node<Input>();
+    rhs.add_node<Input>();
+    for (size_t i = 1; i < 40; i++) {
+        last = _gate(lhs, Gate::Type::AND, last, lhs.add_node<Input>());
+        rhs.add_node<Input>();
+    }
+    REQUIRE(lhs.connect(lhs.add_node<Output>(), 0, last));
+    rhs.add_node<Output>();
+
+    Equivalence result;
+    REQUIRE_EQ(check_equivalence(lhs, rhs, result, 1 << 12), Error::OK);
+    REQUIRE_FALSE(result.is_equivalent);
+    REQUIRE(result.is_proven);
+    REQUIRE_EQ(result.output, 0);
+    REQUIRE_EQ(result.counterexample, std::vector<bool>(40, true));
+
+    // Without a budget the solver gives up and only the simulated patterns
+    // are reported.
+    std::filesystem::remove(fs::CACHE / "equivalence.cache");
+    REQUIRE_EQ(check_equivalence(lhs, rhs, result, 1 << 12, 0, 0), Error::OK);
+    REQUIRE(result.is_equivalent);
+    REQUIRE_FALSE(result.is_proven);
+}
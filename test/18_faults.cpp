@@ -0,0 +1,188 @@
+#include <doctest.h>
+#include <random>
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+/** Every combination of three inputs. */
+static std::vector<std::vector<bool>> _exhaustive3(void)
+{
+    std::vector<std::vector<bool>> vectors;
+    for (uint32_t p = 0; p < 8; p++) {
+        vectors.push_back({ (p & 1) != 0, (p & 2) != 0, (p & 4) != 0 });
+    }
+    return vectors;
+}
+
+/** Builds the same random circuit for the same seed. */
+static void _create_random(
+    Scene& s, uint32_t seed, size_t input_s, size_t gate_s, size_t output_s)
+{
+    std::mt19937 rng { seed };
+    std::vector<Node> nodes;
+    for (size_t i = 0; i < input_s; i++) {
+        nodes.push_back(s.add_node<Input>());
+    }
+    for (size_t i = 0; i < gate_s; i++) {
+        Gate::Type type = static_cast<Gate::Type>(rng() % Gate::TYPE_S);
+        Node g          = s.add_node<Gate>(type);
+        auto gate       = s.get_node<Gate>(g);
+        for (size_t j = 0; j < gate->inputs.size(); j++) {
+            // Prefer recent nodes to keep the circuit deep.
+            size_t window = std::min<size_t>(nodes.size(), 32);
+            s.connect(g, j, nodes[nodes.size() - 1 - rng() % window]);
+        }
+        nodes.push_back(g);
+    }
+    for (size_t i = 0; i < output_s; i++) {
+        s.connect(s.add_node<Output>(), 0,
+            nodes[nodes.size() - 1 - rng() % (gate_s / 4)]);
+    }
+}
+
+static std::vector<std::vector<bool>> _random_vectors(
+    size_t count, size_t input_s, uint32_t seed)
+{
+    std::mt19937 rng { seed };
+    std::vector<std::vector<bool>> vectors(count);
+    for (auto& v : vectors) {
+        for (size_t i = 0; i < input_s; i++) {
+            v.push_back(rng() & 1);
+        }
+    }
+    return vectors;
+}
+
+TEST_CASE("faults-full-adder")
+{
+    Scene s;
+    _create_full_adder_io(s);
+    _create_full_adder(s);
+    FaultCoverage result;
+    REQUIRE_EQ(simulate_faults(s, _exhaustive3(), result), Error::OK);
+    REQUIRE_EQ(result.total, 2 * s._relations.size());
+    REQUIRE_EQ(result.detected, result.total);
+    REQUIRE(result.undetected.empty());
+    REQUIRE_EQ(result.ratio(), 1.0);
+
+    // Every net is zero for a = b = c = 0, so no stuck-at-0 fault shows.
+    REQUIRE_EQ(simulate_faults(s, { { false, false, false } }, result),
+        Error::OK);
+    REQUIRE_GT(result.detected, 0);
+    size_t stuck_at_0 = 0;
+    for (const Fault& f : result.undetected) {
+        stuck_at_0 += f.value ? 0 : 1;
+    }
+    REQUIRE_EQ(stuck_at_0, s._relations.size());
+}
+
+TEST_CASE("faults-redundant")
+{
+    // a OR (a AND b) is a, so only the faults that force the AND to one or
+    // that change a alone are observable.
+    Scene s;
+    Node a    = s.add_node<Input>();
+    Node b    = s.add_node<Input>();
+    Node g    = s.add_node<Gate>(Gate::Type::AND);
+    Node o    = s.add_node<Gate>(Gate::Type::OR);
+    Node out  = s.add_node<Output>();
+    relid r_a = s.connect(g, 0, a);
+    relid r_b = s.connect(g, 1, b);
+    REQUIRE(s.connect(o, 0, a));
+    relid r_g = s.connect(o, 1, g);
+    REQUIRE(s.connect(out, 0, o));
+
+    std::vector<std::vector<bool>> vectors;
+    for (uint32_t p = 0; p < 4; p++) {
+        vectors.push_back({ (p & 1) != 0, (p & 2) != 0 });
+    }
+    FaultCoverage result;
+    REQUIRE_EQ(simulate_faults(s, vectors, result), Error::OK);
+    REQUIRE_EQ(result.total, 10);
+    REQUIRE_EQ(result.detected, 6);
+    REQUIRE_EQ(result.undetected.size(), 4);
+    REQUIRE_EQ(result.undetected[0].rel, r_a);
+    REQUIRE_FALSE(result.undetected[0].value);
+    REQUIRE_EQ(result.undetected[1].rel, r_b);
+    REQUIRE_EQ(result.undetected[2].rel, r_b);
+    REQUIRE_EQ(result.undetected[3].rel, r_g);
+    REQUIRE_FALSE(result.undetected[3].value);
+}
+
+TEST_CASE("faults-match-serial")
+{
+    const size_t input_s = 8;
+    std::vector<std::vector<bool>> vectors
+        = _random_vectors(24, input_s, 7);
+    Scene s;
+    _create_random(s, 11, input_s, 120, 4);
+    FaultCoverage result;
+    REQUIRE_EQ(simulate_faults(s, vectors, result, 3), Error::OK);
+    REQUIRE_GT(result.detected, 0);
+    REQUIRE_GT(result.undetected.size(), 0);
+
+    Netlist good;
+    REQUIRE_EQ(good.compile(s), Error::OK);
+    auto pattern = [&](const std::vector<bool>& v) {
+        uint64_t p = 0;
+        for (size_t i = 0; i < v.size(); i++) {
+            p |= static_cast<uint64_t>(v[i]) << i;
+        }
+        return p;
+    };
+
+    // Each fault is injected one at a time by feeding the consumer of the
+    // relation from a new Input with the stuck value.
+    size_t detected = 0;
+    std::vector<Fault> undetected;
+    for (const auto& [id, rel] : s._relations) {
+        for (bool value : { false, true }) {
+            Scene faulty;
+            _create_random(faulty, 11, input_s, 120, 4);
+            auto r      = faulty.get_rel(id);
+            Node to     = r->to_node;
+            sockid sock = r->to_sock;
+            REQUIRE_EQ(faulty.disconnect(id), Error::OK);
+            REQUIRE(faulty.connect(to, sock, faulty.add_node<Input>()));
+            Netlist n;
+            REQUIRE_EQ(n.compile(faulty), Error::OK);
+            bool is_detected = false;
+            for (const auto& v : vectors) {
+                uint64_t p  = pattern(v);
+                is_detected = is_detected
+                    || n.run(p | static_cast<uint64_t>(value) << input_s)
+                        != good.run(p);
+            }
+            if (is_detected) {
+                detected++;
+            } else {
+                undetected.push_back({ id, value });
+            }
+        }
+    }
+    REQUIRE_EQ(result.detected, detected);
+    REQUIRE_EQ(result.undetected.size(), undetected.size());
+    for (size_t i = 0; i < undetected.size(); i++) {
+        REQUIRE_EQ(result.undetected[i].rel, undetected[i].rel);
+        REQUIRE_EQ(result.undetected[i].value, undetected[i].value);
+    }
+}
+
+TEST_CASE("faults-large")
+{
+    const size_t input_s = 64;
+    Scene s;
+    _create_random(s, 3, input_s, 2000, 64);
+    std::vector<std::vector<bool>> vectors = _random_vectors(128, input_s, 5);
+    FaultCoverage result;
+    REQUIRE_EQ(simulate_faults(s, vectors, result), Error::OK);
+    REQUIRE_GT(result.total, 6000);
+    REQUIRE_GT(result.detected, 0);
+    REQUIRE_EQ(result.detected + result.undetected.size(), result.total);
+
+    // The result does not depend on the number of workers.
+    FaultCoverage single;
+    REQUIRE_EQ(simulate_faults(s, vectors, single, 1), Error::OK);
+    REQUIRE_EQ(single.detected, result.detected);
+}
@@ -0,0 +1,75 @@
+#include <doctest.h>
+#include "common.h"
+#include "core.h"
+
+using namespace ic;
+
+TEST_CASE("vcd-records-changes")
+{
+    Scene s { "wave test" };
+    s.gate_delay[Gate::Type::NOT] = 3;
+    Node i      = s.add_node<Input>();
+    Node g_not  = s.add_node<Gate>(Gate::Type::NOT);
+    Node o      = s.add_node<Output>();
+    relid r_in  = s.connect(g_not, 0, i);
+    relid r_out = s.connect(o, 0, g_not);
+    REQUIRE(r_in);
+    REQUIRE(r_out);
+    s.step(3);
+
+    std::filesystem::path path = fs::CACHE / "wave.vcd";
+    WaveRecorder rec;
+    rec.add(r_in, "in");
+    rec.add_outputs(s);
+    REQUIRE_EQ(rec.open(s, path), Error::OK);
+    REQUIRE(rec.is_open());
+    REQUIRE_EQ(s.recorder, &rec);
+
+    s.get_node<Input>(i)->set(true);
+    s.step(3);
+    // Setting the same value again is not a change.
+    s.get_node<Input>(i)->set(true);
+    s.step(3);
+    s.get_node<Input>(i)->set(false);
+    s.step(3);
+    rec.close();
+    REQUIRE_FALSE(rec.is_open());
+    REQUIRE_EQ(s.recorder, nullptr);
+
+    // Changes after closing are not recorded.
+    s.get_node<Input>(i)->set(true);
+    s.step(3);
+
+    std::string data;
+    REQUIRE(fs::read(path, data));
+    REQUIRE_EQ(data,
+        "$version " APPNAME " $end\n"
+        "$timescale 1ms $end\n"
+        "$scope module wave_test $end\n"
+        "$var wire 1 ! in $end\n"
+        "$var wire 1 \" out_0 $end\n"
+        "$upscope $end\n"
+        "$enddefinitions $end\n"
+        "#3\n"
+        "$dumpvars\n"
+        "0!\n"
+        "1\"\n"
+        "$end\n"
+        "1!\n"
+        "#6\n"
+        "0\"\n"
+        "#9\n"
+        "0!\n"
+        "#12\n"
+        "1\"\n");
+}
+
+TEST_CASE("vcd-missing-relation")
+{
+    Scene s;
+    WaveRecorder rec;
+    rec.add(42);
+    REQUIRE_EQ(rec.open(s, fs::CACHE / "missing.vcd"), Error::REL_NOT_FOUND);
+    REQUIRE_FALSE(rec.is_open());
+    REQUIRE_EQ(s.recorder, nullptr);
+}
@@ -0,0 +1,85 @@
+#include <doctest.h>
+#include <sstream>
+#include "common.h"
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+TEST_CASE("stimulus-csv")
+{
+    Scene s;
+    _create_full_adder_io(s);
+    _create_full_adder(s);
+    std::istringstream in { "a,b,c_in\n"
+                            "0,0,0\n"
+                            "1,0,0\n"
+                            "\n"
+                            "1,1,0\n"
+                            "1,1,1\n" };
+    std::ostringstream out;
+    REQUIRE_EQ(run_stimulus(s, in, StreamFormat::CSV, out, StreamFormat::CSV),
+        Error::OK);
+    REQUIRE_EQ(out.str(),
+        "tick,out_0,out_1\n"
+        "1,0,0\n"
+        "2,0,1\n"
+        "3,1,0\n"
+        "4,1,1\n");
+}
+
+TEST_CASE("stimulus-binary")
+{
+    Scene s;
+    _create_full_adder_io(s);
+    _create_full_adder(s);
+    std::string stimulus { STREAM_MAGIC, sizeof(STREAM_MAGIC) };
+    stimulus += std::string { "\x03\x00", 2 };
+    for (char p = 0; p < 8; p++) {
+        stimulus += p;
+    }
+    std::istringstream in { stimulus };
+    std::ostringstream out;
+    REQUIRE_EQ(run_stimulus(s, in, StreamFormat::BINARY, out,
+                   StreamFormat::BINARY, 2),
+        Error::OK);
+
+    std::string expected { STREAM_MAGIC, sizeof(STREAM_MAGIC) };
+    expected += std::string { "\x02\x00", 2 };
+    for (int p = 0; p < 8; p++) {
+        int total = (p & 1) + ((p >> 1) & 1) + ((p >> 2) & 1);
+        // out_0 is the carry and out_1 is the sum.
+        expected += static_cast<char>((total >> 1) | ((total & 1) << 1));
+    }
+    REQUIRE_EQ(out.str(), expected);
+    REQUIRE_EQ(s.tick(), 16);
+}
+
+TEST_CASE("stimulus-errors")
+{
+    Scene s;
+    _create_full_adder_io(s);
+    _create_full_adder(s);
+    std::ostringstream out;
+
+    std::istringstream short_row { "0,1\n" };
+    REQUIRE_EQ(
+        run_stimulus(s, short_row, StreamFormat::CSV, out, StreamFormat::CSV),
+        Error::IO_MISMATCH);
+
+    std::istringstream late_header { "0,0,1\nx,y,z\n" };
+    REQUIRE_EQ(
+        run_stimulus(s, late_header, StreamFormat::CSV, out, StreamFormat::CSV),
+        Error::INVALID_FILE);
+
+    std::string header { STREAM_MAGIC, sizeof(STREAM_MAGIC) };
+    std::istringstream wrong_size { header + std::string { "\x04\x00", 2 } };
+    REQUIRE_EQ(run_stimulus(
+                   s, wrong_size, StreamFormat::BINARY, out, StreamFormat::CSV),
+        Error::IO_MISMATCH);
+
+    std::istringstream no_magic { "0,0,0\n" };
+    REQUIRE_EQ(run_stimulus(
+                   s, no_magic, StreamFormat::BINARY, out, StreamFormat::CSV),
+        Error::INVALID_FILE);
+}
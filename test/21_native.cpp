@@ -0,0 +1,217 @@
+#include <doctest.h>
+#include <cstdlib>
+#include <random>
+#include "common.h"
+#include "core.h"
+
+using namespace ic;
+
+/** Random netlist with every kind of cell. */
+static Netlist _random_netlist(uint32_t seed)
+{
+    std::mt19937_64 rng { seed };
+    Netlist n;
+    for (int i = 0; i < 10; i++) {
+        n.inputs.push_back({ Node {}, n.add(Netlist::INPUT, {}) });
+    }
+    for (int i = 0; i < 300; i++) {
+        Netlist::Op op = static_cast<Netlist::Op>(
+            Netlist::BUF + rng() % (Netlist::OP_S - Netlist::BUF));
+        uint32_t size  = 2 + rng() % 3;
+        if (op == Netlist::BUF || op == Netlist::NOT) {
+            size = 1;
+        } else if (op == Netlist::LUT) {
+            size = 1 + rng() % 4;
+        }
+        std::vector<Netlist::netid> in;
+        for (uint32_t j = 0; j < size; j++) {
+            in.push_back(rng() % n.cells.size());
+        }
+        uint32_t table = 0;
+        if (op == Netlist::LUT) {
+            table = n.tables.size();
+            n.tables.push_back(Lut::Table { rng() });
+        }
+        n.add(op, in, table);
+    }
+    for (int i = 0; i < 12; i++) {
+        n.outputs.push_back({ Node {}, static_cast<Netlist::netid>(
+                                           n.cells.size() - 1 - i * 7) });
+    }
+    return n;
+}
+
+TEST_CASE("native-generate")
+{
+    Netlist n;
+    Netlist::netid a = n.add(Netlist::INPUT, {});
+    Netlist::netid b = n.add(Netlist::INPUT, {});
+    n.inputs.push_back({ Node {}, a });
+    n.inputs.push_back({ Node {}, b });
+    n.tables.push_back(Lut::Table { 0b0110 });
+    n.outputs.push_back({ Node {}, n.add(Netlist::NAND, { a, b }) });
+    n.outputs.push_back({ Node {}, n.add(Netlist::LUT, { a, b }, 0) });
+    std::string src = NativeNetlist::generate(n);
+    REQUIRE_NE(src.find("void ic_simulate(const uint64_t* in, uint64_t* out)"),
+        std::string::npos);
+    REQUIRE_NE(src.find("const uint64_t n2 = in[0];"), std::string::npos);
+    REQUIRE_NE(src.find("const uint64_t n4 = ~(n2 & n3);"), std::string::npos);
+    REQUIRE_NE(src.find("const uint64_t n5 = ((n3 & ~n2) | (~n3 & n2));"),
+        std::string::npos);
+    REQUIRE_NE(src.find("out[1] = n5;"), std::string::npos);
+}
+
+TEST_CASE("native-matches-interpreter")
+{
+    Netlist n = _random_netlist(9);
+    NativeNetlist native { Netlist { n } };
+    REQUIRE_EQ(native.build(), Error::OK);
+    REQUIRE(native.is_native());
+
+    std::mt19937_64 rng { 3 };
+    std::vector<uint64_t> in(n.inputs.size()), expected, out;
+    for (int round = 0; round < 32; round++) {
+        for (uint64_t& v : in) {
+            v = rng();
+        }
+        n.simulate(in, expected);
+        native.simulate(in, out);
+        REQUIRE_EQ(out, expected);
+        uint64_t pattern = rng();
+        REQUIRE_EQ(native.run(pattern), n.run(pattern));
+    }
+
+    // The second build of the same netlist is loaded from the cache.
+    NativeNetlist cached { Netlist { n } };
+    REQUIRE_EQ(cached.build(), Error::OK);
+    REQUIRE_EQ(cached.run(0b1011), n.run(0b1011));
+}
+
+TEST_CASE("native-fallback")
+{
+    Netlist n = _random_netlist(4);
+    NativeNetlist native { Netlist { n } };
+    setenv("CXX", "ic-missing-compiler", 1);
+    Error err = native.build();
+    unsetenv("CXX");
+    REQUIRE_EQ(err, Error::COMPILER_NOT_FOUND);
+    REQUIRE_FALSE(native.is_native());
+    for (uint64_t pattern = 0; pattern < 1024; pattern += 37) {
+        REQUIRE_EQ(native.run(pattern), n.run(pattern));
+    }
+}
+
+/** Scene with a 2x1 multiplexer component whose inputs are Input nodes. */
+static void _create_mux_user(Scene& s, std::vector<Node>& in, Node& o)
+{
+    Scene mux { ComponentContext { &mux, 3, 1 }, "2x1-mux" };
+    Node g_and   = mux.add_node<Gate>(Gate::Type::AND);
+    Node g_and_2 = mux.add_node<Gate>(Gate::Type::AND);
+    Node g_not   = mux.add_node<Gate>(Gate::Type::NOT);
+    Node g_out   = mux.add_node<Gate>(Gate::Type::OR);
+    mux.connect(g_and, 0, mux.component_context->get_input(0));
+    mux.connect(g_and_2, 0, mux.component_context->get_input(1));
+    mux.connect(g_and, 1, mux.component_context->get_input(2));
+    mux.connect(g_not, 0, mux.component_context->get_input(2));
+    mux.connect(g_and_2, 1, g_not);
+    mux.connect(g_out, 0, g_and);
+    mux.connect(g_out, 1, g_and_2);
+    mux.connect(mux.component_context->get_output(0), 0, g_out);
+
+    s.add_dependency(std::move(mux));
+    Node c = s.add_node<Component>();
+    REQUIRE_EQ(s.get_node<Component>(c)->set_component(0), Error::OK);
+    for (sockid i = 0; i < 3; i++) {
+        in.push_back(s.add_node<Input>());
+        REQUIRE(s.connect(c, i, in.back()));
+    }
+    o = s.add_node<Output>();
+    REQUIRE(s.connect(o, 0, c, 0));
+}
+
+TEST_CASE("native-dependency")
+{
+    Scene interpreted, native;
+    native.is_native = true;
+    std::vector<Node> in_i, in_n;
+    Node o_i, o_n;
+    _create_mux_user(interpreted, in_i, o_i);
+    _create_mux_user(native, in_n, o_n);
+    for (uint32_t pattern = 0; pattern < 16; pattern++) {
+        for (size_t i = 0; i < 3; i++) {
+            interpreted.get_node<Input>(in_i[i])->set((pattern >> i) & 1);
+            native.get_node<Input>(in_n[i])->set((pattern >> i) & 1);
+        }
+        REQUIRE_EQ(native.get_node<Output>(o_n)->get(),
+            interpreted.get_node<Output>(o_i)->get());
+    }
+    Scene moved { std::move(native) };
+    REQUIRE(moved.is_native);
+}
+
+TEST_CASE("native-artifact")
+{
+    Netlist n         = _random_netlist(7);
+    Netlist tabulated = n;
+    REQUIRE(tabulated.tabulate());
+    REQUIRE_EQ(tabulated.truth_table.size(), 1 << 10);
+    for (uint64_t pattern = 0; pattern < 1024; pattern += 7) {
+        REQUIRE_EQ(tabulated.run(pattern), n.run(pattern));
+    }
+
+    std::filesystem::path path = fs::CACHE / "native-artifact.icn";
+    REQUIRE_EQ(tabulated.write_file(path, 42), Error::OK);
+    Netlist loaded;
+    REQUIRE_EQ(loaded.read_file(path, 42), Error::OK);
+    REQUIRE_EQ(loaded.cells.size(), n.cells.size());
+    REQUIRE_EQ(loaded.fanin, n.fanin);
+    REQUIRE(loaded.tables == n.tables);
+    REQUIRE_EQ(loaded.truth_table, tabulated.truth_table);
+    loaded.truth_table.clear();
+    for (uint64_t pattern = 0; pattern < 1024; pattern += 7) {
+        REQUIRE_EQ(loaded.run(pattern), n.run(pattern));
+    }
+
+    // Artifacts of another scene and damaged artifacts are rejected.
+    REQUIRE_EQ(loaded.read_file(path, 43), Error::INVALID_FILE);
+    std::vector<unsigned char> data;
+    REQUIRE(fs::read(path, data));
+    data.back() ^= 1;
+    REQUIRE(fs::write(path, data));
+    REQUIRE_EQ(loaded.read_file(path, 42), Error::INVALID_FILE);
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("native-dependency-artifact")
+{
+    std::filesystem::path dir = fs::CACHE / "netlist";
+    std::filesystem::remove_all(dir);
+    auto count = [&]() {
+        return std::distance(std::filesystem::directory_iterator { dir },
+            std::filesystem::directory_iterator {});
+    };
+
+    Scene compiled, loaded;
+    std::vector<Node> in_c, in_l;
+    Node o_c, o_l;
+    _create_mux_user(compiled, in_c, o_c);
+    compiled.get_node<Input>(in_c[0])->set(true);
+    REQUIRE_EQ(count(), 1);
+    // The second scene finds the artifact of the same dependency.
+    _create_mux_user(loaded, in_l, o_l);
+    for (uint32_t pattern = 0; pattern < 8; pattern++) {
+        for (size_t i = 0; i < 3; i++) {
+            compiled.get_node<Input>(in_c[i])->set((pattern >> i) & 1);
+            loaded.get_node<Input>(in_l[i])->set((pattern >> i) & 1);
+        }
+        REQUIRE_EQ(loaded.get_node<Output>(o_l)->get(),
+            compiled.get_node<Output>(o_c)->get());
+    }
+    REQUIRE_EQ(count(), 1);
+
+    // Any change to a scene changes its content hash and so its key.
+    uint64_t hash = compiled.content_hash();
+    REQUIRE_EQ(loaded.content_hash(), hash);
+    loaded.add_node<Gate>(Gate::Type::AND);
+    REQUIRE_NE(loaded.content_hash(), hash);
+}
@@ -0,0 +1,165 @@
+#include <doctest.h>
+#include <random>
+#include <sstream>
+#include "common.h"
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+/** Builds the same random combinational scene for the same seed. */
+static void _create_random(Scene& s, uint32_t seed)
+{
+    std::mt19937 rng { seed };
+    std::vector<Node> nodes;
+    for (size_t i = 0; i < 6; i++) {
+        nodes.push_back(s.add_node<Input>());
+    }
+    for (size_t i = 0; i < 80; i++) {
+        Node n;
+        sockid size = 3;
+        if (i % 10 == 9) {
+            n = s.add_node<Lut>(size, Lut::Table { rng() });
+        } else {
+            auto type = static_cast<Gate::Type>(rng() % Gate::TYPE_S);
+            n         = s.add_node<Gate>(type);
+            size      = type == Gate::Type::NOT ? 1 : 2;
+        }
+        for (sockid j = 0; j < size; j++) {
+            size_t window = std::min<size_t>(nodes.size(), 16);
+            s.connect(n, j, nodes[nodes.size() - 1 - rng() % window]);
+        }
+        nodes.push_back(n);
+    }
+    for (size_t i = 0; i < 8; i++) {
+        s.connect(s.add_node<Output>(), 0, nodes[nodes.size() - 1 - i * 3]);
+    }
+}
+
+static std::vector<std::vector<bool>> _rows(size_t count, size_t size)
+{
+    std::mt19937 rng { 17 };
+    std::vector<std::vector<bool>> rows(count);
+    for (auto& row : rows) {
+        for (size_t i = 0; i < size; i++) {
+            row.push_back(rng() & 1);
+        }
+    }
+    return rows;
+}
+
+TEST_CASE("backend-agree")
+{
+    Scene reference;
+    _create_random(reference, 5);
+    auto expected = Backend::create(Backend::EVENT);
+    REQUIRE_EQ(expected->load(reference), Error::OK);
+    REQUIRE_EQ(expected->input_size(), 6);
+    REQUIRE_EQ(expected->output_size(), 8);
+    std::vector<std::vector<bool>> rows = _rows(100, 6);
+    std::vector<std::vector<State>> want, got;
+    expected->run(rows, 1, want);
+    REQUIRE_EQ(want.size(), rows.size());
+
+    for (uint8_t t = Backend::RECURSIVE; t < Backend::TYPE_S; t++) {
+        Scene s;
+        _create_random(s, 5);
+        auto backend = Backend::create(static_cast<Backend::Type>(t));
+        REQUIRE_EQ(backend->load(s), Error::OK);
+        backend->run(rows, 1, got);
+        REQUIRE_EQ(got, want);
+    }
+}
+
+TEST_CASE("backend-cross-check")
+{
+    Scene s;
+    _create_random(s, 8);
+    CrossCheck check { Backend::create(Backend::LEVELIZED),
+        Backend::create(Backend::BIT_PARALLEL) };
+    REQUIRE_EQ(check.load(s), Error::OK);
+    REQUIRE_EQ(check.batch_size(), 64);
+    std::vector<std::vector<State>> out;
+    check.run(_rows(70, 6), 1, out);
+    REQUIRE_EQ(out.size(), 70);
+    REQUIRE_FALSE(check.divergence().has_value());
+
+    // An unconnected gate is DISABLED, but reads as FALSE when bit parallel.
+    Scene partial;
+    Node a = partial.add_node<Input>();
+    Node g = partial.add_node<Gate>(Gate::Type::AND);
+    Node o = partial.add_node<Output>();
+    REQUIRE(partial.connect(g, 0, a));
+    REQUIRE(partial.connect(o, 0, g));
+    CrossCheck two_valued { Backend::create(Backend::LEVELIZED),
+        Backend::create(Backend::BIT_PARALLEL) };
+    REQUIRE_EQ(two_valued.load(partial), Error::OK);
+    two_valued.run({ { false }, { true } }, 1, out);
+    REQUIRE_FALSE(two_valued.divergence().has_value());
+    REQUIRE_EQ(out[0][0], DISABLED);
+
+    // Only the event backend waits for gate delays, so it lags behind.
+    Scene slow;
+    Node i = slow.add_node<Input>();
+    Node n = slow.add_node<Gate>(Gate::Type::NOT);
+    Node y = slow.add_node<Output>();
+    REQUIRE(slow.connect(n, 0, i));
+    REQUIRE(slow.connect(y, 0, n));
+    slow.get_node<Gate>(n)->set_delay(8);
+    CrossCheck diverging { Backend::create(Backend::LEVELIZED),
+        Backend::create(Backend::EVENT) };
+    REQUIRE_EQ(diverging.load(slow), Error::OK);
+    diverging.run({ { false } }, 1, out);
+    REQUIRE_FALSE(diverging.divergence().has_value());
+    diverging.run({ { false }, { true } }, 1, out);
+    REQUIRE(diverging.divergence().has_value());
+    REQUIRE_EQ(diverging.divergence()->step, 2);
+    REQUIRE_EQ(diverging.divergence()->output, 0);
+    REQUIRE_EQ(diverging.divergence()->expected, FALSE);
+    REQUIRE_EQ(diverging.divergence()->actual, TRUE);
+    REQUIRE_EQ(out[1][0], FALSE);
+}
+
+TEST_CASE("backend-stimulus")
+{
+    std::string csv = "a,b,c_in\n";
+    for (const auto& row : _rows(90, 3)) {
+        csv += row[0] ? "1," : "0,";
+        csv += row[1] ? "1," : "0,";
+        csv += row[2] ? "1\n" : "0\n";
+    }
+    std::string expected;
+    for (uint8_t t = 0; t < Backend::TYPE_S; t++) {
+        Scene s;
+        _create_full_adder_io(s);
+        _create_full_adder(s);
+        s.engine = static_cast<Backend::Type>(t);
+        std::istringstream in { csv };
+        std::ostringstream out;
+        REQUIRE_EQ(
+            run_stimulus(s, in, StreamFormat::CSV, out, StreamFormat::CSV),
+            Error::OK);
+        if (t == Backend::EVENT) {
+            expected = out.str();
+        }
+        REQUIRE_EQ(out.str(), expected);
+    }
+}
+
+TEST_CASE("backend-rejects-state")
+{
+    Scene s;
+    Node d  = s.add_node<Input>();
+    Node ff = s.add_node<Sequential>(Sequential::Type::D_FLIPFLOP);
+    REQUIRE(s.connect(ff, 0, d));
+    for (uint8_t t = Backend::RECURSIVE; t < Backend::TYPE_S; t++) {
+        auto backend = Backend::create(static_cast<Backend::Type>(t));
+        REQUIRE_EQ(backend->load(s), Error::NOT_COMBINATIONAL);
+    }
+    REQUIRE_EQ(Backend::create(Backend::EVENT)->load(s), Error::OK);
+
+    Backend::Type type = Backend::EVENT;
+    REQUIRE(Backend::parse("bit-parallel", type));
+    REQUIRE_EQ(type, Backend::BIT_PARALLEL);
+    REQUIRE_FALSE(Backend::parse("fastest", type));
+}
@@ -0,0 +1,525 @@
+#include <atomic>
+#include <doctest.h>
+#include <functional>
+#include <random>
+#include <thread>
+#include "common.h"
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+/** Whether a temporary file of fs::write_atomic is left next to path. */
+static bool _has_temp(const std::filesystem::path& path)
+{
+    std::string prefix = path.filename().string() + ".";
+    for (const auto& entry :
+        std::filesystem::directory_iterator(path.parent_path())) {
+        if (entry.path().filename().string().rfind(prefix, 0) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** Scene with every kind of node, a removed slot and delays. */
+static void _create_mixed(Scene& s)
+{
+    s.set_author("Author");
+    s.set_description("Every kind of node.");
+    s.gate_delay[Gate::Type::XOR] = 7;
+    Node a   = s.add_node<Input>();
+    Node clk = s.add_node<Input>(uint8_t { 4 });
+    Node g1  = s.add_node<Gate>(Gate::Type::XOR);
+    Node g2  = s.add_node<Gate>(Gate::Type::AND, sockid { 3 });
+    Node g3  = s.add_node<Gate>(Gate::Type::OR);
+    Node ff  = s.add_node<Sequential>(Sequential::Type::REGISTER, sockid { 8 });
+    Node lut = s.add_node<Lut>(sockid { 3 }, Lut::Table { 0b10010110 });
+    Node rom = s.add_node<Memory>(
+        Memory::Type::ROM, sockid { 4 }, sockid { 8 });
+    Node o   = s.add_node<Output>();
+    s.get_node<Input>(a)->set(true);
+    s.get_node<Gate>(g3)->set_delay(4);
+    s.get_node<Sequential>(ff)->set_value(0xA5);
+    s.get_node<Memory>(rom)->write(3, 0x42);
+    s.get_base(g1)->move({ 120, -40 });
+    s.get_base(lut)->move({ -300, 200 });
+    REQUIRE(s.connect(g1, 0, a));
+    REQUIRE(s.connect(g1, 1, clk));
+    REQUIRE(s.connect(g3, 0, g1));
+    REQUIRE(s.connect(lut, 2, g3));
+    REQUIRE(s.connect(rom, 0, lut));
+    REQUIRE(s.connect(o, 0, g3));
+    REQUIRE_EQ(s.remove_node(g2), Error::OK);
+}
+
+/** Builds the same large random scene for the same seed. */
+static void _create_large(Scene& s, uint32_t seed)
+{
+    std::mt19937 rng { seed };
+    std::vector<Node> nodes;
+    for (int16_t i = 0; i < 32; i++) {
+        nodes.push_back(s.add_node<Input>());
+        s.get_base(nodes.back())->move({ 0, static_cast<int16_t>(i * 40) });
+    }
+    for (int16_t i = 0; i < 3000; i++) {
+        auto type = static_cast<Gate::Type>(rng() % Gate::TYPE_S);
+        Node n    = s.add_node<Gate>(type);
+        s.get_base(n)->move({ static_cast<int16_t>(100 + i / 50 * 80),
+            static_cast<int16_t>(i % 50 * 40) });
+        sockid size = type == Gate::Type::NOT ? 1 : 2;
+        for (sockid j = 0; j < size; j++) {
+            size_t window = std::min<size_t>(nodes.size(), 64);
+            s.connect(n, j, nodes[nodes.size() - 1 - rng() % window]);
+        }
+        nodes.push_back(n);
+    }
+    for (size_t i = 0; i < 16; i++) {
+        s.connect(s.add_node<Output>(), 0, nodes[nodes.size() - 1 - i]);
+    }
+}
+
+TEST_CASE("format-v2-round-trip")
+{
+    Scene s { "mixed" };
+    _create_mixed(s);
+    std::vector<uint8_t> data, v1, v1_loaded;
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    REQUIRE_EQ(data[0], Scene::FORMAT_VERSION);
+
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(data), Error::OK);
+    REQUIRE(scene_cmp(s, s_loaded));
+    REQUIRE(s_loaded.get_node<Gate>(Node { 1, Node::GATE }) == nullptr);
+    REQUIRE_EQ(s_loaded.get_node<Gate>(Node { 2, Node::GATE })->delay(), 4);
+    REQUIRE_EQ(s_loaded.get_node<Input>(Node { 1, Node::INPUT })->freq(), 4);
+    // Both documents describe the same scene when written by version 1.
+    REQUIRE_EQ(s.write_to(v1, 1), Error::OK);
+    REQUIRE_EQ(s_loaded.write_to(v1_loaded, 1), Error::OK);
+    REQUIRE_EQ(v1, v1_loaded);
+}
+
+TEST_CASE("format-reads-v1")
+{
+    Scene s { "mixed" };
+    _create_mixed(s);
+    std::vector<uint8_t> v1, v2, v2_loaded;
+    REQUIRE_EQ(s.write_to(v1, 1), Error::OK);
+    REQUIRE_EQ(v1[0], 1);
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(v1), Error::OK);
+    REQUIRE_EQ(s.write_to(v2), Error::OK);
+    REQUIRE_EQ(s_loaded.write_to(v2_loaded), Error::OK);
+    REQUIRE_EQ(v2, v2_loaded);
+    REQUIRE_EQ(s.write_to(v2, 3), Error::INVALID_SCENE_FORMAT);
+}
+
+TEST_CASE("format-engine")
+{
+    Scene s { "mixed" };
+    _create_mixed(s);
+    s.engine    = Backend::BIT_PARALLEL;
+    s.is_native = true;
+    for (uint8_t version : { 1, 2 }) {
+        std::vector<uint8_t> data;
+        REQUIRE_EQ(s.write_to(data, version), Error::OK);
+        Scene s_loaded;
+        REQUIRE_EQ(s_loaded.read_from(data), Error::OK);
+        REQUIRE_EQ(s_loaded.engine, Backend::BIT_PARALLEL);
+        REQUIRE(s_loaded.is_native);
+    }
+    Scene moved { std::move(s) };
+    REQUIRE_EQ(moved.engine, Backend::BIT_PARALLEL);
+}
+
+TEST_CASE("format-size")
+{
+    Scene s { "large" };
+    _create_large(s, 3);
+    std::vector<uint8_t> v1, v2, v2_loaded;
+    REQUIRE_EQ(s.write_to(v1, 1), Error::OK);
+    REQUIRE_EQ(s.write_to(v2), Error::OK);
+    REQUIRE_LT(v2.size() * 2, v1.size());
+
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(v2), Error::OK);
+    REQUIRE_EQ(s_loaded._relations.size(), s._relations.size());
+    REQUIRE_EQ(s_loaded.write_to(v2_loaded), Error::OK);
+    REQUIRE_EQ(v2, v2_loaded);
+}
+
+TEST_CASE("format-corrupted")
+{
+    Scene s { "mixed" };
+    _create_mixed(s);
+    std::vector<uint8_t> data;
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+
+    std::vector<uint8_t> flipped = data;
+    flipped[flipped.size() / 2] ^= 0x10;
+    Scene s_flipped;
+    REQUIRE_EQ(s_flipped.read_from(flipped), Error::CHECKSUM_MISMATCH);
+
+    std::vector<uint8_t> truncated { data.begin(), data.begin() + 6 };
+    Scene s_truncated;
+    REQUIRE_EQ(s_truncated.read_from(truncated), Error::INVALID_SCENE_FORMAT);
+
+    Scene s_empty;
+    REQUIRE_EQ(s_empty.read_from({}), Error::INVALID_SCENE_FORMAT);
+}
+
+TEST_CASE("format-read-file")
+{
+    Scene s { "mixed" };
+    _create_mixed(s);
+    std::vector<uint8_t> data;
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    std::filesystem::path path = fs::CACHE / "format-read-file.ic";
+    REQUIRE(fs::write(path, data));
+
+    fs::MappedFile file;
+    REQUIRE(file.open(path));
+    std::vector<uint8_t> mapped { file.data(), file.data() + file.size() };
+    REQUIRE_EQ(mapped, data);
+    fs::MappedFile moved = std::move(file);
+    REQUIRE(file.data() == nullptr);
+    REQUIRE_EQ(moved.size(), data.size());
+
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_file(path), Error::OK);
+    REQUIRE(scene_cmp(s, s_loaded));
+    Scene s_missing;
+    REQUIRE_EQ(s_missing.read_file(fs::CACHE / "missing.ic"), Error::NOT_FOUND);
+}
+
+TEST_CASE("format-write-file")
+{
+    Scene s { "large" };
+    _create_large(s, 6);
+    std::vector<uint8_t> expected, data;
+    REQUIRE_EQ(s.write_to(expected), Error::OK);
+    std::filesystem::path path = fs::CACHE / "format-write-file.ic";
+    REQUIRE_EQ(s.write_file(path), Error::OK);
+    REQUIRE(fs::read(path, data));
+    REQUIRE_EQ(data, expected);
+    REQUIRE_FALSE(_has_temp(path));
+
+    // A failed save leaves no temporary file behind.
+    std::filesystem::path dir = fs::CACHE / "format-write-dir";
+    REQUIRE(fs::write(dir / "keep.ic", data));
+    REQUIRE_EQ(s.write_file(dir), Error::NO_SAVE_PATH_DEFINED);
+    REQUIRE_FALSE(_has_temp(dir));
+    REQUIRE(std::filesystem::exists(dir / "keep.ic"));
+}
+
+TEST_CASE("format-write-concurrent")
+{
+    // Writers of the same path never share a temporary file, so the result
+    // is always one of the complete documents.
+    std::filesystem::path path = fs::CACHE / "format-write-concurrent.ic";
+    std::vector<Scene> scenes(4);
+    for (size_t i = 0; i < scenes.size(); i++) {
+        _create_large(scenes[i], 4 + i);
+    }
+    std::vector<std::thread> writers;
+    std::atomic<size_t> failed { 0 };
+    for (const Scene& s : scenes) {
+        writers.emplace_back([&]() {
+            for (int i = 0; i < 8; i++) {
+                if (s.write_file(path) != Error::OK) {
+                    failed++;
+                }
+            }
+        });
+    }
+    for (std::thread& t : writers) {
+        t.join();
+    }
+    REQUIRE_EQ(failed, 0);
+    REQUIRE_FALSE(_has_temp(path));
+    Scene r;
+    REQUIRE_EQ(r.read_file(path), Error::OK);
+    bool is_written = false;
+    for (const Scene& s : scenes) {
+        is_written = is_written || r._gates.size() == s._gates.size();
+    }
+    REQUIRE(is_written);
+}
+
+TEST_CASE("format-compressed")
+{
+    Scene s { "large" };
+    _create_large(s, 9);
+    std::vector<uint8_t> plain, packed;
+    REQUIRE_EQ(s.write_to(plain), Error::OK);
+    REQUIRE_EQ(
+        s.write_to(packed, Scene::FORMAT_VERSION | Scene::FORMAT_COMPRESSED),
+        Error::OK);
+    REQUIRE_EQ(packed[0], 0x82);
+    REQUIRE_LT(packed.size() * 3, plain.size() * 2);
+    // The checksum covers the decompressed document.
+    REQUIRE(std::equal(plain.begin() + 4, plain.begin() + 12, &packed[4]));
+
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(packed), Error::OK);
+    REQUIRE(s_loaded.is_compressed);
+    std::vector<uint8_t> plain_loaded;
+    REQUIRE_EQ(s_loaded.write_to(plain_loaded), Error::OK);
+    REQUIRE_EQ(plain_loaded, plain);
+
+    std::filesystem::path path = fs::CACHE / "format-compressed.ic";
+    REQUIRE_EQ(s_loaded.write_file(path), Error::OK);
+    std::vector<uint8_t> data;
+    REQUIRE(fs::read(path, data));
+    REQUIRE_EQ(data, packed);
+
+    for (size_t i = 12; i < packed.size(); i += packed.size() / 16) {
+        std::vector<uint8_t> flipped = packed;
+        flipped[i] ^= 0x10;
+        Scene s_flipped;
+        REQUIRE_NE(s_flipped.read_from(flipped), Error::OK);
+    }
+    std::vector<uint8_t> flipped = packed;
+    flipped[4] ^= 1;
+    Scene s_flipped;
+    REQUIRE_EQ(s_flipped.read_from(flipped), Error::CHECKSUM_MISMATCH);
+    std::vector<uint8_t> truncated { packed.begin(), packed.end() - 9 };
+    Scene s_truncated;
+    REQUIRE_EQ(s_truncated.read_from(truncated), Error::INVALID_SCENE_FORMAT);
+}
+
+TEST_CASE("format-lz4")
+{
+    std::mt19937 rng { 4 };
+    std::vector<uint8_t> random(5000), repeated, block, out;
+    for (auto& b : random) {
+        b = rng();
+    }
+    for (size_t i = 0; i < 5000; i++) {
+        repeated.push_back(i % 97 == 0 ? rng() : i % 13);
+    }
+    for (const auto* data : { &random, &repeated }) {
+        for (size_t size : { 0, 1, 12, 13, 300, 5000 }) {
+            block.clear();
+            size_t block_s = lz4_compress(data->data(), size, block);
+            REQUIRE_EQ(block_s, block.size());
+            REQUIRE_LE(block_s, size + size / 255 + 16);
+            out.assign(size, 0);
+            REQUIRE(lz4_decompress(block.data(), block_s, out.data(), size));
+            REQUIRE(std::equal(out.begin(), out.end(), data->begin()));
+        }
+    }
+    block.clear();
+    lz4_compress(repeated.data(), repeated.size(), block);
+    REQUIRE_LT(block.size() * 2, repeated.size());
+    REQUIRE_FALSE(lz4_decompress(
+        block.data(), block.size() - 1, out.data(), repeated.size()));
+    REQUIRE_FALSE(
+        lz4_decompress(block.data(), block.size(), out.data(), 100));
+}
+
+TEST_CASE("format-journal-replay")
+{
+    std::filesystem::path path = fs::CACHE / "format-journal.ic";
+    Scene s { "mixed" };
+    _create_mixed(s);
+    Journal journal;
+    REQUIRE_EQ(journal.compact(path, s), Error::OK);
+    REQUIRE(journal.is_open());
+    REQUIRE_EQ(journal.pending(), 0);
+
+    Node g = s.add_node<Gate>(Gate::Type::NAND, sockid { 3 });
+    Node o = s.add_node<Output>();
+    s.get_base(g)->move({ 64, 32 });
+    REQUIRE(s.connect(g, 0, Node { 0, Node::INPUT }));
+    relid id = s.connect(o, 0, g);
+    REQUIRE(id);
+    REQUIRE_EQ(s.disconnect(id), Error::OK);
+    REQUIRE_EQ(s.remove_node(Node { 2, Node::GATE }), Error::OK);
+    REQUIRE_EQ(journal.pending(), 10);
+    journal.close();
+    s.journal = nullptr;
+
+    Scene s_loaded;
+    Journal replayed;
+    REQUIRE_EQ(s_loaded.read_file(path), Error::OK);
+    REQUIRE_EQ(replayed.open(path, s_loaded), Error::OK);
+    REQUIRE_EQ(replayed.pending(), 10);
+    REQUIRE(s_loaded.journal == &replayed);
+    REQUIRE(scene_cmp(s, s_loaded));
+    std::vector<uint8_t> expected, data;
+    REQUIRE_EQ(s.write_to(expected), Error::OK);
+    REQUIRE_EQ(s_loaded.write_to(data), Error::OK);
+    REQUIRE_EQ(data, expected);
+
+    // Compacting folds the edits into the scene file.
+    REQUIRE_EQ(replayed.compact(path, s_loaded), Error::OK);
+    REQUIRE_EQ(replayed.pending(), 0);
+    REQUIRE_EQ(std::filesystem::file_size(Journal::path_of(path)),
+        replayed.size());
+    replayed.close(true);
+    REQUIRE_FALSE(std::filesystem::exists(Journal::path_of(path)));
+}
+
+/** Reopens a journaled scene and compares the replayed scene with it. */
+static void _check_replay(
+    const std::filesystem::path& path, Scene& s, Journal& journal)
+{
+    journal.close();
+    s.journal = nullptr;
+    Scene s_loaded;
+    Journal replayed;
+    REQUIRE_EQ(s_loaded.read_file(path), Error::OK);
+    size_t undo_s = s_loaded.undo.size();
+    REQUIRE_EQ(replayed.open(path, s_loaded), Error::OK);
+    // Replayed edits are already saved, so there is nothing to undo.
+    REQUIRE_EQ(s_loaded.undo.size(), undo_s);
+    std::vector<uint8_t> expected, data;
+    REQUIRE_EQ(s.write_to(expected), Error::OK);
+    REQUIRE_EQ(s_loaded.write_to(data), Error::OK);
+    REQUIRE_EQ(data, expected);
+    replayed.close(true);
+}
+
+TEST_CASE("format-journal-edits")
+{
+    std::filesystem::path path = fs::CACHE / "format-journal-edits.ic";
+    const std::function<void(Scene&)> edits[] = {
+        // Duplicating and resizing gates.
+        [](Scene& s) {
+            Node g = s.add_node<Gate>(Gate::Type::AND);
+            REQUIRE(s.get_node<Gate>(g)->increment());
+            REQUIRE(s.get_node<Gate>(g)->increment());
+            REQUIRE(s.get_node<Gate>(g)->decrement());
+            REQUIRE_EQ(s.duplicate_node(g), Error::OK);
+            REQUIRE(s.connect(g, 2, Node { 0, Node::INPUT }));
+        },
+        // Duplicating a connected node leaves the copy unconnected.
+        [](Scene& s) {
+            Node g { 0, Node::GATE };
+            REQUIRE_EQ(s.duplicate_node(g), Error::OK);
+            REQUIRE_EQ(s.get_node<Gate>(g)->inputs[0], 0);
+            REQUIRE(s.get_node<Gate>(g)->output.empty());
+            REQUIRE(s.connect(g, 0, Node { 0, Node::INPUT }));
+        },
+        [](Scene& s) {
+            s.get_node<Gate>(Node { 2, Node::GATE })->set_delay(9);
+            s.get_node<Gate>(Node { 0, Node::GATE })->set_delay(3);
+            s.get_node<Gate>(Node { 0, Node::GATE })
+                ->set_delay(Gate::INHERIT_DELAY);
+        },
+        [](Scene& s) {
+            s.get_node<Lut>(Node { 0, Node::LUT })
+                ->set_table(Lut::Table { 0b11101000 });
+        },
+        [](Scene& s) {
+            s.get_node<Input>(Node { 0, Node::INPUT })->toggle();
+            s.get_node<Input>(Node { 1, Node::INPUT })->set_freq(20);
+        },
+        [](Scene& s) {
+            s.get_node<Sequential>(Node { 0, Node::SEQUENTIAL })
+                ->set_value(0x3C);
+        },
+        [](Scene& s) {
+            s.get_node<Memory>(Node { 0, Node::MEMORY })->write(5, 0x17);
+        },
+        [](Scene& s) {
+            s.get_node<Memory>(Node { 0, Node::MEMORY })->load({ 1, 2, 3 });
+        },
+    };
+    for (const auto& edit : edits) {
+        Scene s { "mixed" };
+        _create_mixed(s);
+        Journal journal;
+        REQUIRE_EQ(journal.compact(path, s), Error::OK);
+        edit(s);
+        REQUIRE_GT(journal.pending(), 0);
+        _check_replay(path, s, journal);
+    }
+}
+
+TEST_CASE("format-journal-memory-write")
+{
+    std::filesystem::path path = fs::CACHE / "format-journal-memory.ic";
+    Scene s;
+    Node m = s.add_node<Memory>(Memory::Type::RAM, sockid { 12 }, sockid { 8 });
+    Journal journal;
+    REQUIRE_EQ(journal.compact(path, s), Error::OK);
+    // A word costs a few bytes however large the memory is.
+    size_t size = journal.size();
+    s.get_node<Memory>(m)->write(4000, 0xA5);
+    REQUIRE_LT(journal.size() - size, 16);
+    s.get_node<Memory>(m)->write(7, 0x3C);
+    REQUIRE_EQ(journal.pending(), 2);
+    _check_replay(path, s, journal);
+}
+
+TEST_CASE("format-journal-recovery")
+{
+    std::filesystem::path path = fs::CACHE / "format-journal-torn.ic";
+    Scene s { "mixed" };
+    _create_mixed(s);
+    Journal journal;
+    REQUIRE_EQ(journal.compact(path, s), Error::OK);
+    Node g = s.add_node<Gate>(Gate::Type::XOR);
+    size_t size = journal.size();
+    s.get_base(g)->move({ -8, 8 });
+    size_t torn_size = journal.size() - 2;
+    journal.close();
+    s.journal = nullptr;
+
+    // A record that was cut short by a crash is dropped.
+    std::filesystem::resize_file(Journal::path_of(path), torn_size);
+    Scene s_torn;
+    Journal torn;
+    REQUIRE_EQ(s_torn.read_file(path), Error::OK);
+    REQUIRE_EQ(torn.open(path, s_torn), Error::OK);
+    REQUIRE_EQ(torn.pending(), 1);
+    REQUIRE_EQ(std::filesystem::file_size(Journal::path_of(path)), size);
+    REQUIRE_EQ(s_torn.get_base(g)->point().x, 0);
+    torn.close();
+
+    // A journal of an older version of the file is ignored.
+    Scene other { "other" };
+    REQUIRE_EQ(other.write_file(path), Error::OK);
+    Scene s_other;
+    Journal restarted;
+    REQUIRE_EQ(s_other.read_file(path), Error::OK);
+    REQUIRE_EQ(restarted.open(path, s_other), Error::OK);
+    REQUIRE_EQ(restarted.pending(), 0);
+    REQUIRE(s_other.get_node<Gate>(g) == nullptr);
+    restarted.close(true);
+}
+
+TEST_CASE("format-journal-unreplayable")
+{
+    std::filesystem::path path = fs::CACHE / "format-journal-bad.ic";
+    std::filesystem::path bad  = Journal::path_of(path);
+    bad += ".bad";
+    Scene s { "mixed" };
+    _create_mixed(s);
+    Journal journal;
+    REQUIRE_EQ(journal.compact(path, s), Error::OK);
+    size_t header_s = journal.size();
+    REQUIRE_EQ(s.remove_node(Node { 2, Node::GATE }), Error::OK);
+    journal.close();
+    s.journal = nullptr;
+
+    // Removing the same node twice can not be replayed.
+    std::vector<uint8_t> data;
+    REQUIRE(fs::read(Journal::path_of(path), data));
+    std::vector<uint8_t> records { data.begin() + header_s, data.end() };
+    data.insert(data.end(), records.begin(), records.end());
+    REQUIRE(fs::write(Journal::path_of(path), data));
+    Scene s_loaded;
+    Journal replayed;
+    REQUIRE_EQ(s_loaded.read_file(path), Error::OK);
+    REQUIRE_NE(replayed.open(path, s_loaded), Error::OK);
+
+    // The file still opens as it was saved and the journal is kept aside.
+    REQUIRE_EQ(tabs::open(path), Error::OK);
+    REQUIRE(std::filesystem::exists(bad));
+    REQUIRE(tabs::active()->get_node<Gate>(Node { 2, Node::GATE }) != nullptr);
+    REQUIRE_EQ(tabs::close(), Error::OK);
+    std::filesystem::remove(bad);
+}
@@ -0,0 +1,344 @@
+#include <doctest.h>
+#include "common.h"
+#include "core.h"
+#include "test_util.h"
+
+using namespace ic;
+
+/** Writes a netlist to the cache directory. */
+static std::filesystem::path _netlist_file(
+    const std::string& name, const std::string& text)
+{
+    std::filesystem::path path = fs::CACHE / name;
+    REQUIRE(fs::write(path, text));
+    return path;
+}
+
+/** Sets the Input nodes to the bits of the pattern and reads the outputs. */
+static uint64_t _run(Scene& s, uint64_t pattern)
+{
+    for (size_t i = 0; i < s._inputs.size(); i++) {
+        s.get_node<Input>(Node { static_cast<uint16_t>(i), Node::INPUT })
+            ->set((pattern >> i) & 1);
+    }
+    uint64_t out = 0;
+    for (size_t i = 0; i < s._outputs.size(); i++) {
+        if (s._outputs[i].get() == TRUE) {
+            out |= uint64_t { 1 } << i;
+        }
+    }
+    return out;
+}
+
+static const char* ADDER_V = R"(
+// Two bit adder out of full adders out of half adders.
+module half(input a, input b, output s, output c);
+    xor (s, a, b);
+    \$_AND_ g (.A(a), .B(b), .Y(c));
+endmodule
+
+module adder(x, y, z);
+    input [1:0] x, y;
+    output [2:0] z;
+    wire c;
+    full f0 (.a(x[0]), .b(y[0]), .cin(1'b0), .s(z[0]), .cout(c));
+    full f1 (x[1], y[1], c, z[1], z[2]);
+endmodule
+
+module full(input a, input b, input cin, output s, output cout);
+    wire p, g, t;
+    half h0 (a, b, p, g);
+    half h1 (.a(p), .b(cin), .s(s), .c(t));
+    assign cout = g | t;
+endmodule
+)";
+
+TEST_CASE("hdl-read-verilog")
+{
+    std::filesystem::path path = _netlist_file("hdl-adder.v", ADDER_V);
+    Scene s;
+    REQUIRE_EQ(hdl::read_scene(path, s), Error::OK);
+    REQUIRE_EQ(std::string { s.name().data() }, "adder");
+    REQUIRE_EQ(s._inputs.size(), 4);
+    REQUIRE_EQ(s._outputs.size(), 3);
+    REQUIRE_EQ(s._components.size(), 2);
+    REQUIRE_EQ(s.dependencies().size(), 1);
+    REQUIRE_EQ(s.dependencies()[0].dependencies().size(), 1);
+
+    Netlist n;
+    REQUIRE_EQ(hdl::read_netlist(path, n), Error::OK);
+    REQUIRE_EQ(n.inputs.size(), 4);
+    REQUIRE_EQ(n.outputs.size(), 3);
+    for (uint64_t pattern = 0; pattern < 16; pattern++) {
+        uint64_t sum = (pattern & 3) + (pattern >> 2);
+        REQUIRE_EQ(_run(s, pattern), sum);
+        REQUIRE_EQ(n.run(pattern), sum);
+    }
+}
+
+TEST_CASE("hdl-read-verilog-expressions")
+{
+    std::filesystem::path path = _netlist_file("hdl-expr.v", R"(
+module expr(d, s, y);
+    input [0:3] d;
+    input s;
+    output [3:0] y;
+    wire [1:0] m = s ? d[0:1] : {d[2], d[3]};
+    assign y[1:0] = m;
+    assign y[2] = ~(d[0] ^~ d[1]) & 1'b1 | d[2] & d[3];
+    assign y[3] = &d;
+endmodule
+)");
+    Netlist n;
+    REQUIRE_EQ(hdl::read_netlist(path, n), Error::UNSUPPORTED_NETLIST);
+
+    REQUIRE(fs::write(path, R"(
+module expr(d, s, y);
+    input [0:3] d;
+    input s;
+    output [3:0] y;
+    wire [1:0] m = s ? d[0:1] : {d[2], d[3]};
+    assign y[1:0] = m, y[3] = 0;
+    assign y[2] = ~(d[0] ^~ d[1]) & 1'b1 | d[2] & d[3];
+endmodule
+)"));
+    REQUIRE_EQ(hdl::read_netlist(path, n), Error::OK);
+    for (uint64_t pattern = 0; pattern < 32; pattern++) {
+        // d[3] is the least significant bit of d.
+        bool d[4];
+        for (size_t i = 0; i < 4; i++) {
+            d[i] = (pattern >> (3 - i)) & 1;
+        }
+        bool s        = (pattern >> 4) & 1;
+        uint64_t m    = s ? (d[0] << 1 | d[1]) : (d[2] << 1 | d[3]);
+        uint64_t y2   = ((d[0] ^ d[1]) | (d[2] & d[3]));
+        REQUIRE_EQ(n.run(pattern), m | y2 << 2);
+    }
+}
+
+TEST_CASE("hdl-read-blif")
+{
+    std::filesystem::path path = _netlist_file("hdl-top.blif", R"(
+# y = a & b | c, z = !y, w = !(a & c)
+.model top
+.inputs a b \
+    c
+.outputs y z w
+.names a b t
+11 1
+.names t c y
+1- 1
+-1 1
+.subckt inv i=y o=z
+.names a c w
+11 0
+.end
+
+.model inv
+.inputs i
+.outputs o
+.names i o
+0 1
+.end
+)");
+    Scene s;
+    REQUIRE_EQ(hdl::read_scene(path, s), Error::OK);
+    REQUIRE_EQ(s._gates.size(), 3);
+    REQUIRE_EQ(s._components.size(), 1);
+    Netlist n;
+    REQUIRE_EQ(hdl::read_netlist(path, n), Error::OK);
+    for (uint64_t pattern = 0; pattern < 8; pattern++) {
+        bool a = pattern & 1, b = pattern & 2, c = pattern & 4;
+        bool y = (a && b) || c;
+        uint64_t expected = y | !y << 1 | !(a && c) << 2;
+        REQUIRE_EQ(_run(s, pattern), expected);
+        REQUIRE_EQ(n.run(pattern), expected);
+    }
+}
+
+TEST_CASE("hdl-write-and-read")
+{
+    Scene s { "hdl-write" };
+    _create_full_adder_io(s);
+    _create_full_adder(s);
+
+    Scene mux { ComponentContext { &mux, 3, 1 }, "2x1-mux" };
+    Node g_and_1 = mux.add_node<Gate>(Gate::Type::AND);
+    Node g_and_2 = mux.add_node<Gate>(Gate::Type::AND);
+    Node g_not   = mux.add_node<Gate>(Gate::Type::NOT);
+    Node g_out   = mux.add_node<Lut>(sockid { 2 }, Lut::Table { 0b1110 });
+    mux.connect(g_and_1, 0, mux.component_context->get_input(0));
+    mux.connect(g_and_2, 0, mux.component_context->get_input(1));
+    mux.connect(g_and_1, 1, mux.component_context->get_input(2));
+    mux.connect(g_not, 0, mux.component_context->get_input(2));
+    mux.connect(g_and_2, 1, g_not);
+    mux.connect(g_out, 0, g_and_1);
+    mux.connect(g_out, 1, g_and_2);
+    mux.connect(mux.component_context->get_output(0), 0, g_out);
+    s.add_dependency(std::move(mux));
+
+    Node c = s.add_node<Component>();
+    REQUIRE_EQ(s.get_node<Component>(c)->set_component(0), Error::OK);
+    REQUIRE(s.connect(c, 0, a));
+    REQUIRE(s.connect(c, 1, b));
+    REQUIRE(s.connect(c, 2, c_in));
+    Node clk = s.add_node<Input>();
+    Node ff  = s.add_node<Sequential>(Sequential::Type::D_FLIPFLOP);
+    REQUIRE(s.connect(ff, 0, g_xor_sum));
+    REQUIRE(s.connect(ff, 1, clk));
+    Node o_mux = s.add_node<Output>();
+    Node o_q   = s.add_node<Output>();
+    Node o_nq  = s.add_node<Output>();
+    REQUIRE(s.connect(o_mux, 0, c));
+    REQUIRE(s.connect(o_q, 0, ff, 0));
+    REQUIRE(s.connect(o_nq, 0, ff, 1));
+
+    for (const char* name : { "hdl-write.v", "hdl-write.blif" }) {
+        std::filesystem::path path = fs::CACHE / name;
+        REQUIRE_EQ(hdl::write_scene(s, path), Error::OK);
+        Scene r;
+        REQUIRE_EQ(hdl::read_scene(path, r), Error::OK);
+        REQUIRE_EQ(r._inputs.size(), 4);
+        REQUIRE_EQ(r._outputs.size(), 5);
+        REQUIRE_EQ(r._sequentials.size(), 1);
+        REQUIRE_EQ(r.dependencies().size(), 1);
+        // Clock is the highest input and rises on even steps, so both
+        // flip-flops start from the first value they sample.
+        for (uint64_t step = 0; step < 32; step++) {
+            uint64_t pattern = (step / 2 % 8) | (step + 1) % 2 << 3;
+            REQUIRE_EQ(_run(r, pattern), _run(s, pattern));
+        }
+    }
+
+    s.add_node<Memory>(Memory::Type::ROM, sockid { 4 }, sockid { 8 });
+    REQUIRE_EQ(hdl::write_scene(s, fs::CACHE / "hdl-memory.v"),
+        Error::UNSUPPORTED_NETLIST);
+}
+
+TEST_CASE("hdl-write-and-read-constants")
+{
+    // Gates with an open input are written as constant false, which must
+    // not become a port.
+    Scene s { "hdl-constants" };
+    Node a     = s.add_node<Input>();
+    Node b     = s.add_node<Input>();
+    Node g_and = s.add_node<Gate>(Gate::Type::AND);
+    Node g_nor = s.add_node<Gate>(Gate::Type::NOR);
+    Node g_xor = s.add_node<Gate>(Gate::Type::XOR);
+    Node o_and = s.add_node<Output>();
+    Node o_nor = s.add_node<Output>();
+    Node o_xor = s.add_node<Output>();
+    REQUIRE(s.connect(g_and, 0, a));
+    REQUIRE(s.connect(g_nor, 1, b));
+    REQUIRE(s.connect(g_xor, 0, a));
+    REQUIRE(s.connect(g_xor, 1, b));
+    REQUIRE(s.connect(o_and, 0, g_and));
+    REQUIRE(s.connect(o_nor, 0, g_nor));
+    REQUIRE(s.connect(o_xor, 0, g_xor));
+
+    for (const char* name : { "hdl-constants.v", "hdl-constants.blif" }) {
+        std::filesystem::path path = fs::CACHE / name;
+        REQUIRE_EQ(hdl::write_scene(s, path), Error::OK);
+        Scene r;
+        REQUIRE_EQ(hdl::read_scene(path, r), Error::OK);
+        REQUIRE_EQ(r._inputs.size(), 2);
+        REQUIRE_EQ(r._outputs.size(), 3);
+        for (uint64_t pattern = 0; pattern < 4; pattern++) {
+            REQUIRE_EQ(_run(r, pattern), ((pattern ^ pattern >> 1) & 1) << 2);
+        }
+        Equivalence result;
+        REQUIRE_EQ(check_equivalence(s, r, result), Error::OK);
+        REQUIRE(result.is_equivalent);
+    }
+}
+
+TEST_CASE("hdl-read-constants")
+{
+    // Constants must not become ports, even without any other driver.
+    std::filesystem::path path = _netlist_file("hdl-constants-only.v", R"(
+module constants(y, z);
+    output y, z;
+    assign y = 1'b1;
+    assign z = 1'b0;
+endmodule
+)");
+    Scene s;
+    REQUIRE_EQ(hdl::read_scene(path, s), Error::OK);
+    REQUIRE(s._inputs.empty());
+    REQUIRE_EQ(s._outputs.size(), 2);
+    REQUIRE_EQ(s._outputs[0].get(), State::TRUE);
+    REQUIRE_EQ(s._outputs[1].get(), State::FALSE);
+
+    for (const char* name :
+        { "hdl-constants-only.blif", "hdl-constants-only.v" }) {
+        path = fs::CACHE / name;
+        REQUIRE_EQ(hdl::write_scene(s, path), Error::OK);
+        Scene r;
+        REQUIRE_EQ(hdl::read_scene(path, r), Error::OK);
+        REQUIRE(r._inputs.empty());
+        REQUIRE_EQ(r._outputs[0].get(), State::TRUE);
+        REQUIRE_EQ(r._outputs[1].get(), State::FALSE);
+        Equivalence result;
+        REQUIRE_EQ(check_equivalence(s, r, result), Error::OK);
+        REQUIRE(result.is_equivalent);
+    }
+}
+
+TEST_CASE("hdl-read-large-netlist")
+{
+    // Parity of the inputs through a chain of XOR cells, each input is used
+    // an odd number of times.
+    const size_t INPUT_S = 16, CELL_S = 16 * 1251;
+    std::string cell_s = std::to_string(CELL_S);
+    std::string text   = "module parity(in, out);\n    input [15:0] in;\n"
+                         "    output out;\n    wire ["
+        + cell_s + ":0] w;\n    assign w[0] = 1'b0;\n";
+    for (size_t i = 0; i < CELL_S; i++) {
+        text += "    \\$_XOR_ c" + std::to_string(i) + " (.A(w["
+            + std::to_string(i) + "]), .B(in[" + std::to_string(i % INPUT_S)
+            + "]), .Y(w[" + std::to_string(i + 1) + "]));\n";
+    }
+    text += "    assign out = w[" + cell_s + "];\nendmodule\n";
+    std::filesystem::path path = _netlist_file("hdl-parity.v", text);
+
+    Netlist n;
+    REQUIRE_EQ(hdl::read_netlist(path, n), Error::OK);
+    REQUIRE_EQ(n.inputs.size(), INPUT_S);
+    REQUIRE_EQ(n.outputs.size(), 1);
+    for (uint64_t pattern : { 0x0, 0x1, 0x8001, 0xFFFF, 0x1234 }) {
+        uint64_t parity = std::bitset<64> { pattern }.count() & 1;
+        REQUIRE_EQ(n.run(pattern), parity);
+    }
+    n.optimize();
+    REQUIRE(n.gate_count() <= CELL_S);
+    REQUIRE_EQ(n.run(0x1234), 1);
+}
+
+TEST_CASE("hdl-unsupported")
+{
+    Scene s;
+    REQUIRE_EQ(hdl::read_scene(fs::CACHE / "hdl-missing.v", s),
+        Error::NOT_FOUND);
+    std::filesystem::path path = _netlist_file("hdl-always.v", R"(
+module counter(input clk, output reg q);
+    always @(posedge clk) q <= ~q;
+endmodule
+)");
+    REQUIRE_EQ(hdl::read_scene(path, s), Error::UNSUPPORTED_NETLIST);
+
+    path = _netlist_file("hdl-latch.blif", R"(
+.model toggle
+.inputs clk
+.outputs q
+.latch d q re clk 0
+.names q d
+0 1
+.end
+)");
+    Netlist n;
+    REQUIRE_EQ(hdl::read_netlist(path, n), Error::NOT_COMBINATIONAL);
+    REQUIRE_EQ(hdl::read_scene(path, s), Error::OK);
+    for (int i = 0; i < 4; i++) {
+        REQUIRE_EQ(_run(s, i % 2), (i + 1) / 2 % 2);
+    }
+}
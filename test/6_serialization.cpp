@@ -172,3 +172,225 @@ TEST_CASE("save-component-load-to-scene")
     REQUIRE_EQ(s3.read_from(data), Error::OK);
     REQUIRE_EQ(s3.get_node<Output>(Node { 0, Node::OUTPUT })->get(), TRUE);
 }
+
+static std::vector<uint8_t> _create_dependent(Gate::Type type)
+{
+    std::vector<uint8_t> data;
+    Scene s { ComponentContext { &s, 2, 1 }, "Cached", "Author" };
+    Node g = s.add_node<Gate>(type);
+    s.connect(g, 0, s.component_context->get_input(0));
+    s.connect(g, 1, s.component_context->get_input(1));
+    s.connect(s.component_context->get_output(0), 0, g);
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    REQUIRE(fs::write(
+        fs::LIBRARY / (base64_encode(s.to_dependency()) + ".ic"), data));
+
+    Scene s2 { "CachedScene", "Author" };
+    s2.add_dependency(std::move(s));
+    Node c  = s2.add_node<Component>();
+    Node i1 = s2.add_node<Input>();
+    Node i2 = s2.add_node<Input>();
+    Node o  = s2.add_node<Output>();
+    REQUIRE_EQ(s2.get_node<Component>(c)->set_component(0), Error::OK);
+    REQUIRE(s2.connect(o, 0, c, 0));
+    REQUIRE(s2.connect(c, 0, i1));
+    REQUIRE(s2.connect(c, 1, i2));
+    s2.get_node<Input>(i1)->set(true);
+    REQUIRE_EQ(s2.write_to(data), Error::OK);
+    return data;
+}
+
+TEST_CASE("dependency-cache")
+{
+    std::vector<uint8_t> data = _create_dependent(Gate::Type::XOR);
+    std::weak_ptr<const Scene> cached;
+    {
+        Scene first, second;
+        REQUIRE_EQ(first.read_from(data), Error::OK);
+        REQUIRE_EQ(second.read_from(data), Error::OK);
+        REQUIRE(first.dependencies()[0].source != nullptr);
+        REQUIRE_EQ(first.dependencies()[0].source,
+            second.dependencies()[0].source);
+        // Every scene simulates its own copy.
+        REQUIRE_NE(
+            &first.dependencies()[0], first.dependencies()[0].source.get());
+        REQUIRE_EQ(first.get_node<Output>(Node { 0, Node::OUTPUT })->get(),
+            TRUE);
+        cached = first.dependencies()[0].source;
+
+        // A changed file is parsed again.
+        std::vector<uint8_t> changed = _create_dependent(Gate::Type::AND);
+        Scene third;
+        REQUIRE_EQ(third.read_from(changed), Error::OK);
+        REQUIRE_NE(third.dependencies()[0].source, cached.lock());
+        REQUIRE_EQ(third.get_node<Output>(Node { 0, Node::OUTPUT })->get(),
+            FALSE);
+    }
+    REQUIRE(cached.expired());
+}
+
+/** Component named name that XORs the outputs of its dependencies. */
+static void _create_layer(
+    const std::string& name, const std::vector<std::string>& deps)
+{
+    Scene s { ComponentContext { &s, 2, 1 }, name, "Author" };
+    std::vector<uint8_t> data;
+    Node last = s.component_context->get_input(0);
+    for (const std::string& dep : deps) {
+        Scene d;
+        REQUIRE_EQ(load_dependency(dep, d), Error::OK);
+        s.add_dependency(std::move(d));
+        Node c = s.add_node<Component>();
+        REQUIRE_EQ(s.get_node<Component>(c)->set_component(
+                       s.dependencies().size() - 1),
+            Error::OK);
+        Node g = s.add_node<Gate>(Gate::Type::XOR);
+        REQUIRE(s.connect(c, 0, s.component_context->get_input(0)));
+        REQUIRE(s.connect(c, 1, s.component_context->get_input(1)));
+        REQUIRE(s.connect(g, 0, last));
+        REQUIRE(s.connect(g, 1, c, 0));
+        last = g;
+    }
+    if (deps.empty()) {
+        Node g = s.add_node<Gate>(Gate::Type::AND);
+        REQUIRE(s.connect(g, 0, s.component_context->get_input(0)));
+        REQUIRE(s.connect(g, 1, s.component_context->get_input(1)));
+        last = g;
+    }
+    REQUIRE(s.connect(s.component_context->get_output(0), 0, last));
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    REQUIRE(fs::write(
+        fs::LIBRARY / (base64_encode(s.to_dependency()) + ".ic"), data));
+}
+
+TEST_CASE("dependency-hierarchy")
+{
+    std::vector<std::string> leaves, middles;
+    for (size_t i = 0; i < 6; i++) {
+        std::string name = "Leaf" + std::to_string(i);
+        _create_layer(name, {});
+        leaves.push_back("Author/" + name + "/1");
+    }
+    for (size_t i = 0; i < 4; i++) {
+        std::string name = "Middle" + std::to_string(i);
+        _create_layer(name, { leaves[i], leaves[i + 1], leaves[i + 2] });
+        middles.push_back("Author/" + name + "/1");
+    }
+    _create_layer("Top", middles);
+
+    Scene s;
+    REQUIRE_EQ(load_dependency("Author/Top/1", s), Error::OK);
+    REQUIRE_EQ(s.dependencies().size(), middles.size());
+    for (const Scene& middle : s.dependencies()) {
+        REQUIRE_EQ(middle.dependencies().size(), 3);
+        REQUIRE(middle.source != nullptr);
+        REQUIRE_NE(middle.source_hash, 0);
+    }
+    // The key covers the files of the nested dependencies as well.
+    REQUIRE_NE(s.source_hash, 0);
+    REQUIRE_NE(s.dependencies()[0].source_hash,
+        s.dependencies()[1].source_hash);
+    // Every middle layer XORs three ANDs, a 1 for each when both are set.
+    REQUIRE_EQ(s.component_context->run(0b11), 1);
+    REQUIRE_EQ(s.component_context->run(0b01), 1);
+    REQUIRE_EQ(s.component_context->run(0b00), 0);
+}
+
+TEST_CASE("dependency-library")
+{
+    Scene s { ComponentContext { &s, 2, 1 }, "Indexed", "Author" };
+    Node g = s.add_node<Gate>(Gate::Type::OR);
+    REQUIRE(s.connect(g, 0, s.component_context->get_input(0)));
+    REQUIRE(s.connect(g, 1, s.component_context->get_input(1)));
+    REQUIRE(s.connect(s.component_context->get_output(0), 0, g));
+    std::string name = s.to_dependency();
+    REQUIRE_EQ(library::install(s), Error::OK);
+    REQUIRE_EQ(library::install(s), Error::OK);
+
+    library::Package package;
+    REQUIRE(library::find(name, package));
+    REQUIRE_EQ(package.name, name);
+    REQUIRE_EQ(package.input_s, 2);
+    REQUIRE_EQ(package.output_s, 1);
+    REQUIRE(std::filesystem::exists(library::blob_path(package.hash)));
+    REQUIRE_EQ(std::filesystem::file_size(library::blob_path(package.hash)),
+        package.size);
+    // Installing the same document twice keeps a single package.
+    size_t count = 0;
+    for (const library::Package& p : library::list()) {
+        count += p.name == name;
+    }
+    REQUIRE_EQ(count, 1);
+    REQUIRE_FALSE(library::find("Author/Missing/1", package));
+
+    // Resolved from the index, there is no file named after the dependency.
+    Scene loaded;
+    REQUIRE_EQ(load_dependency(name, loaded), Error::OK);
+    REQUIRE_EQ(loaded.component_context->run(0b10), 1);
+    REQUIRE_EQ(loaded.component_context->run(0b00), 0);
+    // Without dependencies of its own, it is keyed by its blob alone.
+    REQUIRE_EQ(loaded.source_hash, package.hash);
+
+    // A new version of the package replaces the old blob.
+    uint64_t old_hash = package.hash;
+    s.get_node<Gate>(g)->move({ 1, 1 });
+    REQUIRE_EQ(library::install(s), Error::OK);
+    REQUIRE(library::find(name, package));
+    REQUIRE_NE(package.hash, old_hash);
+    REQUIRE_FALSE(std::filesystem::exists(library::blob_path(old_hash)));
+    // The cached copy is dropped, scenes that use it keep their own.
+    Scene reloaded;
+    REQUIRE_EQ(load_dependency(name, reloaded), Error::OK);
+    REQUIRE(loaded.source != nullptr);
+    REQUIRE_NE(reloaded.source, loaded.source);
+    REQUIRE_EQ(reloaded.source_hash, package.hash);
+
+    REQUIRE_EQ(library::remove(name), Error::OK);
+    REQUIRE_FALSE(library::find(name, package));
+    REQUIRE_FALSE(std::filesystem::exists(library::blob_path(package.hash)));
+    REQUIRE_EQ(library::remove(name), Error::COMPONENT_NOT_FOUND);
+
+    // A damaged index is left alone instead of being replaced by one that
+    // only has the new package.
+    REQUIRE_EQ(library::install(s), Error::OK);
+    REQUIRE(library::find(name, package));
+    std::filesystem::path index = fs::LIBRARY / "index";
+    std::vector<uint8_t> data;
+    REQUIRE(fs::read(index, data));
+    data.resize(8);
+    std::filesystem::remove(index);
+    REQUIRE(fs::write(index, data));
+    library::refresh();
+    REQUIRE_FALSE(library::find(name, package));
+    REQUIRE_EQ(library::install(s), Error::DAMAGED_INDEX);
+    REQUIRE_EQ(library::remove(name), Error::DAMAGED_INDEX);
+    REQUIRE_EQ(std::filesystem::file_size(index), data.size());
+    std::filesystem::remove(index);
+    std::filesystem::remove(library::blob_path(package.hash));
+}
+
+TEST_CASE("dependency-library-compressed")
+{
+    Scene s { ComponentContext { &s, 2, 1 }, "Packed", "Author" };
+    s.is_compressed = true;
+    Node g          = s.add_node<Gate>(Gate::Type::XOR);
+    REQUIRE(s.connect(g, 0, s.component_context->get_input(0)));
+    REQUIRE(s.connect(g, 1, s.component_context->get_input(1)));
+    REQUIRE(s.connect(s.component_context->get_output(0), 0, g));
+    std::string name = s.to_dependency();
+    REQUIRE_EQ(library::install(s), Error::OK);
+
+    library::Package package;
+    REQUIRE(library::find(name, package));
+    std::vector<uint8_t> blob;
+    REQUIRE(fs::read(library::blob_path(package.hash), blob));
+    REQUIRE_EQ(blob.size(), package.size);
+    REQUIRE_EQ(blob[0], Scene::FORMAT_VERSION | Scene::FORMAT_COMPRESSED);
+
+    Scene loaded;
+    REQUIRE_EQ(load_dependency(name, loaded), Error::OK);
+    REQUIRE(loaded.is_compressed);
+    REQUIRE_EQ(loaded.component_context->run(0b10), 1);
+    REQUIRE_EQ(loaded.component_context->run(0b11), 0);
+    REQUIRE_EQ(library::remove(name), Error::OK);
+}
@@ -0,0 +1,173 @@
+#include <doctest.h>
+#include "common.h"
+#include "core.h"
+
+using namespace ic;
+
+TEST_CASE("zero-delay-settles-instantly")
+{
+    Scene s;
+    Node i     = s.add_node<Input>();
+    Node g_not = s.add_node<Gate>(Gate::Type::NOT);
+    Node o     = s.add_node<Output>();
+    REQUIRE(s.connect(g_not, 0, i));
+    REQUIRE(s.connect(o, 0, g_not));
+
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+    s.get_node<Input>(i)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::FALSE);
+    REQUIRE_EQ(s.tick(), 0);
+}
+
+TEST_CASE("gate-type-delay")
+{
+    Scene s;
+    s.gate_delay[Gate::Type::NOT] = 3;
+    Node i     = s.add_node<Input>();
+    Node g_not = s.add_node<Gate>(Gate::Type::NOT);
+    Node o     = s.add_node<Output>();
+    REQUIRE(s.connect(g_not, 0, i));
+    REQUIRE(s.connect(o, 0, g_not));
+    REQUIRE_EQ(s.get_node<Gate>(g_not)->delay(), 3);
+
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::DISABLED);
+    s.step(3);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+
+    s.get_node<Input>(i)->set(true);
+    s.step(2);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+    s.step(1);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::FALSE);
+}
+
+TEST_CASE("gate-instance-delay-override")
+{
+    Scene s;
+    s.gate_delay[Gate::Type::AND] = 5;
+    Node i      = s.add_node<Input>();
+    Node g_fast = s.add_node<Gate>(Gate::Type::AND);
+    Node g_slow = s.add_node<Gate>(Gate::Type::AND);
+    Node o_fast = s.add_node<Output>();
+    Node o_slow = s.add_node<Output>();
+    s.get_node<Gate>(g_fast)->set_delay(1);
+    REQUIRE(s.get_node<Gate>(g_fast)->has_delay());
+    REQUIRE_FALSE(s.get_node<Gate>(g_slow)->has_delay());
+
+    REQUIRE(s.connect(g_fast, 0, i));
+    REQUIRE(s.connect(g_fast, 1, i));
+    REQUIRE(s.connect(g_slow, 0, i));
+    REQUIRE(s.connect(g_slow, 1, i));
+    REQUIRE(s.connect(o_fast, 0, g_fast));
+    REQUIRE(s.connect(o_slow, 0, g_slow));
+    REQUIRE(s.settle());
+
+    s.get_node<Input>(i)->set(true);
+    s.step(1);
+    REQUIRE_EQ(s.get_node<Output>(o_fast)->get(), State::TRUE);
+    REQUIRE_EQ(s.get_node<Output>(o_slow)->get(), State::FALSE);
+    s.step(4);
+    REQUIRE_EQ(s.get_node<Output>(o_slow)->get(), State::TRUE);
+}
+
+TEST_CASE("glitch-is-visible-with-delay")
+{
+    // y = a AND NOT a produces a pulse when a rises if NOT is slower than the
+    // wire.
+    Scene s;
+    s.gate_delay[Gate::Type::NOT] = 2;
+    s.gate_delay[Gate::Type::AND] = 1;
+    Node a     = s.add_node<Input>();
+    Node g_not = s.add_node<Gate>(Gate::Type::NOT);
+    Node g_and = s.add_node<Gate>(Gate::Type::AND);
+    Node o     = s.add_node<Output>();
+    REQUIRE(s.connect(g_not, 0, a));
+    REQUIRE(s.connect(g_and, 0, a));
+    REQUIRE(s.connect(g_and, 1, g_not));
+    REQUIRE(s.connect(o, 0, g_and));
+    REQUIRE(s.settle());
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::FALSE);
+
+    s.get_node<Input>(a)->set(true);
+    s.step(1);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+    REQUIRE(s.settle());
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::FALSE);
+}
+
+TEST_CASE("ring-oscillator-with-delay")
+{
+    Scene s;
+    s.gate_delay[Gate::Type::NOT] = 1;
+    Node g1 = s.add_node<Gate>(Gate::Type::NOT);
+    Node g2 = s.add_node<Gate>(Gate::Type::NOT);
+    Node g3 = s.add_node<Gate>(Gate::Type::NOT);
+    Node o  = s.add_node<Output>();
+    REQUIRE(s.connect(g2, 0, g1));
+    REQUIRE(s.connect(g3, 0, g2));
+    REQUIRE(s.connect(g1, 0, g3));
+    REQUIRE(s.connect(o, 0, g3));
+
+    // The loop never settles, but each step does a bounded amount of work.
+    REQUIRE_FALSE(s.settle(1000));
+    std::vector<State> seen;
+    for (size_t i = 0; i < 12; i++) {
+        REQUIRE(s.step(1, 100) <= 100);
+        seen.push_back(s.get_node<Output>(o)->get());
+    }
+    REQUIRE(std::find(seen.begin(), seen.end(), State::TRUE) != seen.end());
+    REQUIRE(std::find(seen.begin(), seen.end(), State::FALSE) != seen.end());
+}
+
+TEST_CASE("event-budget-limits-work")
+{
+    Scene s;
+    s.gate_delay[Gate::Type::NOT] = 1;
+    Node i = s.add_node<Input>();
+    std::vector<Node> gates;
+    for (size_t k = 0; k < 10; k++) {
+        gates.push_back(s.add_node<Gate>(Gate::Type::NOT));
+        REQUIRE(s.connect(gates.back(), 0, i));
+        REQUIRE(s.connect(s.add_node<Output>(), 0, gates.back()));
+    }
+    REQUIRE(s.settle());
+    s.get_node<Input>(i)->set(true);
+    REQUIRE_EQ(s.step(1, 4), 4);
+    REQUIRE_EQ(s.step(0, 4), 4);
+    REQUIRE_EQ(s.step(0, 4), 2);
+    REQUIRE(s.settle());
+}
+
+TEST_CASE("long-delay-grows-the-wheel")
+{
+    Scene s;
+    Node i     = s.add_node<Input>();
+    Node g_not = s.add_node<Gate>(Gate::Type::NOT);
+    Node o     = s.add_node<Output>();
+    s.get_node<Gate>(g_not)->set_delay(1000);
+    REQUIRE(s.connect(g_not, 0, i));
+    REQUIRE(s.connect(o, 0, g_not));
+    s.step(999);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::DISABLED);
+    s.step(1);
+    REQUIRE_EQ(s.get_node<Output>(o)->get(), State::TRUE);
+}
+
+TEST_CASE("save-load-delays")
+{
+    Scene s { "delays" };
+    s.gate_delay[Gate::Type::XOR] = 7;
+    Node g1 = s.add_node<Gate>(Gate::Type::XOR);
+    Node g2 = s.add_node<Gate>(Gate::Type::OR);
+    s.get_node<Gate>(g2)->set_delay(4);
+
+    std::vector<uint8_t> data;
+    REQUIRE_EQ(s.write_to(data), Error::OK);
+    Scene s_loaded;
+    REQUIRE_EQ(s_loaded.read_from(data), Error::OK);
+    REQUIRE_EQ(s_loaded.gate_delay[Gate::Type::XOR], 7);
+    REQUIRE_EQ(s_loaded.get_node<Gate>(g1)->delay(), 7);
+    REQUIRE_FALSE(s_loaded.get_node<Gate>(g1)->has_delay());
+    REQUIRE_EQ(s_loaded.get_node<Gate>(g2)->delay(), 4);
+    REQUIRE(s_loaded.get_node<Gate>(g2)->has_delay());
+}
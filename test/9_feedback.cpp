@@ -0,0 +1,105 @@
+#include <doctest.h>
+#include "core.h"
+
+using namespace ic;
+
+TEST_CASE("acyclic-has-no-loops")
+{
+    Scene s;
+    Node i     = s.add_node<Input>();
+    Node g_not = s.add_node<Gate>(Gate::Type::NOT);
+    Node o     = s.add_node<Output>();
+    REQUIRE(s.connect(g_not, 0, i));
+    REQUIRE(s.connect(o, 0, g_not));
+    REQUIRE(s.loops().empty());
+    REQUIRE_FALSE(s.is_oscillating());
+}
+
+TEST_CASE("sr-latch-from-nor")
+{
+    Scene s;
+    Node set   = s.add_node<Input>();
+    Node reset = s.add_node<Input>();
+    Node g_q   = s.add_node<Gate>(Gate::Type::NOR);
+    Node g_qn  = s.add_node<Gate>(Gate::Type::NOR);
+    Node q     = s.add_node<Output>();
+    Node qn    = s.add_node<Output>();
+    REQUIRE(s.connect(g_q, 0, reset));
+    REQUIRE(s.connect(g_qn, 0, set));
+    REQUIRE(s.connect(g_q, 1, g_qn));
+    REQUIRE(s.connect(g_qn, 1, g_q));
+    REQUIRE(s.connect(q, 0, g_q));
+    REQUIRE(s.connect(qn, 0, g_qn));
+
+    REQUIRE_EQ(s.loops().size(), 1);
+    REQUIRE_EQ(s.loops()[0].nodes.size(), 2);
+
+    s.get_node<Input>(set)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::TRUE);
+    REQUIRE_EQ(s.get_node<Output>(qn)->get(), State::FALSE);
+    s.get_node<Input>(set)->set(false);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::TRUE);
+    REQUIRE_EQ(s.get_node<Output>(qn)->get(), State::FALSE);
+
+    s.get_node<Input>(reset)->set(true);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+    REQUIRE_EQ(s.get_node<Output>(qn)->get(), State::TRUE);
+    s.get_node<Input>(reset)->set(false);
+    REQUIRE_EQ(s.get_node<Output>(q)->get(), State::FALSE);
+    REQUIRE_EQ(s.get_node<Output>(qn)->get(), State::TRUE);
+    REQUIRE_FALSE(s.is_oscillating());
+}
+
+TEST_CASE("zero-delay-ring-oscillator")
+{
+    Scene s;
+    Node g1 = s.add_node<Gate>(Gate::Type::NOT);
+    Node g2 = s.add_node<Gate>(Gate::Type::NOT);
+    Node g3 = s.add_node<Gate>(Gate::Type::NOT);
+    REQUIRE(s.connect(g2, 0, g1));
+    REQUIRE(s.connect(g3, 0, g2));
+    relid r = s.connect(g1, 0, g3);
+    REQUIRE(r);
+
+    REQUIRE_EQ(s.loops().size(), 1);
+    REQUIRE_EQ(s.loops()[0].nodes.size(), 3);
+    REQUIRE(s.loops()[0].oscillating);
+    REQUIRE(s.is_oscillating());
+
+    REQUIRE_EQ(s.disconnect(r), Error::OK);
+    REQUIRE(s.loops().empty());
+    REQUIRE_FALSE(s.is_oscillating());
+}
+
+TEST_CASE("self-loop")
+{
+    Scene s;
+    Node i     = s.add_node<Input>();
+    Node g_and = s.add_node<Gate>(Gate::Type::AND);
+    REQUIRE(s.connect(g_and, 0, i));
+    REQUIRE(s.connect(g_and, 1, g_and));
+    REQUIRE_EQ(s.loops().size(), 1);
+    REQUIRE_EQ(s.loops()[0].nodes.size(), 1);
+
+    s.get_node<Input>(i)->set(true);
+    REQUIRE_FALSE(s.is_oscillating());
+}
+
+TEST_CASE("loop-limit")
+{
+    Scene s;
+    s.loop_limit = 4;
+    Node i       = s.add_node<Input>();
+    Node g_xor   = s.add_node<Gate>(Gate::Type::XOR);
+    Node o       = s.add_node<Output>();
+    REQUIRE(s.connect(g_xor, 0, i));
+    REQUIRE(s.connect(g_xor, 1, g_xor));
+    REQUIRE(s.connect(o, 0, g_xor));
+    REQUIRE_FALSE(s.is_oscillating());
+
+    // x = i ^ x has no fixed point while i is set.
+    s.get_node<Input>(i)->set(true);
+    REQUIRE(s.is_oscillating());
+    s.get_node<Input>(i)->set(false);
+    REQUIRE_FALSE(s.is_oscillating());
+}